@@ -0,0 +1,167 @@
+#include "ossia/health_prober.hpp"
+#include "ossia/tcp_server.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \brief
+///   First port of the listener farm.
+static constexpr std::uint16_t base_port = 28100;
+
+/// \brief
+///   Answer a payload probe with "PONG", or close the connection at once for connect probes.
+static auto farm_session(tcp_stream stream, bool payload) noexcept -> future<> {
+    if (!payload)
+        co_return;
+
+    char buffer[4];
+    auto received = co_await stream.receive_async(buffer, sizeof(buffer));
+    if (!received.has_value() || *received != sizeof(buffer))
+        co_return;
+
+    [[maybe_unused]] auto sent = co_await stream.send_async("PONG", 4);
+}
+
+static auto farm_listener(inet_address address, bool payload) noexcept -> future<> {
+    tcp_server server;
+    if (auto error = server.bind(address); error.value() != 0) {
+        std::fprintf(stderr, "Failed to bind port %u: %s\n", address.port(),
+                     error.message().c_str());
+        co_return;
+    }
+
+    while (true) {
+        auto stream = co_await server.accept_async();
+        if (!stream.has_value()) [[unlikely]] {
+            if (stream.error() == std::errc::connection_aborted)
+                continue;
+            co_return;
+        }
+
+        schedule(farm_session(std::move(*stream), payload));
+    }
+}
+
+static auto spawn_farm(std::size_t &listeners, bool &payload) noexcept -> future<> {
+    for (std::size_t i = 0; i < listeners; ++i) {
+        inet_address address(ipv4_loopback, static_cast<std::uint16_t>(base_port + i));
+        schedule(farm_listener(address, payload));
+    }
+    co_return;
+}
+
+/// \brief
+///   Parse a positive integer from command line argument.
+/// \param argc
+///   Number of command line arguments.
+/// \param argv
+///   Command line arguments.
+/// \param index
+///   Index of the argument to parse.
+/// \param fallback
+///   Value to use if the argument is absent or invalid.
+/// \return
+///   The parsed value.
+static auto parse_argument(int argc, char **argv, int index, std::size_t fallback) -> std::size_t {
+    if (index >= argc)
+        return fallback;
+
+    std::size_t value = 0;
+    auto [ptr, ec]    = std::from_chars(argv[index], argv[index] + std::strlen(argv[index]), value);
+    return (ec == std::errc() && value != 0) ? value : fallback;
+}
+
+/// \brief
+///   Probes/sec benchmark of \c health_prober against a farm of local listeners. Endpoints are
+///   spread over the listeners, and rounds start back to back so that the prober runs as fast as
+///   its in-flight limit allows.
+///
+///   Usage: ossia-bench-health_prober [endpoints] [listeners] [seconds] [threads] [in-flight]
+///          [payload]
+///
+///   Pass 1 as payload to exchange "PING" and "PONG" after connecting.
+auto main(int argc, char **argv) -> int {
+    std::size_t endpoints = parse_argument(argc, argv, 1, 20000);
+    std::size_t listeners = parse_argument(argc, argv, 2, 64);
+    std::size_t seconds   = parse_argument(argc, argv, 3, 10);
+    std::size_t threads   = parse_argument(argc, argv, 4, 2);
+    std::size_t in_flight = parse_argument(argc, argv, 5, 512);
+    bool        payload   = parse_argument(argc, argv, 6, 2) == 1;
+
+    listeners = std::min<std::size_t>(listeners, 65535 - base_port);
+
+    std::vector<inet_address> addresses;
+    addresses.reserve(endpoints);
+    for (std::size_t i = 0; i < endpoints; ++i) {
+        auto port = static_cast<std::uint16_t>(base_port + i % listeners);
+        addresses.emplace_back(ipv4_loopback, port);
+    }
+
+    health_prober_options options;
+    options.interval      = std::chrono::steady_clock::duration::zero();
+    options.timeout       = 1s;
+    options.max_in_flight = static_cast<std::uint32_t>(in_flight);
+    if (payload) {
+        options.request  = "PING";
+        options.response = "PONG";
+    }
+
+    health_prober prober(std::move(addresses), threads, options);
+    auto          run = [&prober]() noexcept -> future<> { return prober.run(); };
+
+    io_context farm_context(threads);
+    io_context prober_context(threads);
+
+    // Every farm worker binds all listeners with SO_REUSEPORT, so accepts are spread evenly.
+    farm_context.dispatch(spawn_farm, listeners, payload);
+    std::thread farm_thread([&farm_context] { farm_context.run(); });
+
+    // Give listeners some time to bind.
+    std::this_thread::sleep_for(100ms);
+
+    prober_context.dispatch(run);
+    std::thread prober_thread([&prober_context] { prober_context.run(); });
+
+    std::printf("Probing %zu endpoints over %zu listeners for %zus\n", endpoints, listeners,
+                seconds);
+    std::printf("  %zu threads, %zu probes in flight per thread, %s probes\n", threads, in_flight,
+                payload ? "payload" : "connect");
+
+    // Warm up before measuring.
+    std::this_thread::sleep_for(1s);
+
+    auto start_probes   = prober.probes();
+    auto start_failures = prober.failures();
+    auto start_time     = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    auto end_probes   = prober.probes();
+    auto end_failures = prober.failures();
+    auto end_time     = std::chrono::steady_clock::now();
+
+    prober.stop();
+    std::this_thread::sleep_for(options.timeout);
+    prober_context.stop();
+    farm_context.stop();
+    prober_thread.join();
+    farm_thread.join();
+
+    auto elapsed = std::chrono::duration<double>(end_time - start_time).count();
+    auto count   = static_cast<double>(end_probes - start_probes);
+
+    std::printf("  %.0f probes in %.2fs, %llu failed\n", count, elapsed,
+                static_cast<unsigned long long>(end_failures - start_failures));
+    std::printf("  Healthy endpoints: %zu/%zu\n", prober.healthy_count(), prober.size());
+    std::printf("Probes/sec: %.2f\n", count / elapsed);
+
+    return 0;
+}
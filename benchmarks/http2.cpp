@@ -0,0 +1,207 @@
+#include "ossia/http2.hpp"
+#include "ossia/timer.hpp"
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \struct benchmark_state
+/// \brief
+///   Shared state between benchmark clients and the main thread.
+struct benchmark_state {
+    std::atomic_bool     stop;
+    std::atomic_uint64_t streams;
+    std::atomic_uint64_t errors;
+};
+
+static auto echo(const http2_request &request, http2_response &response) noexcept -> void {
+    response.add_header("content-type", "application/grpc");
+    response.set_body(request.body());
+}
+
+static auto listener(const inet_address &address) noexcept -> future<> {
+    http2_server server;
+    if (auto error = server.bind(address); error.value() != 0) {
+        std::fprintf(stderr, "Failed to bind: %s\n", error.message().c_str());
+        co_return;
+    }
+
+    http2_settings settings;
+    settings.max_concurrent_streams = 1024;
+    settings.initial_window_size    = 1048576;
+
+    co_await server.run(echo, settings);
+}
+
+/// \brief
+///   Send requests one after another on the shared connection until the benchmark stops.
+static auto stream_loop(http2_client    &client,
+                        std::string_view payload,
+                        std::size_t     &active,
+                        benchmark_state &state) noexcept -> future<> {
+    while (!state.stop.load(std::memory_order_relaxed)) {
+        auto response = co_await client.request_async("POST", "/echo", payload);
+        if (!response.has_value() || response->body().size() != payload.size()) [[unlikely]] {
+            state.errors.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+
+        state.streams.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    active -= 1;
+}
+
+static auto client(const inet_address &address,
+                   std::size_t         concurrency,
+                   std::size_t         size,
+                   benchmark_state    &state) noexcept -> future<> {
+    http2_client connection;
+    if ((co_await connection.connect_async(address, "localhost")).value() != 0) {
+        state.errors.fetch_add(1, std::memory_order_relaxed);
+        co_return;
+    }
+
+    // The connection must outlive all streams that share it.
+    std::string payload(size, 'x');
+    std::size_t active = concurrency;
+    for (std::size_t i = 0; i < concurrency; ++i)
+        schedule(stream_loop(connection, payload, active, state));
+
+    while (active != 0)
+        co_await sleep_for(10ms);
+}
+
+static auto spawn_clients(const inet_address &address,
+                          std::size_t        &connections,
+                          std::size_t        &concurrency,
+                          std::size_t        &size,
+                          benchmark_state    &state) noexcept -> future<> {
+    for (std::size_t i = 0; i < connections; ++i)
+        schedule(client(address, concurrency, size, state));
+    co_return;
+}
+
+/// \brief
+///   Parse a positive integer from command line argument.
+/// \param argc
+///   Number of command line arguments.
+/// \param argv
+///   Command line arguments.
+/// \param index
+///   Index of the argument to parse.
+/// \param fallback
+///   Value to use if the argument is absent or invalid.
+/// \return
+///   The parsed value.
+static auto parse_argument(int argc, char **argv, int index, std::size_t fallback) -> std::size_t {
+    if (index >= argc)
+        return fallback;
+
+    std::size_t value = 0;
+    auto [ptr, ec]    = std::from_chars(argv[index], argv[index] + std::strlen(argv[index]), value);
+    return (ec == std::errc() && value != 0) ? value : fallback;
+}
+
+/// \brief
+///   Measure HPACK decoding throughput of a single thread with a typical request header block.
+/// \return
+///   Number of header blocks decoded per second.
+static auto hpack_throughput() -> double {
+    hpack_encoder encoder;
+    std::string   block;
+    encoder.encode(":method", "POST", block);
+    encoder.encode(":scheme", "http", block);
+    encoder.encode(":authority", "service.internal:8080", block);
+    encoder.encode(":path", "/package.Service/Method", block);
+    encoder.encode("content-type", "application/grpc", block);
+    encoder.encode("user-agent", "grpc-c++/1.60.0", block);
+    encoder.encode("te", "trailers", block);
+
+    hpack_header_list headers;
+    std::size_t       rounds = 1000000;
+
+    // A new decoder per round keeps its dynamic table empty, so every round decodes the same
+    // literal header fields as the first one.
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+        hpack_decoder decoder;
+        headers.clear();
+        if (!decoder.decode(block, headers).has_value()) [[unlikely]]
+            return 0;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    auto elapsed = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(rounds) / elapsed;
+}
+
+/// \brief
+///   HTTP/2 streams/sec benchmark over loopback. Each connection carries many concurrent streams,
+///   and each stream is a unary request echoed by the server.
+///
+///   Usage: ossia-bench-http2 [connections] [concurrency] [payload] [seconds] [threads]
+auto main(int argc, char **argv) -> int {
+    std::size_t connections = parse_argument(argc, argv, 1, 8);
+    std::size_t concurrency = parse_argument(argc, argv, 2, 128);
+    std::size_t size        = parse_argument(argc, argv, 3, 128);
+    std::size_t seconds     = parse_argument(argc, argv, 4, 10);
+    std::size_t threads     = parse_argument(argc, argv, 5, 2);
+
+    std::printf("HPACK decode: %.0f header blocks/sec\n", hpack_throughput());
+
+    inet_address    address(ipv4_loopback, 28082);
+    benchmark_state state{};
+
+    io_context server_context(threads);
+    io_context client_context(threads);
+
+    std::size_t per_worker = (connections + threads - 1) / threads;
+
+    server_context.dispatch(listener, address);
+    std::thread server_thread([&server_context] { server_context.run(); });
+
+    // Give listeners some time to bind.
+    std::this_thread::sleep_for(100ms);
+
+    client_context.dispatch(spawn_clients, address, per_worker, concurrency, size, state);
+    std::thread client_thread([&client_context] { client_context.run(); });
+
+    std::printf("Running %zus test @ http://127.0.0.1:%u/echo (h2c)\n", seconds, address.port());
+    std::printf("  %zu threads and %zu connections, %zu concurrent streams each, %zu-byte bodies\n",
+                threads, per_worker * threads, concurrency, size);
+
+    // Warm up before measuring.
+    std::this_thread::sleep_for(1s);
+
+    auto start_count = state.streams.load(std::memory_order_relaxed);
+    auto start_time  = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    auto end_count = state.streams.load(std::memory_order_relaxed);
+    auto end_time  = std::chrono::steady_clock::now();
+
+    state.stop.store(true, std::memory_order_relaxed);
+    client_context.stop();
+    server_context.stop();
+    client_thread.join();
+    server_thread.join();
+
+    auto elapsed = std::chrono::duration<double>(end_time - start_time).count();
+    auto count   = static_cast<double>(end_count - start_count);
+
+    std::printf("  %.0f streams in %.2fs\n", count, elapsed);
+    std::printf("  Stream errors: %llu\n",
+                static_cast<unsigned long long>(state.errors.load(std::memory_order_relaxed)));
+    std::printf("Streams/sec: %.2f\n", count / elapsed);
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "ossia/http_server.hpp"
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \brief
+///   Request sent by each benchmark client.
+static constexpr std::string_view request = "GET /plaintext HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+/// \brief
+///   Expected response to \c request.
+static constexpr std::string_view expected_response = "HTTP/1.1 200 OK\r\nContent-Length: 13\r\n"
+                                                      "Content-Type: text/plain\r\n\r\n"
+                                                      "Hello, World!";
+
+/// \struct benchmark_state
+/// \brief
+///   Shared state between benchmark clients and the main thread.
+struct benchmark_state {
+    std::atomic_bool     stop;
+    std::atomic_uint64_t responses;
+    std::atomic_uint64_t errors;
+};
+
+static auto plaintext(const http_request &, http_response &response) -> void {
+    response.add_header("Content-Type", "text/plain");
+    response.set_body("Hello, World!");
+}
+
+static auto listener(const inet_address &address) noexcept -> future<> {
+    http_server server;
+    if (auto error = server.bind(address); error.value() != 0) {
+        std::fprintf(stderr, "Failed to bind: %s\n", error.message().c_str());
+        co_return;
+    }
+
+    co_await server.run(plaintext);
+}
+
+static auto client(const inet_address &address,
+                   std::size_t         pipeline,
+                   benchmark_state    &state) noexcept -> future<> {
+    tcp_stream stream;
+    if (co_await stream.connect_async(address) != std::error_code()) {
+        state.errors.fetch_add(1, std::memory_order_relaxed);
+        co_return;
+    }
+
+    stream.set_no_delay(true);
+
+    std::string requests;
+    for (std::size_t i = 0; i < pipeline; ++i)
+        requests.append(request);
+
+    std::size_t batch_size = expected_response.size() * pipeline;
+    std::string buffer(batch_size, '\0');
+
+    while (!state.stop.load(std::memory_order_relaxed)) {
+        auto sent = co_await stream.send_async(requests.data(),
+                                               static_cast<std::uint32_t>(requests.size()));
+        if (!sent.has_value() || *sent != requests.size()) [[unlikely]]
+            break;
+
+        std::size_t received = 0;
+        while (received < batch_size) {
+            auto result = co_await stream.receive_async(
+                buffer.data() + received, static_cast<std::uint32_t>(batch_size - received));
+            if (!result.has_value() || *result == 0) [[unlikely]] {
+                state.errors.fetch_add(1, std::memory_order_relaxed);
+                co_return;
+            }
+            received += *result;
+        }
+
+        state.responses.fetch_add(pipeline, std::memory_order_relaxed);
+    }
+}
+
+static auto spawn_clients(const inet_address &address,
+                          std::size_t        &connections,
+                          std::size_t        &pipeline,
+                          benchmark_state    &state) noexcept -> future<> {
+    for (std::size_t i = 0; i < connections; ++i)
+        schedule(client(address, pipeline, state));
+    co_return;
+}
+
+/// \brief
+///   Parse a positive integer from command line argument.
+/// \param argc
+///   Number of command line arguments.
+/// \param argv
+///   Command line arguments.
+/// \param index
+///   Index of the argument to parse.
+/// \param fallback
+///   Value to use if the argument is absent or invalid.
+/// \return
+///   The parsed value.
+static auto parse_argument(int argc, char **argv, int index, std::size_t fallback) -> std::size_t {
+    if (index >= argc)
+        return fallback;
+
+    std::size_t value = 0;
+    auto [ptr, ec]    = std::from_chars(argv[index], argv[index] + std::strlen(argv[index]), value);
+    return (ec == std::errc() && value != 0) ? value : fallback;
+}
+
+/// \brief
+///   wrk-style HTTP/1.1 requests/sec benchmark over loopback.
+///
+///   Usage: ossia-bench-http_server [connections] [pipeline] [seconds] [threads]
+auto main(int argc, char **argv) -> int {
+    std::size_t connections = parse_argument(argc, argv, 1, 256);
+    std::size_t pipeline    = parse_argument(argc, argv, 2, 16);
+    std::size_t seconds     = parse_argument(argc, argv, 3, 10);
+    std::size_t threads     = parse_argument(argc, argv, 4, 2);
+
+    inet_address    address(ipv4_loopback, 28080);
+    benchmark_state state{};
+
+    io_context server_context(threads);
+    io_context client_context(threads);
+
+    std::size_t per_worker = (connections + threads - 1) / threads;
+
+    server_context.dispatch(listener, address);
+    std::thread server_thread([&server_context] { server_context.run(); });
+
+    // Give listeners some time to bind.
+    std::this_thread::sleep_for(100ms);
+
+    client_context.dispatch(spawn_clients, address, per_worker, pipeline, state);
+    std::thread client_thread([&client_context] { client_context.run(); });
+
+    std::printf("Running %zus test @ http://127.0.0.1:%u/plaintext\n", seconds, address.port());
+    std::printf("  %zu threads and %zu connections, pipeline depth %zu\n", threads,
+                per_worker * threads, pipeline);
+
+    // Warm up before measuring.
+    std::this_thread::sleep_for(1s);
+
+    auto start_count = state.responses.load(std::memory_order_relaxed);
+    auto start_time  = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    auto end_count = state.responses.load(std::memory_order_relaxed);
+    auto end_time  = std::chrono::steady_clock::now();
+
+    state.stop.store(true, std::memory_order_relaxed);
+    client_context.stop();
+    server_context.stop();
+    client_thread.join();
+    server_thread.join();
+
+    auto   elapsed   = std::chrono::duration<double>(end_time - start_time).count();
+    auto   count     = static_cast<double>(end_count - start_count);
+    double megabytes = count * static_cast<double>(expected_response.size()) / 1048576.0;
+
+    std::printf("  %.0f requests in %.2fs, %.2fMB read\n", count, elapsed, megabytes);
+    std::printf("  Socket errors: %llu\n",
+                static_cast<unsigned long long>(state.errors.load(std::memory_order_relaxed)));
+    std::printf("Requests/sec: %.2f\n", count / elapsed);
+    std::printf("Transfer/sec: %.2fMB\n", megabytes / elapsed);
+
+    return 0;
+}
@@ -0,0 +1,1664 @@
+#include "ossia/tcp_server.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \brief
+///   Maximum length in byte of a key. Same as memcached.
+static constexpr std::size_t max_key_size = 250;
+
+/// \brief
+///   Maximum size in byte of a single value. Same as the default memcached item size limit.
+static constexpr std::size_t max_value_size = 1048576;
+
+/// \brief
+///   Maximum length in byte of a text protocol command line.
+static constexpr std::size_t max_line_size = 2048;
+
+/// \brief
+///   Maximum number of tokens in a text protocol command line.
+static constexpr std::size_t max_tokens = 64;
+
+/// \brief
+///   Relative expiration time larger than this value is treated as a UNIX timestamp.
+static constexpr std::int64_t max_relative_expiration = 60 * 60 * 24 * 30;
+
+/// \brief
+///   Magic byte of binary protocol requests.
+static constexpr std::uint8_t binary_request = 0x80;
+
+/// \brief
+///   Magic byte of binary protocol responses.
+static constexpr std::uint8_t binary_response = 0x81;
+
+/// \brief
+///   Size in byte of binary protocol headers.
+static constexpr std::size_t binary_header_size = 24;
+
+/// \brief
+///   Version string reported by this server.
+static constexpr std::string_view server_version = "1.6.0-ossia";
+
+/// \enum store_mode
+/// \brief
+///   Storage commands.
+enum class store_mode {
+    set,
+    add,
+    replace,
+    append,
+    prepend,
+    cas,
+};
+
+/// \enum store_result
+/// \brief
+///   Results of storage commands.
+enum class store_result {
+    stored,
+    not_stored,
+    exists,
+    not_found,
+};
+
+/// \enum arithmetic_result
+/// \brief
+///   Results of increment and decrement commands.
+enum class arithmetic_result {
+    ok,
+    not_found,
+    non_numeric,
+};
+
+/// \struct cache_item
+/// \brief
+///   A cached value. Items are linked in LRU order within their shard.
+struct cache_item {
+    std::string   key;
+    std::string   value;
+    std::uint32_t flags;
+    std::int64_t  expiration;
+    std::uint64_t cas;
+    cache_item   *prev;
+    cache_item   *next;
+};
+
+/// \brief
+///   Get current time in seconds of the monotonic clock. This is used for expiration.
+/// \return
+///   Seconds since an unspecified epoch.
+static auto monotonic_seconds() noexcept -> std::int64_t {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::seconds>(now).count();
+}
+
+/// \brief
+///   Convert a memcached expiration time to a monotonic deadline.
+/// \param expiration
+///   Expiration time from the client. 0 means never expire, values up to 30 days are relative
+///   and larger values are UNIX timestamps. Negative values expire immediately.
+/// \return
+///   Monotonic deadline in seconds. 0 means never expire.
+static auto to_deadline(std::int64_t expiration) noexcept -> std::int64_t {
+    if (expiration == 0)
+        return 0;
+    if (expiration < 0)
+        return 1;
+
+    if (expiration > max_relative_expiration) {
+        auto unix_now = std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+        expiration -= unix_now;
+        if (expiration <= 0)
+            return 1;
+    }
+
+    return monotonic_seconds() + expiration;
+}
+
+/// \class cache_shard
+/// \brief
+///   A partition of the cache. Each shard has its own lock, LRU list and memory budget.
+class cache_shard {
+public:
+    /// \brief
+    ///   Create an empty shard.
+    /// \param limit
+    ///   Memory budget in byte of keys and values in this shard.
+    explicit cache_shard(std::size_t limit) noexcept
+        : m_mutex(),
+          m_items(),
+          m_head(),
+          m_tail(),
+          m_size(),
+          m_limit(limit) {}
+
+    /// \brief
+    ///   Find an item and pass it to the visitor. The visitor is called with the shard lock held.
+    /// \param key
+    ///   Key of the item.
+    /// \param visitor
+    ///   Callable object that accepts a <tt>const cache_item &</tt>.
+    /// \retval true
+    ///   The item is found.
+    /// \retval false
+    ///   The item is not found or is expired.
+    template <class Visitor>
+    auto find(std::string_view key, Visitor &&visitor) -> bool {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        cache_item *item = this->lookup(key);
+        if (item == nullptr)
+            return false;
+
+        this->touch_lru(item);
+        visitor(*item);
+        return true;
+    }
+
+    /// \brief
+    ///   Store a value.
+    /// \param mode
+    ///   The storage command.
+    /// \param key
+    ///   Key of the item.
+    /// \param value
+    ///   The value to store, append or prepend.
+    /// \param flags
+    ///   Opaque client flags.
+    /// \param expiration
+    ///   Monotonic deadline in seconds. 0 means never expire.
+    /// \param cas
+    ///   Expected CAS value for \c store_mode::cas. Ignored for other modes.
+    /// \param next_cas
+    ///   CAS value to assign to the stored item.
+    /// \return
+    ///   Result of the storage command.
+    auto store(store_mode       mode,
+               std::string_view key,
+               std::string_view value,
+               std::uint32_t    flags,
+               std::int64_t     expiration,
+               std::uint64_t    cas,
+               std::uint64_t    next_cas) -> store_result {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        cache_item *item = this->lookup(key);
+        switch (mode) {
+        case store_mode::set:
+            break;
+
+        case store_mode::add:
+            if (item != nullptr) {
+                this->touch_lru(item);
+                return store_result::not_stored;
+            }
+            break;
+
+        case store_mode::replace:
+            if (item == nullptr)
+                return store_result::not_stored;
+            break;
+
+        case store_mode::append:
+        case store_mode::prepend:
+            if (item == nullptr)
+                return store_result::not_stored;
+
+            m_size -= item->value.size();
+            if (mode == store_mode::append)
+                item->value.append(value);
+            else
+                item->value.insert(0, value);
+            m_size    += item->value.size();
+            item->cas  = next_cas;
+            this->touch_lru(item);
+            this->evict();
+            return store_result::stored;
+
+        case store_mode::cas:
+            if (item == nullptr)
+                return store_result::not_found;
+            if (item->cas != cas)
+                return store_result::exists;
+            break;
+        }
+
+        if (item == nullptr) {
+            auto owned   = std::make_unique<cache_item>();
+            owned->key   = key;
+            item         = owned.get();
+            m_size      += item->key.size();
+            m_items.emplace(std::string_view(item->key), std::move(owned));
+            this->link(item);
+        } else {
+            m_size -= item->value.size();
+            this->touch_lru(item);
+        }
+
+        item->value.assign(value);
+        item->flags      = flags;
+        item->expiration = expiration;
+        item->cas        = next_cas;
+        m_size          += item->value.size();
+
+        this->evict();
+        return store_result::stored;
+    }
+
+    /// \brief
+    ///   Remove an item.
+    /// \param key
+    ///   Key of the item.
+    /// \retval true
+    ///   The item is removed.
+    /// \retval false
+    ///   The item is not found.
+    auto remove(std::string_view key) -> bool {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        cache_item *item = this->lookup(key);
+        if (item == nullptr)
+            return false;
+
+        this->erase(item);
+        return true;
+    }
+
+    /// \brief
+    ///   Increase or decrease a numeric value. Decrement saturates at 0 and increment wraps at
+    ///   64 bits, same as memcached.
+    /// \param key
+    ///   Key of the item.
+    /// \param delta
+    ///   The amount to add or subtract.
+    /// \param increase
+    ///   Whether to increase or decrease the value.
+    /// \param next_cas
+    ///   CAS value to assign to the updated item.
+    /// \param[out] result
+    ///   The new value.
+    /// \return
+    ///   Result of the arithmetic command.
+    auto arithmetic(std::string_view key,
+                    std::uint64_t    delta,
+                    bool             increase,
+                    std::uint64_t    next_cas,
+                    std::uint64_t   &result) -> arithmetic_result {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        cache_item *item = this->lookup(key);
+        if (item == nullptr)
+            return arithmetic_result::not_found;
+
+        std::uint64_t value = 0;
+        const char   *begin = item->value.data();
+        const char   *end   = begin + item->value.size();
+
+        auto [ptr, ec] = std::from_chars(begin, end, value);
+        if (ec != std::errc() || ptr != end)
+            return arithmetic_result::non_numeric;
+
+        if (increase)
+            value += delta;
+        else
+            value = (delta > value) ? 0 : value - delta;
+
+        char buffer[24];
+        auto [last, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+        m_size -= item->value.size();
+        item->value.assign(buffer, last);
+        m_size    += item->value.size();
+        item->cas  = next_cas;
+        this->touch_lru(item);
+
+        result = value;
+        return arithmetic_result::ok;
+    }
+
+    /// \brief
+    ///   Update expiration time of an item.
+    /// \param key
+    ///   Key of the item.
+    /// \param expiration
+    ///   New monotonic deadline in seconds. 0 means never expire.
+    /// \retval true
+    ///   The item is updated.
+    /// \retval false
+    ///   The item is not found.
+    auto touch(std::string_view key, std::int64_t expiration) -> bool {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        cache_item *item = this->lookup(key);
+        if (item == nullptr)
+            return false;
+
+        item->expiration = expiration;
+        this->touch_lru(item);
+        return true;
+    }
+
+    /// \brief
+    ///   Remove all items.
+    auto flush() -> void {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_items.clear();
+        m_head = nullptr;
+        m_tail = nullptr;
+        m_size = 0;
+    }
+
+private:
+    /// \brief
+    ///   Find an unexpired item. Expired items are removed lazily.
+    auto lookup(std::string_view key) -> cache_item * {
+        auto iter = m_items.find(key);
+        if (iter == m_items.end())
+            return nullptr;
+
+        cache_item *item = iter->second.get();
+        if (item->expiration != 0 && item->expiration <= monotonic_seconds()) {
+            this->erase(item);
+            return nullptr;
+        }
+
+        return item;
+    }
+
+    /// \brief
+    ///   Insert an item at the head of the LRU list.
+    auto link(cache_item *item) noexcept -> void {
+        item->prev = nullptr;
+        item->next = m_head;
+        if (m_head != nullptr)
+            m_head->prev = item;
+        m_head = item;
+        if (m_tail == nullptr)
+            m_tail = item;
+    }
+
+    /// \brief
+    ///   Remove an item from the LRU list.
+    auto unlink(cache_item *item) noexcept -> void {
+        if (item->prev != nullptr)
+            item->prev->next = item->next;
+        else
+            m_head = item->next;
+
+        if (item->next != nullptr)
+            item->next->prev = item->prev;
+        else
+            m_tail = item->prev;
+    }
+
+    /// \brief
+    ///   Move an item to the head of the LRU list.
+    auto touch_lru(cache_item *item) noexcept -> void {
+        if (item == m_head)
+            return;
+        this->unlink(item);
+        this->link(item);
+    }
+
+    /// \brief
+    ///   Remove an item from this shard.
+    auto erase(cache_item *item) -> void {
+        this->unlink(item);
+        m_size -= item->key.size() + item->value.size();
+        m_items.erase(std::string_view(item->key));
+    }
+
+    /// \brief
+    ///   Evict least recently used items until this shard fits in its memory budget.
+    auto evict() -> void {
+        while (m_size > m_limit && m_tail != nullptr && m_tail != m_head)
+            this->erase(m_tail);
+    }
+
+private:
+    std::mutex                                                     m_mutex;
+    std::unordered_map<std::string_view, std::unique_ptr<cache_item>> m_items;
+    cache_item                                                    *m_head;
+    cache_item                                                    *m_tail;
+    std::size_t                                                    m_size;
+    std::size_t                                                    m_limit;
+};
+
+/// \class cache
+/// \brief
+///   Sharded in-memory cache shared by all workers. The number of shards scales with the number
+///   of workers so that lock contention stays low.
+class cache {
+public:
+    /// \brief
+    ///   Create an empty cache.
+    /// \param workers
+    ///   Number of workers that access this cache.
+    /// \param limit
+    ///   Memory budget in byte of all keys and values.
+    cache(std::size_t workers, std::size_t limit)
+        : m_shards(std::bit_ceil(workers * 16)),
+          m_mask(m_shards.size() - 1),
+          m_cas(1) {
+        for (auto &shard : m_shards)
+            shard = std::make_unique<cache_shard>(limit / m_shards.size());
+    }
+
+    /// \brief
+    ///   Get the shard that the specified key belongs to.
+    auto shard(std::string_view key) noexcept -> cache_shard & {
+        return *m_shards[std::hash<std::string_view>{}(key) & m_mask];
+    }
+
+    /// \brief
+    ///   Generate a new CAS value.
+    auto next_cas() noexcept -> std::uint64_t {
+        return m_cas.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// \brief
+    ///   Remove all items.
+    auto flush() -> void {
+        for (auto &shard : m_shards)
+            shard->flush();
+    }
+
+private:
+    std::vector<std::unique_ptr<cache_shard>> m_shards;
+    std::size_t                               m_mask;
+    std::atomic_uint64_t                      m_cas;
+};
+
+/// \brief
+///   Parse an unsigned decimal integer.
+/// \param text
+///   The text to parse. The whole text must be a valid integer.
+/// \param[out] value
+///   The parsed integer.
+/// \retval true
+///   The text is a valid integer.
+/// \retval false
+///   The text is not a valid integer.
+template <class T>
+static auto parse_number(std::string_view text, T &value) noexcept -> bool {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && ec == std::errc() && ptr == text.data() + text.size();
+}
+
+/// \brief
+///   Append a decimal integer to the output buffer.
+static auto append_number(std::uint64_t value, std::string &output) -> void {
+    char buffer[24];
+    auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    output.append(buffer, ptr);
+}
+
+/// \brief
+///   Append a \c VALUE line and data block for a text protocol retrieval command.
+static auto write_value(const cache_item &item, bool with_cas, std::string &output) -> void {
+    output.append("VALUE ");
+    output.append(item.key);
+    output.push_back(' ');
+    append_number(item.flags, output);
+    output.push_back(' ');
+    append_number(item.value.size(), output);
+    if (with_cas) {
+        output.push_back(' ');
+        append_number(item.cas, output);
+    }
+    output.append("\r\n");
+    output.append(item.value);
+    output.append("\r\n");
+}
+
+/// \brief
+///   Handle a single text protocol command.
+/// \param data
+///   Received data that starts with a text protocol command.
+/// \param store
+///   The cache.
+/// \param[out] output
+///   Output buffer for responses.
+/// \param[out] close
+///   Set to \c true if the connection should be closed after sending the responses.
+/// \return
+///   Size in byte of the handled command. Return 0 if more data is required.
+static auto handle_text(std::string_view data, cache &store, std::string &output, bool &close)
+    -> std::size_t {
+    std::size_t newline = data.find('\n');
+    if (newline == std::string_view::npos) {
+        if (data.size() > max_line_size) {
+            output.append("CLIENT_ERROR line too long\r\n");
+            close = true;
+        }
+        return 0;
+    }
+
+    std::string_view line = data.substr(0, newline);
+    if (line.ends_with('\r'))
+        line.remove_suffix(1);
+
+    std::size_t consumed = newline + 1;
+
+    // Split the command line into tokens.
+    std::array<std::string_view, max_tokens> tokens;
+    std::size_t                              count = 0;
+    while (!line.empty()) {
+        std::size_t begin = line.find_first_not_of(' ');
+        if (begin == std::string_view::npos)
+            break;
+        line.remove_prefix(begin);
+
+        std::size_t end = std::min(line.find(' '), line.size());
+        if (count == max_tokens) {
+            output.append("CLIENT_ERROR too many tokens\r\n");
+            return consumed;
+        }
+
+        tokens[count++] = line.substr(0, end);
+        line.remove_prefix(end);
+    }
+
+    if (count == 0) {
+        output.append("ERROR\r\n");
+        return consumed;
+    }
+
+    std::string_view command = tokens[0];
+    bool noreply = (count > 1 && tokens[count - 1] == "noreply");
+
+    // Retrieval commands.
+    if (command == "get" || command == "gets") {
+        bool with_cas = (command == "gets");
+        for (std::size_t i = 1; i < count; ++i) {
+            store.shard(tokens[i]).find(tokens[i], [&](const cache_item &item) {
+                write_value(item, with_cas, output);
+            });
+        }
+
+        output.append("END\r\n");
+        return consumed;
+    }
+
+    // Storage commands.
+    store_mode mode     = store_mode::set;
+    bool       is_store = true;
+    if (command == "set")
+        mode = store_mode::set;
+    else if (command == "add")
+        mode = store_mode::add;
+    else if (command == "replace")
+        mode = store_mode::replace;
+    else if (command == "append")
+        mode = store_mode::append;
+    else if (command == "prepend")
+        mode = store_mode::prepend;
+    else if (command == "cas")
+        mode = store_mode::cas;
+    else
+        is_store = false;
+
+    if (is_store) {
+        std::size_t expected = (mode == store_mode::cas) ? 6 : 5;
+        std::size_t   size       = 0;
+        std::uint32_t flags      = 0;
+        std::int64_t  expiration = 0;
+        std::uint64_t cas        = 0;
+
+        if (count < expected || count > expected + 1 || tokens[1].size() > max_key_size ||
+            !parse_number(tokens[2], flags) || !parse_number(tokens[3], expiration) ||
+            !parse_number(tokens[4], size) ||
+            (mode == store_mode::cas && !parse_number(tokens[5], cas))) {
+            output.append("CLIENT_ERROR bad command line format\r\n");
+            close = true;
+            return consumed;
+        }
+
+        if (size > max_value_size) {
+            output.append("SERVER_ERROR object too large for cache\r\n");
+            close = true;
+            return consumed;
+        }
+
+        if (data.size() < consumed + size + 2)
+            return 0;
+
+        std::string_view value = data.substr(consumed, size);
+        if (data[consumed + size] != '\r' || data[consumed + size + 1] != '\n') {
+            output.append("CLIENT_ERROR bad data chunk\r\n");
+            close = true;
+            return consumed;
+        }
+
+        consumed += size + 2;
+
+        std::string_view key    = tokens[1];
+        auto             result = store.shard(key).store(mode, key, value, flags,
+                                                         to_deadline(expiration), cas,
+                                                         store.next_cas());
+
+        if (noreply)
+            return consumed;
+
+        switch (result) {
+        case store_result::stored:
+            output.append("STORED\r\n");
+            break;
+        case store_result::not_stored:
+            output.append("NOT_STORED\r\n");
+            break;
+        case store_result::exists:
+            output.append("EXISTS\r\n");
+            break;
+        case store_result::not_found:
+            output.append("NOT_FOUND\r\n");
+            break;
+        }
+
+        return consumed;
+    }
+
+    if (command == "delete" && count >= 2 && count <= 3) {
+        bool removed = store.shard(tokens[1]).remove(tokens[1]);
+        if (!noreply)
+            output.append(removed ? "DELETED\r\n" : "NOT_FOUND\r\n");
+        return consumed;
+    }
+
+    if ((command == "incr" || command == "decr") && count >= 3 && count <= 4) {
+        std::uint64_t delta;
+        if (!parse_number(tokens[2], delta)) {
+            output.append("CLIENT_ERROR invalid numeric delta argument\r\n");
+            return consumed;
+        }
+
+        std::uint64_t value  = 0;
+        auto          result = store.shard(tokens[1]).arithmetic(tokens[1], delta,
+                                                                 command == "incr",
+                                                                 store.next_cas(), value);
+        if (noreply)
+            return consumed;
+
+        if (result == arithmetic_result::ok) {
+            append_number(value, output);
+            output.append("\r\n");
+        } else if (result == arithmetic_result::not_found) {
+            output.append("NOT_FOUND\r\n");
+        } else {
+            output.append("CLIENT_ERROR cannot increment or decrement non-numeric value\r\n");
+        }
+
+        return consumed;
+    }
+
+    if (command == "touch" && count >= 3 && count <= 4) {
+        std::int64_t expiration;
+        if (!parse_number(tokens[2], expiration)) {
+            output.append("CLIENT_ERROR invalid exptime argument\r\n");
+            return consumed;
+        }
+
+        bool touched = store.shard(tokens[1]).touch(tokens[1], to_deadline(expiration));
+        if (!noreply)
+            output.append(touched ? "TOUCHED\r\n" : "NOT_FOUND\r\n");
+        return consumed;
+    }
+
+    if (command == "flush_all") {
+        store.flush();
+        if (!noreply)
+            output.append("OK\r\n");
+        return consumed;
+    }
+
+    if (command == "version") {
+        output.append("VERSION ");
+        output.append(server_version);
+        output.append("\r\n");
+        return consumed;
+    }
+
+    if (command == "quit") {
+        close = true;
+        return consumed;
+    }
+
+    output.append("ERROR\r\n");
+    return consumed;
+}
+
+/// \brief
+///   Binary protocol opcodes supported by this server.
+namespace binary_opcode {
+static constexpr std::uint8_t get       = 0x00;
+static constexpr std::uint8_t set       = 0x01;
+static constexpr std::uint8_t add       = 0x02;
+static constexpr std::uint8_t replace   = 0x03;
+static constexpr std::uint8_t remove    = 0x04;
+static constexpr std::uint8_t increment = 0x05;
+static constexpr std::uint8_t decrement = 0x06;
+static constexpr std::uint8_t quit      = 0x07;
+static constexpr std::uint8_t flush     = 0x08;
+static constexpr std::uint8_t getq      = 0x09;
+static constexpr std::uint8_t noop      = 0x0a;
+static constexpr std::uint8_t version   = 0x0b;
+static constexpr std::uint8_t getk      = 0x0c;
+static constexpr std::uint8_t getkq     = 0x0d;
+static constexpr std::uint8_t append    = 0x0e;
+static constexpr std::uint8_t prepend   = 0x0f;
+} // namespace binary_opcode
+
+/// \brief
+///   Binary protocol response status codes.
+namespace binary_status {
+static constexpr std::uint16_t ok              = 0x0000;
+static constexpr std::uint16_t not_found       = 0x0001;
+static constexpr std::uint16_t exists          = 0x0002;
+static constexpr std::uint16_t too_large       = 0x0003;
+static constexpr std::uint16_t invalid         = 0x0004;
+static constexpr std::uint16_t not_stored      = 0x0005;
+static constexpr std::uint16_t non_numeric     = 0x0006;
+static constexpr std::uint16_t unknown_command = 0x0081;
+} // namespace binary_status
+
+/// \brief
+///   Read a big-endian integer.
+template <class T>
+static auto load_big_endian(const char *data) noexcept -> T {
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        value = static_cast<T>((value << 8) | static_cast<std::uint8_t>(data[i]));
+    return value;
+}
+
+/// \brief
+///   Append a big-endian integer to the output buffer.
+template <class T>
+static auto store_big_endian(T value, std::string &output) -> void {
+    for (std::size_t i = sizeof(T); i > 0; --i)
+        output.push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xff));
+}
+
+/// \brief
+///   Append a binary protocol response.
+/// \param opcode
+///   Opcode of the request.
+/// \param status
+///   Response status.
+/// \param opaque
+///   Opaque value copied from the request.
+/// \param cas
+///   CAS value of the item.
+/// \param extras
+///   Extras of the response.
+/// \param key
+///   Key of the response.
+/// \param value
+///   Value of the response.
+/// \param[out] output
+///   The output buffer.
+static auto write_binary(std::uint8_t     opcode,
+                         std::uint16_t    status,
+                         std::uint32_t    opaque,
+                         std::uint64_t    cas,
+                         std::string_view extras,
+                         std::string_view key,
+                         std::string_view value,
+                         std::string     &output) -> void {
+    output.push_back(static_cast<char>(binary_response));
+    output.push_back(static_cast<char>(opcode));
+    store_big_endian(static_cast<std::uint16_t>(key.size()), output);
+    output.push_back(static_cast<char>(extras.size()));
+    output.push_back('\0');
+    store_big_endian(status, output);
+    store_big_endian(static_cast<std::uint32_t>(extras.size() + key.size() + value.size()),
+                     output);
+    output.append(reinterpret_cast<const char *>(&opaque), sizeof(opaque));
+    store_big_endian(cas, output);
+    output.append(extras);
+    output.append(key);
+    output.append(value);
+}
+
+/// \brief
+///   Handle a single binary protocol request.
+/// \param data
+///   Received data that starts with a binary protocol request.
+/// \param store
+///   The cache.
+/// \param[out] output
+///   Output buffer for responses.
+/// \param[out] close
+///   Set to \c true if the connection should be closed after sending the responses.
+/// \return
+///   Size in byte of the handled request. Return 0 if more data is required.
+static auto handle_binary(std::string_view data, cache &store, std::string &output, bool &close)
+    -> std::size_t {
+    if (data.size() < binary_header_size)
+        return 0;
+
+    const char   *header     = data.data();
+    auto          opcode     = static_cast<std::uint8_t>(header[1]);
+    auto          key_size   = load_big_endian<std::uint16_t>(header + 2);
+    auto          extra_size = static_cast<std::uint8_t>(header[4]);
+    auto          body_size  = load_big_endian<std::uint32_t>(header + 8);
+    std::uint32_t opaque;
+    std::memcpy(&opaque, header + 12, sizeof(opaque));
+    auto cas = load_big_endian<std::uint64_t>(header + 16);
+
+    if (body_size > max_value_size + 512 || key_size > max_key_size ||
+        std::size_t{key_size} + extra_size > body_size) {
+        write_binary(opcode, binary_status::invalid, opaque, 0, {}, {}, "Invalid arguments",
+                     output);
+        close = true;
+        return data.size();
+    }
+
+    if (data.size() < binary_header_size + body_size)
+        return 0;
+
+    std::size_t      consumed = binary_header_size + body_size;
+    std::string_view extras   = data.substr(binary_header_size, extra_size);
+    std::string_view key      = data.substr(binary_header_size + extra_size, key_size);
+    std::string_view value    = data.substr(binary_header_size + extra_size + key_size,
+                                            body_size - extra_size - key_size);
+
+    switch (opcode) {
+    case binary_opcode::get:
+    case binary_opcode::getq:
+    case binary_opcode::getk:
+    case binary_opcode::getkq: {
+        bool with_key = (opcode == binary_opcode::getk || opcode == binary_opcode::getkq);
+        bool quiet    = (opcode == binary_opcode::getq || opcode == binary_opcode::getkq);
+
+        bool found = store.shard(key).find(key, [&](const cache_item &item) {
+            std::string flags;
+            store_big_endian(item.flags, flags);
+            write_binary(opcode, binary_status::ok, opaque, item.cas, flags,
+                         with_key ? key : std::string_view(), item.value, output);
+        });
+
+        if (!found && !quiet)
+            write_binary(opcode, binary_status::not_found, opaque, 0, {},
+                         with_key ? key : std::string_view(), "Not found", output);
+        return consumed;
+    }
+
+    case binary_opcode::set:
+    case binary_opcode::add:
+    case binary_opcode::replace:
+    case binary_opcode::append:
+    case binary_opcode::prepend: {
+        bool has_extras = (opcode != binary_opcode::append && opcode != binary_opcode::prepend);
+        if ((has_extras && extras.size() != 8) || (!has_extras && !extras.empty()) || key.empty()) {
+            write_binary(opcode, binary_status::invalid, opaque, 0, {}, {}, "Invalid arguments",
+                         output);
+            return consumed;
+        }
+
+        std::uint32_t flags      = has_extras ? load_big_endian<std::uint32_t>(extras.data()) : 0;
+        std::int64_t  expiration = 0;
+        if (has_extras) {
+            auto raw   = load_big_endian<std::uint32_t>(extras.data() + 4);
+            expiration = static_cast<std::int32_t>(raw);
+        }
+
+        store_mode mode = store_mode::set;
+        if (opcode == binary_opcode::add)
+            mode = store_mode::add;
+        else if (opcode == binary_opcode::replace)
+            mode = store_mode::replace;
+        else if (opcode == binary_opcode::append)
+            mode = store_mode::append;
+        else if (opcode == binary_opcode::prepend)
+            mode = store_mode::prepend;
+        else if (cas != 0)
+            mode = store_mode::cas;
+
+        std::uint64_t next_cas = store.next_cas();
+        auto result = store.shard(key).store(mode, key, value, flags, to_deadline(expiration), cas,
+                                             next_cas);
+
+        switch (result) {
+        case store_result::stored:
+            write_binary(opcode, binary_status::ok, opaque, next_cas, {}, {}, {}, output);
+            break;
+        case store_result::not_stored:
+            write_binary(opcode,
+                         mode == store_mode::add ? binary_status::exists
+                                                 : binary_status::not_found,
+                         opaque, 0, {}, {}, "Not stored", output);
+            break;
+        case store_result::exists:
+            write_binary(opcode, binary_status::exists, opaque, 0, {}, {}, "Data exists",
+                         output);
+            break;
+        case store_result::not_found:
+            write_binary(opcode, binary_status::not_found, opaque, 0, {}, {}, "Not found",
+                         output);
+            break;
+        }
+
+        return consumed;
+    }
+
+    case binary_opcode::remove: {
+        bool removed = store.shard(key).remove(key);
+        write_binary(opcode, removed ? binary_status::ok : binary_status::not_found, opaque, 0,
+                     {}, {}, removed ? std::string_view() : "Not found", output);
+        return consumed;
+    }
+
+    case binary_opcode::increment:
+    case binary_opcode::decrement: {
+        if (extras.size() != 20 || key.empty()) {
+            write_binary(opcode, binary_status::invalid, opaque, 0, {}, {}, "Invalid arguments",
+                         output);
+            return consumed;
+        }
+
+        auto delta      = load_big_endian<std::uint64_t>(extras.data());
+        auto initial    = load_big_endian<std::uint64_t>(extras.data() + 8);
+        auto expiration = load_big_endian<std::uint32_t>(extras.data() + 16);
+
+        cache_shard  &shard    = store.shard(key);
+        std::uint64_t next_cas = store.next_cas();
+        std::uint64_t result   = 0;
+
+        auto status = shard.arithmetic(key, delta, opcode == binary_opcode::increment, next_cas,
+                                       result);
+
+        // Create the counter with the initial value unless expiration is all ones.
+        if (status == arithmetic_result::not_found && expiration != 0xffffffff) {
+            std::string text;
+            append_number(initial, text);
+            shard.store(store_mode::add, key, text, 0,
+                        to_deadline(static_cast<std::int32_t>(expiration)), 0, next_cas);
+            status = arithmetic_result::ok;
+            result = initial;
+        }
+
+        if (status == arithmetic_result::ok) {
+            std::string body;
+            store_big_endian(result, body);
+            write_binary(opcode, binary_status::ok, opaque, next_cas, {}, {}, body, output);
+        } else if (status == arithmetic_result::not_found) {
+            write_binary(opcode, binary_status::not_found, opaque, 0, {}, {}, "Not found",
+                         output);
+        } else {
+            write_binary(opcode, binary_status::non_numeric, opaque, 0, {}, {},
+                         "Non-numeric server-side value for incr or decr", output);
+        }
+
+        return consumed;
+    }
+
+    case binary_opcode::quit:
+        write_binary(opcode, binary_status::ok, opaque, 0, {}, {}, {}, output);
+        close = true;
+        return consumed;
+
+    case binary_opcode::flush:
+        store.flush();
+        write_binary(opcode, binary_status::ok, opaque, 0, {}, {}, {}, output);
+        return consumed;
+
+    case binary_opcode::noop:
+        write_binary(opcode, binary_status::ok, opaque, 0, {}, {}, {}, output);
+        return consumed;
+
+    case binary_opcode::version:
+        write_binary(opcode, binary_status::ok, opaque, 0, {}, {}, server_version, output);
+        return consumed;
+
+    default:
+        write_binary(opcode, binary_status::unknown_command, opaque, 0, {}, {},
+                     "Unknown command", output);
+        return consumed;
+    }
+}
+
+/// \brief
+///   Serve a single client connection. Text and binary protocol requests are detected by the
+///   first byte of each request. Responses to pipelined requests are sent together.
+static auto serve(tcp_stream stream, cache &store) noexcept -> future<> {
+    std::string input;
+    std::string output;
+    bool        close = false;
+
+    while (!close) {
+        std::size_t size = input.size();
+        input.resize(size + 16384);
+
+        auto received = co_await stream.receive_async(input.data() + size, 16384);
+        if (!received.has_value() || *received == 0)
+            co_return;
+
+        input.resize(size + *received);
+
+        std::size_t consumed = 0;
+        while (consumed < input.size() && !close) {
+            std::string_view data = std::string_view(input).substr(consumed);
+
+            std::size_t handled;
+            if (static_cast<std::uint8_t>(data[0]) == binary_request)
+                handled = handle_binary(data, store, output, close);
+            else
+                handled = handle_text(data, store, output, close);
+
+            if (handled == 0)
+                break;
+            consumed += handled;
+        }
+
+        input.erase(0, consumed);
+
+        std::size_t sent = 0;
+        while (sent < output.size()) {
+            auto result = co_await stream.send_async(
+                output.data() + sent, static_cast<std::uint32_t>(output.size() - sent));
+            if (!result.has_value()) [[unlikely]]
+                co_return;
+            sent += *result;
+        }
+
+        output.clear();
+    }
+}
+
+/// \brief
+///   Accept connections on a per-worker \c SO_REUSEPORT listener.
+static auto listener(const inet_address &address, cache &store) noexcept -> future<> {
+    tcp_server server;
+    if (auto error = server.bind(address); error.value() != 0) {
+        std::fprintf(stderr, "Failed to bind: %s\n", error.message().c_str());
+        co_return;
+    }
+
+    while (true) {
+        auto stream = co_await server.accept_async<no_delay_tcp_policy>();
+        if (!stream.has_value()) [[unlikely]] {
+            if (stream.error() == std::errc::connection_aborted)
+                continue;
+            co_return;
+        }
+
+        schedule(serve(std::move(stream->base()), store));
+    }
+}
+
+/// \struct load_profile
+/// \brief
+///   Bundled load profile modeled after a read-heavy production cache: a Zipf-distributed key
+///   space, mostly small values with a long tail, and a mix of single gets, multi-gets and sets.
+struct load_profile {
+    /// \brief
+    ///   Number of distinct keys.
+    static constexpr std::size_t keys = 100000;
+
+    /// \brief
+    ///   Zipf exponent of key popularity.
+    static constexpr double skew = 0.99;
+
+    /// \brief
+    ///   Percentage of single-key gets.
+    static constexpr std::uint32_t get_percent = 85;
+
+    /// \brief
+    ///   Percentage of multi-key gets. The rest are sets.
+    static constexpr std::uint32_t multi_get_percent = 5;
+
+    /// \brief
+    ///   Number of keys in each multi-key get.
+    static constexpr std::size_t multi_get_keys = 4;
+
+    /// \brief
+    ///   Value sizes and their cumulative percentages.
+    static constexpr std::array<std::pair<std::size_t, std::uint32_t>, 4> value_sizes{{
+        {32, 50},
+        {256, 80},
+        {1024, 95},
+        {4096, 100},
+    }};
+};
+
+/// \class key_sampler
+/// \brief
+///   Samples key indices from a Zipf distribution with a precomputed CDF.
+class key_sampler {
+public:
+    key_sampler() : m_cdf(load_profile::keys) {
+        double sum = 0;
+        for (std::size_t i = 0; i < load_profile::keys; ++i) {
+            sum      += 1.0 / std::pow(static_cast<double>(i + 1), load_profile::skew);
+            m_cdf[i]  = sum;
+        }
+
+        for (double &value : m_cdf)
+            value /= sum;
+    }
+
+    /// \brief
+    ///   Sample a key index.
+    template <class Random>
+    auto operator()(Random &random) const -> std::size_t {
+        double u    = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+        auto   iter = std::lower_bound(m_cdf.begin(), m_cdf.end(), u);
+        return std::min<std::size_t>(static_cast<std::size_t>(iter - m_cdf.begin()),
+                                     load_profile::keys - 1);
+    }
+
+private:
+    std::vector<double> m_cdf;
+};
+
+/// \brief
+///   Latency histogram with 1 microsecond resolution up to 100 milliseconds.
+using latency_histogram = std::array<std::uint64_t, 100001>;
+
+/// \struct benchmark_state
+/// \brief
+///   Shared state between benchmark clients and the main thread.
+struct benchmark_state {
+    std::atomic_bool     stop;
+    std::atomic_bool     measuring;
+    std::atomic_uint64_t operations;
+    std::atomic_uint64_t hits;
+    std::atomic_uint64_t misses;
+    std::atomic_uint64_t errors;
+    std::atomic_size_t   prefilled;
+    std::atomic_size_t   next_index;
+
+    key_sampler                    sampler;
+    std::vector<latency_histogram> histograms;
+};
+
+/// \brief
+///   Format key of the specified index.
+static auto make_key(std::size_t index, char (&buffer)[16]) noexcept -> std::string_view {
+    std::memcpy(buffer, "key:", 4);
+    auto [ptr, ec] = std::to_chars(buffer + 4, buffer + sizeof(buffer), index);
+    return std::string_view(buffer, static_cast<std::size_t>(ptr - buffer));
+}
+
+/// \brief
+///   Pick a value size from the load profile.
+template <class Random>
+static auto value_size(Random &random) -> std::size_t {
+    auto percent = static_cast<std::uint32_t>(random() % 100);
+    for (auto [size, cumulative] : load_profile::value_sizes) {
+        if (percent < cumulative)
+            return size;
+    }
+    return load_profile::value_sizes.back().first;
+}
+
+/// \class load_client
+/// \brief
+///   A benchmark connection that speaks either the text or the binary protocol and counts the
+///   expected responses of each pipelined batch.
+class load_client {
+public:
+    load_client(bool binary, std::size_t index) noexcept
+        : m_stream(),
+          m_binary(binary),
+          m_random(static_cast<std::uint32_t>(index * 2654435761u + 1)),
+          m_value(4096, 'v'),
+          m_output(),
+          m_input(),
+          m_expected(),
+          m_hits(),
+          m_misses(),
+          m_group_hits(),
+          m_groups() {}
+
+    auto connect_async(const inet_address &address) noexcept -> future<std::error_code> {
+        auto error = co_await m_stream.connect_async(address);
+        if (!error)
+            m_stream.set_no_delay(true);
+        co_return error;
+    }
+
+    /// \brief
+    ///   Queue a set request.
+    auto queue_set(std::size_t index, std::size_t size) -> void {
+        char             buffer[16];
+        std::string_view key   = make_key(index, buffer);
+        std::string_view value = std::string_view(m_value).substr(0, size);
+
+        if (m_binary) {
+            char extras[8]{};
+            write_binary_request(binary_opcode::set, std::string_view(extras, 8), key, value);
+        } else {
+            m_output.append("set ");
+            m_output.append(key);
+            m_output.append(" 0 0 ");
+            append_number(size, m_output);
+            m_output.append("\r\n");
+            m_output.append(value);
+            m_output.append("\r\n");
+        }
+
+        m_expected += 1;
+    }
+
+    /// \brief
+    ///   Queue a get request for the specified keys.
+    auto queue_get(std::span<const std::size_t> indices) -> void {
+        char buffer[16];
+        if (m_binary) {
+            // Quiet gets followed by a loud get, as binary clients do for multi-gets.
+            for (std::size_t i = 0; i < indices.size(); ++i) {
+                bool last = (i + 1 == indices.size());
+                write_binary_request(last ? binary_opcode::getk : binary_opcode::getkq, {},
+                                     make_key(indices[i], buffer), {});
+            }
+        } else {
+            m_output.append("get");
+            for (std::size_t index : indices) {
+                m_output.push_back(' ');
+                m_output.append(make_key(index, buffer));
+            }
+            m_output.append("\r\n");
+        }
+
+        m_groups.push_back(indices.size());
+        m_expected += 1;
+    }
+
+    /// \brief
+    ///   Send queued requests and wait for all responses.
+    /// \retval true
+    ///   All responses are received.
+    /// \retval false
+    ///   Any error occurred.
+    auto round_trip() noexcept -> future<bool> {
+        std::size_t sent = 0;
+        while (sent < m_output.size()) {
+            auto result = co_await m_stream.send_async(
+                m_output.data() + sent, static_cast<std::uint32_t>(m_output.size() - sent));
+            if (!result.has_value()) [[unlikely]]
+                co_return false;
+            sent += *result;
+        }
+
+        m_output.clear();
+        while (m_expected != 0) {
+            std::size_t size = m_input.size();
+            m_input.resize(size + 65536);
+
+            auto result = co_await m_stream.receive_async(m_input.data() + size, 65536);
+            if (!result.has_value() || *result == 0) [[unlikely]]
+                co_return false;
+
+            m_input.resize(size + *result);
+            if (!this->consume()) [[unlikely]]
+                co_return false;
+        }
+
+        co_return true;
+    }
+
+    auto random() noexcept -> std::minstd_rand & {
+        return m_random;
+    }
+
+    auto take_hits() noexcept -> std::uint64_t {
+        return std::exchange(m_hits, 0);
+    }
+
+    auto take_misses() noexcept -> std::uint64_t {
+        return std::exchange(m_misses, 0);
+    }
+
+private:
+    auto write_binary_request(std::uint8_t     opcode,
+                              std::string_view extras,
+                              std::string_view key,
+                              std::string_view value) -> void {
+        m_output.push_back(static_cast<char>(binary_request));
+        m_output.push_back(static_cast<char>(opcode));
+        store_big_endian(static_cast<std::uint16_t>(key.size()), m_output);
+        m_output.push_back(static_cast<char>(extras.size()));
+        m_output.append(3, '\0');
+        store_big_endian(static_cast<std::uint32_t>(extras.size() + key.size() + value.size()),
+                         m_output);
+        m_output.append(12, '\0');
+        m_output.append(extras);
+        m_output.append(key);
+        m_output.append(value);
+    }
+
+    /// \brief
+    ///   Consume complete responses from the input buffer.
+    auto consume() -> bool {
+        std::string_view data     = m_input;
+        std::size_t      consumed = 0;
+
+        while (m_expected != 0) {
+            std::string_view rest = data.substr(consumed);
+            if (m_binary) {
+                if (rest.size() < binary_header_size)
+                    break;
+
+                auto body_size = load_big_endian<std::uint32_t>(rest.data() + 8);
+                if (rest.size() < binary_header_size + body_size)
+                    break;
+
+                auto opcode = static_cast<std::uint8_t>(rest[1]);
+                auto status = load_big_endian<std::uint16_t>(rest.data() + 6);
+                if (static_cast<std::uint8_t>(rest[0]) != binary_response)
+                    return false;
+
+                consumed += binary_header_size + body_size;
+                if (opcode == binary_opcode::getkq) {
+                    // Quiet gets are answered only on hits and are followed by a loud get.
+                    m_group_hits += 1;
+                    continue;
+                }
+
+                if (opcode == binary_opcode::getk) {
+                    m_group_hits += (status == binary_status::ok);
+                    this->finish_get();
+                } else if (status != binary_status::ok) {
+                    return false;
+                }
+
+                --m_expected;
+            } else {
+                std::size_t newline = rest.find("\r\n");
+                if (newline == std::string_view::npos)
+                    break;
+
+                std::string_view line = rest.substr(0, newline);
+                if (line.starts_with("VALUE ")) {
+                    std::size_t size = 0;
+                    if (!parse_number(line.substr(line.rfind(' ') + 1), size))
+                        return false;
+                    if (rest.size() < newline + 2 + size + 2)
+                        break;
+
+                    consumed     += newline + 2 + size + 2;
+                    m_group_hits += 1;
+                    continue;
+                }
+
+                if (line == "END")
+                    this->finish_get();
+                else if (line != "STORED")
+                    return false;
+
+                consumed += newline + 2;
+                --m_expected;
+            }
+        }
+
+        m_input.erase(0, consumed);
+        return true;
+    }
+
+    /// \brief
+    ///   Account hits and misses of the oldest get request. Every key that is not returned is a
+    ///   miss.
+    auto finish_get() -> void {
+        m_hits       += m_group_hits;
+        m_misses     += m_groups.front() - m_group_hits;
+        m_group_hits  = 0;
+        m_groups.pop_front();
+    }
+
+private:
+    tcp_stream               m_stream;
+    bool                     m_binary;
+    std::minstd_rand         m_random;
+    std::string              m_value;
+    std::string              m_output;
+    std::string              m_input;
+    std::size_t              m_expected;
+    std::uint64_t            m_hits;
+    std::uint64_t            m_misses;
+    std::uint64_t            m_group_hits;
+    std::deque<std::size_t>  m_groups;
+};
+
+static auto client(const inet_address &address,
+                   std::size_t         index,
+                   std::size_t         connections,
+                   std::size_t         pipeline,
+                   benchmark_state    &state) noexcept -> future<> {
+    // One in four connections uses the binary protocol.
+    load_client connection(index % 4 == 3, index);
+    if (co_await connection.connect_async(address)) {
+        state.errors.fetch_add(1, std::memory_order_relaxed);
+        co_return;
+    }
+
+    // Prefill this connection's slice of the key space.
+    for (std::size_t key = index; key < load_profile::keys; key += connections) {
+        connection.queue_set(key, value_size(connection.random()));
+        bool last = (key + connections >= load_profile::keys);
+        if ((key / connections) % pipeline == pipeline - 1 || last) {
+            if (!co_await connection.round_trip()) {
+                state.errors.fetch_add(1, std::memory_order_relaxed);
+                co_return;
+            }
+        }
+    }
+
+    state.prefilled.fetch_add(1, std::memory_order_relaxed);
+
+    latency_histogram &histogram = state.histograms[index];
+    std::size_t        keys[load_profile::multi_get_keys];
+
+    while (!state.stop.load(std::memory_order_relaxed)) {
+        for (std::size_t i = 0; i < pipeline; ++i) {
+            auto percent = static_cast<std::uint32_t>(connection.random()() % 100);
+            if (percent < load_profile::get_percent) {
+                keys[0] = state.sampler(connection.random());
+                connection.queue_get(std::span<const std::size_t>(keys, 1));
+            } else if (percent < load_profile::get_percent + load_profile::multi_get_percent) {
+                for (std::size_t &key : keys)
+                    key = state.sampler(connection.random());
+                connection.queue_get(keys);
+            } else {
+                auto key = state.sampler(connection.random());
+                connection.queue_set(key, value_size(connection.random()));
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (!co_await connection.round_trip()) [[unlikely]] {
+            state.errors.fetch_add(1, std::memory_order_relaxed);
+            co_return;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        auto hits   = connection.take_hits();
+        auto misses = connection.take_misses();
+
+        if (state.measuring.load(std::memory_order_relaxed)) {
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+            auto bucket = std::min<std::size_t>(static_cast<std::size_t>(micros.count()),
+                                                histogram.size() - 1);
+            histogram[bucket] += 1;
+
+            state.operations.fetch_add(pipeline, std::memory_order_relaxed);
+            state.hits.fetch_add(hits, std::memory_order_relaxed);
+            state.misses.fetch_add(misses, std::memory_order_relaxed);
+        }
+    }
+}
+
+static auto spawn_clients(const inet_address &address,
+                          std::size_t        &count,
+                          std::size_t        &connections,
+                          std::size_t        &pipeline,
+                          benchmark_state    &state) noexcept -> future<> {
+    // Each worker gets its own slice of client indices.
+    auto first = state.next_index.fetch_add(count, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < count; ++i)
+        schedule(client(address, first + i, connections, pipeline, state));
+    co_return;
+}
+
+/// \brief
+///   Parse a positive integer from command line argument.
+/// \param argc
+///   Number of command line arguments.
+/// \param argv
+///   Command line arguments.
+/// \param index
+///   Index of the argument to parse.
+/// \param fallback
+///   Value to use if the argument is absent or invalid.
+/// \return
+///   The parsed value.
+static auto parse_argument(int argc, char **argv, int index, std::size_t fallback) -> std::size_t {
+    if (index >= argc)
+        return fallback;
+
+    std::size_t value = 0;
+    auto [ptr, ec]    = std::from_chars(argv[index], argv[index] + std::strlen(argv[index]), value);
+    return (ec == std::errc() && value != 0) ? value : fallback;
+}
+
+/// \brief
+///   Get the specified percentile from merged latency histograms.
+static auto percentile(const std::vector<latency_histogram> &histograms, double ratio)
+    -> std::size_t {
+    std::uint64_t total = 0;
+    for (const auto &histogram : histograms) {
+        for (auto count : histogram)
+            total += count;
+    }
+
+    auto          target = static_cast<std::uint64_t>(static_cast<double>(total) * ratio);
+    std::uint64_t seen   = 0;
+    for (std::size_t bucket = 0; bucket < histograms.front().size(); ++bucket) {
+        for (const auto &histogram : histograms)
+            seen += histogram[bucket];
+        if (seen > target)
+            return bucket;
+    }
+
+    return histograms.front().size() - 1;
+}
+
+/// \brief
+///   memcached-compatible cache server and end-to-end benchmark. Both the text and the binary
+///   protocols are supported, so standard memcached clients and load generators could be used
+///   against the server mode.
+///
+///   Usage:
+///     ossia-bench-memcached server [port] [threads] [memory MiB]
+///     ossia-bench-memcached [connections] [pipeline] [seconds] [threads]
+auto main(int argc, char **argv) -> int {
+    if (argc >= 2 && std::string_view(argv[1]) == "server") {
+        auto port    = static_cast<std::uint16_t>(parse_argument(argc, argv, 2, 11211));
+        auto threads = parse_argument(argc, argv, 3, std::thread::hardware_concurrency());
+        auto memory  = parse_argument(argc, argv, 4, 1024);
+
+        inet_address address(ipv4_any, port);
+        cache        store(threads, memory * 1048576);
+        io_context   context(threads);
+
+        std::printf("Listening on port %u with %zu threads and %zuMiB memory\n", port, threads,
+                    memory);
+        context.dispatch(listener, address, store);
+        context.run();
+        return 0;
+    }
+
+    std::size_t connections = parse_argument(argc, argv, 1, 256);
+    std::size_t pipeline    = parse_argument(argc, argv, 2, 8);
+    std::size_t seconds     = parse_argument(argc, argv, 3, 10);
+    std::size_t threads     = parse_argument(argc, argv, 4, 2);
+
+    inet_address address(ipv4_loopback, 28082);
+    cache        store(threads, 1024 * 1048576);
+
+    auto state = std::make_unique<benchmark_state>();
+
+    io_context server_context(threads);
+    io_context client_context(threads);
+
+    server_context.dispatch(listener, address, store);
+    std::thread server_thread([&server_context] { server_context.run(); });
+
+    // Give listeners some time to bind.
+    std::this_thread::sleep_for(100ms);
+
+    std::size_t per_worker = std::max<std::size_t>(1, connections / threads);
+    connections            = per_worker * threads;
+    state->histograms.resize(connections);
+
+    client_context.dispatch(spawn_clients, address, per_worker, connections, pipeline, *state);
+    std::thread client_thread([&client_context] { client_context.run(); });
+
+    std::printf("Running %zus test @ memcached://127.0.0.1:%u\n", seconds, address.port());
+    std::printf("  %zu threads and %zu connections, pipeline depth %zu\n", threads, connections,
+                pipeline);
+    std::printf("  Profile: %zu keys (zipf %.2f), %u%% get, %u%% multi-get x%zu, %u%% set\n",
+                load_profile::keys, load_profile::skew, load_profile::get_percent,
+                load_profile::multi_get_percent, load_profile::multi_get_keys,
+                100 - load_profile::get_percent - load_profile::multi_get_percent);
+
+    // Wait for prefill, then warm up before measuring.
+    while (state->prefilled.load(std::memory_order_relaxed) +
+               state->errors.load(std::memory_order_relaxed) <
+           connections)
+        std::this_thread::sleep_for(10ms);
+    std::this_thread::sleep_for(1s);
+
+    state->measuring.store(true, std::memory_order_relaxed);
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    state->measuring.store(false, std::memory_order_relaxed);
+    auto end_time = std::chrono::steady_clock::now();
+
+    state->stop.store(true, std::memory_order_relaxed);
+    client_context.stop();
+    server_context.stop();
+    client_thread.join();
+    server_thread.join();
+
+    auto elapsed = std::chrono::duration<double>(end_time - start_time).count();
+    auto count   = static_cast<double>(state->operations.load(std::memory_order_relaxed));
+    auto hits    = static_cast<double>(state->hits.load(std::memory_order_relaxed));
+    auto misses  = static_cast<double>(state->misses.load(std::memory_order_relaxed));
+
+    std::printf("  %.0f operations in %.2fs, hit rate %.2f%%\n", count, elapsed,
+                hits + misses == 0 ? 0.0 : hits * 100.0 / (hits + misses));
+    std::printf("  Batch latency p50 %zuus, p99 %zuus, p99.9 %zuus\n",
+                percentile(state->histograms, 0.5), percentile(state->histograms, 0.99),
+                percentile(state->histograms, 0.999));
+    std::printf("  Socket errors: %llu\n",
+                static_cast<unsigned long long>(state->errors.load(std::memory_order_relaxed)));
+    std::printf("Operations/sec: %.2f\n", count / elapsed);
+
+    return 0;
+}
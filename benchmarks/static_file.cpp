@@ -0,0 +1,670 @@
+#include "ossia/http_server.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \brief
+///   Files no larger than this are read into the output buffer and sent together with the
+///   headers. Larger files are spliced from the page cache into the socket.
+static constexpr std::uint64_t small_file_size = 16384;
+
+/// \brief
+///   Cached file descriptors are revalidated by \c statx at most once per this interval.
+static constexpr auto revalidate_interval = 1s;
+
+/// \brief
+///   Maximum number of open files cached by each worker.
+static constexpr std::size_t max_cached_files = 4096;
+
+/// \brief
+///   Size in byte of the receive buffer of benchmark clients.
+static constexpr std::size_t client_buffer_size = 262144;
+
+/// \struct cached_file
+/// \brief
+///   An open file and its prebuilt response header fields.
+struct cached_file {
+    file                                  handle;
+    file_status                           status;
+    std::string                           etag;
+    std::string                           headers;
+    std::chrono::steady_clock::time_point checked;
+};
+
+/// \brief
+///   Guess content type of a file from its extension.
+static auto content_type(std::string_view path) noexcept -> std::string_view {
+    auto dot = path.rfind('.');
+    if (dot == std::string_view::npos || path.find('/', dot) != std::string_view::npos)
+        return "application/octet-stream";
+
+    auto extension = path.substr(dot + 1);
+    if (extension == "html" || extension == "htm")
+        return "text/html; charset=utf-8";
+    if (extension == "css")
+        return "text/css; charset=utf-8";
+    if (extension == "js")
+        return "text/javascript; charset=utf-8";
+    if (extension == "json")
+        return "application/json";
+    if (extension == "txt")
+        return "text/plain; charset=utf-8";
+    if (extension == "svg")
+        return "image/svg+xml";
+    if (extension == "png")
+        return "image/png";
+    if (extension == "jpg" || extension == "jpeg")
+        return "image/jpeg";
+    if (extension == "webp")
+        return "image/webp";
+    if (extension == "woff2")
+        return "font/woff2";
+    return "application/octet-stream";
+}
+
+/// \brief
+///   Format a time point as an IMF-fixdate, such as <tt>Sun, 06 Nov 1994 08:49:37 GMT</tt>.
+static auto format_http_date(std::chrono::system_clock::time_point time) -> std::string {
+    static constexpr const char *weekdays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static constexpr const char *months[]   = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                               "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    auto seconds = std::chrono::floor<std::chrono::seconds>(time);
+    auto days    = std::chrono::floor<std::chrono::days>(seconds);
+
+    std::chrono::year_month_day date(days);
+    std::chrono::hh_mm_ss       clock(seconds - days);
+    std::chrono::weekday        weekday(days);
+
+    char buffer[32];
+    int  size = std::snprintf(buffer, sizeof(buffer), "%s, %02u %s %04d %02d:%02d:%02d GMT",
+                              weekdays[weekday.c_encoding()], static_cast<unsigned>(date.day()),
+                              months[static_cast<unsigned>(date.month()) - 1],
+                              static_cast<int>(date.year()),
+                              static_cast<int>(clock.hours().count()),
+                              static_cast<int>(clock.minutes().count()),
+                              static_cast<int>(clock.seconds().count()));
+
+    return std::string(buffer, static_cast<std::size_t>(size));
+}
+
+/// \brief
+///   Build the response header fields of a file. The fields do not change until the file is
+///   replaced, so they are built once when the file is opened.
+static auto make_headers(cached_file &entry, std::string_view path) -> void {
+    auto modified = entry.status.last_write_time.time_since_epoch();
+    auto nanos    = std::chrono::duration_cast<std::chrono::nanoseconds>(modified).count();
+
+    char etag[64];
+    int  size = std::snprintf(etag, sizeof(etag), "\"%llx-%llx-%llx\"",
+                              static_cast<unsigned long long>(entry.status.id),
+                              static_cast<unsigned long long>(entry.status.size),
+                              static_cast<unsigned long long>(nanos));
+    entry.etag.assign(etag, static_cast<std::size_t>(size));
+
+    char length[24];
+    auto result = std::to_chars(length, length + sizeof(length), entry.status.size);
+
+    entry.headers.clear();
+    entry.headers.append("Content-Length: ");
+    entry.headers.append(length, result.ptr);
+    entry.headers.append("\r\nContent-Type: ");
+    entry.headers.append(content_type(path));
+    entry.headers.append("\r\nLast-Modified: ");
+    entry.headers.append(format_http_date(entry.status.last_write_time));
+    entry.headers.append("\r\nETag: ");
+    entry.headers.append(entry.etag);
+    entry.headers.append("\r\n");
+}
+
+/// \brief
+///   Resolve request target into a path relative to the document root. Query strings are ignored
+///   and percent-encoded octets are decoded.
+/// \param target
+///   The request target.
+/// \param[out] path
+///   The resolved relative path that starts with '/'.
+/// \return
+///   0 if succeeded. Otherwise, return the status code that the request should be rejected with.
+static auto resolve_target(std::string_view target, std::string &path) -> std::uint16_t {
+    target = target.substr(0, target.find_first_of("?#"));
+    if (target.empty() || target.front() != '/')
+        return 400;
+
+    std::string decoded;
+    decoded.reserve(target.size());
+    for (std::size_t i = 0; i < target.size(); ++i) {
+        if (target[i] != '%') {
+            decoded.push_back(target[i]);
+            continue;
+        }
+
+        unsigned value = 0;
+        if (i + 2 >= target.size() ||
+            std::from_chars(target.data() + i + 1, target.data() + i + 3, value, 16).ptr !=
+                target.data() + i + 3)
+            return 400;
+
+        decoded.push_back(static_cast<char>(value));
+        i += 2;
+    }
+
+    // Rebuild the path segment by segment so that it never escapes the document root.
+    path.clear();
+    std::string_view rest = decoded;
+    while (!rest.empty()) {
+        auto slash   = rest.find('/');
+        auto segment = rest.substr(0, slash);
+        rest         = slash == std::string_view::npos ? std::string_view()
+                                                       : rest.substr(slash + 1);
+
+        if (segment.empty() || segment == ".")
+            continue;
+        if (segment == ".." || segment.find_first_of(std::string_view("\0\\", 2)) !=
+                                   std::string_view::npos)
+            return 400;
+
+        path.push_back('/');
+        path.append(segment);
+    }
+
+    if (path.empty() || decoded.back() == '/')
+        path.append("/index.html");
+
+    return 0;
+}
+
+/// \brief
+///   Map a system error to an HTTP status code.
+static auto error_status(std::error_code error) noexcept -> std::uint16_t {
+    if (error == std::errc::no_such_file_or_directory || error == std::errc::not_a_directory)
+        return 404;
+    if (error == std::errc::permission_denied)
+        return 403;
+    return 500;
+}
+
+/// \class file_cache
+/// \brief
+///   Per-worker cache of open files. Opening a file and querying its status are submitted to the
+///   worker's IO muxer so that a cold lookup never blocks the worker, and cached descriptors are
+///   revalidated periodically so that replaced files are picked up.
+class file_cache {
+public:
+    /// \brief
+    ///   Create an empty cache.
+    /// \param root
+    ///   The document root.
+    explicit file_cache(std::string root) noexcept : m_root(std::move(root)), m_files() {}
+
+    /// \brief
+    ///   Look up a file by its relative path.
+    /// \param path
+    ///   Path relative to the document root.
+    /// \return
+    ///   The cached file if succeeded. Otherwise, return the HTTP status code of the error.
+    auto open(std::string path) noexcept
+        -> future<std::expected<std::shared_ptr<cached_file>, std::uint16_t>> {
+        auto now = std::chrono::steady_clock::now();
+
+        std::shared_ptr<cached_file> entry;
+        if (auto iter = m_files.find(path); iter != m_files.end()) {
+            entry = iter->second;
+            if (now - entry->checked < revalidate_interval)
+                co_return entry;
+        }
+
+        std::string full_path = m_root + path;
+
+        auto status = co_await file::status_async(full_path.c_str());
+        if (!status.has_value()) {
+            m_files.erase(path);
+            co_return std::unexpected(error_status(status.error()));
+        }
+
+        if (!status->is_regular) {
+            m_files.erase(path);
+            co_return std::unexpected(std::uint16_t(404));
+        }
+
+        // The cached descriptor still refers to the same content.
+        if (entry != nullptr && entry->status.id == status->id &&
+            entry->status.size == status->size &&
+            entry->status.last_write_time == status->last_write_time) {
+            entry->checked = now;
+            co_return entry;
+        }
+
+        auto opened = co_await file::open_async(full_path.c_str());
+        if (!opened.has_value())
+            co_return std::unexpected(error_status(opened.error()));
+
+        entry = std::make_shared<cached_file>(cached_file{
+            .handle  = std::move(*opened),
+            .status  = *status,
+            .etag    = {},
+            .headers = {},
+            .checked = now,
+        });
+        make_headers(*entry, path);
+
+        // Transfers in progress keep their own reference to evicted files.
+        if (m_files.size() >= max_cached_files && !m_files.contains(path))
+            m_files.erase(m_files.begin());
+
+        m_files.insert_or_assign(std::move(path), entry);
+        co_return entry;
+    }
+
+private:
+    std::string                                                   m_root;
+    std::unordered_map<std::string, std::shared_ptr<cached_file>> m_files;
+};
+
+/// \brief
+///   Send all data in the output buffer and clear it.
+/// \return
+///   \c true if succeeded. \c false if any error occurs.
+static auto flush(tcp_stream &stream, std::string &output) noexcept -> future<bool> {
+    std::size_t sent = 0;
+    while (sent < output.size()) {
+        auto result = co_await stream.send_async(output.data() + sent,
+                                                 static_cast<std::uint32_t>(output.size() - sent));
+        if (!result.has_value()) [[unlikely]]
+            co_return false;
+        sent += *result;
+    }
+
+    output.clear();
+    co_return true;
+}
+
+/// \brief
+///   Serve a single HTTP/1.1 connection. Small files and header fields of pipelined requests are
+///   batched in the output buffer. Large files are sent with zero-copy transfer.
+static auto serve(tcp_stream stream, file_cache &cache) noexcept -> future<> {
+    detail::http_input input(http_server::default_buffer_size, http_server::default_request_limit);
+    http_request       request;
+    http_response      response;
+    std::string        output;
+    std::string        path;
+    bool               keep_alive = true;
+
+    while (true) {
+        while (keep_alive) {
+            auto size = input.next(request);
+            if (!size.has_value()) {
+                detail::write_http_error(size.error(), output);
+                keep_alive = false;
+                break;
+            }
+
+            if (*size == 0)
+                break;
+
+            response.clear();
+            response.set_keep_alive(request.keep_alive());
+            keep_alive = request.keep_alive();
+
+            bool is_head = request.method() == "HEAD";
+            if (request.method() != "GET" && !is_head) {
+                response.set_status(405);
+                response.add_header("Allow", "GET, HEAD");
+                detail::write_http_response(request, response, output);
+                input.consume(*size);
+                continue;
+            }
+
+            if (auto status = resolve_target(request.target(), path); status != 0) {
+                response.set_status(status);
+                detail::write_http_response(request, response, output);
+                input.consume(*size);
+                continue;
+            }
+
+            auto entry = co_await cache.open(path);
+            if (!entry.has_value()) {
+                response.set_status(entry.error());
+                detail::write_http_response(request, response, output);
+                input.consume(*size);
+                continue;
+            }
+
+            const cached_file &target = **entry;
+            if (request.header("If-None-Match") == std::string_view(target.etag)) {
+                response.set_status(304);
+                response.add_header("ETag", target.etag);
+                detail::write_http_response(request, response, output);
+                input.consume(*size);
+                continue;
+            }
+
+            output.append("HTTP/1.1 200 OK\r\n");
+            output.append(target.headers);
+            if (!keep_alive)
+                output.append("Connection: close\r\n");
+            else if (request.minor_version() == 0)
+                output.append("Connection: keep-alive\r\n");
+            output.append("\r\n");
+            input.consume(*size);
+
+            std::uint64_t file_size = target.status.size;
+            if (is_head || file_size == 0)
+                continue;
+
+            // Small files are copied so that they are sent together with other responses.
+            if (file_size <= small_file_size) {
+                std::size_t offset = output.size();
+                output.resize(offset + file_size);
+
+                std::uint64_t done = 0;
+                while (done < file_size) {
+                    auto result = co_await target.handle.read_async(
+                        output.data() + offset + done,
+                        static_cast<std::uint32_t>(file_size - done), done);
+
+                    // The file is truncated after the headers are built. Content-Length could
+                    // not be honored, so the connection is closed.
+                    if (!result.has_value() || *result == 0) [[unlikely]]
+                        co_return;
+                    done += *result;
+                }
+
+                continue;
+            }
+
+            if (!co_await flush(stream, output)) [[unlikely]]
+                co_return;
+
+            auto sent = co_await stream.send_file_async(target.handle, 0, file_size);
+            if (!sent.has_value() || *sent != file_size) [[unlikely]]
+                co_return;
+        }
+
+        if (!co_await flush(stream, output)) [[unlikely]]
+            co_return;
+
+        if (!keep_alive)
+            co_return;
+
+        input.prepare();
+        auto result = co_await stream.receive_async(input.free_data(), input.free_size());
+        if (!result.has_value() || *result == 0)
+            co_return;
+
+        input.commit(*result);
+    }
+}
+
+/// \brief
+///   Accept connections on a per-worker \c SO_REUSEPORT listener. Each worker owns its own file
+///   cache so that no lock is required.
+static auto listener(const inet_address &address, const std::string &root) noexcept -> future<> {
+    tcp_server server;
+    if (auto error = server.bind(address); error.value() != 0) {
+        std::fprintf(stderr, "Failed to bind: %s\n", error.message().c_str());
+        co_return;
+    }
+
+    file_cache cache(root);
+    while (true) {
+        auto stream = co_await server.accept_async<no_delay_tcp_policy>();
+        if (!stream.has_value()) [[unlikely]] {
+            if (stream.error() == std::errc::connection_aborted)
+                continue;
+            co_return;
+        }
+
+        schedule(serve(std::move(stream->base()), cache));
+    }
+}
+
+/// \struct benchmark_state
+/// \brief
+///   Shared state between benchmark clients and the main thread.
+struct benchmark_state {
+    std::atomic_bool     stop;
+    std::atomic_size_t   target;
+    std::atomic_uint64_t responses;
+    std::atomic_uint64_t bytes;
+    std::atomic_uint64_t errors;
+    std::string          requests[2];
+};
+
+/// \brief
+///   Request files in a loop and discard the bodies. The requested file is switched by the main
+///   thread between measurement phases.
+static auto client(const inet_address &address, benchmark_state &state) noexcept -> future<> {
+    tcp_stream stream;
+    if (co_await stream.connect_async(address) != std::error_code()) {
+        state.errors.fetch_add(1, std::memory_order_relaxed);
+        co_return;
+    }
+
+    stream.set_no_delay(true);
+
+    auto buffer = std::make_unique_for_overwrite<char[]>(client_buffer_size);
+    while (!state.stop.load(std::memory_order_relaxed)) {
+        const std::string &request = state.requests[state.target.load(std::memory_order_relaxed)];
+
+        auto sent = co_await stream.send_async(request.data(),
+                                               static_cast<std::uint32_t>(request.size()));
+        if (!sent.has_value() || *sent != request.size()) [[unlikely]]
+            break;
+
+        // Receive header fields.
+        std::size_t received = 0;
+        std::size_t header   = std::string_view::npos;
+        while (header == std::string_view::npos) {
+            if (received == client_buffer_size) [[unlikely]]
+                break;
+
+            auto result = co_await stream.receive_async(
+                buffer.get() + received, static_cast<std::uint32_t>(client_buffer_size - received));
+            if (!result.has_value() || *result == 0) [[unlikely]]
+                break;
+
+            received += *result;
+            header    = std::string_view(buffer.get(), received).find("\r\n\r\n");
+        }
+
+        std::string_view head(buffer.get(), header == std::string_view::npos ? 0 : header);
+
+        std::uint64_t length = 0;
+        auto          field  = head.find("Content-Length: ");
+        if (!head.starts_with("HTTP/1.1 200 ") || field == std::string_view::npos) [[unlikely]] {
+            state.errors.fetch_add(1, std::memory_order_relaxed);
+            co_return;
+        }
+
+        const char *number = head.data() + field + 16;
+        std::from_chars(number, head.data() + head.size(), length);
+
+        // Discard the body.
+        std::uint64_t body = received - (header + 4);
+        while (body < length) {
+            auto size   = std::min<std::uint64_t>(length - body, client_buffer_size);
+            auto result = co_await stream.receive_async(buffer.get(),
+                                                        static_cast<std::uint32_t>(size));
+            if (!result.has_value() || *result == 0) [[unlikely]] {
+                state.errors.fetch_add(1, std::memory_order_relaxed);
+                co_return;
+            }
+            body += *result;
+        }
+
+        state.responses.fetch_add(1, std::memory_order_relaxed);
+        state.bytes.fetch_add(length, std::memory_order_relaxed);
+    }
+}
+
+static auto spawn_clients(const inet_address &address,
+                          std::size_t        &connections,
+                          benchmark_state    &state) noexcept -> future<> {
+    for (std::size_t i = 0; i < connections; ++i)
+        schedule(client(address, state));
+    co_return;
+}
+
+/// \brief
+///   Parse a positive integer from command line argument.
+/// \param argc
+///   Number of command line arguments.
+/// \param argv
+///   Command line arguments.
+/// \param index
+///   Index of the argument to parse.
+/// \param fallback
+///   Value to use if the argument is absent or invalid.
+/// \return
+///   The parsed value.
+static auto parse_argument(int argc, char **argv, int index, std::size_t fallback) -> std::size_t {
+    if (index >= argc)
+        return fallback;
+
+    std::size_t value = 0;
+    auto [ptr, ec]    = std::from_chars(argv[index], argv[index] + std::strlen(argv[index]), value);
+    return (ec == std::errc() && value != 0) ? value : fallback;
+}
+
+/// \brief
+///   Create a file filled with deterministic content.
+static auto create_file(const std::filesystem::path &path, std::size_t size) -> bool {
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+
+    std::vector<char> block(65536);
+    for (std::size_t i = 0; i < block.size(); ++i)
+        block[i] = static_cast<char>('a' + i % 26);
+
+    while (size != 0 && stream) {
+        std::size_t chunk = std::min(size, block.size());
+        stream.write(block.data(), static_cast<std::streamsize>(chunk));
+        size -= chunk;
+    }
+
+    return static_cast<bool>(stream);
+}
+
+/// \brief
+///   Measure one phase of the benchmark.
+static auto measure(benchmark_state   &state,
+                    std::size_t        target,
+                    std::size_t        seconds,
+                    const std::string &name) -> void {
+    state.target.store(target, std::memory_order_relaxed);
+
+    // Warm up before measuring so that the page cache and the file caches are hot.
+    std::this_thread::sleep_for(1s);
+
+    auto start_count = state.responses.load(std::memory_order_relaxed);
+    auto start_bytes = state.bytes.load(std::memory_order_relaxed);
+    auto start_time  = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    auto end_count = state.responses.load(std::memory_order_relaxed);
+    auto end_bytes = state.bytes.load(std::memory_order_relaxed);
+    auto end_time  = std::chrono::steady_clock::now();
+
+    auto   elapsed   = std::chrono::duration<double>(end_time - start_time).count();
+    auto   count     = static_cast<double>(end_count - start_count);
+    double megabytes = static_cast<double>(end_bytes - start_bytes) / 1048576.0;
+
+    std::printf("  %s: %.0f requests in %.2fs, %.2fMB read\n", name.c_str(), count, elapsed,
+                megabytes);
+    std::printf("    Requests/sec: %.2f\n", count / elapsed);
+    std::printf("    Transfer/sec: %.2fMB\n", megabytes / elapsed);
+}
+
+/// \brief
+///   Static file server and large-object throughput benchmark. Files are opened and stated
+///   through the IO muxer, open descriptors are cached per worker, and large files are sent with
+///   zero-copy transfer from the page cache.
+///
+///   Usage:
+///     ossia-bench-static_file server <root> [port] [threads]
+///     ossia-bench-static_file [connections] [large file MiB] [seconds] [threads]
+auto main(int argc, char **argv) -> int {
+    if (argc >= 3 && std::string_view(argv[1]) == "server") {
+        std::string root    = argv[2];
+        auto        port    = static_cast<std::uint16_t>(parse_argument(argc, argv, 3, 8080));
+        auto        threads = parse_argument(argc, argv, 4, std::thread::hardware_concurrency());
+
+        while (root.size() > 1 && root.back() == '/')
+            root.pop_back();
+
+        inet_address address(ipv4_any, port);
+        io_context   context(threads);
+
+        std::printf("Serving %s on port %u with %zu threads\n", root.c_str(), port, threads);
+        context.dispatch(listener, address, root);
+        context.run();
+        return 0;
+    }
+
+    std::size_t connections = parse_argument(argc, argv, 1, 64);
+    std::size_t large_size  = parse_argument(argc, argv, 2, 16);
+    std::size_t seconds     = parse_argument(argc, argv, 3, 5);
+    std::size_t threads     = parse_argument(argc, argv, 4, 2);
+
+    auto root = std::filesystem::temp_directory_path() / "ossia-bench-static_file";
+    std::filesystem::create_directories(root);
+    if (!create_file(root / "large.bin", large_size * 1048576) ||
+        !create_file(root / "small.txt", 4096)) {
+        std::fprintf(stderr, "Failed to create files in %s\n", root.string().c_str());
+        return 1;
+    }
+
+    inet_address address(ipv4_loopback, 28083);
+    std::string  root_path = root.string();
+
+    auto state         = std::make_unique<benchmark_state>();
+    state->requests[0] = "GET /large.bin HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    state->requests[1] = "GET /small.txt HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    io_context server_context(threads);
+    io_context client_context(threads);
+
+    server_context.dispatch(listener, address, root_path);
+    std::thread server_thread([&server_context] { server_context.run(); });
+
+    // Give listeners some time to bind.
+    std::this_thread::sleep_for(100ms);
+
+    std::size_t per_worker = std::max<std::size_t>(1, connections / threads);
+    client_context.dispatch(spawn_clients, address, per_worker, *state);
+    std::thread client_thread([&client_context] { client_context.run(); });
+
+    std::printf("Running %zus tests @ http://127.0.0.1:%u\n", seconds, address.port());
+    std::printf("  %zu threads and %zu connections\n", threads, per_worker * threads);
+
+    measure(*state, 0, seconds, "Large objects (" + std::to_string(large_size) + "MiB)");
+    measure(*state, 1, seconds, "Small objects (4KiB)");
+
+    state->stop.store(true, std::memory_order_relaxed);
+    client_context.stop();
+    server_context.stop();
+    client_thread.join();
+    server_thread.join();
+
+    std::printf("  Socket errors: %llu\n",
+                static_cast<unsigned long long>(state->errors.load(std::memory_order_relaxed)));
+
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+    return 0;
+}
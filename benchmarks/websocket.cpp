@@ -0,0 +1,194 @@
+#include "ossia/websocket.hpp"
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \struct benchmark_state
+/// \brief
+///   Shared state between benchmark clients and the main thread.
+struct benchmark_state {
+    std::atomic_bool     stop;
+    std::atomic_uint64_t frames;
+    std::atomic_uint64_t errors;
+};
+
+static auto echo(websocket_stream &stream) noexcept -> future<> {
+    while (true) {
+        auto message = co_await stream.receive_async();
+        if (!message.has_value() || message->opcode == websocket_opcode::close)
+            co_return;
+
+        // Replies are sent together before waiting for the next batch of messages.
+        stream.queue(message->opcode, message->payload);
+    }
+}
+
+static auto listener(const inet_address &address) noexcept -> future<> {
+    websocket_server server;
+    if (auto error = server.bind(address); error.value() != 0) {
+        std::fprintf(stderr, "Failed to bind: %s\n", error.message().c_str());
+        co_return;
+    }
+
+    co_await server.run(echo);
+}
+
+static auto client(const inet_address &address,
+                   std::size_t         pipeline,
+                   std::size_t         size,
+                   benchmark_state    &state) noexcept -> future<> {
+    auto stream = co_await websocket_stream::connect_async(address, "localhost", "/echo");
+    if (!stream.has_value()) {
+        state.errors.fetch_add(1, std::memory_order_relaxed);
+        co_return;
+    }
+
+    std::string payload(size, 'x');
+    while (!state.stop.load(std::memory_order_relaxed)) {
+        for (std::size_t i = 0; i < pipeline; ++i)
+            stream->queue(websocket_opcode::binary, payload);
+
+        if (co_await stream->flush_async()) [[unlikely]] {
+            state.errors.fetch_add(1, std::memory_order_relaxed);
+            co_return;
+        }
+
+        for (std::size_t i = 0; i < pipeline; ++i) {
+            auto message = co_await stream->receive_async();
+            if (!message.has_value() || message->payload.size() != size) [[unlikely]] {
+                state.errors.fetch_add(1, std::memory_order_relaxed);
+                co_return;
+            }
+        }
+
+        state.frames.fetch_add(pipeline, std::memory_order_relaxed);
+    }
+}
+
+static auto spawn_clients(const inet_address &address,
+                          std::size_t        &connections,
+                          std::size_t        &pipeline,
+                          std::size_t        &size,
+                          benchmark_state    &state) noexcept -> future<> {
+    for (std::size_t i = 0; i < connections; ++i)
+        schedule(client(address, pipeline, size, state));
+    co_return;
+}
+
+/// \brief
+///   Parse a positive integer from command line argument.
+/// \param argc
+///   Number of command line arguments.
+/// \param argv
+///   Command line arguments.
+/// \param index
+///   Index of the argument to parse.
+/// \param fallback
+///   Value to use if the argument is absent or invalid.
+/// \return
+///   The parsed value.
+static auto parse_argument(int argc, char **argv, int index, std::size_t fallback) -> std::size_t {
+    if (index >= argc)
+        return fallback;
+
+    std::size_t value = 0;
+    auto [ptr, ec]    = std::from_chars(argv[index], argv[index] + std::strlen(argv[index]), value);
+    return (ec == std::errc() && value != 0) ? value : fallback;
+}
+
+/// \brief
+///   Measure unmasking throughput of a single thread.
+/// \param size
+///   Size in byte of each payload.
+/// \return
+///   Unmasking throughput in GiB/s.
+static auto unmask_throughput(std::size_t size) -> double {
+    std::string payload(size, 'x');
+    std::size_t rounds = std::max<std::size_t>(1, (std::size_t{1} << 30) / size);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < rounds; ++i)
+        websocket_mask(std::span<char>(payload.data(), payload.size()), 0x12345678);
+    auto end = std::chrono::steady_clock::now();
+
+    // Keep the result observable.
+    if (payload[0] == '\0')
+        std::puts("");
+
+    auto elapsed = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(rounds * size) / 1073741824.0 / elapsed;
+}
+
+/// \brief
+///   WebSocket echo frames/sec benchmark over loopback. Client frames are masked and every frame
+///   is unmasked by the server.
+///
+///   Usage: ossia-bench-websocket [connections] [pipeline] [payload] [seconds] [threads]
+auto main(int argc, char **argv) -> int {
+    std::size_t connections = parse_argument(argc, argv, 1, 256);
+    std::size_t pipeline    = parse_argument(argc, argv, 2, 16);
+    std::size_t size        = parse_argument(argc, argv, 3, 128);
+    std::size_t seconds     = parse_argument(argc, argv, 4, 10);
+    std::size_t threads     = parse_argument(argc, argv, 5, 2);
+
+    std::printf("Unmask throughput: %.2fGiB/s (%zu-byte payload)\n", unmask_throughput(size),
+                size);
+
+    inet_address    address(ipv4_loopback, 28081);
+    benchmark_state state{};
+
+    io_context server_context(threads);
+    io_context client_context(threads);
+
+    std::size_t per_worker = (connections + threads - 1) / threads;
+
+    server_context.dispatch(listener, address);
+    std::thread server_thread([&server_context] { server_context.run(); });
+
+    // Give listeners some time to bind.
+    std::this_thread::sleep_for(100ms);
+
+    client_context.dispatch(spawn_clients, address, per_worker, pipeline, size, state);
+    std::thread client_thread([&client_context] { client_context.run(); });
+
+    std::printf("Running %zus test @ ws://127.0.0.1:%u/echo\n", seconds, address.port());
+    std::printf("  %zu threads and %zu connections, pipeline depth %zu, %zu-byte frames\n",
+                threads, per_worker * threads, pipeline, size);
+
+    // Warm up before measuring.
+    std::this_thread::sleep_for(1s);
+
+    auto start_count = state.frames.load(std::memory_order_relaxed);
+    auto start_time  = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    auto end_count = state.frames.load(std::memory_order_relaxed);
+    auto end_time  = std::chrono::steady_clock::now();
+
+    state.stop.store(true, std::memory_order_relaxed);
+    client_context.stop();
+    server_context.stop();
+    client_thread.join();
+    server_thread.join();
+
+    auto   elapsed   = std::chrono::duration<double>(end_time - start_time).count();
+    auto   count     = static_cast<double>(end_count - start_count);
+    double megabytes = count * static_cast<double>(size) / 1048576.0;
+
+    std::printf("  %.0f echoed frames in %.2fs, %.2fMB payload\n", count, elapsed, megabytes);
+    std::printf("  Socket errors: %llu\n",
+                static_cast<unsigned long long>(state.errors.load(std::memory_order_relaxed)));
+    std::printf("Frames/sec: %.2f\n", count / elapsed);
+    std::printf("Payload/sec: %.2fMB\n", megabytes / elapsed);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ossia {
+namespace detail {
+
+/// \brief
+///   For internal usage. Buffers of a pooled connection state that have grown larger than this
+///   are released when the state is recycled, so that a few large requests do not pin memory in
+///   the pool.
+inline constexpr std::size_t max_retained_buffer = 65536;
+
+/// \class connection_pool
+/// \brief
+///   For internal usage. Pool of connection states of accepted connections. Released connection
+///   states are recycled in place and kept for new connections, so that accepting a connection
+///   allocates nothing once the pool is warm. The pool keeps as many connection states as the
+///   peak number of concurrent connections in the latest window, and trims the rest when the load
+///   drops. This class is not thread safe. Servers share the pool of the current worker through
+///   \c local().
+/// \tparam State
+///   Type of the connection states. \p State must provide <tt>recycle() noexcept -> bool</tt>,
+///   which resets a released state in place and returns \c false if the state could not be kept.
+template <class State>
+class connection_pool {
+public:
+    /// \brief
+    ///   Number of released connection states in each sizing window.
+    static constexpr std::size_t window_size = 1024;
+
+    /// \brief
+    ///   Create an empty connection pool.
+    connection_pool() noexcept
+        : m_free(),
+          m_active(),
+          m_peak(),
+          m_retained(),
+          m_released() {}
+
+    /// \brief
+    ///   Get the connection pool of the calling thread. Each worker has its own pool, so that
+    ///   all servers in a worker share pooled connection states without locks.
+    /// \return
+    ///   Reference to the connection pool of the calling thread.
+    [[nodiscard]]
+    static auto local() noexcept -> connection_pool & {
+        thread_local connection_pool instance;
+        return instance;
+    }
+
+    /// \brief
+    ///   Take a connection state from this pool. A new connection state is created if the pool is
+    ///   empty.
+    /// \tparam Args
+    ///   Types of arguments to create new connection states.
+    /// \param args
+    ///   Arguments to create a new connection state. Recycled connection states ignore them, so
+    ///   all users of a pool should pass the same arguments.
+    /// \return
+    ///   A connection state that is ready for a new connection.
+    /// \throws std::bad_alloc
+    ///   Thrown if failed to allocate a new connection state.
+    template <class... Args>
+    [[nodiscard]]
+    auto acquire(Args &&...args) -> std::unique_ptr<State> {
+        std::unique_ptr<State> state;
+        if (!m_free.empty()) [[likely]] {
+            state = std::move(m_free.back());
+            m_free.pop_back();
+        } else {
+            state = std::make_unique<State>(std::forward<Args>(args)...);
+
+            // Reserve room for every live connection state, so that release never allocates.
+            m_free.reserve(m_active + 1);
+        }
+
+        m_active  += 1;
+        m_peak     = std::max(m_peak, m_active);
+        m_retained = std::max(m_retained, m_peak);
+        return state;
+    }
+
+    /// \brief
+    ///   Return a connection state to this pool. The connection state is recycled and kept for
+    ///   reuse, or released if the pool already keeps enough connection states.
+    /// \param state
+    ///   The connection state to be returned.
+    auto release(std::unique_ptr<State> state) noexcept -> void {
+        m_active -= 1;
+
+        // Shrink the pool to the peak of the window that has just ended.
+        m_released += 1;
+        if (m_released == window_size) {
+            m_retained = m_peak;
+            m_peak     = m_active;
+            m_released = 0;
+
+            if (m_free.size() + m_active > m_retained)
+                m_free.resize(m_retained > m_active ? m_retained - m_active : 0);
+        }
+
+        if (m_free.size() + m_active >= m_retained)
+            return;
+
+        if (!state->recycle()) [[unlikely]]
+            return;
+
+        m_free.push_back(std::move(state));
+    }
+
+    /// \brief
+    ///   Get number of idle connection states in this pool.
+    /// \return
+    ///   Number of idle connection states in this pool.
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t {
+        return m_free.size();
+    }
+
+    /// \brief
+    ///   Get number of connection states that are in use.
+    /// \return
+    ///   Number of connection states that are in use.
+    [[nodiscard]]
+    auto active() const noexcept -> std::size_t {
+        return m_active;
+    }
+
+private:
+    std::vector<std::unique_ptr<State>> m_free;
+
+    /// \brief
+    ///   Number of connection states in use and the peak of it in the current window.
+    std::size_t m_active;
+    std::size_t m_peak;
+
+    /// \brief
+    ///   Maximum number of connection states to keep, including the ones in use.
+    std::size_t m_retained;
+
+    /// \brief
+    ///   Number of connection states released in the current window.
+    std::size_t m_released;
+};
+
+} // namespace detail
+} // namespace ossia
@@ -0,0 +1,546 @@
+#pragma once
+
+#include "io_context.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <expected>
+#include <system_error>
+
+namespace ossia {
+
+/// \enum file_mode
+/// \brief
+///   Flags that control how a file is opened. Flags could be combined with bitwise or.
+enum class file_mode : std::uint32_t {
+    /// \brief
+    ///   Open the file for reading.
+    read = 0x01,
+
+    /// \brief
+    ///   Open the file for writing.
+    write = 0x02,
+
+    /// \brief
+    ///   Open the file for both reading and writing.
+    read_write = 0x03,
+
+    /// \brief
+    ///   Create the file if it does not exist. Requires \c write.
+    create = 0x04,
+
+    /// \brief
+    ///   Truncate the file to zero length. Requires \c write.
+    truncate = 0x08,
+
+    /// \brief
+    ///   Fail if the file already exists. Requires \c create.
+    exclusive = 0x10,
+};
+
+/// \brief
+///   Combine two \c file_mode flags.
+[[nodiscard]]
+constexpr auto operator|(file_mode lhs, file_mode rhs) noexcept -> file_mode {
+    return static_cast<file_mode>(static_cast<std::uint32_t>(lhs) |
+                                  static_cast<std::uint32_t>(rhs));
+}
+
+/// \brief
+///   Intersect two \c file_mode flags.
+[[nodiscard]]
+constexpr auto operator&(file_mode lhs, file_mode rhs) noexcept -> file_mode {
+    return static_cast<file_mode>(static_cast<std::uint32_t>(lhs) &
+                                  static_cast<std::uint32_t>(rhs));
+}
+
+/// \struct file_status
+/// \brief
+///   Metadata of a file.
+struct file_status {
+    /// \brief
+    ///   Size in byte of the file.
+    std::uint64_t size;
+
+    /// \brief
+    ///   Identifier of the file on its device, such as the inode number. This could be used to
+    ///   detect that a path refers to a different file.
+    std::uint64_t id;
+
+    /// \brief
+    ///   Last modification time of the file.
+    std::chrono::system_clock::time_point last_write_time;
+
+    /// \brief
+    ///   Whether this is a regular file.
+    bool is_regular;
+
+    /// \brief
+    ///   Whether this is a directory.
+    bool is_directory;
+};
+
+/// \class file
+/// \brief
+///   \c file is a class that represents an open file. File IO is submitted to the worker's IO
+///   muxer and never blocks the worker. This class could only be used in workers.
+class file {
+public:
+    /// \class open_awaitable
+    /// \brief
+    ///   Awaitable object for opening a file.
+    class open_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c open_awaitable object for asynchronous open operation.
+        /// \param[in] path
+        ///   Null-terminated UTF-8 path of the file. The path must be valid until this operation
+        ///   is completed.
+        /// \param mode
+        ///   Flags that control how the file is opened.
+        open_awaitable(const char *path, file_mode mode) noexcept
+            : m_ovlp(),
+              m_path(path),
+              m_mode(mode),
+              m_handle() {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async open operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            return this->await_suspend();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous open operation.
+        /// \return
+        ///   The opened file if succeeded. Otherwise, return a system error code.
+        OSSIA_API auto await_resume() const noexcept -> std::expected<file, std::error_code>;
+
+    private:
+        /// \brief
+        ///   Prepare for asynchronous open operation and suspend this coroutine.
+        OSSIA_API auto await_suspend() noexcept -> bool;
+
+    private:
+        detail::overlapped m_ovlp;
+        const char        *m_path;
+        file_mode          m_mode;
+        std::uintptr_t     m_handle;
+    };
+
+    /// \class status_awaitable
+    /// \brief
+    ///   Awaitable object for querying file metadata.
+    class status_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c status_awaitable object for asynchronous status operation.
+        /// \param handle
+        ///   Handle of an open file. Ignored if \p path is not \c nullptr.
+        /// \param[in] path
+        ///   Null-terminated UTF-8 path of the file, or \c nullptr to query the open file. The
+        ///   path must be valid until this operation is completed.
+        status_awaitable(std::uintptr_t handle, const char *path) noexcept
+            : m_ovlp(),
+              m_handle(handle),
+              m_path(path),
+              m_buffer() {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async status operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            return this->await_suspend();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous status operation.
+        /// \return
+        ///   Metadata of the file if succeeded. Otherwise, return a system error code.
+        OSSIA_API auto await_resume() const noexcept -> std::expected<file_status, std::error_code>;
+
+    private:
+        /// \brief
+        ///   Prepare for asynchronous status operation and suspend this coroutine.
+        OSSIA_API auto await_suspend() noexcept -> bool;
+
+    private:
+        detail::overlapped m_ovlp;
+        std::uintptr_t     m_handle;
+        const char        *m_path;
+
+        /// \brief
+        ///   Storage of the platform-specific status structure, such as \c struct \c statx.
+        alignas(8) std::byte m_buffer[256];
+    };
+
+    /// \class read_awaitable
+    /// \brief
+    ///   Awaitable object for reading data from a file.
+    class read_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c read_awaitable object for asynchronous read operation.
+        /// \param handle
+        ///   Handle of the file to read from.
+        /// \param[out] data
+        ///   Pointer to start of buffer to store the data.
+        /// \param size
+        ///   Size in byte of the buffer.
+        /// \param offset
+        ///   Offset in byte in the file to start reading from.
+        /// \param buffer_index
+        ///   Index of the registered buffer that \p data points into, or -1 if \p data is not in a
+        ///   registered buffer.
+        read_awaitable(std::uintptr_t handle,
+                       void          *data,
+                       std::uint32_t  size,
+                       std::uint64_t  offset,
+                       std::int32_t   buffer_index = -1) noexcept
+            : m_ovlp(),
+              m_handle(handle),
+              m_data(data),
+              m_size(size),
+              m_offset(offset),
+              m_buffer_index(buffer_index) {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async read operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            return this->await_suspend();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous read operation.
+        /// \return
+        ///   Number of bytes read if succeeded. 0 means end of file. Otherwise, return a system
+        ///   error code.
+        OSSIA_API auto await_resume() const noexcept
+            -> std::expected<std::uint32_t, std::error_code>;
+
+    private:
+        /// \brief
+        ///   Prepare for asynchronous read operation and suspend this coroutine.
+        OSSIA_API auto await_suspend() noexcept -> bool;
+
+    private:
+        detail::overlapped m_ovlp;
+        std::uintptr_t     m_handle;
+        void              *m_data;
+        std::uint32_t      m_size;
+        std::uint64_t      m_offset;
+        std::int32_t       m_buffer_index;
+    };
+
+    /// \class write_awaitable
+    /// \brief
+    ///   Awaitable object for writing data to a file.
+    class write_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c write_awaitable object for asynchronous write operation.
+        /// \param handle
+        ///   Handle of the file to write to.
+        /// \param data
+        ///   Pointer to start of data to write.
+        /// \param size
+        ///   Size in byte of data to write.
+        /// \param offset
+        ///   Offset in byte in the file to start writing at.
+        /// \param buffer_index
+        ///   Index of the registered buffer that \p data points into, or -1 if \p data is not in a
+        ///   registered buffer.
+        write_awaitable(std::uintptr_t handle,
+                        const void    *data,
+                        std::uint32_t  size,
+                        std::uint64_t  offset,
+                        std::int32_t   buffer_index = -1) noexcept
+            : m_ovlp(),
+              m_handle(handle),
+              m_data(data),
+              m_size(size),
+              m_offset(offset),
+              m_buffer_index(buffer_index) {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async write operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            return this->await_suspend();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous write operation.
+        /// \return
+        ///   Number of bytes written if succeeded. Otherwise, return a system error code.
+        OSSIA_API auto await_resume() const noexcept
+            -> std::expected<std::uint32_t, std::error_code>;
+
+    private:
+        /// \brief
+        ///   Prepare for asynchronous write operation and suspend this coroutine.
+        OSSIA_API auto await_suspend() noexcept -> bool;
+
+    private:
+        detail::overlapped m_ovlp;
+        std::uintptr_t     m_handle;
+        const void        *m_data;
+        std::uint32_t      m_size;
+        std::uint64_t      m_offset;
+        std::int32_t       m_buffer_index;
+    };
+
+public:
+    /// \brief
+    ///   Create an empty \c file object. Empty \c file object does not refer to any file.
+    OSSIA_API file() noexcept;
+
+    /// \brief
+    ///   For internal usage. Wrap a native file handle.
+    /// \param handle
+    ///   The native file handle. The created object takes ownership of the handle.
+    explicit file(std::uintptr_t handle) noexcept : m_handle(handle) {}
+
+    /// \brief
+    ///   \c file is not copyable.
+    file(const file &other) = delete;
+
+    /// \brief
+    ///   Move constructor of \c file.
+    /// \param[in, out] other
+    ///   The \c file object to move. The moved \c file object will be empty.
+    OSSIA_API file(file &&other) noexcept;
+
+    /// \brief
+    ///   Close the file and destroy this object.
+    OSSIA_API ~file();
+
+    /// \brief
+    ///   \c file is not copyable.
+    auto operator=(const file &other) = delete;
+
+    /// \brief
+    ///   Move assignment operator of \c file.
+    /// \param[in, out] other
+    ///   The \c file object to move. The moved \c file object will be empty.
+    /// \return
+    ///   Reference to this \c file object.
+    OSSIA_API auto operator=(file &&other) noexcept -> file &;
+
+    /// \brief
+    ///   Open a file asynchronously. On Linux, the file is opened by \c IORING_OP_OPENAT so path
+    ///   lookup never blocks the worker. On Windows, the file is opened synchronously.
+    /// \param[in] path
+    ///   Null-terminated UTF-8 path of the file. The path must be valid until the operation is
+    ///   completed.
+    /// \param mode
+    ///   Flags that control how the file is opened.
+    /// \return
+    ///   The opened file if succeeded. Otherwise, return a system error code.
+    [[nodiscard]]
+    static auto open_async(const char *path, file_mode mode = file_mode::read) noexcept
+        -> open_awaitable {
+        return open_awaitable(path, mode);
+    }
+
+    /// \brief
+    ///   Query metadata of a file by path asynchronously. On Linux, this is done by
+    ///   \c IORING_OP_STATX. Symbolic links are followed.
+    /// \param[in] path
+    ///   Null-terminated UTF-8 path of the file. The path must be valid until the operation is
+    ///   completed.
+    /// \return
+    ///   Metadata of the file if succeeded. Otherwise, return a system error code.
+    [[nodiscard]]
+    static auto status_async(const char *path) noexcept -> status_awaitable {
+        return status_awaitable(invalid_handle, path);
+    }
+
+    /// \brief
+    ///   Query metadata of this file asynchronously.
+    /// \return
+    ///   Metadata of this file if succeeded. Otherwise, return a system error code.
+    [[nodiscard]]
+    auto status_async() const noexcept -> status_awaitable {
+        return status_awaitable(m_handle, nullptr);
+    }
+
+    /// \brief
+    ///   Read data from this file at the specified offset. The file position is not used.
+    /// \param[out] data
+    ///   Pointer to start of buffer to store the data.
+    /// \param size
+    ///   Size in byte of the buffer.
+    /// \param offset
+    ///   Offset in byte in the file to start reading from.
+    /// \return
+    ///   Number of bytes read if succeeded. 0 means end of file. Otherwise, return a system error
+    ///   code.
+    [[nodiscard]]
+    auto read_async(void *data, std::uint32_t size, std::uint64_t offset) const noexcept
+        -> read_awaitable {
+        return read_awaitable(m_handle, data, size, offset);
+    }
+
+    /// \brief
+    ///   Read data from this file into a registered buffer at the specified offset. The kernel
+    ///   does not pin the buffer pages for this request. The buffer must be acquired from the
+    ///   current worker.
+    /// \param buffer
+    ///   The registered buffer to store the data.
+    /// \param size
+    ///   Size in byte to read. This value must not be greater than size of \p buffer.
+    /// \param offset
+    ///   Offset in byte in the file to start reading from.
+    /// \return
+    ///   Number of bytes read if succeeded. 0 means end of file. Otherwise, return a system error
+    ///   code.
+    [[nodiscard]]
+    auto read_async(const registered_buffer &buffer,
+                    std::uint32_t            size,
+                    std::uint64_t            offset) const noexcept -> read_awaitable {
+        return read_awaitable(m_handle, buffer.data, size, offset,
+                              static_cast<std::int32_t>(buffer.index));
+    }
+
+    /// \brief
+    ///   Write data to this file at the specified offset. The file position is not used.
+    /// \param data
+    ///   Pointer to start of data to write.
+    /// \param size
+    ///   Size in byte of data to write.
+    /// \param offset
+    ///   Offset in byte in the file to start writing at.
+    /// \return
+    ///   Number of bytes written if succeeded. Otherwise, return a system error code.
+    [[nodiscard]]
+    auto write_async(const void *data, std::uint32_t size, std::uint64_t offset) const noexcept
+        -> write_awaitable {
+        return write_awaitable(m_handle, data, size, offset);
+    }
+
+    /// \brief
+    ///   Write data in a registered buffer to this file at the specified offset. The kernel does
+    ///   not pin the buffer pages for this request. The buffer must be acquired from the current
+    ///   worker.
+    /// \param buffer
+    ///   The registered buffer that contains the data.
+    /// \param size
+    ///   Size in byte of data to write. This value must not be greater than size of \p buffer.
+    /// \param offset
+    ///   Offset in byte in the file to start writing at.
+    /// \return
+    ///   Number of bytes written if succeeded. Otherwise, return a system error code.
+    [[nodiscard]]
+    auto write_async(const registered_buffer &buffer,
+                     std::uint32_t            size,
+                     std::uint64_t            offset) const noexcept -> write_awaitable {
+        return write_awaitable(m_handle, buffer.data, size, offset,
+                               static_cast<std::int32_t>(buffer.index));
+    }
+
+    /// \brief
+    ///   Checks if this object refers to an open file.
+    /// \retval true
+    ///   This object refers to an open file.
+    /// \retval false
+    ///   This object is empty.
+    [[nodiscard]]
+    auto is_open() const noexcept -> bool {
+        return m_handle != invalid_handle;
+    }
+
+    /// \brief
+    ///   Get the native file handle. This is a file descriptor on Linux and a \c HANDLE on
+    ///   Windows.
+    /// \return
+    ///   The native file handle.
+    [[nodiscard]]
+    auto native_handle() const noexcept -> std::uintptr_t {
+        return m_handle;
+    }
+
+    /// \brief
+    ///   Close this file. This method does nothing if this is an empty \c file object.
+    OSSIA_API auto close() noexcept -> void;
+
+private:
+    /// \brief
+    ///   Value of native handle of empty \c file objects.
+    static constexpr std::uintptr_t invalid_handle = static_cast<std::uintptr_t>(-1);
+
+private:
+    std::uintptr_t m_handle;
+};
+
+} // namespace ossia
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "io_context.hpp"
+
+#include <atomic>
+#include <climits>
+#include <expected>
+#include <system_error>
+
+namespace ossia {
+
+/// \class futex
+/// \brief
+///   A 32-bit futex word that could be awaited by coroutines in workers and notified from any
+///   thread, including threads that are not managed by ossia. On Linux kernels that support
+///   \c IORING_OP_FUTEX_WAIT, waiting coroutines are suspended on the futex word itself through
+///   the worker's IO muxer, so the worker keeps running other tasks and a plain \c FUTEX_WAKE on
+///   \c word() resumes them. On older kernels an \c eventfd is read instead, and waiters must be
+///   woken by \c notify_one or \c notify_all. Like \c FUTEX_WAIT, waiting may wake up spuriously,
+///   so the word should be checked again after each wait. Waiting is not supported on Windows.
+class futex {
+public:
+    /// \class wait_awaitable
+    /// \brief
+    ///   Awaitable object for waiting for the futex word to be notified.
+    class wait_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c wait_awaitable object for asynchronous wait operation.
+        /// \param[in] owner
+        ///   The futex to wait for.
+        /// \param expected
+        ///   Expected value of the futex word. The coroutine is not suspended if the futex word is
+        ///   not equal to this value.
+        wait_awaitable(futex &owner, std::uint32_t expected) noexcept
+            : m_ovlp(),
+              m_futex(&owner),
+              m_expected(expected),
+              m_counter() {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Do not suspend if the futex word has been changed.
+        /// \retval true
+        ///   The futex word is not equal to the expected value.
+        /// \retval false
+        ///   This coroutine should be suspended.
+        [[nodiscard]]
+        auto await_ready() const noexcept -> bool {
+            return m_futex->m_word.load(std::memory_order_acquire) != m_expected;
+        }
+
+        /// \brief
+        ///   Prepare for async wait operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            return this->await_suspend();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous wait operation.
+        /// \return
+        ///   A system error code that indicates the result of the operation. The error code is 0
+        ///   if the futex word is changed or notified.
+        OSSIA_API auto await_resume() noexcept -> std::error_code;
+
+    private:
+        /// \brief
+        ///   Prepare for asynchronous wait operation and suspend this coroutine.
+        OSSIA_API auto await_suspend() noexcept -> bool;
+
+    private:
+        detail::overlapped m_ovlp;
+        futex             *m_futex;
+        std::uint32_t      m_expected;
+
+        /// \brief
+        ///   Buffer to read the \c eventfd counter into.
+        std::uint64_t m_counter;
+    };
+
+public:
+    /// \brief
+    ///   Create a new futex word.
+    /// \param value
+    ///   Initial value of the futex word.
+    /// \throws std::system_error
+    ///   Thrown if \c IORING_OP_FUTEX_WAIT is not supported and failed to create the \c eventfd.
+    OSSIA_API explicit futex(std::uint32_t value = 0);
+
+    /// \brief
+    ///   \c futex is not copyable. Waiting coroutines refer to the address of the futex word.
+    futex(const futex &other) = delete;
+
+    /// \brief
+    ///   \c futex is not movable. Waiting coroutines refer to the address of the futex word.
+    futex(futex &&other) = delete;
+
+    /// \brief
+    ///   Destroy this futex. It is undefined behavior to destroy a futex while any coroutine is
+    ///   waiting for it.
+    OSSIA_API ~futex();
+
+    /// \brief
+    ///   \c futex is not copyable.
+    auto operator=(const futex &other) = delete;
+
+    /// \brief
+    ///   \c futex is not movable.
+    auto operator=(futex &&other) = delete;
+
+    /// \brief
+    ///   Get the futex word.
+    /// \return
+    ///   Reference to the futex word.
+    [[nodiscard]]
+    auto word() noexcept -> std::atomic<std::uint32_t> & {
+        return m_word;
+    }
+
+    /// \brief
+    ///   Checks if waiting coroutines are suspended on the futex word directly. A plain
+    ///   \c FUTEX_WAKE on \c word() wakes them up only if this is \c true.
+    /// \retval true
+    ///   \c IORING_OP_FUTEX_WAIT is used.
+    /// \retval false
+    ///   The \c eventfd fallback is used.
+    [[nodiscard]]
+    auto is_native() const noexcept -> bool {
+        return m_handle == invalid_handle;
+    }
+
+    /// \brief
+    ///   Wait until this futex is notified if the futex word is equal to \p expected. This method
+    ///   could only be called in workers.
+    /// \param expected
+    ///   Expected value of the futex word.
+    /// \return
+    ///   A system error code that indicates the result of the operation. The error code is 0 if
+    ///   the futex word is changed or notified. \c std::errc::operation_not_supported is returned
+    ///   on Windows.
+    [[nodiscard]]
+    auto wait(std::uint32_t expected) noexcept -> wait_awaitable {
+        return wait_awaitable(*this, expected);
+    }
+
+    /// \brief
+    ///   Wake up at most \p count coroutines waiting for this futex. This method could be called
+    ///   in any thread. The futex word should be modified before notifying.
+    /// \param count
+    ///   Maximum number of waiters to wake up.
+    OSSIA_API auto notify(std::uint32_t count) noexcept -> void;
+
+    /// \brief
+    ///   Wake up one coroutine waiting for this futex.
+    auto notify_one() noexcept -> void {
+        this->notify(1);
+    }
+
+    /// \brief
+    ///   Wake up all coroutines waiting for this futex.
+    auto notify_all() noexcept -> void {
+        this->notify(INT_MAX);
+    }
+
+private:
+    static constexpr std::uintptr_t invalid_handle = static_cast<std::uintptr_t>(-1);
+
+    /// \brief
+    ///   The futex word.
+    std::atomic<std::uint32_t> m_word;
+
+    /// \brief
+    ///   Number of coroutines that are waiting on the \c eventfd fallback.
+    std::atomic<std::uint32_t> m_waiters;
+
+    /// \brief
+    ///   The \c eventfd used if \c IORING_OP_FUTEX_WAIT is not supported.
+    std::uintptr_t m_handle;
+};
+
+} // namespace ossia
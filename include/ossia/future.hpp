@@ -53,6 +53,7 @@ public:
 
         promise.m_parent       = &parent;
         promise.m_stack_bottom = parent.m_stack_bottom;
+        promise.m_context      = parent.m_context;
 
         return m_coroutine;
     }
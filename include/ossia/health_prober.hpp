@@ -0,0 +1,233 @@
+#pragma once
+
+#include "tcp_stream.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ossia {
+namespace detail {
+
+/// \struct probe_shard
+/// \brief
+///   For internal usage. Probes of a \c health_prober that run in one worker.
+struct probe_shard;
+
+} // namespace detail
+
+/// \struct health_prober_options
+/// \brief
+///   Options of \c health_prober.
+struct health_prober_options {
+    /// \brief
+    ///   Time between the starts of two probe rounds. Each endpoint is probed once per round.
+    std::chrono::steady_clock::duration interval = std::chrono::seconds(1);
+
+    /// \brief
+    ///   Timeout of a probe, including connecting and exchanging the payload. This should be
+    ///   shorter than \c interval so that probes of an endpoint never overlap.
+    std::chrono::steady_clock::duration timeout = std::chrono::milliseconds(500);
+
+    /// \brief
+    ///   Maximum number of probes in flight in each worker. A round is spread over time once the
+    ///   limit is reached, which bounds sockets and ephemeral ports in use.
+    std::uint32_t max_in_flight = 1024;
+
+    /// \brief
+    ///   Number of consecutive successful probes after which an endpoint is healthy.
+    std::uint32_t healthy_threshold = 1;
+
+    /// \brief
+    ///   Number of consecutive failed probes after which an endpoint is unhealthy.
+    std::uint32_t unhealthy_threshold = 2;
+
+    /// \brief
+    ///   Payload sent to an endpoint once connected. Leave empty to only probe by connecting.
+    std::string request;
+
+    /// \brief
+    ///   Expected prefix of the reply. If \c request is not empty and this is empty, any reply of
+    ///   at least one byte succeeds. If both are empty, a probe succeeds once connected.
+    std::string response;
+};
+
+/// \enum endpoint_health
+/// \brief
+///   Health of an endpoint probed by \c health_prober.
+enum class endpoint_health : std::uint8_t {
+    unknown   = 0,
+    healthy   = 1,
+    unhealthy = 2,
+};
+
+/// \struct probe_status
+/// \brief
+///   Result of the latest probes of an endpoint.
+struct probe_status {
+    /// \brief
+    ///   Health of the endpoint.
+    endpoint_health health;
+
+    /// \brief
+    ///   Whether the latest probe succeeded.
+    bool succeeded;
+
+    /// \brief
+    ///   Number of consecutive probes with the same result as the latest one. Saturates at 8191.
+    std::uint16_t consecutive;
+
+    /// \brief
+    ///   Error of the latest probe. This is empty if the latest probe succeeded.
+    std::error_code error;
+
+    /// \brief
+    ///   Time spent by the latest probe.
+    std::chrono::microseconds latency;
+};
+
+/// \class health_prober
+/// \brief
+///   Health checker for a large number of TCP endpoints. Endpoints are split evenly into shards,
+///   one per worker, and each worker probes its shard every \c interval with a bounded number of
+///   probes in flight. Every probe is bounded by \c timeout through the \c task_context deadline,
+///   so connects and replies that never complete are cancelled by linked timeouts.
+///
+///   The status of each endpoint is packed into a single 64-bit word, which is written only by
+///   the worker that owns the endpoint and could be read from any thread.
+class health_prober {
+public:
+    /// \brief
+    ///   Create a new health prober.
+    /// \param endpoints
+    ///   Addresses of the endpoints to probe.
+    /// \param workers
+    ///   Number of workers that run this prober. \c run must be called in exactly this number of
+    ///   workers.
+    /// \param options
+    ///   Options of this prober.
+    OSSIA_API health_prober(std::vector<inet_address>    endpoints,
+                            std::size_t                  workers,
+                            const health_prober_options &options = {}) noexcept;
+
+    /// \brief
+    ///   \c health_prober is not copyable.
+    health_prober(const health_prober &other) = delete;
+
+    /// \brief
+    ///   \c health_prober is not copyable.
+    auto operator=(const health_prober &other) = delete;
+
+    /// \brief
+    ///   Probe a shard of the endpoints in current worker until \c stop is called. Each call takes
+    ///   the next shard, so dispatch this to all workers with \c io_context::dispatch. The
+    ///   returned task completes once all probes of the shard are finished.
+    /// \return
+    ///   A task that probes the endpoints. This prober must be alive until the task completes.
+    OSSIA_API auto run() noexcept -> future<>;
+
+    /// \brief
+    ///   Stop starting new probes. Tasks returned by \c run complete once their probes in flight
+    ///   are finished. This method could be called in any thread.
+    auto stop() noexcept -> void {
+        m_stopped.store(true, std::memory_order_relaxed);
+    }
+
+    /// \brief
+    ///   Get number of endpoints of this prober.
+    /// \return
+    ///   Number of endpoints.
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t {
+        return m_endpoints.size();
+    }
+
+    /// \brief
+    ///   Get address of an endpoint.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \return
+    ///   Address of the endpoint.
+    [[nodiscard]]
+    auto address(std::size_t index) const noexcept -> const inet_address & {
+        return m_endpoints[index];
+    }
+
+    /// \brief
+    ///   Get status of an endpoint. This method could be called in any thread.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \return
+    ///   Status of the endpoint.
+    [[nodiscard]]
+    OSSIA_API auto status(std::size_t index) const noexcept -> probe_status;
+
+    /// \brief
+    ///   Count endpoints that are healthy. This method could be called in any thread.
+    /// \return
+    ///   Number of healthy endpoints.
+    [[nodiscard]]
+    OSSIA_API auto healthy_count() const noexcept -> std::size_t;
+
+    /// \brief
+    ///   Get total number of finished probes.
+    /// \return
+    ///   Total number of finished probes.
+    [[nodiscard]]
+    auto probes() const noexcept -> std::uint64_t {
+        return m_probes.load(std::memory_order_relaxed);
+    }
+
+    /// \brief
+    ///   Get total number of failed probes.
+    /// \return
+    ///   Total number of failed probes.
+    [[nodiscard]]
+    auto failures() const noexcept -> std::uint64_t {
+        return m_failures.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// \brief
+    ///   Probe an endpoint once and record the result.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \param[in, out] shard
+    ///   The shard that the endpoint belongs to.
+    /// \return
+    ///   A task that probes the endpoint.
+    OSSIA_API auto probe(std::size_t index, detail::probe_shard &shard) noexcept -> future<>;
+
+    /// \brief
+    ///   Exchange the payload with a connected endpoint.
+    /// \param stream
+    ///   Connection to the endpoint.
+    /// \return
+    ///   Error of the exchange. The error code is 0 if the reply is expected.
+    OSSIA_API auto exchange(tcp_stream &stream) noexcept -> future<std::error_code>;
+
+    /// \brief
+    ///   Record the result of a probe.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \param error
+    ///   Error of the probe. The error code is 0 if the probe succeeded.
+    /// \param latency
+    ///   Time spent by the probe.
+    OSSIA_API auto record(std::size_t                         index,
+                          std::error_code                     error,
+                          std::chrono::steady_clock::duration latency) noexcept -> void;
+
+private:
+    std::vector<inet_address>               m_endpoints;
+    health_prober_options                   m_options;
+    std::size_t                             m_workers;
+    std::unique_ptr<std::atomic_uint64_t[]> m_states;
+    std::atomic_size_t                      m_next_shard;
+    std::atomic_bool                        m_stopped;
+    std::atomic_uint64_t                    m_probes;
+    std::atomic_uint64_t                    m_failures;
+};
+
+} // namespace ossia
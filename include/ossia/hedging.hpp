@@ -0,0 +1,469 @@
+#pragma once
+
+#include "tcp_stream.hpp"
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace ossia {
+
+/// \struct hedging_options
+/// \brief
+///   Options of \c hedging_client.
+struct hedging_options {
+    /// \brief
+    ///   Latency percentile of primary requests after which a hedged request is sent.
+    double percentile = 0.95;
+
+    /// \brief
+    ///   Hedge delay used until enough latency samples are collected.
+    std::chrono::steady_clock::duration initial_delay = std::chrono::milliseconds(10);
+
+    /// \brief
+    ///   Lower bound of the hedge delay. This keeps a burst of fast replies from making every
+    ///   request hedged.
+    std::chrono::steady_clock::duration min_delay = std::chrono::milliseconds(1);
+
+    /// \brief
+    ///   Hedge budget earned by each request. A hedged request costs 1, so this is the maximum
+    ///   long-term ratio of hedged requests to requests.
+    double budget_ratio = 0.1;
+
+    /// \brief
+    ///   Maximum hedge budget that could be saved up while replicas are fast.
+    double budget_burst = 10;
+};
+
+/// \struct hedging_stats
+/// \brief
+///   Statistics of a \c hedging_client.
+struct hedging_stats {
+    /// \brief
+    ///   Number of requests issued.
+    std::uint64_t requests;
+
+    /// \brief
+    ///   Number of hedged requests sent.
+    std::uint64_t hedges;
+
+    /// \brief
+    ///   Number of hedged requests that answered before the primary request.
+    std::uint64_t hedge_wins;
+
+    /// \brief
+    ///   Number of hedged requests that were not sent because the hedge budget ran out.
+    std::uint64_t throttled_hedges;
+
+    /// \brief
+    ///   Number of requests that failed on every replica tried.
+    std::uint64_t failures;
+
+    /// \brief
+    ///   Get the ratio of hedged requests that answered first.
+    /// \return
+    ///   Ratio of \c hedge_wins to \c hedges. Return 0 if no request is hedged.
+    [[nodiscard]]
+    auto hit_rate() const noexcept -> double {
+        return hedges == 0 ? 0 : static_cast<double>(hedge_wins) / static_cast<double>(hedges);
+    }
+};
+
+namespace detail {
+
+/// \class hedge_race
+/// \brief
+///   For internal usage. Shared state of the primary and the hedged attempt of a request. The
+///   requesting coroutine returns as soon as an attempt wins, so the state is shared with the
+///   attempts and released by whichever finishes last.
+class hedge_race {
+public:
+    /// \class wait_awaitable
+    /// \brief
+    ///   Awaitable object for waiting until an attempt finishes or a deadline passes.
+    class wait_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c wait_awaitable object.
+        /// \param[in] race
+        ///   The race to wait for.
+        /// \param deadline
+        ///   Time point to stop waiting at. \c time_point::max() means no deadline.
+        wait_awaitable(hedge_race &race, std::chrono::steady_clock::time_point deadline) noexcept
+            : m_race(&race),
+              m_deadline(deadline) {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Suspend the requesting coroutine until an attempt finishes or the deadline passes.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> void {
+            m_race->suspend(&static_cast<promise_base &>(coroutine.promise()), m_deadline);
+        }
+
+        /// \brief
+        ///   Remove the deadline timer if it has not expired.
+        auto await_resume() const noexcept -> void {
+            m_race->resume();
+        }
+
+    private:
+        hedge_race                           *m_race;
+        std::chrono::steady_clock::time_point m_deadline;
+    };
+
+public:
+    /// \brief
+    ///   Create a new race with no attempt.
+    OSSIA_API hedge_race() noexcept;
+
+    /// \brief
+    ///   \c hedge_race is not copyable.
+    hedge_race(const hedge_race &other) = delete;
+
+    /// \brief
+    ///   \c hedge_race is not movable.
+    hedge_race(hedge_race &&other) = delete;
+
+    /// \brief
+    ///   Destroy this race.
+    ~hedge_race() = default;
+
+    /// \brief
+    ///   \c hedge_race is not copyable.
+    auto operator=(const hedge_race &other) = delete;
+
+    /// \brief
+    ///   \c hedge_race is not movable.
+    auto operator=(hedge_race &&other) = delete;
+
+    /// \brief
+    ///   Get the connection of an attempt.
+    /// \param index
+    ///   Index of the attempt. 0 is the primary attempt and 1 is the hedged attempt.
+    /// \return
+    ///   The connection of the attempt.
+    [[nodiscard]]
+    auto stream(std::size_t index) noexcept -> tcp_stream & {
+        return m_streams[index];
+    }
+
+    /// \brief
+    ///   Get how long an attempt has taken.
+    /// \param index
+    ///   Index of the attempt.
+    /// \return
+    ///   Time from start to finish of the attempt. Attempts that have not finished are counted
+    ///   until now.
+    [[nodiscard]]
+    OSSIA_API auto elapsed(std::size_t index) const noexcept -> std::chrono::steady_clock::duration;
+
+    /// \brief
+    ///   Checks if any attempt has succeeded.
+    [[nodiscard]]
+    auto is_done() const noexcept -> bool {
+        return m_winner >= 0;
+    }
+
+    /// \brief
+    ///   Get index of the attempt that succeeded first.
+    /// \return
+    ///   Index of the winning attempt. Return -1 if no attempt has succeeded.
+    [[nodiscard]]
+    auto winner() const noexcept -> int {
+        return m_winner;
+    }
+
+    /// \brief
+    ///   Get number of attempts that have not finished.
+    [[nodiscard]]
+    auto pending() const noexcept -> std::uint32_t {
+        return m_pending;
+    }
+
+    /// \brief
+    ///   Register a new attempt. This must be called before the attempt is scheduled.
+    /// \param index
+    ///   Index of the attempt.
+    OSSIA_API auto start(std::size_t index) noexcept -> void;
+
+    /// \brief
+    ///   Finish an attempt. The first attempt that succeeds wins and the other attempt is
+    ///   cancelled. The requesting coroutine is woken up if it is waiting.
+    /// \param index
+    ///   Index of the attempt.
+    /// \param succeeded
+    ///   Whether the attempt succeeded.
+    /// \retval true
+    ///   The result of this attempt should be returned to the requesting coroutine.
+    /// \retval false
+    ///   The result of this attempt should be dropped.
+    OSSIA_API auto finish(std::size_t index, bool succeeded) noexcept -> bool;
+
+    /// \brief
+    ///   Cancel all attempts that have not finished.
+    OSSIA_API auto cancel() noexcept -> void;
+
+    /// \brief
+    ///   Wait until an attempt finishes or the deadline passes.
+    /// \param deadline
+    ///   Time point to stop waiting at.
+    /// \return
+    ///   Awaitable object for the wait operation.
+    [[nodiscard]]
+    auto wait(std::chrono::steady_clock::time_point deadline =
+                  std::chrono::steady_clock::time_point::max()) noexcept -> wait_awaitable {
+        return wait_awaitable(*this, deadline);
+    }
+
+private:
+    /// \brief
+    ///   Suspend the requesting coroutine.
+    /// \param[in] promise
+    ///   Promise of the requesting coroutine.
+    /// \param deadline
+    ///   Time point to wake the requesting coroutine up at.
+    OSSIA_API auto suspend(promise_base                         *promise,
+                           std::chrono::steady_clock::time_point deadline) noexcept -> void;
+
+    /// \brief
+    ///   Clean up after the requesting coroutine is resumed.
+    OSSIA_API auto resume() noexcept -> void;
+
+    /// \brief
+    ///   Wake up the requesting coroutine if it is waiting.
+    auto wake() noexcept -> void;
+
+private:
+    tcp_stream                            m_streams[2];
+    std::chrono::steady_clock::time_point m_start_times[2];
+    std::chrono::steady_clock::duration   m_elapsed[2];
+    bool                                  m_running[2];
+    std::uint32_t                         m_pending;
+    int                                   m_winner;
+    bool                                  m_failed;
+    promise_base                         *m_waiter;
+    timer_entry                           m_timer;
+    bool                                  m_timer_armed;
+};
+
+/// \struct hedge_state
+/// \brief
+///   For internal usage. A \c hedge_race with the request function and the result to return.
+/// \tparam Result
+///   Result type of the request.
+/// \tparam Func
+///   Type of the request function.
+template <class Result, class Func>
+struct hedge_state : hedge_race {
+    /// \brief
+    ///   Create a new race for the specified request.
+    /// \param func
+    ///   The request function.
+    explicit hedge_state(Func &&func) noexcept
+        : hedge_race(),
+          request(std::move(func)),
+          context(),
+          result() {}
+
+    /// \brief
+    ///   The request function that attempts call with their connections.
+    Func request;
+
+    /// \brief
+    ///   Copy of the task context of the requesting coroutine. Attempts are scheduled rather than
+    ///   awaited, and the losing attempt may outlive the requesting coroutine.
+    std::optional<task_context> context;
+
+    /// \brief
+    ///   Result to return to the requesting coroutine.
+    std::optional<Result> result;
+};
+
+} // namespace detail
+
+/// \class hedging_client
+/// \brief
+///   Client helper that hedges idempotent requests to replicated backends to cut tail latency.
+///   Each request is sent to a primary replica first. If it has not completed when the hedge
+///   delay passes, the same request is sent to the next replica, and whichever succeeds first is
+///   returned. The other attempt is then cancelled. The hedge delay tracks a latency percentile
+///   of primary attempts, and hedged requests are limited by a budget earned per request so that
+///   hedging never multiplies the load on slow backends.
+///
+///   Every attempt uses a new connection that is closed once the request finishes, since a
+///   cancelled connection is left in an unknown state. Requests must be idempotent. This class is
+///   not thread safe and could only be used in one worker.
+class hedging_client {
+public:
+    /// \brief
+    ///   Create a new hedging client.
+    /// \param replicas
+    ///   Addresses of the replicas. Primary attempts are spread over replicas in turn.
+    /// \param options
+    ///   Options of this client.
+    OSSIA_API explicit hedging_client(std::vector<inet_address> replicas,
+                                      const hedging_options    &options = {}) noexcept;
+
+    /// \brief
+    ///   Send a request and wait for the first successful reply. Attempts inherit the
+    ///   \c task_context of the calling coroutine, so their receive operations honor its deadline.
+    /// \tparam Func
+    ///   Type of the request function. The function is called with a connected \c tcp_stream and
+    ///   must return a \c future of \c std::expected with \c std::error_code as the error type.
+    /// \param request
+    ///   Function that sends the request over the connection and receives the reply. It may be
+    ///   called twice with different connections, and it should return once its connection is
+    ///   cancelled.
+    /// \return
+    ///   The first successful reply. If every attempt fails, the error of the first failed
+    ///   attempt is returned.
+    template <class Func>
+        requires(std::is_invocable_v<Func &, tcp_stream &>)
+    auto execute_async(Func request) noexcept -> std::invoke_result_t<Func &, tcp_stream &> {
+        using result_type = typename std::invoke_result_t<Func &, tcp_stream &>::value_type;
+        using state_type  = detail::hedge_state<result_type, Func>;
+
+        auto state   = std::make_shared<state_type>(std::move(request));
+        auto start   = std::chrono::steady_clock::now();
+        auto primary = this->begin_request();
+
+        // Attempts honor the deadline of the request.
+        if (const task_context *context = co_await current_task_context(); context != nullptr)
+            state->context = *context;
+
+        state->start(0);
+        schedule(attempt<state_type>(state, 0, m_replicas[primary]));
+
+        // Wait for the primary attempt until the hedge delay. Hedge at once if it fails early.
+        auto deadline = start + m_delay;
+        while (state->pending() != 0 && !state->is_done() &&
+               std::chrono::steady_clock::now() < deadline)
+            co_await state->wait(deadline);
+
+        if (!state->is_done() && m_replicas.size() > 1 && this->acquire_hedge()) {
+            state->start(1);
+            schedule(attempt<state_type>(state, 1, m_replicas[(primary + 1) % m_replicas.size()]));
+        }
+
+        while (state->pending() != 0 && !state->is_done())
+            co_await state->wait();
+
+        // The losing attempt finishes on its own once cancelled.
+        state->cancel();
+        this->end_request(*state);
+        co_return std::move(*state->result);
+    }
+
+    /// \brief
+    ///   Get the current hedge delay.
+    /// \return
+    ///   Time after which a request is hedged.
+    [[nodiscard]]
+    auto hedge_delay() const noexcept -> std::chrono::steady_clock::duration {
+        return m_delay;
+    }
+
+    /// \brief
+    ///   Get statistics of this client.
+    /// \return
+    ///   Statistics of this client.
+    [[nodiscard]]
+    auto stats() const noexcept -> const hedging_stats & {
+        return m_stats;
+    }
+
+private:
+    /// \brief
+    ///   Connect to a replica and run the request over the connection.
+    /// \tparam State
+    ///   Type of the shared state of the request.
+    /// \param state
+    ///   The shared state of the request.
+    /// \param index
+    ///   Index of this attempt.
+    /// \param address
+    ///   Address of the replica.
+    template <class State>
+    static auto attempt(std::shared_ptr<State> state,
+                        std::size_t            index,
+                        inet_address           address) noexcept -> future<> {
+        if (state->context.has_value())
+            co_await set_task_context(&*state->context);
+
+        tcp_stream     &stream = state->stream(index);
+        std::error_code error  = co_await stream.connect_async(address);
+
+        // The other attempt may have won while connecting.
+        if (!error && state->is_done())
+            error = std::make_error_code(std::errc::operation_canceled);
+
+        if (error) {
+            if (state->finish(index, false))
+                state->result.emplace(std::unexpect, error);
+            co_return;
+        }
+
+        auto value = co_await state->request(stream);
+        if (state->finish(index, value.has_value()))
+            state->result = std::move(value);
+    }
+
+    /// \brief
+    ///   Account a new request and pick its primary replica.
+    /// \return
+    ///   Index of the primary replica.
+    OSSIA_API auto begin_request() noexcept -> std::size_t;
+
+    /// \brief
+    ///   Take a hedged request from the hedge budget.
+    /// \retval true
+    ///   The request could be hedged.
+    /// \retval false
+    ///   The hedge budget ran out.
+    OSSIA_API auto acquire_hedge() noexcept -> bool;
+
+    /// \brief
+    ///   Account a finished request and update the hedge delay.
+    /// \param race
+    ///   The finished race.
+    OSSIA_API auto end_request(const detail::hedge_race &race) noexcept -> void;
+
+private:
+    /// \brief
+    ///   Number of latency samples kept to estimate the hedge delay.
+    static constexpr std::size_t sample_capacity = 128;
+
+    /// \brief
+    ///   The hedge delay is recomputed after this many new samples.
+    static constexpr std::size_t sample_interval = 16;
+
+    std::vector<inet_address>           m_replicas;
+    hedging_options                     m_options;
+    std::size_t                         m_next_replica;
+    double                              m_budget;
+    std::chrono::steady_clock::duration m_delay;
+    hedging_stats                       m_stats;
+
+    /// \brief
+    ///   Latencies of recent primary attempts in a ring buffer.
+    std::vector<std::chrono::steady_clock::duration> m_samples;
+
+    /// \brief
+    ///   Total number of latency samples recorded.
+    std::size_t m_sample_count;
+};
+
+} // namespace ossia
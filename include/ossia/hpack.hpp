@@ -0,0 +1,365 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ossia {
+
+/// \enum hpack_error
+/// \brief
+///   Errors that could occur when decoding HPACK header blocks. Any of them is a connection error
+///   of type \c COMPRESSION_ERROR in HTTP/2.
+enum class hpack_error {
+    /// \brief
+    ///   The header block is truncated or an integer or string is malformed.
+    invalid,
+
+    /// \brief
+    ///   An index refers to no entry of the static or dynamic table.
+    invalid_index,
+
+    /// \brief
+    ///   A Huffman-encoded string is malformed or padded incorrectly.
+    invalid_huffman,
+
+    /// \brief
+    ///   A dynamic table size update exceeds the limit or is not at the start of the block.
+    invalid_table_size,
+
+    /// \brief
+    ///   The decoded header list exceeds the size limit.
+    header_list_too_large,
+};
+
+/// \class hpack_header_list
+/// \brief
+///   A list of header fields. Names and values are stored in a single buffer that is reused once
+///   the list is cleared, so no memory is allocated once the buffers are large enough.
+class hpack_header_list {
+public:
+    /// \brief
+    ///   Create an empty header list.
+    hpack_header_list() noexcept : m_storage(), m_fields() {}
+
+    /// \brief
+    ///   Append a header field to this list.
+    /// \param name
+    ///   Name of the header field.
+    /// \param value
+    ///   Value of the header field.
+    OSSIA_API auto add(std::string_view name, std::string_view value) -> void;
+
+    /// \brief
+    ///   Get number of header fields in this list.
+    /// \return
+    ///   Number of header fields in this list.
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t {
+        return m_fields.size();
+    }
+
+    /// \brief
+    ///   Checks if this list is empty.
+    /// \retval true
+    ///   This list is empty.
+    /// \retval false
+    ///   This list is not empty.
+    [[nodiscard]]
+    auto empty() const noexcept -> bool {
+        return m_fields.empty();
+    }
+
+    /// \brief
+    ///   Get name of the header field at the specified index.
+    /// \param index
+    ///   Index of the header field. The index must be less than \c size().
+    /// \return
+    ///   Name of the header field. The view is valid until this list is modified.
+    [[nodiscard]]
+    auto name(std::size_t index) const noexcept -> std::string_view {
+        const auto &entry = m_fields[index];
+        return std::string_view(m_storage.data() + entry.offset, entry.name_size);
+    }
+
+    /// \brief
+    ///   Get value of the header field at the specified index.
+    /// \param index
+    ///   Index of the header field. The index must be less than \c size().
+    /// \return
+    ///   Value of the header field. The view is valid until this list is modified.
+    [[nodiscard]]
+    auto value(std::size_t index) const noexcept -> std::string_view {
+        const auto &entry = m_fields[index];
+        return std::string_view(m_storage.data() + entry.offset + entry.name_size,
+                                entry.value_size);
+    }
+
+    /// \brief
+    ///   Find the first header field with the specified name. Names are compared exactly, since
+    ///   HTTP/2 header names are always lowercase.
+    /// \param name
+    ///   Name of the header field to find.
+    /// \return
+    ///   Value of the header field if found. Otherwise, return \c std::nullopt.
+    [[nodiscard]]
+    OSSIA_API auto find(std::string_view name) const noexcept -> std::optional<std::string_view>;
+
+    /// \brief
+    ///   Get size of this list as defined by \c SETTINGS_MAX_HEADER_LIST_SIZE: the sum of sizes of
+    ///   names and values plus 32 bytes per header field.
+    /// \return
+    ///   Size in byte of this list.
+    [[nodiscard]]
+    auto list_size() const noexcept -> std::size_t {
+        return m_storage.size() + m_fields.size() * 32;
+    }
+
+    /// \brief
+    ///   Remove all header fields. Buffers are not released.
+    auto clear() noexcept -> void {
+        m_storage.clear();
+        m_fields.clear();
+    }
+
+private:
+    /// \struct field
+    /// \brief
+    ///   Location of a header field in the storage buffer. The value follows the name.
+    struct field {
+        std::uint32_t offset;
+        std::uint32_t name_size;
+        std::uint32_t value_size;
+    };
+
+    std::string        m_storage;
+    std::vector<field> m_fields;
+};
+
+namespace detail {
+
+/// \class hpack_table
+/// \brief
+///   For internal usage. The static table and a dynamic table of HPACK. Indices start from 1 and
+///   the dynamic table follows the 61 static entries.
+class hpack_table {
+public:
+    /// \brief
+    ///   Number of entries in the static table.
+    static constexpr std::size_t static_size = 61;
+
+    /// \brief
+    ///   Create an empty dynamic table.
+    /// \param max_size
+    ///   Maximum size in byte of the dynamic table.
+    explicit hpack_table(std::size_t max_size) noexcept
+        : m_entries(),
+          m_size(),
+          m_max_size(max_size) {}
+
+    /// \brief
+    ///   Get the entry at the specified index.
+    /// \param index
+    ///   Index of the entry.
+    /// \param[out] name
+    ///   Name of the entry.
+    /// \param[out] value
+    ///   Value of the entry.
+    /// \retval true
+    ///   The entry is found.
+    /// \retval false
+    ///   The index is out of range.
+    OSSIA_API auto get(std::size_t index, std::string_view &name, std::string_view &value) const
+        noexcept -> bool;
+
+    /// \brief
+    ///   Find the entry that best matches the specified header field.
+    /// \param name
+    ///   Name of the header field.
+    /// \param value
+    ///   Value of the header field.
+    /// \param[out] exact
+    ///   Whether the value matches as well.
+    /// \return
+    ///   Index of the entry. Return 0 if no entry has the same name.
+    [[nodiscard]]
+    OSSIA_API auto find(std::string_view name, std::string_view value, bool &exact) const noexcept
+        -> std::size_t;
+
+    /// \brief
+    ///   Insert a new entry into the dynamic table. Old entries are evicted to make room, and the
+    ///   table is emptied if the entry is larger than the table. \p name and \p value may refer to
+    ///   an entry of this table.
+    /// \param name
+    ///   Name of the entry.
+    /// \param value
+    ///   Value of the entry.
+    OSSIA_API auto insert(std::string_view name, std::string_view value) -> void;
+
+    /// \brief
+    ///   Change maximum size of the dynamic table. Entries are evicted if necessary.
+    /// \param max_size
+    ///   New maximum size in byte of the dynamic table.
+    OSSIA_API auto resize(std::size_t max_size) noexcept -> void;
+
+    /// \brief
+    ///   Get maximum size of the dynamic table.
+    /// \return
+    ///   Maximum size in byte of the dynamic table.
+    [[nodiscard]]
+    auto max_size() const noexcept -> std::size_t {
+        return m_max_size;
+    }
+
+    /// \brief
+    ///   Get current size of the dynamic table.
+    /// \return
+    ///   Size in byte of all entries in the dynamic table, including 32 bytes of overhead per
+    ///   entry.
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t {
+        return m_size;
+    }
+
+private:
+    /// \brief
+    ///   Evict the oldest entries until the table size does not exceed \p max_size.
+    auto evict(std::size_t max_size) noexcept -> void;
+
+private:
+    /// \brief
+    ///   Dynamic table entries. The newest entry is at the front.
+    std::deque<std::pair<std::string, std::string>> m_entries;
+    std::size_t                                     m_size;
+    std::size_t                                     m_max_size;
+};
+
+} // namespace detail
+
+/// \class hpack_decoder
+/// \brief
+///   HPACK header block decoder. Huffman-encoded strings are decoded 4 bits at a time with a
+///   state transition table that is generated at compile time. Each HTTP/2 connection has its own
+///   decoder, since the dynamic table is part of the connection state.
+class hpack_decoder {
+public:
+    /// \brief
+    ///   Create a new decoder.
+    /// \param max_table_size
+    ///   Maximum size in byte of the dynamic table. This is the \c SETTINGS_HEADER_TABLE_SIZE
+    ///   value sent to the peer.
+    explicit hpack_decoder(std::size_t max_table_size = 4096) noexcept
+        : m_table(max_table_size),
+          m_max_table_size(max_table_size),
+          m_name(),
+          m_value() {}
+
+    /// \brief
+    ///   Decode a complete header block and append the header fields to \p headers.
+    /// \param block
+    ///   The header block. Fragments of \c HEADERS and \c CONTINUATION frames must be
+    ///   concatenated before decoding.
+    /// \param[out] headers
+    ///   The header list to append the header fields to.
+    /// \param max_list_size
+    ///   Maximum size in byte of \p headers. See \c hpack_header_list::list_size.
+    /// \return
+    ///   An \c hpack_error if the header block is malformed. The decoder could not be used anymore
+    ///   after an error, since its dynamic table is out of sync with the peer.
+    OSSIA_API auto decode(std::string_view   block,
+                          hpack_header_list &headers,
+                          std::size_t        max_list_size = SIZE_MAX)
+        -> std::expected<void, hpack_error>;
+
+private:
+    detail::hpack_table m_table;
+    std::size_t         m_max_table_size;
+
+    /// \brief
+    ///   Buffers for Huffman-decoded names and values. They are reused across header blocks.
+    std::string m_name;
+    std::string m_value;
+};
+
+/// \class hpack_encoder
+/// \brief
+///   HPACK header block encoder. Header fields are indexed in the dynamic table unless they are
+///   sensitive or unlikely to repeat, and strings are Huffman-encoded when that is shorter.
+class hpack_encoder {
+public:
+    /// \brief
+    ///   Create a new encoder.
+    /// \param max_table_size
+    ///   Maximum size in byte of the dynamic table. This must not exceed the
+    ///   \c SETTINGS_HEADER_TABLE_SIZE value received from the peer.
+    explicit hpack_encoder(std::size_t max_table_size = 4096) noexcept
+        : m_table(max_table_size),
+          m_pending_update(false) {}
+
+    /// \brief
+    ///   Change maximum size of the dynamic table. A dynamic table size update is emitted at the
+    ///   start of the next header block.
+    /// \param max_table_size
+    ///   New maximum size in byte of the dynamic table.
+    auto set_max_table_size(std::size_t max_table_size) noexcept -> void {
+        m_table.resize(max_table_size);
+        m_pending_update = true;
+    }
+
+    /// \brief
+    ///   Encode a header field and append it to the header block.
+    /// \param name
+    ///   Name of the header field. HTTP/2 requires names in lowercase.
+    /// \param value
+    ///   Value of the header field.
+    /// \param[out] output
+    ///   The header block to append the encoded header field to.
+    /// \param sensitive
+    ///   Whether the header field is sensitive, such as credentials. Sensitive header fields are
+    ///   never indexed by this encoder or by intermediaries.
+    OSSIA_API auto encode(std::string_view name,
+                          std::string_view value,
+                          std::string     &output,
+                          bool             sensitive = false) -> void;
+
+private:
+    detail::hpack_table m_table;
+    bool                m_pending_update;
+};
+
+/// \brief
+///   Huffman-encode a string with the HPACK Huffman code and append it to the output buffer.
+/// \param data
+///   The string to be encoded.
+/// \param[out] output
+///   The output buffer to append the encoded string to.
+OSSIA_API auto hpack_huffman_encode(std::string_view data, std::string &output) -> void;
+
+/// \brief
+///   Get size in byte of a string after Huffman encoding.
+/// \param data
+///   The string to be encoded.
+/// \return
+///   Size in byte of the encoded string.
+[[nodiscard]]
+OSSIA_API auto hpack_huffman_size(std::string_view data) noexcept -> std::size_t;
+
+/// \brief
+///   Decode a Huffman-encoded string and append it to the output buffer.
+/// \param data
+///   The Huffman-encoded string.
+/// \param[out] output
+///   The output buffer to append the decoded string to.
+/// \retval true
+///   The string is decoded.
+/// \retval false
+///   The string is malformed. \p output may contain partially decoded data.
+OSSIA_API auto hpack_huffman_decode(std::string_view data, std::string &output) -> bool;
+
+} // namespace ossia
@@ -0,0 +1,941 @@
+#pragma once
+
+#include "hpack.hpp"
+#include "tcp_server.hpp"
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ossia {
+namespace detail {
+class http2_connection;
+} // namespace detail
+
+/// \enum http2_frame_type
+/// \brief
+///   Types of HTTP/2 frames. See RFC 9113 section 6.
+enum class http2_frame_type : std::uint8_t {
+    data          = 0x0,
+    headers       = 0x1,
+    priority      = 0x2,
+    rst_stream    = 0x3,
+    settings      = 0x4,
+    push_promise  = 0x5,
+    ping          = 0x6,
+    goaway        = 0x7,
+    window_update = 0x8,
+    continuation  = 0x9,
+};
+
+/// \enum http2_error_code
+/// \brief
+///   Error codes of \c RST_STREAM and \c GOAWAY frames. See RFC 9113 section 7.
+enum class http2_error_code : std::uint32_t {
+    no_error            = 0x0,
+    protocol_error      = 0x1,
+    internal_error      = 0x2,
+    flow_control_error  = 0x3,
+    settings_timeout    = 0x4,
+    stream_closed       = 0x5,
+    frame_size_error    = 0x6,
+    refused_stream      = 0x7,
+    cancel              = 0x8,
+    compression_error   = 0x9,
+    connect_error       = 0xA,
+    enhance_your_calm   = 0xB,
+    inadequate_security = 0xC,
+    http_1_1_required   = 0xD,
+};
+
+/// \brief
+///   Flag of \c DATA and \c HEADERS frames: this is the last frame of the stream.
+inline constexpr std::uint8_t http2_flag_end_stream = 0x1;
+
+/// \brief
+///   Flag of \c SETTINGS and \c PING frames: this frame acknowledges the peer's frame.
+inline constexpr std::uint8_t http2_flag_ack = 0x1;
+
+/// \brief
+///   Flag of \c HEADERS and \c CONTINUATION frames: this frame ends the header block.
+inline constexpr std::uint8_t http2_flag_end_headers = 0x4;
+
+/// \brief
+///   Flag of \c DATA and \c HEADERS frames: the payload is padded.
+inline constexpr std::uint8_t http2_flag_padded = 0x8;
+
+/// \brief
+///   Flag of \c HEADERS frames: the payload starts with priority fields.
+inline constexpr std::uint8_t http2_flag_priority = 0x20;
+
+/// \brief
+///   Size in byte of HTTP/2 frame headers.
+inline constexpr std::size_t http2_frame_header_size = 9;
+
+/// \brief
+///   Connection preface sent by HTTP/2 clients.
+inline constexpr std::string_view http2_client_preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+/// \struct http2_frame_header
+/// \brief
+///   Parsed HTTP/2 frame header.
+struct http2_frame_header {
+    /// \brief
+    ///   Size in byte of the frame payload.
+    std::uint32_t length;
+
+    /// \brief
+    ///   Type of this frame.
+    http2_frame_type type;
+
+    /// \brief
+    ///   Type-specific flags of this frame.
+    std::uint8_t flags;
+
+    /// \brief
+    ///   Stream identifier of this frame. The reserved bit is cleared.
+    std::uint32_t stream_id;
+};
+
+/// \brief
+///   Parse an HTTP/2 frame header. Only the header is parsed and the payload may be incomplete.
+/// \param data
+///   Received data that starts with a frame header.
+/// \return
+///   The parsed frame header. Return \c std::nullopt if \p data is shorter than a frame header.
+[[nodiscard]]
+OSSIA_API auto parse_http2_frame_header(std::span<const char> data) noexcept
+    -> std::optional<http2_frame_header>;
+
+/// \brief
+///   Serialize an HTTP/2 frame header and append it to the output buffer.
+/// \param header
+///   The frame header to be serialized. Length of the frame must be less than 2^24.
+/// \param[out] output
+///   The output buffer to append the frame header to.
+OSSIA_API auto write_http2_frame_header(const http2_frame_header &header, std::string &output)
+    -> void;
+
+/// \struct http2_settings
+/// \brief
+///   Settings that an HTTP/2 endpoint announces to its peer. See RFC 9113 section 6.5.2.
+struct http2_settings {
+    /// \brief
+    ///   Maximum size in byte of the HPACK dynamic table used to decode received header blocks.
+    std::uint32_t header_table_size = 4096;
+
+    /// \brief
+    ///   Maximum number of concurrent streams that the peer could open. Streams beyond the limit
+    ///   are refused with \c REFUSED_STREAM.
+    std::uint32_t max_concurrent_streams = 100;
+
+    /// \brief
+    ///   Initial flow control window size in byte of each stream for received data.
+    std::uint32_t initial_window_size = 65535;
+
+    /// \brief
+    ///   Maximum size in byte of received frame payloads.
+    std::uint32_t max_frame_size = 16384;
+
+    /// \brief
+    ///   Maximum size in byte of received header lists. See \c hpack_header_list::list_size.
+    std::uint32_t max_header_list_size = 65536;
+};
+
+/// \class http2_request
+/// \brief
+///   HTTP/2 request received by the server. Pseudo-header fields are kept in the header list.
+class http2_request {
+public:
+    /// \brief
+    ///   Create an empty request.
+    http2_request() noexcept : m_stream_id(), m_headers(), m_body() {}
+
+    /// \brief
+    ///   Get identifier of the stream that carries this request.
+    /// \return
+    ///   Stream identifier of this request.
+    [[nodiscard]]
+    auto stream_id() const noexcept -> std::uint32_t {
+        return m_stream_id;
+    }
+
+    /// \brief
+    ///   Get value of the \c :method pseudo-header field.
+    /// \return
+    ///   Request method, such as \c GET.
+    [[nodiscard]]
+    auto method() const noexcept -> std::string_view {
+        return m_headers.find(":method").value_or(std::string_view());
+    }
+
+    /// \brief
+    ///   Get value of the \c :path pseudo-header field.
+    /// \return
+    ///   Request target, such as \c /index.html.
+    [[nodiscard]]
+    auto path() const noexcept -> std::string_view {
+        return m_headers.find(":path").value_or(std::string_view());
+    }
+
+    /// \brief
+    ///   Get value of the \c :authority pseudo-header field.
+    /// \return
+    ///   Authority of the request target. Return an empty string if absent.
+    [[nodiscard]]
+    auto authority() const noexcept -> std::string_view {
+        return m_headers.find(":authority").value_or(std::string_view());
+    }
+
+    /// \brief
+    ///   Get value of the \c :scheme pseudo-header field.
+    /// \return
+    ///   Scheme of the request target, such as \c http.
+    [[nodiscard]]
+    auto scheme() const noexcept -> std::string_view {
+        return m_headers.find(":scheme").value_or(std::string_view());
+    }
+
+    /// \brief
+    ///   Find the first header field with the specified name.
+    /// \param name
+    ///   Name of the header field in lowercase.
+    /// \return
+    ///   Value of the header field if found. Otherwise, return \c std::nullopt.
+    [[nodiscard]]
+    auto header(std::string_view name) const noexcept -> std::optional<std::string_view> {
+        return m_headers.find(name);
+    }
+
+    /// \brief
+    ///   Get all header fields of this request, including pseudo-header fields.
+    /// \return
+    ///   Header list of this request.
+    [[nodiscard]]
+    auto headers() const noexcept -> const hpack_header_list & {
+        return m_headers;
+    }
+
+    /// \brief
+    ///   Get body of this request.
+    /// \return
+    ///   Body of this request.
+    [[nodiscard]]
+    auto body() const noexcept -> std::string_view {
+        return m_body;
+    }
+
+private:
+    friend class detail::http2_connection;
+
+    std::uint32_t     m_stream_id;
+    hpack_header_list m_headers;
+    std::string       m_body;
+};
+
+/// \class http2_response
+/// \brief
+///   HTTP/2 response. Servers fill it in request handlers and clients receive it from
+///   \c http2_client::request_async.
+class http2_response {
+public:
+    /// \brief
+    ///   Create an empty \c 200 response.
+    http2_response() noexcept : m_status(200), m_headers(), m_body() {}
+
+    /// \brief
+    ///   Get status code of this response.
+    /// \return
+    ///   Status code of this response.
+    [[nodiscard]]
+    auto status() const noexcept -> std::uint16_t {
+        return m_status;
+    }
+
+    /// \brief
+    ///   Set status code of this response.
+    /// \param status
+    ///   The status code to be set. The status code should be in range [200, 999].
+    auto set_status(std::uint16_t status) noexcept -> void {
+        m_status = status;
+    }
+
+    /// \brief
+    ///   Append a header field to this response. \c content-length is generated automatically and
+    ///   connection-specific header fields are not allowed in HTTP/2.
+    /// \param name
+    ///   Name of the header field. HTTP/2 requires names in lowercase.
+    /// \param value
+    ///   Value of the header field.
+    auto add_header(std::string_view name, std::string_view value) -> void {
+        m_headers.add(name, value);
+    }
+
+    /// \brief
+    ///   Find the first header field with the specified name.
+    /// \param name
+    ///   Name of the header field in lowercase.
+    /// \return
+    ///   Value of the header field if found. Otherwise, return \c std::nullopt.
+    [[nodiscard]]
+    auto header(std::string_view name) const noexcept -> std::optional<std::string_view> {
+        return m_headers.find(name);
+    }
+
+    /// \brief
+    ///   Get all header fields of this response. Pseudo-header fields are not included.
+    /// \return
+    ///   Header list of this response.
+    [[nodiscard]]
+    auto headers() const noexcept -> const hpack_header_list & {
+        return m_headers;
+    }
+
+    /// \brief
+    ///   Get body of this response.
+    /// \return
+    ///   Reference to the body buffer of this response.
+    [[nodiscard]]
+    auto body() noexcept -> std::string & {
+        return m_body;
+    }
+
+    /// \brief
+    ///   Get body of this response.
+    /// \return
+    ///   Body of this response.
+    [[nodiscard]]
+    auto body() const noexcept -> std::string_view {
+        return m_body;
+    }
+
+    /// \brief
+    ///   Replace body of this response.
+    /// \param body
+    ///   The new body of this response.
+    auto set_body(std::string_view body) -> void {
+        m_body.assign(body);
+    }
+
+private:
+    friend class detail::http2_connection;
+
+    std::uint16_t     m_status;
+    hpack_header_list m_headers;
+    std::string       m_body;
+};
+
+namespace detail {
+
+/// \struct http2_stream
+/// \brief
+///   For internal usage. State of a single HTTP/2 stream.
+struct http2_stream {
+    /// \brief
+    ///   Identifier of this stream.
+    std::uint32_t id;
+
+    /// \brief
+    ///   Whether the peer has ended this stream.
+    bool remote_closed;
+
+    /// \brief
+    ///   Whether this stream has been reset by either endpoint.
+    bool reset;
+
+    /// \brief
+    ///   Whether this stream has been passed to a request handler, or is owned by a client request.
+    ///   Dispatched streams are removed by their owner only.
+    bool dispatched;
+
+    /// \brief
+    ///   Whether the final response header block has been received. Only used by clients.
+    bool headers_received;
+
+    /// \brief
+    ///   Flow control window in byte for sending data on this stream. It may become negative if
+    ///   the peer shrinks the initial window size.
+    std::int64_t send_window;
+
+    /// \brief
+    ///   Flow control window in byte for receiving data on this stream.
+    std::int64_t receive_window;
+
+    /// \brief
+    ///   Coroutine waiting for the response or for flow control window.
+    promise_base *waiter;
+
+    /// \brief
+    ///   The request carried by this stream.
+    http2_request request;
+
+    /// \brief
+    ///   The response carried by this stream.
+    http2_response response;
+};
+
+/// \class http2_connection
+/// \brief
+///   For internal usage. State of an HTTP/2 connection. The connection is shared by the reading
+///   coroutine, the writing coroutine and all stream coroutines, and is released by whichever
+///   finishes last. Frames queued by stream coroutines are batched and sent by the writing
+///   coroutine with a single send operation per worker loop iteration.
+class http2_connection {
+public:
+    /// \class wait_awaitable
+    /// \brief
+    ///   Awaitable object for waiting until another coroutine wakes this one up.
+    class wait_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c wait_awaitable object.
+        /// \param[out] waiter
+        ///   Slot to store the waiting coroutine in.
+        explicit wait_awaitable(promise_base *&waiter) noexcept : m_waiter(&waiter) {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Suspend current coroutine until it is woken up.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> void {
+            *m_waiter = &static_cast<promise_base &>(coroutine.promise());
+        }
+
+        /// \brief
+        ///   C++20 coroutine API method. Nothing to do.
+        static constexpr auto await_resume() noexcept -> void {}
+
+    private:
+        promise_base **m_waiter;
+    };
+
+public:
+    /// \brief
+    ///   Create a new HTTP/2 connection.
+    /// \param stream
+    ///   The underlying TCP connection.
+    /// \param client
+    ///   Whether this is a client connection.
+    /// \param settings
+    ///   Settings announced to the peer.
+    /// \param limit
+    ///   Maximum size in byte of a single request or response body.
+    OSSIA_API http2_connection(tcp_stream            stream,
+                               bool                  client,
+                               const http2_settings &settings,
+                               std::size_t           limit);
+
+    /// \brief
+    ///   \c http2_connection is not copyable.
+    http2_connection(const http2_connection &other) = delete;
+
+    /// \brief
+    ///   \c http2_connection is not movable.
+    http2_connection(http2_connection &&other) = delete;
+
+    /// \brief
+    ///   Destroy this connection and close the underlying TCP connection.
+    ~http2_connection() = default;
+
+    /// \brief
+    ///   \c http2_connection is not copyable.
+    auto operator=(const http2_connection &other) = delete;
+
+    /// \brief
+    ///   \c http2_connection is not movable.
+    auto operator=(http2_connection &&other) = delete;
+
+    /// \brief
+    ///   Checks if this connection is closed. Closed connections queue no more frames.
+    [[nodiscard]]
+    auto is_closed() const noexcept -> bool {
+        return m_closed;
+    }
+
+    /// \brief
+    ///   Queue the connection preface and initial \c SETTINGS frame, and start the writing
+    ///   coroutine.
+    /// \param self
+    ///   Shared pointer to this connection, held by the writing coroutine.
+    OSSIA_API static auto start(const std::shared_ptr<http2_connection> &self) -> void;
+
+    /// \brief
+    ///   Receive data and handle all complete frames. Server streams whose requests are complete
+    ///   are appended to \c ready(). Client streams whose responses are complete are woken up.
+    /// \return
+    ///   A system error code that indicates the result of the receive operation. The error code
+    ///   is 0 if succeeded. \c std::errc::protocol_error is returned if the peer violates the
+    ///   protocol, in which case a \c GOAWAY frame is queued.
+    [[nodiscard]]
+    OSSIA_API auto receive_async() noexcept -> future<std::error_code>;
+
+    /// \brief
+    ///   Get server streams whose requests are complete and should be dispatched.
+    /// \return
+    ///   Reference to the list of ready streams.
+    [[nodiscard]]
+    auto ready() noexcept -> std::vector<http2_stream *> & {
+        return m_ready;
+    }
+
+    /// \brief
+    ///   Send the response of a server stream and remove the stream. Data frames are sent as the
+    ///   flow control windows allow.
+    /// \param[in, out] stream
+    ///   The stream to respond to. The stream is destroyed once this method completes.
+    [[nodiscard]]
+    OSSIA_API auto respond_async(http2_stream &stream) noexcept -> future<>;
+
+    /// \brief
+    ///   Open a client stream and send a request.
+    /// \param method
+    ///   Method of the request.
+    /// \param path
+    ///   Request target.
+    /// \param body
+    ///   Body of the request.
+    /// \return
+    ///   The response if succeeded. Otherwise, return a system error code.
+    ///   \c std::errc::resource_unavailable_try_again is returned if the peer's limit of
+    ///   concurrent streams is reached, and \c std::errc::connection_reset is returned if the
+    ///   stream is reset or the connection is closed.
+    [[nodiscard]]
+    OSSIA_API auto request_async(std::string_view method,
+                                 std::string_view path,
+                                 std::string_view body) noexcept
+        -> future<std::expected<http2_response, std::error_code>>;
+
+    /// \brief
+    ///   Close this connection. All waiting coroutines are woken up and the writing coroutine
+    ///   exits once queued frames are sent.
+    /// \param cancel
+    ///   Whether to cancel pending IO operations, so that a reading coroutine exits as well.
+    OSSIA_API auto close(bool cancel = false) noexcept -> void;
+
+    /// \brief
+    ///   Set value of the \c :authority pseudo-header field of client requests.
+    /// \param authority
+    ///   The authority of client requests.
+    auto set_authority(std::string_view authority) -> void {
+        m_authority.assign(authority);
+    }
+
+private:
+    /// \brief
+    ///   Send all queued frames until the connection is closed.
+    /// \param self
+    ///   Shared pointer to this connection.
+    static auto write_loop(std::shared_ptr<http2_connection> self) noexcept -> future<>;
+
+    /// \brief
+    ///   Handle a single complete frame.
+    /// \param header
+    ///   Header of the frame.
+    /// \param payload
+    ///   Payload of the frame.
+    /// \return
+    ///   \c http2_error_code::no_error if succeeded. Otherwise, return the connection error.
+    auto handle_frame(const http2_frame_header &header, std::string_view payload)
+        -> http2_error_code;
+
+    /// \brief
+    ///   Handle a \c DATA frame.
+    auto handle_data(const http2_frame_header &header, std::string_view payload)
+        -> http2_error_code;
+
+    /// \brief
+    ///   Handle a \c HEADERS frame.
+    auto handle_headers(const http2_frame_header &header, std::string_view payload)
+        -> http2_error_code;
+
+    /// \brief
+    ///   Handle a complete header block of \c HEADERS and \c CONTINUATION frames.
+    auto handle_header_block() -> http2_error_code;
+
+    /// \brief
+    ///   Handle a \c SETTINGS frame.
+    auto handle_settings(const http2_frame_header &header, std::string_view payload)
+        -> http2_error_code;
+
+    /// \brief
+    ///   Handle a \c WINDOW_UPDATE frame.
+    auto handle_window_update(const http2_frame_header &header, std::string_view payload)
+        -> http2_error_code;
+
+    /// \brief
+    ///   Checks if a stream identifier has not been used yet. Frames other than \c HEADERS and
+    ///   \c PRIORITY on idle streams are connection errors.
+    [[nodiscard]]
+    auto is_idle(std::uint32_t id) const noexcept -> bool;
+
+    /// \brief
+    ///   Mark a stream as ended by the peer. Server streams become ready and client streams are
+    ///   woken up.
+    auto finish_stream(http2_stream &stream) -> void;
+
+    /// \brief
+    ///   Reset a stream with the specified error code. Streams that are not dispatched are
+    ///   removed.
+    auto reset_stream(std::uint32_t id, http2_error_code error) -> void;
+
+    /// \brief
+    ///   Queue a frame. The writing coroutine is woken up if it is waiting.
+    auto queue_frame(http2_frame_type type,
+                     std::uint8_t     flags,
+                     std::uint32_t    stream_id,
+                     std::string_view payload) -> void;
+
+    /// \brief
+    ///   Queue a \c WINDOW_UPDATE frame.
+    auto queue_window_update(std::uint32_t stream_id, std::uint32_t increment) -> void;
+
+    /// \brief
+    ///   Queue a \c GOAWAY frame and close this connection.
+    auto queue_goaway(http2_error_code error) -> void;
+
+    /// \brief
+    ///   Queue a header block as a \c HEADERS frame followed by \c CONTINUATION frames if it is
+    ///   larger than the peer's maximum frame size.
+    auto queue_headers(std::uint32_t stream_id, std::string_view block, bool end_stream) -> void;
+
+    /// \brief
+    ///   Send a message body on a stream as the flow control windows allow.
+    auto send_body_async(http2_stream &stream, std::string_view body) noexcept -> future<bool>;
+
+    /// \brief
+    ///   Wake up a coroutine stored in \p waiter, if any.
+    static auto wake(promise_base *&waiter) noexcept -> void;
+
+    /// \brief
+    ///   Wake up all coroutines waiting for flow control window.
+    auto wake_streams() noexcept -> void;
+
+private:
+    tcp_stream  m_stream;
+    bool        m_client;
+    bool        m_closed;
+    bool        m_preface_received;
+    bool        m_settings_received;
+    std::size_t m_limit;
+
+    /// \brief
+    ///   Settings announced to the peer and received from the peer.
+    http2_settings m_settings;
+    std::uint32_t  m_peer_max_concurrent_streams;
+    std::uint32_t  m_peer_initial_window_size;
+    std::uint32_t  m_peer_max_frame_size;
+
+    /// \brief
+    ///   Connection-level flow control windows.
+    std::int64_t m_send_window;
+    std::int64_t m_receive_window;
+
+    /// \brief
+    ///   Largest stream identifier opened by the peer, and the next one to be opened by this
+    ///   endpoint.
+    std::uint32_t m_last_stream_id;
+    std::uint32_t m_next_stream_id;
+
+    /// \brief
+    ///   Stream of the header block being received, or 0 if no header block is in progress.
+    std::uint32_t m_header_stream_id;
+    bool          m_header_end_stream;
+    std::string   m_header_block;
+
+    hpack_decoder     m_decoder;
+    hpack_encoder     m_encoder;
+    hpack_header_list m_scratch;
+    std::string       m_encoded;
+    std::string       m_authority;
+
+    std::unordered_map<std::uint32_t, std::unique_ptr<http2_stream>> m_streams;
+    std::vector<http2_stream *>                                      m_ready;
+
+    /// \brief
+    ///   Receive buffer. Data in range [m_begin, m_end) is not handled yet.
+    std::unique_ptr<char[]> m_data;
+    std::size_t             m_begin;
+    std::size_t             m_end;
+    std::size_t             m_capacity;
+
+    /// \brief
+    ///   Frames queued for the next send operation and frames being sent.
+    std::string   m_pending;
+    std::string   m_sending;
+    promise_base *m_writer;
+};
+
+} // namespace detail
+
+/// \class http2_server
+/// \brief
+///   HTTP/2 server over cleartext TCP (h2c with prior knowledge) based on \c tcp_server. Each
+///   stream is served by its own coroutine, so that thousands of streams could share a few
+///   connections. This class could only be used in workers.
+class http2_server {
+public:
+    /// \brief
+    ///   Default maximum size in byte of a single request body.
+    static constexpr std::size_t default_request_limit = 1048576;
+
+    /// \brief
+    ///   Create a new \c http2_server object. Empty server object is not valid for use before
+    ///   binding.
+    http2_server() noexcept = default;
+
+    /// \brief
+    ///   Get local address of this server. It is undefined behavior to get local address of an
+    ///   empty server.
+    /// \return
+    ///   Local address of this server.
+    [[nodiscard]]
+    auto local_address() const noexcept -> const inet_address & {
+        return m_server.local_address();
+    }
+
+    /// \brief
+    ///   Start listening on the specified address. \c SO_REUSEPORT is enabled so that each worker
+    ///   could bind its own server to the same address.
+    /// \param[in] address
+    ///   The address to bind. The address could be either an IPv4 or IPv6 address.
+    /// \return
+    ///   An \c std::error_code object that represents system error. The error code is 0 if this
+    ///   operation is succeeded.
+    auto bind(const inet_address &address) noexcept -> std::error_code {
+        return m_server.bind(address);
+    }
+
+    /// \brief
+    ///   Stop listening. Pending accept operation will fail and \c run will return.
+    auto close() noexcept -> void {
+        m_server.close();
+    }
+
+    /// \brief
+    ///   Accept incoming connections and serve them in current worker until this server is closed.
+    /// \tparam Handler
+    ///   Type of the request handler. The handler is invoked as
+    ///   <tt>handler(const http2_request &, http2_response &)</tt> and may either return \c void
+    ///   or \c future<>. Each stream holds its own copy of the handler.
+    /// \param handler
+    ///   The request handler.
+    /// \param settings
+    ///   Settings announced to clients.
+    template <class Handler>
+    auto run(Handler handler, http2_settings settings = {}) noexcept -> future<> {
+        while (true) {
+            auto stream = co_await m_server.accept_async<no_delay_tcp_policy>();
+            if (!stream.has_value()) [[unlikely]] {
+                if (stream.error() == std::errc::connection_aborted)
+                    continue;
+                co_return;
+            }
+
+            schedule(serve(std::move(stream->base()), handler, settings));
+        }
+    }
+
+    /// \brief
+    ///   Serve a single HTTP/2 connection until the peer closes the connection, any IO error
+    ///   occurs, or the peer violates the protocol. Requests are answered with \c 503 while the
+    ///   worker is overloaded. See \c io_context_options::shedding_target.
+    /// \tparam Handler
+    ///   Type of the request handler. See \c run for details.
+    /// \param stream
+    ///   The connection to be served.
+    /// \param handler
+    ///   The request handler.
+    /// \param settings
+    ///   Settings announced to the client.
+    /// \param limit
+    ///   Maximum size in byte of a single request body.
+    template <class Handler>
+    static auto serve(tcp_stream     stream,
+                      Handler        handler,
+                      http2_settings settings = {},
+                      std::size_t    limit    = default_request_limit) noexcept -> future<> {
+        auto connection = std::make_shared<detail::http2_connection>(std::move(stream), false,
+                                                                     settings, limit);
+        detail::http2_connection::start(connection);
+
+        while (true) {
+            auto error = co_await connection->receive_async();
+            if (error.value() != 0)
+                break;
+
+            for (detail::http2_stream *ready : connection->ready())
+                schedule(serve_stream(connection, *ready, handler));
+            connection->ready().clear();
+        }
+
+        connection->close();
+    }
+
+private:
+    /// \brief
+    ///   Invoke the request handler for a single stream and send the response.
+    /// \tparam Handler
+    ///   Type of the request handler. See \c run for details.
+    /// \param connection
+    ///   The connection that the stream belongs to.
+    /// \param[in, out] stream
+    ///   The stream to be served.
+    /// \param handler
+    ///   The request handler.
+    template <class Handler>
+    static auto serve_stream(std::shared_ptr<detail::http2_connection> connection,
+                             detail::http2_stream                     &stream,
+                             Handler                                   handler) noexcept
+        -> future<> {
+        using result_type =
+            std::invoke_result_t<Handler &, const http2_request &, http2_response &>;
+
+        if (!stream.reset && !connection->is_closed()) {
+            // Reject the request without invoking the handler while the worker is overloaded.
+            if (!admit_request()) [[unlikely]] {
+                stream.response.set_status(503);
+                stream.response.add_header("retry-after", "1");
+            } else if constexpr (std::is_same_v<result_type, future<>>) {
+                co_await handler(std::as_const(stream.request), stream.response);
+            } else {
+                handler(std::as_const(stream.request), stream.response);
+            }
+        }
+
+        co_await connection->respond_async(stream);
+    }
+
+private:
+    tcp_server m_server;
+};
+
+/// \class http2_client
+/// \brief
+///   Minimal HTTP/2 client over cleartext TCP (h2c with prior knowledge). Requests are multiplexed
+///   over a single connection and may be sent concurrently from multiple coroutines of the same
+///   worker. This class could only be used in workers.
+class http2_client {
+public:
+    /// \brief
+    ///   Default maximum size in byte of a single response body.
+    static constexpr std::size_t default_response_limit = 16777216;
+
+    /// \brief
+    ///   Create an empty client that is not connected to any server.
+    http2_client() noexcept = default;
+
+    /// \brief
+    ///   \c http2_client is not copyable.
+    http2_client(const http2_client &other) = delete;
+
+    /// \brief
+    ///   Move constructor of \c http2_client.
+    /// \param[in, out] other
+    ///   The \c http2_client object to move. The moved object will be empty.
+    http2_client(http2_client &&other) noexcept = default;
+
+    /// \brief
+    ///   Close the connection. Pending requests complete with an error.
+    ~http2_client() {
+        this->close();
+    }
+
+    /// \brief
+    ///   \c http2_client is not copyable.
+    auto operator=(const http2_client &other) = delete;
+
+    /// \brief
+    ///   Move assignment of \c http2_client.
+    /// \param[in, out] other
+    ///   The \c http2_client object to move. The moved object will be empty.
+    /// \return
+    ///   Reference to this \c http2_client object.
+    auto operator=(http2_client &&other) noexcept -> http2_client & {
+        if (this != &other) [[likely]] {
+            this->close();
+            m_connection = std::move(other.m_connection);
+        }
+        return *this;
+    }
+
+    /// \brief
+    ///   Connect to an HTTP/2 server. The connection preface is sent without waiting for the
+    ///   server's \c SETTINGS frame.
+    /// \param address
+    ///   Address of the HTTP/2 server.
+    /// \param authority
+    ///   Value of the \c :authority pseudo-header field of requests.
+    /// \param settings
+    ///   Settings announced to the server.
+    /// \return
+    ///   A system error code that indicates the result of the connect operation. The error code
+    ///   is 0 if succeeded.
+    [[nodiscard]]
+    OSSIA_API auto connect_async(const inet_address &address,
+                                 std::string_view    authority,
+                                 http2_settings      settings = {}) noexcept
+        -> future<std::error_code>;
+
+    /// \brief
+    ///   Send a request and wait for the response. The request body is sent as the flow control
+    ///   windows allow. \p path and \p body must be kept alive until this operation completes.
+    /// \param method
+    ///   Method of the request.
+    /// \param path
+    ///   Request target, such as \c /index.html.
+    /// \param body
+    ///   Body of the request.
+    /// \return
+    ///   The response if succeeded. Otherwise, return a system error code.
+    ///   \c std::errc::resource_unavailable_try_again is returned if the server's limit of
+    ///   concurrent streams is reached, and \c std::errc::connection_reset is returned if the
+    ///   stream is reset or the connection is closed.
+    [[nodiscard]]
+    auto request_async(std::string_view method,
+                       std::string_view path,
+                       std::string_view body = {}) noexcept
+        -> future<std::expected<http2_response, std::error_code>> {
+        return request(m_connection, method, path, body);
+    }
+
+    /// \brief
+    ///   Close the connection. Pending requests complete with an error.
+    OSSIA_API auto close() noexcept -> void;
+
+private:
+    /// \brief
+    ///   Send a request while keeping the connection alive.
+    [[nodiscard]]
+    OSSIA_API static auto request(std::shared_ptr<detail::http2_connection> connection,
+                                  std::string_view                          method,
+                                  std::string_view                          path,
+                                  std::string_view                          body) noexcept
+        -> future<std::expected<http2_response, std::error_code>>;
+
+    /// \brief
+    ///   Receive frames until the connection is closed.
+    static auto read_loop(std::shared_ptr<detail::http2_connection> connection) noexcept
+        -> future<>;
+
+private:
+    std::shared_ptr<detail::http2_connection> m_connection;
+};
+
+} // namespace ossia
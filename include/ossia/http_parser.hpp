@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace ossia {
+
+/// \enum http_parse_error
+/// \brief
+///   Errors that may occur when parsing HTTP/1.x messages.
+enum class http_parse_error {
+    /// \brief
+    ///   More data is required to parse the message.
+    incomplete,
+
+    /// \brief
+    ///   The message is malformed and should be rejected with \c 400 Bad Request.
+    invalid,
+
+    /// \brief
+    ///   The message contains more header fields than \c http_request::max_headers.
+    too_many_headers,
+
+    /// \brief
+    ///   The message uses a transfer coding that is not supported.
+    unsupported_transfer_coding,
+};
+
+/// \struct http_header
+/// \brief
+///   A single HTTP header field. Name and value are views into the buffer that the message is
+///   parsed from.
+struct http_header {
+    std::string_view name;
+    std::string_view value;
+};
+
+class http_request;
+
+/// \brief
+///   Parse request line and header fields of an HTTP/1.x request. Delimiters are scanned and
+///   tokens are validated with SIMD instructions when available. No memory is allocated and all
+///   views in \p request refer to \p data.
+/// \param data
+///   Buffer that contains the request. The buffer may contain more than one request.
+/// \param[out] request
+///   The request object to store the parse result. Body of the request is not parsed.
+/// \return
+///   Size in byte of the request line and header fields including the terminating empty line if
+///   succeeded. Otherwise, return an \c http_parse_error that represents the parse error.
+OSSIA_API auto parse_http_request(std::string_view data, http_request &request) noexcept
+    -> std::expected<std::size_t, http_parse_error>;
+
+/// \class http_request
+/// \brief
+///   Zero-copy view of an HTTP/1.x request. All string views refer to the buffer that the request
+///   is parsed from and become dangling once that buffer is modified or released.
+class http_request {
+public:
+    /// \brief
+    ///   Maximum number of header fields in a single request.
+    static constexpr std::size_t max_headers = 64;
+
+    /// \brief
+    ///   Create an empty HTTP request.
+    http_request() noexcept
+        : m_method(),
+          m_target(),
+          m_body(),
+          m_content_length(),
+          m_minor_version(),
+          m_header_count(),
+          m_is_chunked(),
+          m_keep_alive(),
+          m_headers() {}
+
+    /// \brief
+    ///   Get request method.
+    /// \return
+    ///   Request method. Methods are case-sensitive.
+    [[nodiscard]]
+    auto method() const noexcept -> std::string_view {
+        return m_method;
+    }
+
+    /// \brief
+    ///   Get request target. This is usually the origin-form path and query of the request.
+    /// \return
+    ///   Request target as is.
+    [[nodiscard]]
+    auto target() const noexcept -> std::string_view {
+        return m_target;
+    }
+
+    /// \brief
+    ///   Get minor version of the HTTP protocol used by this request.
+    /// \return
+    ///   \c 1 for HTTP/1.1 and \c 0 for HTTP/1.0.
+    [[nodiscard]]
+    auto minor_version() const noexcept -> int {
+        return m_minor_version;
+    }
+
+    /// \brief
+    ///   Get all header fields of this request in the order they appear.
+    /// \return
+    ///   A span of header fields.
+    [[nodiscard]]
+    auto headers() const noexcept -> std::span<const http_header> {
+        return {m_headers, m_header_count};
+    }
+
+    /// \brief
+    ///   Find value of the first header field with the specified name. Header names are compared
+    ///   case-insensitively.
+    /// \param name
+    ///   Name of the header field to find.
+    /// \return
+    ///   Value of the header field if found. Otherwise, return \c std::nullopt.
+    [[nodiscard]]
+    OSSIA_API auto header(std::string_view name) const noexcept -> std::optional<std::string_view>;
+
+    /// \brief
+    ///   Get body of this request. Chunked bodies are decoded in place.
+    /// \return
+    ///   Body of this request. The body is empty if the request has no body or the body has not
+    ///   been received yet.
+    [[nodiscard]]
+    auto body() const noexcept -> std::string_view {
+        return m_body;
+    }
+
+    /// \brief
+    ///   Set body of this request. This is used by connection handlers after the body is received.
+    /// \param body
+    ///   The request body.
+    auto set_body(std::string_view body) noexcept -> void {
+        m_body = body;
+    }
+
+    /// \brief
+    ///   Get value of the \c Content-Length header field.
+    /// \return
+    ///   Length of the request body in bytes. This value is 0 if the request does not have a
+    ///   \c Content-Length header field.
+    [[nodiscard]]
+    auto content_length() const noexcept -> std::uint64_t {
+        return m_content_length;
+    }
+
+    /// \brief
+    ///   Checks if the request body uses chunked transfer coding.
+    /// \retval true
+    ///   The request body is chunked.
+    /// \retval false
+    ///   The request body is not chunked.
+    [[nodiscard]]
+    auto is_chunked() const noexcept -> bool {
+        return m_is_chunked;
+    }
+
+    /// \brief
+    ///   Checks if the connection should be kept alive after this request according to the
+    ///   protocol version and the \c Connection header field.
+    /// \retval true
+    ///   The connection is persistent.
+    /// \retval false
+    ///   The connection should be closed after responding to this request.
+    [[nodiscard]]
+    auto keep_alive() const noexcept -> bool {
+        return m_keep_alive;
+    }
+
+    friend auto parse_http_request(std::string_view data, http_request &request) noexcept
+        -> std::expected<std::size_t, http_parse_error>;
+
+private:
+    std::string_view m_method;
+    std::string_view m_target;
+    std::string_view m_body;
+    std::uint64_t    m_content_length;
+    int              m_minor_version;
+    std::uint32_t    m_header_count;
+    bool             m_is_chunked;
+    bool             m_keep_alive;
+    http_header      m_headers[max_headers];
+};
+
+/// \struct http_chunked_result
+/// \brief
+///   Result of decoding a chunked message body.
+struct http_chunked_result {
+    /// \brief
+    ///   Size in byte of the encoded body in the buffer, including the last chunk and trailers.
+    std::size_t consumed;
+
+    /// \brief
+    ///   Size in byte of the decoded body. The decoded body starts at the beginning of the buffer.
+    std::size_t size;
+};
+
+/// \brief
+///   Decode a chunked message body in place. The buffer is not modified if the chunked body is
+///   incomplete or malformed.
+/// \param[in, out] data
+///   Buffer that starts with the chunked body. Decoded data is moved to the beginning of the
+///   buffer. Data after the chunked body is not modified.
+/// \return
+///   Size of the encoded and decoded body if succeeded. Otherwise, return an \c http_parse_error
+///   that represents the parse error.
+OSSIA_API auto decode_http_chunked(std::span<char> data) noexcept
+    -> std::expected<http_chunked_result, http_parse_error>;
+
+} // namespace ossia
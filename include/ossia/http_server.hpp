@@ -0,0 +1,475 @@
+#pragma once
+
+#include "connection_pool.hpp"
+#include "http_parser.hpp"
+#include "tcp_server.hpp"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ossia {
+
+/// \class http_response
+/// \brief
+///   HTTP/1.1 response to be sent to the client. Header fields and body are stored in buffers that
+///   are reused across requests of the same connection, so no memory is allocated once the
+///   buffers are large enough.
+class http_response {
+public:
+    /// \brief
+    ///   Create an empty \c 200 OK response.
+    http_response() noexcept : m_status(200), m_keep_alive(true), m_headers(), m_body() {}
+
+    /// \brief
+    ///   Get status code of this response.
+    /// \return
+    ///   Status code of this response.
+    [[nodiscard]]
+    auto status() const noexcept -> std::uint16_t {
+        return m_status;
+    }
+
+    /// \brief
+    ///   Set status code of this response.
+    /// \param status
+    ///   The status code to be set. The status code should be in range [100, 999].
+    auto set_status(std::uint16_t status) noexcept -> void {
+        m_status = status;
+    }
+
+    /// \brief
+    ///   Append a header field to this response. \c Content-Length and \c Connection header fields
+    ///   are generated automatically and should not be added manually.
+    /// \param name
+    ///   Name of the header field.
+    /// \param value
+    ///   Value of the header field.
+    auto add_header(std::string_view name, std::string_view value) -> void {
+        m_headers.append(name);
+        m_headers.append(": ");
+        m_headers.append(value);
+        m_headers.append("\r\n");
+    }
+
+    /// \brief
+    ///   Get serialized header fields of this response.
+    /// \return
+    ///   Header fields added to this response. Each header field is terminated with CRLF.
+    [[nodiscard]]
+    auto headers() const noexcept -> std::string_view {
+        return m_headers;
+    }
+
+    /// \brief
+    ///   Get body of this response.
+    /// \return
+    ///   Reference to the body buffer of this response.
+    [[nodiscard]]
+    auto body() noexcept -> std::string & {
+        return m_body;
+    }
+
+    /// \brief
+    ///   Get body of this response.
+    /// \return
+    ///   Body of this response.
+    [[nodiscard]]
+    auto body() const noexcept -> std::string_view {
+        return m_body;
+    }
+
+    /// \brief
+    ///   Replace body of this response.
+    /// \param body
+    ///   The new body of this response.
+    auto set_body(std::string_view body) -> void {
+        m_body.assign(body);
+    }
+
+    /// \brief
+    ///   Checks if the connection should be kept alive after this response.
+    /// \retval true
+    ///   The connection is kept alive.
+    /// \retval false
+    ///   The connection will be closed after this response is sent.
+    [[nodiscard]]
+    auto keep_alive() const noexcept -> bool {
+        return m_keep_alive;
+    }
+
+    /// \brief
+    ///   Set whether the connection should be kept alive after this response. This is initialized
+    ///   from the request and could only be used to close a persistent connection.
+    /// \param enable
+    ///   \c true to keep the connection alive. \c false to close the connection.
+    auto set_keep_alive(bool enable) noexcept -> void {
+        m_keep_alive = enable;
+    }
+
+    /// \brief
+    ///   Reset this response to an empty \c 200 OK response. Buffers are not released.
+    auto clear() noexcept -> void {
+        m_status     = 200;
+        m_keep_alive = true;
+        m_headers.clear();
+        m_body.clear();
+    }
+
+private:
+    std::uint16_t m_status;
+    bool          m_keep_alive;
+    std::string   m_headers;
+    std::string   m_body;
+};
+
+namespace detail {
+
+/// \class http_input
+/// \brief
+///   For internal usage. Receive buffer of an HTTP/1.1 connection. Requests are parsed in place
+///   and pipelined requests are handled one by one without copying.
+class http_input {
+public:
+    /// \brief
+    ///   Create a new receive buffer.
+    /// \param capacity
+    ///   Initial capacity in byte of the buffer.
+    /// \param limit
+    ///   Maximum size in byte of a single request including its body.
+    OSSIA_API http_input(std::size_t capacity, std::size_t limit);
+
+    /// \brief
+    ///   Parse the next request in this buffer.
+    /// \param[out] request
+    ///   The request object to store the parse result.
+    /// \return
+    ///   Size in byte of the request including its body if a complete request is parsed. Return 0
+    ///   if more data is required. Return the status code that the request should be rejected with
+    ///   if the request is malformed or too large.
+    [[nodiscard]]
+    OSSIA_API auto next(http_request &request) noexcept
+        -> std::expected<std::size_t, std::uint16_t>;
+
+    /// \brief
+    ///   Discard data that has been handled.
+    /// \param size
+    ///   Size in byte of data to discard.
+    auto consume(std::size_t size) noexcept -> void {
+        m_begin += size;
+    }
+
+    /// \brief
+    ///   Make room for receiving more data. Unhandled data will be moved to the beginning of the
+    ///   buffer. The buffer may grow up to the request size limit.
+    OSSIA_API auto prepare() -> void;
+
+    /// \brief
+    ///   Get pointer to the free space of this buffer.
+    /// \return
+    ///   Pointer to the free space of this buffer.
+    [[nodiscard]]
+    auto free_data() noexcept -> char * {
+        return m_data.get() + m_end;
+    }
+
+    /// \brief
+    ///   Get size in byte of the free space of this buffer.
+    /// \return
+    ///   Size in byte of the free space of this buffer.
+    [[nodiscard]]
+    auto free_size() const noexcept -> std::uint32_t {
+        return static_cast<std::uint32_t>(m_capacity - m_end);
+    }
+
+    /// \brief
+    ///   Mark received data as valid.
+    /// \param size
+    ///   Size in byte of the received data.
+    auto commit(std::size_t size) noexcept -> void {
+        m_end += size;
+    }
+
+    /// \brief
+    ///   Discard all data so that this buffer could be reused by another connection.
+    /// \param max_capacity
+    ///   Maximum capacity in byte to keep. A buffer that has grown larger than this for large
+    ///   requests is replaced with a new buffer of \p capacity bytes.
+    /// \param capacity
+    ///   Capacity in byte of the new buffer.
+    /// \throws std::bad_alloc
+    ///   Thrown if failed to allocate the new buffer.
+    OSSIA_API auto reset(std::size_t max_capacity, std::size_t capacity) -> void;
+
+private:
+    std::unique_ptr<char[]> m_data;
+    std::size_t             m_begin;
+    std::size_t             m_end;
+    std::size_t             m_capacity;
+    std::size_t             m_limit;
+};
+
+/// \struct http_connection
+/// \brief
+///   For internal usage. Per-connection state of an HTTP/1.1 connection. Connection states are
+///   pooled by \c http_server so that buffers are reused across connections.
+struct http_connection {
+    /// \brief
+    ///   Create a new connection state.
+    /// \param capacity
+    ///   Initial capacity in byte of the receive buffer.
+    /// \param limit
+    ///   Maximum size in byte of a single request including its body.
+    http_connection(std::size_t capacity, std::size_t limit)
+        : input(capacity, limit),
+          request(),
+          response(),
+          output(),
+          buffer_size(capacity) {}
+
+    /// \brief
+    ///   Reset this connection state in place for a new connection. Buffers that have grown
+    ///   larger than \c max_retained_buffer for large requests are released.
+    /// \retval true
+    ///   This connection state is ready for a new connection.
+    /// \retval false
+    ///   Failed to allocate a new receive buffer. This connection state should be released.
+    OSSIA_API auto recycle() noexcept -> bool;
+
+    http_input    input;
+    http_request  request;
+    http_response response;
+    std::string   output;
+
+    /// \brief
+    ///   Initial capacity in byte of the receive buffer.
+    std::size_t buffer_size;
+};
+
+/// \brief
+///   For internal usage. Serialize an HTTP/1.1 response and append it to the output buffer.
+/// \param request
+///   The request that this response is responding to.
+/// \param response
+///   The response to be serialized.
+/// \param[out] output
+///   The output buffer to append the serialized response.
+OSSIA_API auto write_http_response(const http_request  &request,
+                                   const http_response &response,
+                                   std::string         &output) -> void;
+
+/// \brief
+///   For internal usage. Serialize an error response that closes the connection and append it to
+///   the output buffer.
+/// \param status
+///   Status code of the error response.
+/// \param[out] output
+///   The output buffer to append the serialized response.
+OSSIA_API auto write_http_error(std::uint16_t status, std::string &output) -> void;
+
+} // namespace detail
+
+/// \class http_server
+/// \brief
+///   HTTP/1.1 server based on \c tcp_server. Persistent connections and pipelining are supported.
+///   Responses to pipelined requests are batched and sent with a single send operation. This
+///   class could only be used in workers.
+class http_server {
+public:
+    /// \brief
+    ///   Default initial capacity in byte of the per-connection receive buffer.
+    static constexpr std::size_t default_buffer_size = 16384;
+
+    /// \brief
+    ///   Default maximum size in byte of a single request including its body.
+    static constexpr std::size_t default_request_limit = 1048576;
+
+    /// \brief
+    ///   Create a new \c http_server object. Empty server object is not valid for use before
+    ///   binding.
+    http_server() noexcept = default;
+
+    /// \brief
+    ///   Get local address of this server. It is undefined behavior to get local address of an
+    ///   empty server.
+    /// \return
+    ///   Local address of this server.
+    [[nodiscard]]
+    auto local_address() const noexcept -> const inet_address & {
+        return m_server.local_address();
+    }
+
+    /// \brief
+    ///   Start listening on the specified address. \c SO_REUSEPORT is enabled so that each worker
+    ///   could bind its own server to the same address.
+    /// \param[in] address
+    ///   The address to bind. The address could be either an IPv4 or IPv6 address.
+    /// \return
+    ///   An \c std::error_code object that represents system error. The error code is 0 if this
+    ///   operation is succeeded.
+    auto bind(const inet_address &address) noexcept -> std::error_code {
+        return m_server.bind(address);
+    }
+
+    /// \brief
+    ///   Stop listening. Pending accept operation will fail and \c run will return.
+    auto close() noexcept -> void {
+        m_server.close();
+    }
+
+    /// \brief
+    ///   Get number of idle connection states kept for new connections in the current worker.
+    ///   All HTTP servers in a worker share these connection states.
+    /// \return
+    ///   Number of idle connection states of the current worker.
+    [[nodiscard]]
+    auto pooled_connections() const noexcept -> std::size_t {
+        return detail::connection_pool<detail::http_connection>::local().size();
+    }
+
+    /// \brief
+    ///   Accept incoming connections and serve them in current worker until this server is closed.
+    ///   Connection states are pooled per worker, so that accepting a connection allocates nothing
+    ///   once the pool is warm if \c io_context_options::coroutine_frame_pool is enabled as well.
+    /// \tparam Handler
+    ///   Type of the request handler. The handler is invoked as
+    ///   <tt>handler(const http_request &, http_response &)</tt> and may either return \c void or
+    ///   \c future<>. Each connection holds its own copy of the handler.
+    /// \param handler
+    ///   The request handler.
+    template <class Handler>
+    auto run(Handler handler) noexcept -> future<> {
+        while (true) {
+            auto stream = co_await m_server.accept_async<no_delay_tcp_policy>();
+            if (!stream.has_value()) [[unlikely]] {
+                if (stream.error() == std::errc::connection_aborted)
+                    continue;
+                co_return;
+            }
+
+            schedule(serve_pooled(std::move(stream->base()), handler));
+        }
+    }
+
+    /// \brief
+    ///   Serve a single HTTP/1.1 connection until the peer closes the connection, any IO error
+    ///   occurs, or a response closes the connection. Requests are answered with \c 503 while
+    ///   the worker is overloaded. See \c io_context_options::shedding_target.
+    /// \tparam Handler
+    ///   Type of the request handler. See \c run for details.
+    /// \param stream
+    ///   The connection to be served.
+    /// \param handler
+    ///   The request handler.
+    /// \param limit
+    ///   Maximum size in byte of a single request including its body.
+    template <class Handler>
+    static auto serve(tcp_stream  stream,
+                      Handler     handler,
+                      std::size_t limit = default_request_limit) noexcept -> future<> {
+        detail::http_connection connection(default_buffer_size, limit);
+        co_await serve_connection(std::move(stream), std::move(handler), connection);
+    }
+
+private:
+    /// \brief
+    ///   Serve a single HTTP/1.1 connection with a connection state taken from the connection
+    ///   pool of the current worker.
+    /// \tparam Handler
+    ///   Type of the request handler. See \c run for details.
+    /// \param stream
+    ///   The connection to be served.
+    /// \param handler
+    ///   The request handler.
+    template <class Handler>
+    static auto serve_pooled(tcp_stream stream, Handler handler) noexcept -> future<> {
+        auto &pool       = detail::connection_pool<detail::http_connection>::local();
+        auto  connection = pool.acquire(default_buffer_size, default_request_limit);
+        co_await serve_connection(std::move(stream), std::move(handler), *connection);
+        pool.release(std::move(connection));
+    }
+
+    /// \brief
+    ///   Serve a single HTTP/1.1 connection with the specified connection state.
+    /// \tparam Handler
+    ///   Type of the request handler. See \c run for details.
+    /// \param stream
+    ///   The connection to be served.
+    /// \param handler
+    ///   The request handler.
+    /// \param[in, out] connection
+    ///   Buffers of this connection.
+    template <class Handler>
+    static auto serve_connection(tcp_stream               stream,
+                                 Handler                  handler,
+                                 detail::http_connection &connection) noexcept -> future<> {
+        using result_type = std::invoke_result_t<Handler &, const http_request &, http_response &>;
+
+        detail::http_input &input      = connection.input;
+        http_request       &request    = connection.request;
+        http_response      &response   = connection.response;
+        std::string        &output     = connection.output;
+        bool                keep_alive = true;
+
+        while (true) {
+            // Handle all buffered requests. Responses are appended to the output buffer.
+            while (keep_alive) {
+                auto size = input.next(request);
+                if (!size.has_value()) {
+                    detail::write_http_error(size.error(), output);
+                    keep_alive = false;
+                    break;
+                }
+
+                if (*size == 0)
+                    break;
+
+                response.clear();
+                response.set_keep_alive(request.keep_alive());
+
+                // Reject the request without invoking the handler while the worker is overloaded.
+                if (!admit_request()) [[unlikely]] {
+                    response.set_status(503);
+                    response.add_header("Retry-After", "1");
+                } else if constexpr (std::is_same_v<result_type, future<>>) {
+                    co_await handler(std::as_const(request), response);
+                } else {
+                    handler(std::as_const(request), response);
+                }
+
+                detail::write_http_response(request, response, output);
+                keep_alive = response.keep_alive();
+                input.consume(*size);
+            }
+
+            // Send all batched responses at once.
+            std::size_t sent = 0;
+            while (sent < output.size()) {
+                auto result = co_await stream.send_async(
+                    output.data() + sent, static_cast<std::uint32_t>(output.size() - sent));
+                if (!result.has_value()) [[unlikely]]
+                    co_return;
+                sent += *result;
+            }
+
+            output.clear();
+            if (!keep_alive)
+                co_return;
+
+            // Receive more data.
+            input.prepare();
+            auto result = co_await stream.receive_async(input.free_data(), input.free_size());
+            if (!result.has_value() || *result == 0)
+                co_return;
+
+            input.commit(*result);
+        }
+    }
+
+private:
+    tcp_server m_server;
+};
+
+} // namespace ossia
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ossia {
+
+/// \class huge_page_buffer
+/// \brief
+///   A block of memory allocated directly from the operating system, preferably backed by huge
+///   pages to reduce TLB misses. On Linux, \c MAP_HUGETLB pages are tried first. If no huge page is
+///   reserved, normal pages aligned to the huge page size are allocated and advised for
+///   transparent huge pages instead. On Windows, large pages are used if the process holds the
+///   \c SeLockMemoryPrivilege. The memory is zero-initialized.
+class huge_page_buffer {
+public:
+    /// \brief
+    ///   Size in byte of a huge page. Sizes of buffers are rounded up to multiple of this value.
+    static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+    /// \brief
+    ///   Create an empty \c huge_page_buffer object.
+    huge_page_buffer() noexcept : m_data(), m_size(), m_is_huge_page() {}
+
+    /// \brief
+    ///   Allocate a new buffer. Normal pages are used if huge pages are not available.
+    /// \param size
+    ///   Minimum size in byte of the buffer.
+    /// \throws std::bad_alloc
+    ///   Thrown if failed to allocate memory.
+    OSSIA_API explicit huge_page_buffer(std::size_t size);
+
+    /// \brief
+    ///   \c huge_page_buffer is not copyable.
+    huge_page_buffer(const huge_page_buffer &other) = delete;
+
+    /// \brief
+    ///   Move constructor of \c huge_page_buffer.
+    /// \param[in, out] other
+    ///   The \c huge_page_buffer object to move. The moved \c huge_page_buffer object will be
+    ///   empty.
+    huge_page_buffer(huge_page_buffer &&other) noexcept
+        : m_data(other.m_data),
+          m_size(other.m_size),
+          m_is_huge_page(other.m_is_huge_page) {
+        other.m_data         = nullptr;
+        other.m_size         = 0;
+        other.m_is_huge_page = false;
+    }
+
+    /// \brief
+    ///   Release the memory of this buffer.
+    OSSIA_API ~huge_page_buffer();
+
+    /// \brief
+    ///   \c huge_page_buffer is not copyable.
+    auto operator=(const huge_page_buffer &other) = delete;
+
+    /// \brief
+    ///   Move assignment operator of \c huge_page_buffer.
+    /// \param[in, out] other
+    ///   The \c huge_page_buffer object to move. The moved \c huge_page_buffer object will be
+    ///   empty.
+    /// \return
+    ///   Reference to this \c huge_page_buffer object.
+    OSSIA_API auto operator=(huge_page_buffer &&other) noexcept -> huge_page_buffer &;
+
+    /// \brief
+    ///   Get start address of this buffer.
+    /// \return
+    ///   Start address of this buffer. Return \c nullptr if this is an empty buffer.
+    [[nodiscard]]
+    auto data() const noexcept -> void * {
+        return m_data;
+    }
+
+    /// \brief
+    ///   Get size in byte of this buffer.
+    /// \return
+    ///   Size in byte of this buffer. This is a multiple of \c huge_page_size.
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t {
+        return m_size;
+    }
+
+    /// \brief
+    ///   Checks if this buffer is backed by reserved huge pages.
+    /// \retval true
+    ///   This buffer is backed by huge pages.
+    /// \retval false
+    ///   This buffer is backed by normal pages, or this is an empty buffer. The kernel may still
+    ///   promote normal pages to transparent huge pages.
+    [[nodiscard]]
+    auto is_huge_page() const noexcept -> bool {
+        return m_is_huge_page;
+    }
+
+private:
+    void       *m_data;
+    std::size_t m_size;
+    bool        m_is_huge_page;
+};
+
+} // namespace ossia
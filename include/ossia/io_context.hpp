@@ -1,12 +1,228 @@
 #pragma once
 
 #include "future.hpp"
+#include "huge_page.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
 #include <memory>
+#include <system_error>
 #include <vector>
 
 namespace ossia {
+
+/// \enum submission_overflow_policy
+/// \brief
+///   Action to take when an IO request is issued while the submission queue of a worker is full.
+enum class submission_overflow_policy {
+    /// \brief
+    ///   Park the request in a worker-local overflow queue. Parked requests are moved into the
+    ///   submission queue in order as space frees up.
+    queue,
+
+    /// \brief
+    ///   Fail the request immediately with \c std::errc::resource_unavailable_try_again.
+    fail,
+};
+
+/// \struct io_context_options
+/// \brief
+///   Options for creating workers of IO contexts. Async worker limits and affinity keep the
+///   kernel defaults unless set. Other defaults differ from a plain ring: workers share one async
+///   worker backend with \c IORING_SETUP_ATTACH_WQ, the submission queue has 32768 entries, and
+///   the completion queue size is always set with \c IORING_SETUP_CQSIZE.
+struct io_context_options {
+    /// \brief
+    ///   Share one kernel async worker backend among all workers of an IO context with
+    ///   \c IORING_SETUP_ATTACH_WQ. Since Linux 5.12 the async worker pool belongs to the
+    ///   submitting thread rather than to the ring, so on newer kernels this only matters together
+    ///   with the limits below.
+    bool share_async_workers = true;
+
+    /// \brief
+    ///   Maximum number of kernel async worker threads per worker for bounded work, such as
+    ///   regular file and block device IO. 0 keeps the kernel default.
+    std::uint32_t max_bounded_async_workers = 0;
+
+    /// \brief
+    ///   Maximum number of kernel async worker threads per worker for unbounded work, such as
+    ///   socket IO that could not be completed inline. 0 keeps the kernel default.
+    std::uint32_t max_unbounded_async_workers = 0;
+
+    /// \brief
+    ///   CPUs that kernel async worker threads are allowed to run on. Empty keeps the kernel
+    ///   default, which is the affinity of the worker thread.
+    std::vector<std::uint32_t> async_worker_cpus;
+
+    /// \brief
+    ///   Place submission and completion queues of each worker in memory allocated by
+    ///   \c huge_page_buffer with \c IORING_SETUP_NO_MMAP, instead of memory mapped by the kernel.
+    ///   Large rings then take fewer TLB entries. Workers fall back to rings mapped by the kernel
+    ///   if the kernel does not accept the memory. Requires Linux 6.5.
+    bool huge_page_rings = false;
+
+    /// \brief
+    ///   Number of buffers to register with the IO muxer of each worker. Registered buffers are
+    ///   pinned once by the kernel and carved from a single \c huge_page_buffer. See
+    ///   \c io_context_worker::acquire_buffer.
+    std::uint32_t registered_buffer_count = 0;
+
+    /// \brief
+    ///   Size in byte of each registered buffer.
+    std::uint32_t registered_buffer_size = 16384;
+
+    /// \brief
+    ///   Number of direct descriptor slots to register with the IO muxer of each worker. A pending
+    ///   \c tcp_server::accept_async with a first-read buffer holds one slot, so that the accept
+    ///   and the first receive of the new connection are linked in one submission. Accepts that
+    ///   find no free slot fall back to a plain accept. Slots are not registered if the kernel
+    ///   does not support \c IORING_OP_FIXED_FD_INSTALL, which requires Linux 6.8. Ignored on
+    ///   Windows.
+    std::uint32_t direct_descriptor_count = 0;
+
+    /// \brief
+    ///   Allocate coroutine frames from thread-local pools carved from \c huge_page_buffer slabs
+    ///   instead of the global heap. This is a process-wide setting: once any IO context is
+    ///   created with this option, the frame pool stays enabled.
+    bool coroutine_frame_pool = false;
+
+    /// \brief
+    ///   Maximum number of completions that a worker handles in one iteration before resuming the
+    ///   completed coroutines. Smaller values bound the latency of coroutines that complete first
+    ///   under bursts. 0 means no limit.
+    std::uint32_t max_completion_batch = 1024;
+
+    /// \brief
+    ///   Action to take when an IO request is issued while the submission queue is full.
+    submission_overflow_policy submission_overflow = submission_overflow_policy::queue;
+
+    /// \brief
+    ///   Number of submission queue entries of each worker. The kernel rounds this up to power of
+    ///   2 and clamps it to 32768.
+    std::uint32_t submission_queue_entries = 32768;
+
+    /// \brief
+    ///   Size of the completion queue relative to the submission queue. Multishot operations and
+    ///   bursts of completions may overflow a small completion queue. Overflowed completions are
+    ///   kept by the kernel and flushed by workers, but they are slower to handle. The completion
+    ///   queue is never smaller than the submission queue and is clamped to 65536 entries.
+    std::uint32_t completion_queue_factor = 2;
+
+    /// \brief
+    ///   Target of the queue delay for adaptive load shedding. The queue delay is the time from
+    ///   reaping a completion to resuming its coroutine. If it stays above this target for a whole
+    ///   \c shedding_interval, the worker is overloaded: accepts are paused and
+    ///   \c admit_request rejects new requests until the queue delay drops below the target
+    ///   again. Zero disables load shedding.
+    std::chrono::steady_clock::duration shedding_target{};
+
+    /// \brief
+    ///   Time that the queue delay must stay above \c shedding_target before the worker is
+    ///   considered overloaded. Short bursts within this interval are absorbed by the queue.
+    std::chrono::steady_clock::duration shedding_interval = std::chrono::milliseconds(100);
+};
+
+/// \struct registered_buffer
+/// \brief
+///   A buffer registered with the IO muxer of a worker. IO requests on registered buffers skip
+///   pinning and mapping the pages for each request. A registered buffer could only be used in
+///   the worker that it is acquired from.
+struct registered_buffer {
+    /// \brief
+    ///   Start address of the buffer.
+    void *data;
+
+    /// \brief
+    ///   Size in byte of the buffer.
+    std::uint32_t size;
+
+    /// \brief
+    ///   Index of the buffer in the registered buffer table of the worker.
+    std::uint32_t index;
+};
+
+/// \struct worker_stats
+/// \brief
+///   Statistics of an IO context worker.
+struct worker_stats {
+    /// \brief
+    ///   Limit of kernel async worker threads for bounded work. 0 if unknown.
+    std::uint32_t bounded_async_worker_limit;
+
+    /// \brief
+    ///   Limit of kernel async worker threads for unbounded work. 0 if unknown.
+    std::uint32_t unbounded_async_worker_limit;
+
+    /// \brief
+    ///   Number of kernel async worker threads that are currently alive for this worker.
+    std::uint32_t async_worker_threads;
+
+    /// \brief
+    ///   Number of registered buffers that are not acquired.
+    std::uint32_t available_buffers;
+
+    /// \brief
+    ///   Whether the submission and completion queues are placed in reserved huge pages.
+    bool huge_page_ring;
+
+    /// \brief
+    ///   Whether the registered buffers are placed in reserved huge pages.
+    bool huge_page_buffers;
+
+    /// \brief
+    ///   Number of IO requests that are parked in the overflow queue and not submitted yet.
+    std::uint64_t pending_submissions;
+
+    /// \brief
+    ///   Total number of IO requests that were parked because the submission queue was full.
+    std::uint64_t overflowed_submissions;
+
+    /// \brief
+    ///   Total number of IO requests that failed because the submission queue was full.
+    std::uint64_t rejected_submissions;
+
+    /// \brief
+    ///   Number of times that the completion queue overflowed and completions backlogged by the
+    ///   kernel were flushed.
+    std::uint64_t completion_overflows;
+
+    /// \brief
+    ///   Number of completions dropped by the kernel. This is non-zero only if the kernel failed to
+    ///   backlog overflowed completions, in which case coroutines waiting for them are never
+    ///   resumed.
+    std::uint64_t dropped_completions;
+
+    /// \brief
+    ///   Largest number of completions handled in one iteration. This never exceeds
+    ///   \c io_context_options::max_completion_batch in \c io_context_worker::run.
+    std::uint64_t largest_completion_batch;
+
+    /// \brief
+    ///   Queue delay in nanoseconds measured in the latest iteration. This is only measured if
+    ///   load shedding is enabled.
+    std::uint64_t queue_delay;
+
+    /// \brief
+    ///   Whether the worker is currently overloaded and shedding load.
+    bool overloaded;
+
+    /// \brief
+    ///   Number of times that the worker became overloaded.
+    std::uint64_t overload_events;
+
+    /// \brief
+    ///   Total number of requests rejected by \c admit_request.
+    std::uint64_t shed_requests;
+
+    /// \brief
+    ///   Total number of accept operations paused while the worker was overloaded.
+    std::uint64_t paused_accepts;
+};
+
 namespace detail {
 
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
@@ -32,8 +248,96 @@ struct overlapped {
     std::int32_t  result;
     promise_base *promise;
 };
+
+/// \struct multishot_overlapped
+/// \brief
+///   Overlapped structure for Linux \c io_uring multishot operations. A multishot operation may
+///   complete many times before the waiting coroutine is resumed, so completions are handed to
+///   \c complete instead of resuming \c promise directly. Submit multishot operations with
+///   \c multishot_tag set in the user data.
+struct multishot_overlapped : overlapped {
+    /// \brief
+    ///   Completion handler. \c flags and \c result are set before this handler is called in the
+    ///   worker thread. The handler must not resume any coroutine directly.
+    void (*complete)(multishot_overlapped *ovlp) noexcept;
+};
+
+/// \brief
+///   Tag bit in \c io_uring user data that marks a \c multishot_overlapped.
+inline constexpr std::uintptr_t multishot_tag = 1;
 #endif
 
+/// \struct submission_entry
+/// \brief
+///   For internal usage. Storage of a submission queue entry that is parked in the overflow queue
+///   of a worker. This has the same size as \c io_uring_sqe.
+struct submission_entry {
+    alignas(8) std::byte data[64];
+};
+
+/// \struct kernel_timespec
+/// \brief
+///   For internal usage. Relative timeout of asynchronous operations. This structure has the same
+///   layout as \c __kernel_timespec so that it could be passed to \c io_uring directly.
+struct kernel_timespec {
+    std::int64_t seconds;
+    std::int64_t nanoseconds;
+};
+
+/// \brief
+///   For internal usage. Convert a duration into \c kernel_timespec.
+/// \tparam Rep
+///   Type of the duration representation.
+/// \tparam Duration
+///   Type of the duration.
+/// \param duration
+///   The duration to be converted. Negative durations are treated as 0.
+/// \return
+///   The converted \c kernel_timespec object.
+template <class Rep, class Duration>
+[[nodiscard]]
+constexpr auto make_kernel_timespec(std::chrono::duration<Rep, Duration> duration) noexcept
+    -> kernel_timespec {
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    nanoseconds      = nanoseconds < 0 ? 0 : nanoseconds;
+    return kernel_timespec{
+        .seconds     = nanoseconds / 1000000000,
+        .nanoseconds = nanoseconds % 1000000000,
+    };
+}
+
+/// \brief
+///   For internal usage. Install a function that every worker calls in its own thread at the
+///   start of each iteration, before timers expire. Modules use this to keep per-thread state of
+///   workers up to date without the worker depending on them. Only one hook is kept, and it stays
+///   installed once set.
+/// \param hook
+///   The function to call. Pass \c nullptr to remove the hook.
+OSSIA_API auto set_iteration_hook(void (*hook)() noexcept) noexcept -> void;
+
+/// \struct timer_entry
+/// \brief
+///   For internal usage. A timer in the timer queue of a worker. Timers are kept in the worker
+///   thread only, so no lock is required. The timer object must be alive until it expires.
+struct timer_entry {
+    /// \brief
+    ///   Time point at which this timer expires.
+    std::chrono::steady_clock::time_point deadline;
+
+    /// \brief
+    ///   Promise of the coroutine to resume when this timer expires if \c expire is \c nullptr.
+    promise_base *promise;
+
+    /// \brief
+    ///   Expiration handler. This handler is called in the worker thread and must not resume any
+    ///   coroutine directly. It may issue IO requests or post \c promise to the worker.
+    void (*expire)(timer_entry *timer) noexcept;
+
+    /// \brief
+    ///   User data of the expiration handler.
+    void *context;
+};
+
 /// \class io_context_worker
 /// \brief
 ///   Worker class for IO context.
@@ -46,6 +350,18 @@ public:
     ///   Thrown if failed to initialize the IO muxer.
     OSSIA_API io_context_worker();
 
+    /// \brief
+    ///   Create a new worker with the specified options and initialize the IO muxer.
+    /// \param options
+    ///   Options of this worker.
+    /// \param[in] backend
+    ///   Another worker to share the kernel async worker backend with. This worker creates its own
+    ///   backend if this is \c nullptr or \c io_context_options::share_async_workers is \c false.
+    /// \throws std::system_error
+    ///   Thrown if failed to initialize the IO muxer.
+    OSSIA_API io_context_worker(const io_context_options &options,
+                                const io_context_worker  *backend);
+
     /// \brief
     ///   \c io_context_worker is not copyable.
     io_context_worker(const io_context_worker &other) = delete;
@@ -92,6 +408,30 @@ public:
     ///   running.
     OSSIA_API auto run() noexcept -> void;
 
+    /// \brief
+    ///   Handle completions and timers that are ready and resume their coroutines without blocking.
+    ///   This is used to drive this worker from an external event loop, such as a GUI main loop or
+    ///   another reactor, instead of \c run. Wait for \c poll_handle to become readable and then
+    ///   call this method. Timers do not signal the poll handle, so the host loop should also call
+    ///   this method periodically if timers are used. This method must always be called in the
+    ///   same thread, and does nothing if this worker is running in another thread.
+    /// \param max_events
+    ///   Maximum number of completions to handle in this call. Remaining completions keep the poll
+    ///   handle readable.
+    /// \return
+    ///   Number of completions handled.
+    OSSIA_API auto poll_once(std::size_t max_events = SIZE_MAX) noexcept -> std::size_t;
+
+    /// \brief
+    ///   Get a file descriptor that becomes readable when this worker has completions or posted
+    ///   tasks to handle with \c poll_once. On Linux, this is an \c eventfd registered with the
+    ///   \c io_uring, created on the first call. The file descriptor is owned by this worker and
+    ///   should only be polled for readability.
+    /// \return
+    ///   The pollable file descriptor if succeeded. Otherwise, return a system error code.
+    ///   \c std::errc::operation_not_supported is returned on Windows.
+    OSSIA_API auto poll_handle() noexcept -> std::expected<std::uintptr_t, std::error_code>;
+
     /// \brief
     ///   Request this worker to stop. This method only sets the stop flag and does not block. It
     ///   may take some time to stop the worker.
@@ -112,6 +452,103 @@ public:
         this->schedule(&coroutine.promise());
     }
 
+    /// \brief
+    ///   For internal usage. Resume a suspended coroutine in the next iteration of this worker.
+    ///   This method must be called in the worker thread. Unlike \c schedule, no IO request is
+    ///   submitted, so resuming many coroutines in one iteration is cheap.
+    /// \param[in] promise
+    ///   Promise of the suspended coroutine to be resumed.
+    auto post(promise_base *promise) noexcept -> void {
+        m_tasks.push_back(promise);
+    }
+
+    /// \brief
+    ///   For internal usage. Add a timer to this worker. The timer is expired in the first
+    ///   iteration of this worker after its deadline. This method must be called in the worker
+    ///   thread.
+    /// \param[in] timer
+    ///   The timer to add. The timer object must be alive until it expires.
+    OSSIA_API auto add_timer(timer_entry *timer) noexcept -> void;
+
+    /// \brief
+    ///   For internal usage. Remove a timer from this worker before it expires. This method must
+    ///   be called in the worker thread.
+    /// \param[in] timer
+    ///   The timer to remove.
+    /// \retval true
+    ///   The timer is removed and will never expire.
+    /// \retval false
+    ///   The timer has already expired or was never added.
+    OSSIA_API auto cancel_timer(timer_entry *timer) noexcept -> bool;
+
+    /// \brief
+    ///   Checks if this worker is overloaded. See \c io_context_options::shedding_target.
+    /// \retval true
+    ///   This worker is overloaded and shedding load.
+    /// \retval false
+    ///   This worker is not overloaded or load shedding is disabled.
+    [[nodiscard]]
+    auto is_overloaded() const noexcept -> bool {
+        return m_overloaded.load(std::memory_order_relaxed);
+    }
+
+    /// \brief
+    ///   Decide whether a new request should be handled. Rejecting is cheap, so servers should
+    ///   check this before doing any work for a request and fail it at once if rejected. This
+    ///   method must be called in the worker thread.
+    /// \retval true
+    ///   The request should be handled.
+    /// \retval false
+    ///   This worker is overloaded and the request should be rejected.
+    [[nodiscard]]
+    auto admit_request() noexcept -> bool {
+        if (!this->is_overloaded()) [[likely]]
+            return true;
+
+        m_shed_requests.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /// \brief
+    ///   For internal usage. Defer an operation until this worker is no longer overloaded. The
+    ///   entry is expired, without regard to its deadline, once the queue delay drops below the
+    ///   target. This method must be called in the worker thread while it is overloaded.
+    /// \param[in] entry
+    ///   The deferred operation. The object must be alive until it is expired.
+    OSSIA_API auto wait_for_admission(timer_entry *entry) noexcept -> void;
+
+    /// \brief
+    ///   For internal usage. Acquire submission queue entries for IO requests. Requests that must
+    ///   be submitted together, such as linked requests, should be acquired in one call so that
+    ///   they are never split. If the submission queue is full, the entries are parked in the
+    ///   overflow queue of this worker and submitted in order later, unless the overflow policy is
+    ///   \c submission_overflow_policy::fail. This method must be called in the worker thread.
+    /// \param[out] sqes
+    ///   Array to store pointers to \p count entries. On Linux, these are \c io_uring_sqe objects.
+    /// \param count
+    ///   Number of entries to acquire.
+    /// \return
+    ///   0 if succeeded. Otherwise, return a negative system error code: \c -EAGAIN if the
+    ///   submission queue is full and requests should fail.
+    [[nodiscard]]
+    OSSIA_API auto acquire_sqes(void **sqes, std::uint32_t count) noexcept -> std::int32_t;
+
+    /// \brief
+    ///   For internal usage. Acquire a submission queue entry for an IO request. See
+    ///   \c acquire_sqes.
+    /// \param[out] error
+    ///   Negative system error code if failed. This value is not modified if succeeded.
+    /// \return
+    ///   The submission queue entry if succeeded. Otherwise, return \c nullptr.
+    [[nodiscard]]
+    auto acquire_sqe(std::int32_t &error) noexcept -> void * {
+        void        *sqe    = nullptr;
+        std::int32_t result = this->acquire_sqes(&sqe, 1);
+        if (result != 0) [[unlikely]]
+            error = result;
+        return sqe;
+    }
+
     /// \brief
     ///   For internal usage. Get the IO muxer handle.
     /// \return
@@ -130,6 +567,74 @@ public:
     [[nodiscard]]
     OSSIA_API static auto current() noexcept -> io_context_worker *;
 
+    /// \brief
+    ///   Get statistics of this worker. This method could be called in any thread.
+    /// \return
+    ///   Statistics of this worker. Kernel async worker threads are counted only while this worker
+    ///   is running.
+    [[nodiscard]]
+    OSSIA_API auto stats() const noexcept -> worker_stats;
+
+    /// \brief
+    ///   Acquire a registered buffer of this worker. This method must be called in the worker
+    ///   thread.
+    /// \return
+    ///   The registered buffer if succeeded. \c std::errc::no_buffer_space is returned if all
+    ///   registered buffers are in use or no buffer is registered.
+    [[nodiscard]]
+    auto acquire_buffer() noexcept -> std::expected<registered_buffer, std::error_code> {
+        if (m_free_buffers.empty()) [[unlikely]]
+            return std::unexpected(std::make_error_code(std::errc::no_buffer_space));
+
+        std::uint32_t index = m_free_buffers.back();
+        m_free_buffers.pop_back();
+        m_available_buffers.store(static_cast<std::uint32_t>(m_free_buffers.size()),
+                                  std::memory_order_relaxed);
+
+        return registered_buffer{
+            .data  = static_cast<std::byte *>(m_buffer_memory.data()) +
+                    static_cast<std::size_t>(index) * m_buffer_size,
+            .size  = m_buffer_size,
+            .index = index,
+        };
+    }
+
+    /// \brief
+    ///   Return a registered buffer to this worker. This method must be called in the worker
+    ///   thread that the buffer is acquired from, and no IO request may use the buffer any more.
+    /// \param buffer
+    ///   The registered buffer to release.
+    auto release_buffer(const registered_buffer &buffer) noexcept -> void {
+        m_free_buffers.push_back(buffer.index);
+        m_available_buffers.store(static_cast<std::uint32_t>(m_free_buffers.size()),
+                                  std::memory_order_relaxed);
+    }
+
+    /// \brief
+    ///   For internal usage. Acquire a free direct descriptor slot of this worker. This method must
+    ///   be called in the worker thread.
+    /// \return
+    ///   Index of the slot in the registered file table. Return -1 if all slots are in use or no
+    ///   slot is registered.
+    [[nodiscard]]
+    auto acquire_direct_descriptor() noexcept -> std::int32_t {
+        if (m_free_descriptors.empty())
+            return -1;
+
+        std::uint32_t index = m_free_descriptors.back();
+        m_free_descriptors.pop_back();
+        return static_cast<std::int32_t>(index);
+    }
+
+    /// \brief
+    ///   For internal usage. Return a direct descriptor slot to this worker. The slot must be
+    ///   empty, which means that the descriptor in it has been closed or never installed.
+    /// \param index
+    ///   Index of the slot to release.
+    auto release_direct_descriptor(std::int32_t index) noexcept -> void {
+        m_free_descriptors.push_back(static_cast<std::uint32_t>(index));
+    }
+
 private:
     /// \brief
     ///   For internal usage. Schedule a task to be executed in this worker. This method is not
@@ -140,6 +645,59 @@ private:
     OSSIA_API auto schedule(promise_base *promise) noexcept -> void;
 
 private:
+    /// \brief
+    ///   Apply options that take effect per thread, such as affinity of kernel async worker
+    ///   threads. This method is called in the thread that drives this worker.
+    auto apply_thread_options() noexcept -> void;
+
+    /// \brief
+    ///   Expire timers whose deadlines have passed.
+    /// \return
+    ///   Deadline of the earliest timer that is not expired. Return \c time_point::max() if there
+    ///   is no timer left.
+    auto expire_timers() noexcept -> std::chrono::steady_clock::time_point;
+
+    /// \brief
+    ///   Resume tasks of an iteration and measure their queue delay if load shedding is enabled.
+    /// \param[in, out] tasks
+    ///   Tasks to be resumed. This is cleared after all tasks are resumed.
+    auto resume_and_measure(std::vector<promise_base *> &tasks) noexcept -> void;
+
+    /// \brief
+    ///   Update the overload state with the queue delay of an iteration. Operations waiting for
+    ///   admission are released once the worker is no longer overloaded.
+    /// \param delay
+    ///   Queue delay of the iteration.
+    /// \param now
+    ///   Current time.
+    auto update_queue_delay(std::chrono::steady_clock::duration   delay,
+                            std::chrono::steady_clock::time_point now) noexcept -> void;
+
+    /// \brief
+    ///   Move parked IO requests into the submission queue as space allows. The submission queue is
+    ///   submitted to make room while requests are left in the overflow queue.
+    auto flush_overflow() noexcept -> void;
+
+    /// \brief
+    ///   Flush completions backlogged by the kernel into the completion queue if it overflowed.
+    /// \retval true
+    ///   The completion queue overflowed and should be handled again.
+    /// \retval false
+    ///   The completion queue did not overflow.
+    auto flush_completion_overflow() noexcept -> bool;
+
+    /// \brief
+    ///   Record number of completions handled in one iteration.
+    /// \param count
+    ///   Number of completions handled in the iteration.
+    auto record_completion_batch(std::size_t count) noexcept -> void {
+        if (count > m_largest_completion_batch.load(std::memory_order_relaxed)) [[unlikely]]
+            m_largest_completion_batch.store(count, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr std::uintptr_t invalid_poll_handle = static_cast<std::uintptr_t>(-1);
+
     /// \brief
     ///   Running flag for this worker.
     std::atomic_bool m_is_running;
@@ -157,6 +715,110 @@ private:
     ///   Task queue for this worker.
     std::vector<promise_base *> m_tasks;
 
+    /// \brief
+    ///   Readiness notification handle for external event loops. This is \c invalid_poll_handle
+    ///   until \c poll_handle is called.
+    std::uintptr_t m_poll_handle;
+
+    /// \brief
+    ///   CPUs that kernel async worker threads are allowed to run on.
+    std::vector<std::uint32_t> m_async_worker_cpus;
+
+    /// \brief
+    ///   Thread that per-thread options are applied in. This is 0 before this worker is driven by
+    ///   any thread.
+    std::size_t m_configured_thread;
+
+    /// \brief
+    ///   Limits of kernel async worker threads for bounded and unbounded work. These values are
+    ///   read back from the kernel when per-thread options are applied.
+    std::atomic_uint32_t m_async_worker_limits[2];
+
+    /// \brief
+    ///   Memory of the submission and completion queues. This is empty if the rings are mapped by
+    ///   the kernel.
+    huge_page_buffer m_ring_memory;
+
+    /// \brief
+    ///   Memory of all registered buffers.
+    huge_page_buffer m_buffer_memory;
+
+    /// \brief
+    ///   Size in byte of each registered buffer.
+    std::uint32_t m_buffer_size;
+
+    /// \brief
+    ///   Indices of registered buffers that are not acquired.
+    std::vector<std::uint32_t> m_free_buffers;
+
+    /// \brief
+    ///   Number of registered buffers that are not acquired. This is only modified in the worker
+    ///   thread and could be read in any thread.
+    std::atomic_uint32_t m_available_buffers;
+
+    /// \brief
+    ///   Indices of direct descriptor slots that are not acquired.
+    std::vector<std::uint32_t> m_free_descriptors;
+
+    /// \brief
+    ///   Maximum number of completions to handle in one iteration of \c run.
+    std::size_t m_completion_batch;
+
+    /// \brief
+    ///   Largest number of completions handled in one iteration.
+    std::atomic_uint64_t m_largest_completion_batch;
+
+    /// \brief
+    ///   Action to take when the submission queue is full.
+    submission_overflow_policy m_overflow_policy;
+
+    /// \brief
+    ///   IO requests that are waiting for space in the submission queue.
+    std::deque<submission_entry> m_overflow;
+
+    /// \brief
+    ///   Number of parked, overflowed and rejected IO requests. These are only modified in the
+    ///   worker thread and could be read in any thread.
+    std::atomic_uint64_t m_submission_counters[3];
+
+    /// \brief
+    ///   Number of times that the completion queue overflowed.
+    std::atomic_uint64_t m_completion_overflows;
+
+    /// \brief
+    ///   Timers of this worker. This is a min-heap ordered by deadlines.
+    std::vector<timer_entry *> m_timers;
+
+    /// \brief
+    ///   Queue delay target and interval for load shedding. Load shedding is disabled if the
+    ///   target is zero.
+    std::chrono::steady_clock::duration m_shedding_target;
+    std::chrono::steady_clock::duration m_shedding_interval;
+
+    /// \brief
+    ///   Time at which the worker becomes overloaded if the queue delay stays above the target.
+    ///   This is the epoch while the queue delay is below the target.
+    std::chrono::steady_clock::time_point m_overload_deadline;
+
+    /// \brief
+    ///   Whether this worker is overloaded.
+    std::atomic_bool m_overloaded;
+
+    /// \brief
+    ///   Queue delay in nanoseconds measured in the latest iteration.
+    std::atomic_uint64_t m_queue_delay;
+
+    /// \brief
+    ///   Number of overload events, shed requests and paused accepts. These are only modified in
+    ///   the worker thread and could be read in any thread.
+    std::atomic_uint64_t m_overload_events;
+    std::atomic_uint64_t m_shed_requests;
+    std::atomic_uint64_t m_paused_accepts;
+
+    /// \brief
+    ///   Operations deferred until this worker is no longer overloaded.
+    std::vector<timer_entry *> m_admission_waiters;
+
     /// \brief
     ///   Stop flag for this worker. This value is aligned up with cacheline size to avoid cacheline
     ///   lock on atomic operation as possible.
@@ -186,6 +848,17 @@ public:
     ///   Thrown if any worker failed to initialize IO muxer.
     OSSIA_API explicit io_context(std::size_t count);
 
+    /// \brief
+    ///   Create a new IO context with specified number of workers and options.
+    /// \param count
+    ///   Expected number of workers to be created. Number of workers will be determined by number
+    ///   of virtual CPU cores if this value is zero.
+    /// \param options
+    ///   Options for all workers of this IO context.
+    /// \throws std::system_error
+    ///   Thrown if any worker failed to initialize IO muxer.
+    OSSIA_API io_context(std::size_t count, const io_context_options &options);
+
     /// \brief
     ///   \c io_context is not copyable.
     io_context(const io_context &other) = delete;
@@ -226,6 +899,19 @@ public:
         return m_worker_count;
     }
 
+    /// \brief
+    ///   Get a worker of this IO context. This is used to drive workers from an external event loop
+    ///   with \c io_context_worker::poll_once instead of \c run.
+    /// \param index
+    ///   Index of the worker. It is undefined behavior if \p index is not less than
+    ///   \c worker_count().
+    /// \return
+    ///   Reference to the worker.
+    [[nodiscard]]
+    auto worker(std::size_t index) noexcept -> detail::io_context_worker & {
+        return m_workers[index];
+    }
+
     /// \brief
     ///   Start all workers in this IO context. This method will block current thread until all
     ///   workers are stopped.
@@ -265,7 +951,7 @@ private:
 
     /// \brief
     ///   Worker array.
-    std::unique_ptr<detail::io_context_worker[]> m_workers;
+    std::deque<detail::io_context_worker> m_workers;
 };
 
 /// \brief
@@ -280,4 +966,16 @@ auto schedule(future<T> task) noexcept -> void {
     detail::io_context_worker::current()->schedule(std::move(task));
 }
 
+/// \brief
+///   Decide whether the current worker should handle a new request. See
+///   \c io_context_worker::admit_request. This method could only be called in worker threads.
+/// \retval true
+///   The request should be handled.
+/// \retval false
+///   The current worker is overloaded and the request should be rejected.
+[[nodiscard]]
+inline auto admit_request() noexcept -> bool {
+    return detail::io_context_worker::current()->admit_request();
+}
+
 } // namespace ossia
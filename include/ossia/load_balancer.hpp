@@ -0,0 +1,296 @@
+#pragma once
+
+#include "tcp_stream.hpp"
+
+#include <type_traits>
+#include <vector>
+
+namespace ossia {
+
+/// \struct load_balancer_options
+/// \brief
+///   Options of \c load_balancer.
+struct load_balancer_options {
+    /// \brief
+    ///   Time constant of the latency moving average. Latency samples lose weight exponentially
+    ///   with their age, so an endpoint that slows down is noticed within about this time
+    ///   regardless of its request rate.
+    std::chrono::steady_clock::duration decay_time = std::chrono::seconds(10);
+
+    /// \brief
+    ///   Latency assumed for endpoints without any sample.
+    std::chrono::steady_clock::duration initial_latency = std::chrono::milliseconds(1);
+
+    /// \brief
+    ///   Number of consecutive failures after which an endpoint is ejected. Zero disables
+    ///   ejection.
+    std::uint32_t ejection_failures = 5;
+
+    /// \brief
+    ///   Time that an endpoint is ejected for the first time. The time grows linearly with the
+    ///   number of times that the endpoint has been ejected in a row.
+    std::chrono::steady_clock::duration ejection_time = std::chrono::seconds(30);
+
+    /// \brief
+    ///   Upper bound of the ejection time.
+    std::chrono::steady_clock::duration max_ejection_time = std::chrono::seconds(300);
+
+    /// \brief
+    ///   Maximum ratio of endpoints that could be ejected at the same time. Failing endpoints are
+    ///   kept once the limit is reached, so that a common failure never ejects every endpoint.
+    double max_ejection_ratio = 0.5;
+
+    /// \brief
+    ///   Maximum number of idle connections kept per endpoint for reuse.
+    std::uint32_t max_idle_connections = 16;
+
+    /// \brief
+    ///   Idle connections older than this are closed instead of being reused, since the endpoint
+    ///   may have closed them already.
+    std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(30);
+};
+
+/// \struct endpoint_stats
+/// \brief
+///   Statistics of an endpoint of a \c load_balancer.
+struct endpoint_stats {
+    /// \brief
+    ///   Moving average of request latency, with peaks taken at once.
+    std::chrono::steady_clock::duration latency;
+
+    /// \brief
+    ///   Number of requests in flight.
+    std::uint32_t in_flight;
+
+    /// \brief
+    ///   Number of idle connections kept for reuse.
+    std::uint32_t idle_connections;
+
+    /// \brief
+    ///   Whether the endpoint is ejected.
+    bool ejected;
+
+    /// \brief
+    ///   Total number of requests sent to the endpoint.
+    std::uint64_t requests;
+
+    /// \brief
+    ///   Total number of failed requests sent to the endpoint.
+    std::uint64_t failures;
+
+    /// \brief
+    ///   Total number of times that the endpoint has been ejected.
+    std::uint64_t ejections;
+};
+
+/// \class load_balancer
+/// \brief
+///   Client-side load balancer over a set of identical endpoints. Each request picks two
+///   endpoints at random and goes to the one with the lower cost, which is the moving average of
+///   its latency multiplied by its number of requests in flight plus one ("power of two
+///   choices"). Endpoints that fail repeatedly are ejected for a while, and connections are kept
+///   per endpoint for reuse once a request succeeds.
+///
+///   This class is not thread safe and could only be used in one worker. Create one balancer per
+///   worker, so that picking an endpoint takes no lock and touches no memory shared with other
+///   workers.
+class load_balancer {
+public:
+    /// \brief
+    ///   Create a new load balancer.
+    /// \param endpoints
+    ///   Addresses of the endpoints. There must be at least one endpoint.
+    /// \param options
+    ///   Options of this balancer.
+    OSSIA_API explicit load_balancer(const std::vector<inet_address> &endpoints,
+                                     const load_balancer_options     &options = {}) noexcept;
+
+    /// \brief
+    ///   \c load_balancer is not copyable.
+    load_balancer(const load_balancer &other) = delete;
+
+    /// \brief
+    ///   \c load_balancer is not copyable.
+    auto operator=(const load_balancer &other) = delete;
+
+    /// \brief
+    ///   Send a request to an endpoint picked by this balancer.
+    /// \tparam Func
+    ///   Type of the request function. The function is called with a connected \c tcp_stream and
+    ///   must return a \c future of \c std::expected with \c std::error_code as the error type.
+    /// \param request
+    ///   Function that sends the request over the connection and receives the reply. The
+    ///   connection is reused by later requests if the request succeeds, so the function must
+    ///   leave it ready for the next request. The connection is closed if the request fails.
+    /// \return
+    ///   The reply of the request, or the error of connecting to the endpoint.
+    template <class Func>
+        requires(std::is_invocable_v<Func &, tcp_stream &>)
+    auto execute_async(Func request) noexcept -> std::invoke_result_t<Func &, tcp_stream &> {
+        std::size_t index = this->pick();
+        auto        start = this->begin_request(index);
+
+        tcp_stream stream;
+        if (!this->take_connection(index, stream)) {
+            std::error_code error = co_await stream.connect_async(m_endpoints[index].address);
+            if (error) [[unlikely]] {
+                this->end_request(index, start, false);
+                co_return std::unexpected(error);
+            }
+        }
+
+        auto result = co_await request(stream);
+        this->end_request(index, start, result.has_value());
+        if (result.has_value())
+            this->keep_connection(index, std::move(stream));
+
+        co_return result;
+    }
+
+    /// \brief
+    ///   Pick an endpoint with the power of two choices. Ejected endpoints are skipped unless
+    ///   every endpoint is ejected.
+    /// \return
+    ///   Index of the picked endpoint.
+    [[nodiscard]]
+    OSSIA_API auto pick() noexcept -> std::size_t;
+
+    /// \brief
+    ///   Account a request that is sent to an endpoint. Use this with \c end_request to balance
+    ///   requests that do not go through \c execute_async.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \return
+    ///   Start time of the request.
+    OSSIA_API auto begin_request(std::size_t index) noexcept
+        -> std::chrono::steady_clock::time_point;
+
+    /// \brief
+    ///   Account a finished request. The latency sample is taken from both successful and failed
+    ///   requests, so that endpoints that fail slowly are avoided as well.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \param start
+    ///   Start time of the request returned by \c begin_request.
+    /// \param succeeded
+    ///   Whether the request succeeded.
+    OSSIA_API auto end_request(std::size_t                           index,
+                               std::chrono::steady_clock::time_point start,
+                               bool                                  succeeded) noexcept -> void;
+
+    /// \brief
+    ///   Get number of endpoints of this balancer.
+    /// \return
+    ///   Number of endpoints.
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t {
+        return m_endpoints.size();
+    }
+
+    /// \brief
+    ///   Get address of an endpoint.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \return
+    ///   Address of the endpoint.
+    [[nodiscard]]
+    auto address(std::size_t index) const noexcept -> const inet_address & {
+        return m_endpoints[index].address;
+    }
+
+    /// \brief
+    ///   Get statistics of an endpoint.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \return
+    ///   Statistics of the endpoint.
+    [[nodiscard]]
+    OSSIA_API auto stats(std::size_t index) const noexcept -> endpoint_stats;
+
+private:
+    /// \struct idle_connection
+    /// \brief
+    ///   A connection kept for reuse.
+    struct idle_connection {
+        tcp_stream                            stream;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    /// \struct endpoint
+    /// \brief
+    ///   State of an endpoint.
+    struct endpoint {
+        inet_address                          address;
+        double                                latency;
+        std::chrono::steady_clock::time_point updated;
+        std::uint32_t                         in_flight;
+        std::uint32_t                         failures;
+        std::uint32_t                         ejection_count;
+        std::chrono::steady_clock::time_point ejected_until;
+        std::vector<idle_connection>          idle;
+        std::uint64_t                         total_requests;
+        std::uint64_t                         total_failures;
+        std::uint64_t                         total_ejections;
+    };
+
+    /// \brief
+    ///   Get cost of an endpoint for the power of two choices.
+    /// \param target
+    ///   The endpoint.
+    /// \return
+    ///   Cost of the endpoint. Lower is better.
+    [[nodiscard]]
+    static auto cost(const endpoint &target) noexcept -> double {
+        return target.latency * (static_cast<double>(target.in_flight) + 1);
+    }
+
+    /// \brief
+    ///   Checks if an endpoint is ejected and return it once the ejection time is over.
+    /// \param target
+    ///   The endpoint.
+    /// \param now
+    ///   Current time.
+    /// \retval true
+    ///   The endpoint is ejected.
+    /// \retval false
+    ///   The endpoint is available.
+    auto is_ejected(endpoint &target, std::chrono::steady_clock::time_point now) noexcept -> bool;
+
+    /// \brief
+    ///   Get a random number with xorshift.
+    /// \return
+    ///   A pseudo random number.
+    auto next_random() noexcept -> std::uint64_t;
+
+    /// \brief
+    ///   Take an idle connection of an endpoint for reuse.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \param[out] stream
+    ///   The idle connection if found.
+    /// \retval true
+    ///   An idle connection is taken.
+    /// \retval false
+    ///   No idle connection could be reused.
+    OSSIA_API auto take_connection(std::size_t index, tcp_stream &stream) noexcept -> bool;
+
+    /// \brief
+    ///   Keep a connection of an endpoint for reuse. The connection is closed if the endpoint has
+    ///   enough idle connections or it is ejected.
+    /// \param index
+    ///   Index of the endpoint.
+    /// \param stream
+    ///   The connection to keep.
+    OSSIA_API auto keep_connection(std::size_t index, tcp_stream &&stream) noexcept -> void;
+
+private:
+    std::vector<endpoint> m_endpoints;
+    load_balancer_options m_options;
+    std::uint64_t         m_random;
+
+    /// \brief
+    ///   Number of endpoints that are ejected.
+    std::size_t m_ejected;
+};
+
+} // namespace ossia
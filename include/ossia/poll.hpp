@@ -0,0 +1,274 @@
+#pragma once
+
+#include "io_context.hpp"
+
+#include <expected>
+#include <system_error>
+
+namespace ossia {
+
+/// \enum poll_event
+/// \brief
+///   Readiness events of a file descriptor. Values are the same as \c poll(2) events so that they
+///   could be passed to the kernel directly. Events could be combined with bitwise or.
+enum class poll_event : std::uint32_t {
+    /// \brief
+    ///   No event.
+    none = 0,
+
+    /// \brief
+    ///   There is data to read.
+    in = 0x0001,
+
+    /// \brief
+    ///   There is urgent data to read.
+    priority = 0x0002,
+
+    /// \brief
+    ///   Writing is now possible.
+    out = 0x0004,
+
+    /// \brief
+    ///   Error condition. Always reported even if not requested.
+    error = 0x0008,
+
+    /// \brief
+    ///   Hang up. Always reported even if not requested.
+    hang_up = 0x0010,
+
+    /// \brief
+    ///   Invalid file descriptor. Always reported even if not requested.
+    invalid = 0x0020,
+
+    /// \brief
+    ///   Stream socket peer closed connection or shut down writing half of connection.
+    read_hang_up = 0x2000,
+};
+
+/// \brief
+///   Combine two \c poll_event flags.
+[[nodiscard]]
+constexpr auto operator|(poll_event lhs, poll_event rhs) noexcept -> poll_event {
+    return static_cast<poll_event>(static_cast<std::uint32_t>(lhs) |
+                                   static_cast<std::uint32_t>(rhs));
+}
+
+/// \brief
+///   Intersect two \c poll_event flags.
+[[nodiscard]]
+constexpr auto operator&(poll_event lhs, poll_event rhs) noexcept -> poll_event {
+    return static_cast<poll_event>(static_cast<std::uint32_t>(lhs) &
+                                   static_cast<std::uint32_t>(rhs));
+}
+
+/// \brief
+///   Combine \c poll_event flags in place.
+constexpr auto operator|=(poll_event &lhs, poll_event rhs) noexcept -> poll_event & {
+    lhs = lhs | rhs;
+    return lhs;
+}
+
+/// \class poll_awaitable
+/// \brief
+///   Awaitable object for waiting for readiness of a file descriptor once.
+class poll_awaitable {
+public:
+    /// \brief
+    ///   Create a new \c poll_awaitable object for asynchronous poll operation.
+    /// \param handle
+    ///   The file descriptor to poll.
+    /// \param events
+    ///   Events to wait for.
+    poll_awaitable(std::uintptr_t handle, poll_event events) noexcept
+        : m_ovlp(),
+          m_handle(handle),
+          m_events(events) {}
+
+    /// \brief
+    ///   C++20 coroutine API method. Always execute \c await_suspend().
+    /// \return
+    ///   This function always returns \c false.
+    static constexpr auto await_ready() noexcept -> bool {
+        return false;
+    }
+
+    /// \brief
+    ///   Prepare for async poll operation and suspend the coroutine.
+    /// \tparam T
+    ///   Type of promise of current coroutine.
+    /// \param coroutine
+    ///   Current coroutine handle.
+    /// \retval true
+    ///   This coroutine should be suspended and resumed later.
+    /// \retval false
+    ///   This coroutine should not be suspended and should be resumed immediately.
+    template <class T>
+    auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+        m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+        return this->await_suspend();
+    }
+
+    /// \brief
+    ///   Get the result of the asynchronous poll operation.
+    /// \return
+    ///   Events that are ready if succeeded. Otherwise, return a system error code.
+    OSSIA_API auto await_resume() const noexcept -> std::expected<poll_event, std::error_code>;
+
+private:
+    /// \brief
+    ///   Prepare for asynchronous poll operation and suspend this coroutine.
+    OSSIA_API auto await_suspend() noexcept -> bool;
+
+private:
+    detail::overlapped m_ovlp;
+    std::uintptr_t     m_handle;
+    poll_event         m_events;
+};
+
+/// \brief
+///   Wait for readiness of a file descriptor that is not wrapped by ossia, such as \c inotify,
+///   \c timerfd, pipes or file descriptors of third-party libraries. On Linux, this is done by
+///   \c IORING_OP_POLL_ADD in the worker's IO muxer. This is not supported on Windows.
+/// \param handle
+///   The file descriptor to poll.
+/// \param events
+///   Events to wait for.
+/// \return
+///   Events that are ready if succeeded. Otherwise, return a system error code.
+///   \c std::errc::operation_not_supported is returned on Windows.
+[[nodiscard]]
+inline auto poll(std::uintptr_t handle, poll_event events) noexcept -> poll_awaitable {
+    return poll_awaitable(handle, events);
+}
+
+/// \class poll_watcher
+/// \brief
+///   Multishot readiness watcher of a file descriptor. A single multishot \c IORING_OP_POLL_ADD
+///   request keeps reporting events until it is cancelled, so no request is submitted per event.
+///   Events that occur while no coroutine is waiting are accumulated and returned by the next
+///   call to \c next. This class could only be used in workers.
+class poll_watcher {
+private:
+    /// \struct state
+    /// \brief
+    ///   State shared with the kernel. It outlives this watcher until the kernel releases it.
+    struct state;
+
+public:
+    /// \class next_awaitable
+    /// \brief
+    ///   Awaitable object for waiting for the next events.
+    class next_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c next_awaitable object.
+        /// \param[in] watcher
+        ///   State of the watcher to wait for.
+        explicit next_awaitable(state *watcher) noexcept : m_state(watcher) {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Do not suspend if there are accumulated events.
+        /// \retval true
+        ///   There are accumulated events or errors.
+        /// \retval false
+        ///   This coroutine should wait for new events.
+        OSSIA_API auto await_ready() const noexcept -> bool;
+
+        /// \brief
+        ///   Arm the watcher if necessary and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            return this->await_suspend(&static_cast<detail::promise_base &>(coroutine.promise()));
+        }
+
+        /// \brief
+        ///   Take the accumulated events.
+        /// \return
+        ///   Events that are ready if succeeded. Otherwise, return a system error code.
+        ///   \c std::errc::operation_canceled is returned once the watcher is cancelled.
+        OSSIA_API auto await_resume() const noexcept -> std::expected<poll_event, std::error_code>;
+
+    private:
+        /// \brief
+        ///   Arm the watcher if necessary and suspend this coroutine.
+        OSSIA_API auto await_suspend(detail::promise_base *promise) noexcept -> bool;
+
+    private:
+        state *m_state;
+    };
+
+public:
+    /// \brief
+    ///   Create an empty \c poll_watcher object.
+    poll_watcher() noexcept : m_state() {}
+
+    /// \brief
+    ///   Create a watcher for the specified file descriptor. The poll request is submitted when
+    ///   \c next is awaited for the first time.
+    /// \param handle
+    ///   The file descriptor to watch. The file descriptor must be valid until the watcher is
+    ///   cancelled or destroyed.
+    /// \param events
+    ///   Events to watch for.
+    /// \throws std::bad_alloc
+    ///   Thrown if failed to allocate memory for the watcher.
+    OSSIA_API poll_watcher(std::uintptr_t handle, poll_event events);
+
+    /// \brief
+    ///   \c poll_watcher is not copyable.
+    poll_watcher(const poll_watcher &other) = delete;
+
+    /// \brief
+    ///   Move constructor of \c poll_watcher.
+    /// \param[in, out] other
+    ///   The \c poll_watcher object to move. The moved \c poll_watcher object will be empty.
+    poll_watcher(poll_watcher &&other) noexcept : m_state(other.m_state) {
+        other.m_state = nullptr;
+    }
+
+    /// \brief
+    ///   Cancel the poll request and destroy this watcher. It is undefined behavior to destroy a
+    ///   watcher while a coroutine is waiting for it.
+    OSSIA_API ~poll_watcher();
+
+    /// \brief
+    ///   \c poll_watcher is not copyable.
+    auto operator=(const poll_watcher &other) = delete;
+
+    /// \brief
+    ///   Move assignment operator of \c poll_watcher.
+    /// \param[in, out] other
+    ///   The \c poll_watcher object to move. The moved \c poll_watcher object will be empty.
+    /// \return
+    ///   Reference to this \c poll_watcher object.
+    OSSIA_API auto operator=(poll_watcher &&other) noexcept -> poll_watcher &;
+
+    /// \brief
+    ///   Wait for the next events. Only one coroutine could wait for a watcher at the same time.
+    ///   The poll request is re-armed automatically if the kernel terminates it.
+    /// \return
+    ///   Events that are ready if succeeded. Otherwise, return a system error code.
+    ///   \c std::errc::operation_canceled is returned once the watcher is cancelled.
+    [[nodiscard]]
+    auto next() noexcept -> next_awaitable {
+        return next_awaitable(m_state);
+    }
+
+    /// \brief
+    ///   Cancel the poll request. The waiting coroutine, if any, is resumed with
+    ///   \c std::errc::operation_canceled.
+    OSSIA_API auto cancel() noexcept -> void;
+
+private:
+    state *m_state;
+};
+
+} // namespace ossia
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <coroutine>
+#include <cstddef>
 #include <cstdint>
 #include <exception>
 #include <optional>
@@ -15,6 +16,8 @@ namespace ossia {
 template <class T = void>
 class future;
 
+struct task_context;
+
 } // namespace ossia
 
 namespace ossia::detail {
@@ -51,6 +54,32 @@ struct final_awaitable {
     static constexpr auto await_resume() noexcept -> void {}
 };
 
+/// \brief
+///   For internal usage. Allocate memory for a coroutine frame. Frames are taken from the
+///   thread-local frame pool once it is enabled, and from the global heap otherwise.
+/// \param size
+///   Size in byte of the coroutine frame.
+/// \return
+///   Pointer to the allocated memory.
+/// \throws std::bad_alloc
+///   Thrown if failed to allocate memory.
+[[nodiscard]]
+OSSIA_API auto allocate_frame(std::size_t size) -> void *;
+
+/// \brief
+///   For internal usage. Release memory of a coroutine frame allocated by \c allocate_frame. The
+///   frame could be released in any thread.
+/// \param[in] frame
+///   Pointer to the coroutine frame.
+/// \param size
+///   Size in byte of the coroutine frame.
+OSSIA_API auto deallocate_frame(void *frame, std::size_t size) noexcept -> void;
+
+/// \brief
+///   For internal usage. Enable the coroutine frame pool for all threads. The frame pool could not
+///   be disabled once enabled.
+OSSIA_API auto enable_frame_pool() noexcept -> void;
+
 /// \class promise_base
 /// \brief
 ///   Base class for promise types.
@@ -63,6 +92,7 @@ public:
           m_coroutine(),
           m_parent(nullptr),
           m_stack_bottom(nullptr),
+          m_context(nullptr),
           m_exception() {}
 
     /// \brief
@@ -85,6 +115,29 @@ public:
     ///   \c promise_base is not movable.
     auto operator=(promise_base &&other) = delete;
 
+    /// \brief
+    ///   For internal usage. C++20 coroutine API. Allocate memory for a coroutine frame.
+    /// \param size
+    ///   Size in byte of the coroutine frame.
+    /// \return
+    ///   Pointer to the allocated memory.
+    /// \throws std::bad_alloc
+    ///   Thrown if failed to allocate memory.
+    [[nodiscard]]
+    static auto operator new(std::size_t size) -> void * {
+        return allocate_frame(size);
+    }
+
+    /// \brief
+    ///   For internal usage. C++20 coroutine API. Release memory of a coroutine frame.
+    /// \param[in] frame
+    ///   Pointer to the coroutine frame.
+    /// \param size
+    ///   Size in byte of the coroutine frame.
+    static auto operator delete(void *frame, std::size_t size) noexcept -> void {
+        deallocate_frame(frame, size);
+    }
+
     /// \brief
     ///   For internal usage. C++20 coroutine API. Futures should always be suspended once they are
     ///   created.
@@ -147,6 +200,24 @@ public:
         return *m_stack_bottom;
     }
 
+    /// \brief
+    ///   Get the task context of this coroutine stack frame. See \c task_context for details.
+    /// \return
+    ///   Pointer to the task context. Return \c nullptr if this frame has no context.
+    [[nodiscard]]
+    auto context() const noexcept -> task_context * {
+        return m_context;
+    }
+
+    /// \brief
+    ///   Set the task context of this coroutine stack frame. Frames that are awaited later by this
+    ///   frame inherit the context.
+    /// \param[in] context
+    ///   Pointer to the task context. Pass \c nullptr to clear the context.
+    auto set_context(task_context *context) noexcept -> void {
+        m_context = context;
+    }
+
     friend struct final_awaitable;
 
     template <class>
@@ -172,6 +243,11 @@ protected:
     ///   Pointer to the bottom of the coroutine stack.
     promise_base *m_stack_bottom;
 
+    /// \brief
+    ///   Pointer to the task context of this coroutine frame. This is inherited from the caller
+    ///   when this frame is awaited.
+    task_context *m_context;
+
     /// \brief
     ///   Exception thrown by this coroutine.
     std::exception_ptr m_exception;
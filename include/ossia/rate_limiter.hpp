@@ -0,0 +1,198 @@
+#pragma once
+
+#include "timer.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace ossia {
+
+/// \enum rate_limit_algorithm
+/// \brief
+///   Algorithm used by \c rate_limiter to decide when a request conforms to the limit.
+enum class rate_limit_algorithm {
+    /// \brief
+    ///   Token bucket. Tokens are refilled at the rate and requests take tokens from the bucket.
+    token_bucket,
+
+    /// \brief
+    ///   Generic cell rate algorithm. Only the theoretical arrival time of the next request is
+    ///   kept. This behaves like a token bucket of the same rate and burst.
+    gcra,
+};
+
+/// \enum rate_limit_unit
+/// \brief
+///   What a \c rate_limiter counts.
+enum class rate_limit_unit {
+    /// \brief
+    ///   Limit bandwidth. Each request costs the number of bytes transferred.
+    bytes,
+
+    /// \brief
+    ///   Limit operation rate. Each request costs 1.
+    operations,
+};
+
+/// \struct rate_limit
+/// \brief
+///   Parameters of a \c rate_limiter.
+struct rate_limit {
+    /// \brief
+    ///   Algorithm of the rate limiter.
+    rate_limit_algorithm algorithm = rate_limit_algorithm::token_bucket;
+
+    /// \brief
+    ///   What the rate limiter counts.
+    rate_limit_unit unit = rate_limit_unit::bytes;
+
+    /// \brief
+    ///   Sustained rate in units per second. Zero or negative values mean no limit.
+    double rate = 0;
+
+    /// \brief
+    ///   Maximum number of units that could be used at once after the rate limiter is idle.
+    std::uint64_t burst = 0;
+};
+
+/// \class rate_limiter
+/// \brief
+///   A rate limiter that could be chained into a hierarchy, such as connection, tenant and worker
+///   limiters. A request conforms only if it conforms to every limiter up to the root, and it is
+///   charged to all of them. Rate limiters are not thread safe and keep no lock. Each worker
+///   should have its own limiters: to limit a tenant over several workers, give each worker a
+///   tenant limiter with a share of the rate.
+///
+///   Requests that do not conform are reserved rather than rejected, so the limiter may go into
+///   debt and later requests wait until the debt is paid off. This keeps requests in order and
+///   allows requests larger than the burst.
+class rate_limiter {
+public:
+    /// \brief
+    ///   Create a new rate limiter. The limiter starts with a full burst.
+    /// \param limit
+    ///   Parameters of this rate limiter.
+    /// \param[in] parent
+    ///   Parent rate limiter. Requests are charged to the parent as well. The parent must outlive
+    ///   this limiter.
+    explicit rate_limiter(const rate_limit &limit, rate_limiter *parent = nullptr) noexcept
+        : m_limit(limit),
+          m_parent(parent),
+          m_tokens(static_cast<double>(limit.burst)),
+          m_last_update(),
+          m_arrival_time() {}
+
+    /// \brief
+    ///   Get parameters of this rate limiter.
+    /// \return
+    ///   Parameters of this rate limiter.
+    [[nodiscard]]
+    auto limit() const noexcept -> const rate_limit & {
+        return m_limit;
+    }
+
+    /// \brief
+    ///   Get parent of this rate limiter.
+    /// \return
+    ///   Parent of this rate limiter. Return \c nullptr if this is a root limiter.
+    [[nodiscard]]
+    auto parent() const noexcept -> rate_limiter * {
+        return m_parent;
+    }
+
+    /// \brief
+    ///   Take a request from this limiter and all of its parents if it conforms to all of them
+    ///   now. Nothing is charged otherwise.
+    /// \param bytes
+    ///   Number of bytes of the request. This is charged to limiters that count bytes.
+    /// \param operations
+    ///   Number of operations of the request. This is charged to limiters that count operations.
+    /// \param now
+    ///   Current time.
+    /// \retval true
+    ///   The request conforms and has been charged.
+    /// \retval false
+    ///   The request does not conform to at least one limiter.
+    [[nodiscard]]
+    OSSIA_API auto try_acquire(std::uint64_t                         bytes,
+                               std::uint64_t                         operations,
+                               std::chrono::steady_clock::time_point now) noexcept -> bool;
+
+    /// \brief
+    ///   Charge a request to this limiter and all of its parents, and get the time at which the
+    ///   request conforms to all of them.
+    /// \param bytes
+    ///   Number of bytes of the request. This is charged to limiters that count bytes.
+    /// \param operations
+    ///   Number of operations of the request. This is charged to limiters that count operations.
+    /// \param now
+    ///   Current time.
+    /// \return
+    ///   Time at which the request could be issued. This is \p now if the request conforms now.
+    OSSIA_API auto reserve(std::uint64_t                         bytes,
+                           std::uint64_t                         operations,
+                           std::chrono::steady_clock::time_point now) noexcept
+        -> std::chrono::steady_clock::time_point;
+
+    /// \brief
+    ///   Charge a request and suspend the current coroutine until the request conforms. This
+    ///   method could only be called in workers. The request is charged when this method is
+    ///   called.
+    /// \param bytes
+    ///   Number of bytes of the request.
+    /// \param operations
+    ///   Number of operations of the request.
+    /// \return
+    ///   Awaitable object that resumes the coroutine once the request conforms.
+    [[nodiscard]]
+    auto acquire_async(std::uint64_t bytes, std::uint64_t operations = 1) noexcept
+        -> sleep_awaitable {
+        return sleep_awaitable(this->reserve(bytes, operations, std::chrono::steady_clock::now()));
+    }
+
+private:
+    /// \brief
+    ///   Get how long a request of \p cost units should wait for this limiter only.
+    /// \param cost
+    ///   Cost of the request in units of this limiter.
+    /// \param now
+    ///   Current time.
+    /// \return
+    ///   Nanoseconds to wait. Return 0 if the request conforms now.
+    [[nodiscard]]
+    auto delay(double cost, std::chrono::steady_clock::time_point now) const noexcept -> double;
+
+    /// \brief
+    ///   Charge a request of \p cost units to this limiter only.
+    /// \param cost
+    ///   Cost of the request in units of this limiter.
+    /// \param now
+    ///   Current time.
+    auto charge(double cost, std::chrono::steady_clock::time_point now) noexcept -> void;
+
+    /// \brief
+    ///   Get the cost of a request in units of this limiter.
+    [[nodiscard]]
+    auto cost(std::uint64_t bytes, std::uint64_t operations) const noexcept -> double {
+        return static_cast<double>(m_limit.unit == rate_limit_unit::bytes ? bytes : operations);
+    }
+
+private:
+    rate_limit    m_limit;
+    rate_limiter *m_parent;
+
+    /// \brief
+    ///   Tokens left in the bucket at \c m_last_update. Negative if the bucket is in debt. Only
+    ///   used by token bucket limiters.
+    double m_tokens;
+
+    /// \brief
+    ///   Time at which \c m_tokens was updated. Only used by token bucket limiters.
+    std::chrono::steady_clock::time_point m_last_update;
+
+    /// \brief
+    ///   Theoretical arrival time of the next request. Only used by GCRA limiters.
+    std::chrono::steady_clock::time_point m_arrival_time;
+};
+
+} // namespace ossia
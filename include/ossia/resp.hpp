@@ -0,0 +1,400 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ossia {
+
+/// \enum resp_type
+/// \brief
+///   Types of RESP values. Values are the type prefix bytes on the wire. RESP2 null bulk strings
+///   and null arrays are reported as \c null.
+enum class resp_type : char {
+    simple_string   = '+',
+    error           = '-',
+    integer         = ':',
+    bulk_string     = '$',
+    array           = '*',
+    null            = '_',
+    boolean         = '#',
+    double_number   = ',',
+    big_number      = '(',
+    bulk_error      = '!',
+    verbatim_string = '=',
+    map             = '%',
+    set             = '~',
+    push            = '>',
+};
+
+/// \enum resp_parse_error
+/// \brief
+///   Errors that could occur when parsing RESP messages.
+enum class resp_parse_error {
+    /// \brief
+    ///   More data is required to parse the message.
+    incomplete,
+
+    /// \brief
+    ///   The message is malformed or too deeply nested.
+    invalid,
+};
+
+namespace detail {
+
+/// \struct resp_node
+/// \brief
+///   For internal usage. A parsed RESP value. Nodes are stored in pre-order and refer to the raw
+///   message by offset so that a message could be copied without reparsing.
+struct resp_node {
+    /// \brief
+    ///   Type of this value.
+    resp_type type;
+
+    /// \brief
+    ///   Number of direct children. Keys and values of maps are counted separately.
+    std::uint32_t size;
+
+    /// \brief
+    ///   Number of nodes of the subtree rooted at this node, including this node.
+    std::uint32_t span;
+
+    /// \brief
+    ///   Offset in byte of string data relative to start of the message.
+    std::uint32_t offset;
+
+    /// \brief
+    ///   Size in byte of string data.
+    std::uint32_t length;
+
+    /// \brief
+    ///   Value of integers and booleans.
+    std::int64_t integer;
+};
+
+} // namespace detail
+
+/// \class resp_value
+/// \brief
+///   A lightweight view of a value in a \c resp_message. String data refers to the message buffer
+///   and is never copied.
+class resp_value {
+public:
+    /// \class iterator
+    /// \brief
+    ///   Forward iterator over children of an aggregate value.
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = resp_value;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = resp_value;
+
+        /// \brief
+        ///   Create an empty iterator.
+        iterator() noexcept : m_data(), m_node() {}
+
+        /// \brief
+        ///   For internal usage. Create an iterator that points to the specified node.
+        /// \param data
+        ///   Pointer to start of the message.
+        /// \param node
+        ///   The node that this iterator points to.
+        iterator(const char *data, const detail::resp_node *node) noexcept
+            : m_data(data),
+              m_node(node) {}
+
+        /// \brief
+        ///   Get the value that this iterator points to.
+        /// \return
+        ///   The value that this iterator points to.
+        [[nodiscard]]
+        auto operator*() const noexcept -> resp_value {
+            return resp_value(m_data, m_node);
+        }
+
+        /// \brief
+        ///   Move this iterator to the next sibling.
+        /// \return
+        ///   Reference to this iterator.
+        auto operator++() noexcept -> iterator & {
+            m_node += m_node->span;
+            return *this;
+        }
+
+        /// \brief
+        ///   Move this iterator to the next sibling.
+        /// \return
+        ///   The iterator before moving.
+        auto operator++(int) noexcept -> iterator {
+            iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        /// \brief
+        ///   Checks if two iterators point to the same node.
+        [[nodiscard]]
+        auto operator==(const iterator &other) const noexcept -> bool {
+            return m_node == other.m_node;
+        }
+
+    private:
+        const char              *m_data;
+        const detail::resp_node *m_node;
+    };
+
+    /// \brief
+    ///   For internal usage. Create a view of the specified node.
+    /// \param data
+    ///   Pointer to start of the message.
+    /// \param node
+    ///   The node to view.
+    resp_value(const char *data, const detail::resp_node *node) noexcept
+        : m_data(data),
+          m_node(node) {}
+
+    /// \brief
+    ///   Get type of this value.
+    /// \return
+    ///   Type of this value.
+    [[nodiscard]]
+    auto type() const noexcept -> resp_type {
+        return m_node->type;
+    }
+
+    /// \brief
+    ///   Checks if this value is null.
+    /// \retval true
+    ///   This value is null.
+    /// \retval false
+    ///   This value is not null.
+    [[nodiscard]]
+    auto is_null() const noexcept -> bool {
+        return m_node->type == resp_type::null;
+    }
+
+    /// \brief
+    ///   Checks if this value is an error reply.
+    /// \retval true
+    ///   This value is a simple error or a bulk error.
+    /// \retval false
+    ///   This value is not an error.
+    [[nodiscard]]
+    auto is_error() const noexcept -> bool {
+        return m_node->type == resp_type::error || m_node->type == resp_type::bulk_error;
+    }
+
+    /// \brief
+    ///   Get string data of this value. This is the payload of strings and errors, and the textual
+    ///   representation of doubles and big numbers. Verbatim strings include the 4-byte format
+    ///   prefix such as \c txt:.
+    /// \return
+    ///   String data of this value. Return an empty string for other types.
+    [[nodiscard]]
+    auto string() const noexcept -> std::string_view {
+        return std::string_view(m_data + m_node->offset, m_node->length);
+    }
+
+    /// \brief
+    ///   Get value of integers and booleans.
+    /// \return
+    ///   Value of this integer. Booleans are returned as 0 or 1. Return 0 for other types.
+    [[nodiscard]]
+    auto integer() const noexcept -> std::int64_t {
+        return m_node->integer;
+    }
+
+    /// \brief
+    ///   Get value of booleans.
+    /// \return
+    ///   Value of this boolean. Non-zero integers are treated as \c true.
+    [[nodiscard]]
+    auto boolean() const noexcept -> bool {
+        return m_node->integer != 0;
+    }
+
+    /// \brief
+    ///   Get value of doubles. Integers are converted to double.
+    /// \return
+    ///   Value of this number. Return NaN if this value is not a number.
+    [[nodiscard]]
+    OSSIA_API auto number() const noexcept -> double;
+
+    /// \brief
+    ///   Get number of children of aggregate values.
+    /// \return
+    ///   Number of children. Keys and values of maps are counted separately. Return 0 for
+    ///   non-aggregate values.
+    [[nodiscard]]
+    auto size() const noexcept -> std::size_t {
+        return m_node->size;
+    }
+
+    /// \brief
+    ///   Get the specified child of this aggregate value. This method takes linear time.
+    /// \param index
+    ///   Index of the child. It is undefined behavior if \p index is out of range.
+    /// \return
+    ///   The specified child.
+    [[nodiscard]]
+    auto operator[](std::size_t index) const noexcept -> resp_value {
+        auto it = begin();
+        std::advance(it, index);
+        return *it;
+    }
+
+    /// \brief
+    ///   Get iterator to the first child of this aggregate value.
+    /// \return
+    ///   Iterator to the first child.
+    [[nodiscard]]
+    auto begin() const noexcept -> iterator {
+        return iterator(m_data, m_node + 1);
+    }
+
+    /// \brief
+    ///   Get iterator past the last child of this aggregate value.
+    /// \return
+    ///   Iterator past the last child.
+    [[nodiscard]]
+    auto end() const noexcept -> iterator {
+        return iterator(m_data, m_node + m_node->span);
+    }
+
+private:
+    const char              *m_data;
+    const detail::resp_node *m_node;
+};
+
+/// \class resp_message
+/// \brief
+///   A parsed RESP message. Parsed messages refer to the input buffer and could be detached to own
+///   a copy of the raw message.
+class resp_message;
+
+/// \brief
+///   Parse a RESP2 or RESP3 message. String data is not copied and the message refers to \p data.
+///   Attributes are skipped and streamed strings are not supported.
+/// \param data
+///   Received data that starts with a RESP message.
+/// \param[out] message
+///   The message object to store the parse result.
+/// \return
+///   Size in byte of the parsed message if succeeded. Otherwise, return a \c resp_parse_error that
+///   indicates the parse error.
+OSSIA_API auto parse_resp(std::string_view data, resp_message &message) noexcept
+    -> std::expected<std::size_t, resp_parse_error>;
+
+class resp_message {
+public:
+    /// \brief
+    ///   Maximum nesting depth of aggregate values.
+    static constexpr std::size_t max_depth = 64;
+
+    /// \brief
+    ///   Create an empty message. Empty message is not valid for use before parsing.
+    resp_message() noexcept : m_data(), m_size(), m_storage(), m_nodes() {}
+
+    /// \brief
+    ///   Get the root value of this message.
+    /// \return
+    ///   The root value of this message. It is undefined behavior to get root value of an empty
+    ///   message.
+    [[nodiscard]]
+    auto root() const noexcept -> resp_value {
+        return resp_value(m_data, m_nodes.data());
+    }
+
+    /// \brief
+    ///   Get the raw message.
+    /// \return
+    ///   The raw message.
+    [[nodiscard]]
+    auto data() const noexcept -> std::string_view {
+        return std::string_view(m_data, m_size);
+    }
+
+    /// \brief
+    ///   Copy the raw message into storage owned by this message so that this message no longer
+    ///   refers to the input buffer.
+    OSSIA_API auto detach() -> void;
+
+    friend auto parse_resp(std::string_view data, resp_message &message) noexcept
+        -> std::expected<std::size_t, resp_parse_error>;
+
+private:
+    const char                    *m_data;
+    std::size_t                    m_size;
+    std::unique_ptr<char[]>        m_storage;
+    std::vector<detail::resp_node> m_nodes;
+};
+
+/// \brief
+///   Serialize a command as an array of bulk strings and append it to the output buffer.
+/// \param args
+///   Command name and arguments.
+/// \param[out] output
+///   The output buffer to append the serialized command.
+OSSIA_API auto write_resp_command(std::span<const std::string_view> args, std::string &output)
+    -> void;
+
+/// \brief
+///   Serialize a simple string and append it to the output buffer.
+/// \param value
+///   The string to be serialized. The string must not contain CR or LF.
+/// \param[out] output
+///   The output buffer.
+OSSIA_API auto write_resp_simple_string(std::string_view value, std::string &output) -> void;
+
+/// \brief
+///   Serialize a simple error and append it to the output buffer.
+/// \param message
+///   The error message, such as <tt>ERR unknown command</tt>. The message must not contain CR or
+///   LF.
+/// \param[out] output
+///   The output buffer.
+OSSIA_API auto write_resp_error(std::string_view message, std::string &output) -> void;
+
+/// \brief
+///   Serialize an integer and append it to the output buffer.
+/// \param value
+///   The integer to be serialized.
+/// \param[out] output
+///   The output buffer.
+OSSIA_API auto write_resp_integer(std::int64_t value, std::string &output) -> void;
+
+/// \brief
+///   Serialize a bulk string and append it to the output buffer.
+/// \param value
+///   The string to be serialized. The string could contain any binary data.
+/// \param[out] output
+///   The output buffer.
+OSSIA_API auto write_resp_bulk_string(std::string_view value, std::string &output) -> void;
+
+/// \brief
+///   Serialize a RESP2 null bulk string and append it to the output buffer. RESP3 clients also
+///   accept RESP2 nulls.
+/// \param[out] output
+///   The output buffer.
+OSSIA_API auto write_resp_null(std::string &output) -> void;
+
+/// \brief
+///   Serialize header of an aggregate value and append it to the output buffer. Children should
+///   be serialized right after the header.
+/// \param type
+///   Type of the aggregate value. This should be \c array, \c map, \c set or \c push.
+/// \param size
+///   Number of children. For maps, this is the number of key-value pairs.
+/// \param[out] output
+///   The output buffer.
+OSSIA_API auto write_resp_aggregate(resp_type type, std::size_t size, std::string &output) -> void;
+
+} // namespace ossia
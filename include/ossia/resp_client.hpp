@@ -0,0 +1,152 @@
+#pragma once
+
+#include "resp.hpp"
+#include "tcp_stream.hpp"
+
+#include <type_traits>
+
+namespace ossia {
+
+/// \class resp_client
+/// \brief
+///   Pipelined RESP client over \c tcp_stream. Commands issued by any number of coroutines in the
+///   same worker iteration are sent together in a single send operation, and replies are mapped
+///   back to the awaiting coroutines in order. This class could only be used in workers.
+class resp_client {
+public:
+    /// \brief
+    ///   Default initial capacity in byte of the receive buffer.
+    static constexpr std::size_t default_buffer_size = 16384;
+
+    /// \brief
+    ///   Default maximum size in byte of a single reply.
+    static constexpr std::size_t default_reply_limit = 64 * 1048576;
+
+    /// \brief
+    ///   Create an unconnected RESP client.
+    /// \param limit
+    ///   Maximum size in byte of a single reply.
+    OSSIA_API explicit resp_client(std::size_t limit = default_reply_limit) noexcept;
+
+    /// \brief
+    ///   Create a RESP client over an established TCP connection.
+    /// \param stream
+    ///   The TCP connection to the server.
+    /// \param limit
+    ///   Maximum size in byte of a single reply.
+    OSSIA_API explicit resp_client(tcp_stream  stream,
+                                   std::size_t limit = default_reply_limit) noexcept;
+
+    /// \brief
+    ///   \c resp_client is not copyable.
+    resp_client(const resp_client &other) = delete;
+
+    /// \brief
+    ///   \c resp_client is not movable because pending operations refer to it.
+    resp_client(resp_client &&other) = delete;
+
+    /// \brief
+    ///   Destroy this client and close the connection. It is undefined behavior to destroy a
+    ///   client with pending commands.
+    OSSIA_API ~resp_client();
+
+    /// \brief
+    ///   \c resp_client is not copyable.
+    auto operator=(const resp_client &other) = delete;
+
+    /// \brief
+    ///   \c resp_client is not movable because pending operations refer to it.
+    auto operator=(resp_client &&other) = delete;
+
+    /// \brief
+    ///   Connect to a RESP server. It is undefined behavior to reconnect a client with pending
+    ///   commands.
+    /// \param address
+    ///   Address of the RESP server.
+    /// \return
+    ///   A system error code that indicates the result of the connection operation. The error code
+    ///   is 0 if succeeded.
+    [[nodiscard]]
+    OSSIA_API auto connect_async(const inet_address &address) noexcept -> future<std::error_code>;
+
+    /// \brief
+    ///   Get the underlying TCP connection.
+    /// \return
+    ///   Reference to the underlying TCP connection.
+    [[nodiscard]]
+    auto tcp() noexcept -> tcp_stream & {
+        return m_stream;
+    }
+
+    /// \brief
+    ///   Execute a command and wait for its reply. The command is serialized when the returned
+    ///   task starts and sent in the next worker iteration together with other commands.
+    /// \param args
+    ///   Command name and arguments. Arguments are copied into the output buffer when the
+    ///   returned task starts.
+    /// \return
+    ///   The reply if succeeded. Error replies from the server are also returned as replies.
+    ///   Otherwise, return a system error code. \c std::errc::protocol_error is returned if the
+    ///   server sends a malformed reply, and \c std::errc::message_size is returned if a reply
+    ///   exceeds the size limit. Once an error occurs, all pending and later commands fail with
+    ///   the same error.
+    [[nodiscard]]
+    OSSIA_API auto execute_async(std::span<const std::string_view> args) noexcept
+        -> future<std::expected<resp_message, std::error_code>>;
+
+    /// \brief
+    ///   Execute a command and wait for its reply. See the \c span overload for details.
+    /// \tparam Args
+    ///   Types of command name and arguments. Each argument must be convertible to
+    ///   \c std::string_view.
+    /// \param args
+    ///   Command name and arguments.
+    /// \return
+    ///   The reply if succeeded. Otherwise, return a system error code.
+    template <class... Args>
+        requires(sizeof...(Args) > 0 &&
+                 (std::is_convertible_v<const Args &, std::string_view> && ...))
+    auto execute_async(Args... args) noexcept
+        -> future<std::expected<resp_message, std::error_code>> {
+        const std::string_view list[]{std::string_view(args)...};
+        co_return co_await this->execute_async(std::span<const std::string_view>(list));
+    }
+
+private:
+    /// \struct request
+    /// \brief
+    ///   A command that is waiting for its reply.
+    struct request;
+
+    /// \brief
+    ///   Send all serialized commands. This task is scheduled once per worker iteration so that
+    ///   commands from the same iteration are batched.
+    auto flush() noexcept -> future<>;
+
+    /// \brief
+    ///   Receive and dispatch replies until no command is waiting.
+    auto receive_loop() noexcept -> future<>;
+
+    /// \brief
+    ///   Fail all waiting commands with the specified error.
+    /// \param error
+    ///   The error to be returned to waiting commands.
+    auto fail(std::error_code error) noexcept -> void;
+
+private:
+    tcp_stream              m_stream;
+    std::unique_ptr<char[]> m_data;
+    std::size_t             m_begin;
+    std::size_t             m_end;
+    std::size_t             m_capacity;
+    std::size_t             m_limit;
+    request                *m_head;
+    request                *m_tail;
+    bool                    m_flushing;
+    bool                    m_receiving;
+    std::error_code         m_error;
+    std::string             m_pending;
+    std::string             m_sending;
+};
+
+} // namespace ossia
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "io_context.hpp"
+
+#include <cstddef>
+#include <expected>
+#include <initializer_list>
+#include <system_error>
+
+namespace ossia {
+
+/// \class signal_set
+/// \brief
+///   \c signal_set receives POSIX signals inside workers. On Linux, signals in the set are
+///   blocked and read from a \c signalfd through the worker's IO muxer, so a coroutine waiting for
+///   \c SIGTERM or \c SIGHUP is resumed as soon as the signal arrives. Signals are managed
+///   process-wide: a forwarding handler is installed while any \c signal_set contains the signal,
+///   and threads that have not blocked the signal forward it to the process pending set so that
+///   it could be read by the \c signalfd. Every worker blocks the signals contained by any
+///   \c signal_set in its next iteration. The previous signal action is restored once the last
+///   \c signal_set that contains the signal is destroyed, and every worker unblocks the signal
+///   again unless it was blocked before. Threads that are not workers only update their signal
+///   masks when they add or release signals themselves, so block the signals in such threads in
+///   advance if they must never be interrupted. Each signal is delivered to only one of the
+///   \c signal_set objects that are waiting for it. This class could only be used in workers and
+///   is not supported on Windows.
+class signal_set {
+public:
+    /// \class wait_awaitable
+    /// \brief
+    ///   Awaitable object for waiting for a signal.
+    class wait_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c wait_awaitable object for asynchronous wait operation.
+        /// \param handle
+        ///   The signal file descriptor to read from.
+        explicit wait_awaitable(std::uintptr_t handle) noexcept
+            : m_ovlp(),
+              m_handle(handle),
+              m_info() {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async wait operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            return this->await_suspend();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous wait operation.
+        /// \return
+        ///   Number of the received signal if succeeded. Otherwise, return a system error code.
+        OSSIA_API auto await_resume() const noexcept -> std::expected<int, std::error_code>;
+
+    private:
+        /// \brief
+        ///   Prepare for asynchronous wait operation and suspend this coroutine.
+        OSSIA_API auto await_suspend() noexcept -> bool;
+
+    private:
+        detail::overlapped m_ovlp;
+        std::uintptr_t     m_handle;
+
+        /// \brief
+        ///   Storage of the platform-specific signal information.
+        alignas(8) std::byte m_info[128];
+    };
+
+public:
+    /// \brief
+    ///   Create an empty \c signal_set object.
+    OSSIA_API signal_set() noexcept;
+
+    /// \brief
+    ///   Create a \c signal_set object that contains the specified signals.
+    /// \param signals
+    ///   Signals to receive, such as \c SIGTERM and \c SIGHUP.
+    /// \throws std::system_error
+    ///   Thrown if failed to add any of the signals.
+    OSSIA_API signal_set(std::initializer_list<int> signals);
+
+    /// \brief
+    ///   \c signal_set is not copyable.
+    signal_set(const signal_set &other) = delete;
+
+    /// \brief
+    ///   Move constructor of \c signal_set.
+    /// \param[in, out] other
+    ///   The \c signal_set object to move. The moved \c signal_set object will be empty.
+    OSSIA_API signal_set(signal_set &&other) noexcept;
+
+    /// \brief
+    ///   Remove all signals and destroy this object. It is undefined behavior to destroy a
+    ///   \c signal_set while a coroutine is waiting for it.
+    OSSIA_API ~signal_set();
+
+    /// \brief
+    ///   \c signal_set is not copyable.
+    auto operator=(const signal_set &other) = delete;
+
+    /// \brief
+    ///   Move assignment operator of \c signal_set.
+    /// \param[in, out] other
+    ///   The \c signal_set object to move. The moved \c signal_set object will be empty.
+    /// \return
+    ///   Reference to this \c signal_set object.
+    OSSIA_API auto operator=(signal_set &&other) noexcept -> signal_set &;
+
+    /// \brief
+    ///   Add a signal to this set. Adding a signal that is already in this set does nothing.
+    /// \param signal
+    ///   The signal to add. \c SIGKILL and \c SIGSTOP could not be added.
+    /// \return
+    ///   A system error code that indicates the result of the operation. The error code is 0 if
+    ///   success. \c std::errc::operation_not_supported is returned on Windows.
+    OSSIA_API auto add(int signal) noexcept -> std::error_code;
+
+    /// \brief
+    ///   Checks if the specified signal is in this set.
+    /// \param signal
+    ///   The signal to check.
+    /// \retval true
+    ///   The signal is in this set.
+    /// \retval false
+    ///   The signal is not in this set.
+    [[nodiscard]]
+    auto contains(int signal) const noexcept -> bool {
+        if (signal <= 0 || signal > 64) [[unlikely]]
+            return false;
+        return (m_signals & (std::uint64_t(1) << (signal - 1))) != 0;
+    }
+
+    /// \brief
+    ///   Wait for any signal in this set asynchronously. Only one coroutine should wait for a
+    ///   \c signal_set at the same time.
+    /// \return
+    ///   Number of the received signal if succeeded. Otherwise, return a system error code.
+    [[nodiscard]]
+    auto wait() noexcept -> wait_awaitable {
+        return wait_awaitable(m_handle);
+    }
+
+    /// \brief
+    ///   Remove all signals from this set and release the signal file descriptor. It is undefined
+    ///   behavior to clear a \c signal_set while a coroutine is waiting for it. This method does
+    ///   nothing if this is an empty \c signal_set object.
+    OSSIA_API auto clear() noexcept -> void;
+
+private:
+    std::uintptr_t m_handle;
+    std::uint64_t  m_signals;
+};
+
+} // namespace ossia
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "future.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace ossia {
+
+/// \struct task_context
+/// \brief
+///   Request-scoped values that are visible to every coroutine awaited by the coroutine that sets
+///   the context, such as the deadline and trace ID of a request. Coroutines inherit the context
+///   of their caller when they are awaited, so nested calls see it without extra parameters.
+///   Thread-local variables could not be used for this, since coroutines interleave on a worker.
+///
+///   Asynchronous receive operations clamp their timeouts to the deadline of the context, and
+///   fail with \c std::errc::timed_out at once if the deadline has passed.
+struct task_context {
+    /// \brief
+    ///   Time point after which IO operations of the task time out. \c time_point::max() means no
+    ///   deadline.
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    /// \brief
+    ///   W3C trace context trace ID of the request. All zeros means that the request is not
+    ///   traced.
+    std::array<std::uint8_t, 16> trace_id{};
+
+    /// \brief
+    ///   W3C trace context ID of the current span.
+    std::array<std::uint8_t, 8> span_id{};
+
+    /// \brief
+    ///   Checks if this context has a deadline.
+    /// \retval true
+    ///   This context has a deadline.
+    /// \retval false
+    ///   This context has no deadline.
+    [[nodiscard]]
+    auto has_deadline() const noexcept -> bool {
+        return deadline != std::chrono::steady_clock::time_point::max();
+    }
+
+    /// \brief
+    ///   Get time left before the deadline.
+    /// \param now
+    ///   Current time.
+    /// \return
+    ///   Time left before the deadline. This is zero or negative if the deadline has passed, and
+    ///   \c duration::max() if there is no deadline.
+    [[nodiscard]]
+    auto remaining(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now())
+        const noexcept -> std::chrono::steady_clock::duration {
+        if (!has_deadline())
+            return std::chrono::steady_clock::duration::max();
+        return deadline - now;
+    }
+
+    /// \brief
+    ///   Create a child context with a deadline no later than \p time. The trace ID is kept.
+    /// \param time
+    ///   Deadline of the child context. The deadline of this context is kept if it is earlier.
+    /// \return
+    ///   The child context.
+    [[nodiscard]]
+    auto with_deadline(std::chrono::steady_clock::time_point time) const noexcept
+        -> task_context {
+        task_context child = *this;
+        child.deadline     = std::min(deadline, time);
+        return child;
+    }
+
+    /// \brief
+    ///   Create a child context that times out after \p timeout from now. The trace ID is kept.
+    /// \param timeout
+    ///   Timeout of the child context. The deadline of this context is kept if it is earlier.
+    /// \return
+    ///   The child context.
+    template <class Rep, class Period>
+    [[nodiscard]]
+    auto with_timeout(std::chrono::duration<Rep, Period> timeout) const noexcept -> task_context {
+        auto now   = std::chrono::steady_clock::now();
+        auto delay = std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+        return with_deadline(now + delay);
+    }
+};
+
+namespace detail {
+
+/// \class current_context_awaitable
+/// \brief
+///   For internal usage. Awaitable object that gets the context of the awaiting coroutine
+///   without suspending it.
+class current_context_awaitable {
+public:
+    /// \brief
+    ///   C++20 coroutine API method. Always execute \c await_suspend().
+    /// \return
+    ///   This function always returns \c false.
+    static constexpr auto await_ready() noexcept -> bool {
+        return false;
+    }
+
+    /// \brief
+    ///   Get the context of the awaiting coroutine.
+    /// \tparam T
+    ///   Type of promise of current coroutine.
+    /// \param coroutine
+    ///   Current coroutine handle.
+    /// \return
+    ///   This function always returns \c false so that the coroutine is not suspended.
+    template <class T>
+    auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+        m_context = static_cast<promise_base &>(coroutine.promise()).context();
+        return false;
+    }
+
+    /// \brief
+    ///   Get the context of the awaiting coroutine.
+    /// \return
+    ///   The context of the awaiting coroutine. Return \c nullptr if there is no context.
+    [[nodiscard]]
+    auto await_resume() const noexcept -> task_context * {
+        return m_context;
+    }
+
+private:
+    task_context *m_context = nullptr;
+};
+
+/// \class set_context_awaitable
+/// \brief
+///   For internal usage. Awaitable object that replaces the context of the awaiting coroutine
+///   without suspending it.
+class set_context_awaitable {
+public:
+    /// \brief
+    ///   Create a new \c set_context_awaitable object.
+    /// \param[in] context
+    ///   The new context. Pass \c nullptr to clear the context.
+    explicit set_context_awaitable(task_context *context) noexcept
+        : m_context(context),
+          m_previous() {}
+
+    /// \brief
+    ///   C++20 coroutine API method. Always execute \c await_suspend().
+    /// \return
+    ///   This function always returns \c false.
+    static constexpr auto await_ready() noexcept -> bool {
+        return false;
+    }
+
+    /// \brief
+    ///   Replace the context of the awaiting coroutine.
+    /// \tparam T
+    ///   Type of promise of current coroutine.
+    /// \param coroutine
+    ///   Current coroutine handle.
+    /// \return
+    ///   This function always returns \c false so that the coroutine is not suspended.
+    template <class T>
+    auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+        auto &promise = static_cast<promise_base &>(coroutine.promise());
+        m_previous    = promise.context();
+        promise.set_context(m_context);
+        return false;
+    }
+
+    /// \brief
+    ///   Get the previous context of the awaiting coroutine.
+    /// \return
+    ///   The previous context. Return \c nullptr if there was no context.
+    auto await_resume() const noexcept -> task_context * {
+        return m_previous;
+    }
+
+private:
+    task_context *m_context;
+    task_context *m_previous;
+};
+
+} // namespace detail
+
+/// \brief
+///   Get the context of the current coroutine. This function must be awaited.
+/// \return
+///   An awaitable object that returns the context of the current coroutine, or \c nullptr if the
+///   coroutine has no context.
+[[nodiscard]]
+inline auto current_task_context() noexcept -> detail::current_context_awaitable {
+    return {};
+}
+
+/// \brief
+///   Replace the context of the current coroutine. Coroutines awaited after this call inherit the
+///   new context, while the caller of the current coroutine keeps its own. This function must be
+///   awaited.
+/// \param[in] context
+///   The new context. It must be alive until the current coroutine and all coroutines awaited by
+///   it no longer use it. Pass \c nullptr to clear the context.
+/// \return
+///   An awaitable object that returns the previous context of the current coroutine.
+[[nodiscard]]
+inline auto set_task_context(task_context *context) noexcept -> detail::set_context_awaitable {
+    return detail::set_context_awaitable(context);
+}
+
+/// \brief
+///   Attach a context to a task before it is scheduled. Scheduled tasks are not awaited by any
+///   coroutine, so they do not inherit a context by themselves.
+/// \tparam T
+///   Return type of the task.
+/// \param task
+///   The task to attach the context to. This task should be the coroutine stack bottom task.
+/// \param[in] context
+///   The context of the task. It must be alive until the task no longer uses it.
+/// \return
+///   The task with the context attached.
+template <class T>
+[[nodiscard]]
+auto with_task_context(future<T> task, task_context *context) noexcept -> future<T> {
+    if (!task.is_null())
+        task.coroutine().promise().set_context(context);
+    return task;
+}
+
+} // namespace ossia
@@ -4,12 +4,37 @@
 
 namespace ossia {
 
+/// \struct accepted_stream
+/// \brief
+///   A TCP connection accepted together with the first bytes received from it.
+struct accepted_stream {
+    /// \brief
+    ///   The accepted connection.
+    tcp_stream stream;
+
+    /// \brief
+    ///   Number of bytes received into the buffer passed to \c tcp_server::accept_async. This is 0
+    ///   if nothing is read ahead, for example if the peer closed the connection, the first
+    ///   receive failed or timed out, or the accept fell back to a plain accept. Receive from
+    ///   \c stream as usual to get the result in that case.
+    std::uint32_t size;
+};
+
 /// \class tcp_server
 /// \brief
 ///   \c tcp_server is a class that represents a TCP server. This class could only be used in
 ///   workers.
 class tcp_server {
 public:
+    /// \brief
+    ///   Size in byte of the end of the buffer that is reserved for addresses when accepting with
+    ///   first receive on Windows.
+    static constexpr std::uint32_t accept_address_space = sizeof(inet_address) + 16;
+
+    /// \brief
+    ///   Timeout of the first receive of \c accept_async with a buffer if no timeout is specified.
+    static constexpr std::chrono::seconds first_receive_timeout = std::chrono::seconds(1);
+
     /// \class accept_awaitable
     /// \brief
     ///   Awaitable object for accepting a new TCP connection.
@@ -19,12 +44,40 @@ public:
         ///   Create a new \c accept_awaitable object for asynchronous accept operation.
         /// \param[in] server
         ///   The \c tcp_server object to accept new connection.
-        accept_awaitable(tcp_server &server) noexcept
+        accept_awaitable(tcp_server &server) noexcept : accept_awaitable(server, nullptr, 0) {}
+
+        /// \brief
+        ///   Create a new \c accept_awaitable object for asynchronous accept operation that also
+        ///   receives the first bytes of the new connection.
+        /// \param[in] server
+        ///   The \c tcp_server object to accept new connection.
+        /// \param[in] data
+        ///   Pointer to start of buffer to receive the first bytes.
+        /// \param size
+        ///   Size in byte of the buffer. Zero means a plain accept.
+        /// \param timeout
+        ///   Timeout of the first receive. Zero timeout means never timeout.
+        accept_awaitable(tcp_server             &server,
+                         void                   *data,
+                         std::uint32_t           size,
+                         detail::kernel_timespec timeout = {}) noexcept
             : m_ovlp(),
               m_server(&server),
               m_socket(),
               m_address(),
-              m_padding{} {}
+              m_padding{},
+              m_admission(),
+              m_data(data),
+              m_size(size),
+              m_timeout(timeout)
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+              ,
+              m_slot(-1),
+              m_pending(),
+              m_steps()
+#endif
+        {
+        }
 
         /// \brief
         ///   C++20 coroutine API method. Always execute \c await_suspend().
@@ -59,15 +112,150 @@ public:
 
     private:
         /// \brief
-        ///   Prepare for asynchronous accept operation and suspend this coroutine.
+        ///   Prepare for asynchronous accept operation and suspend this coroutine. The accept
+        ///   operation is paused while the current worker is overloaded.
         OSSIA_API auto await_suspend() noexcept -> bool;
 
-    private:
-        detail::overlapped m_ovlp;
-        const tcp_server  *m_server;
-        std::uintptr_t     m_socket;
-        inet_address       m_address;
-        char               m_padding[16];
+        /// \brief
+        ///   Issue the accept operation.
+        /// \retval true
+        ///   The accept operation is pending.
+        /// \retval false
+        ///   The accept operation is completed or failed immediately.
+        OSSIA_API auto submit() noexcept -> bool;
+
+        /// \brief
+        ///   Issue the accept operation once the worker is no longer overloaded.
+        /// \param[in] entry
+        ///   The admission entry of this awaitable.
+        OSSIA_API static auto submit_admitted(detail::timer_entry *entry) noexcept -> void;
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+        /// \brief
+        ///   Issue the accept operation linked with the first receive into a direct descriptor
+        ///   slot.
+        /// \param slot
+        ///   Index of the direct descriptor slot to accept into.
+        /// \retval true
+        ///   The linked operations are pending.
+        /// \retval false
+        ///   Failed to issue the linked operations.
+        OSSIA_API auto submit_linked(std::int32_t slot) noexcept -> bool;
+
+        /// \brief
+        ///   Handle completion of one of the linked operations. The coroutine is resumed once all
+        ///   of them are completed.
+        /// \param[in] ovlp
+        ///   Overlapped structure of the completed operation.
+        OSSIA_API static auto complete_linked(detail::multishot_overlapped *ovlp) noexcept -> void;
+#endif
+
+    protected:
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+        /// \struct linked_overlapped
+        /// \brief
+        ///   Overlapped structure of one of the linked operations of an accept with first
+        ///   receive.
+        struct linked_overlapped : detail::multishot_overlapped {
+            accept_awaitable *owner;
+        };
+#endif
+
+        detail::overlapped      m_ovlp;
+        const tcp_server       *m_server;
+        std::uintptr_t          m_socket;
+        inet_address            m_address;
+        char                    m_padding[16];
+        detail::timer_entry     m_admission;
+        void                   *m_data;
+        std::uint32_t           m_size;
+        detail::kernel_timespec m_timeout;
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+        /// \brief
+        ///   Direct descriptor slot of the linked operations. This is -1 for a plain accept.
+        std::int32_t m_slot;
+
+        /// \brief
+        ///   Number of linked operations that are not completed.
+        std::int32_t m_pending;
+
+        /// \brief
+        ///   Accept, descriptor install, first receive, its linked timeout and slot close, in
+        ///   submission order. The timeout is left out if the first receive never times out.
+        linked_overlapped m_steps[5];
+#endif
+    };
+
+    /// \class accept_receive_awaitable
+    /// \brief
+    ///   Awaitable object for accepting a new TCP connection and receiving its first bytes. On
+    ///   Linux the accept, the first receive and the installation of the new descriptor are linked
+    ///   in one submission with a direct descriptor slot, so the coroutine is resumed once per
+    ///   connection. On Windows the first bytes are received by \c AcceptEx.
+    class accept_receive_awaitable : public accept_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c accept_receive_awaitable object.
+        /// \param[in] server
+        ///   The \c tcp_server object to accept new connection.
+        /// \param[in] data
+        ///   Pointer to start of buffer to receive the first bytes.
+        /// \param size
+        ///   Size in byte of the buffer.
+        /// \param timeout
+        ///   Timeout of the first receive. Zero timeout means never timeout.
+        accept_receive_awaitable(tcp_server             &server,
+                                 void                   *data,
+                                 std::uint32_t           size,
+                                 detail::kernel_timespec timeout) noexcept
+            : accept_awaitable(server, data, size, timeout) {}
+
+        /// \brief
+        ///   Get the result of the asynchronous accept operation.
+        /// \return
+        ///   The new connection and number of bytes received into the buffer if succeeded.
+        ///   Otherwise, return a system error code that represents system IO error.
+        OSSIA_API auto await_resume() const noexcept
+            -> std::expected<accepted_stream, std::error_code>;
+    };
+
+    /// \class basic_accept_awaitable
+    /// \brief
+    ///   Awaitable object for accepting a new TCP connection and applying the options of
+    ///   \p Policy to it.
+    /// \tparam Policy
+    ///   Options of the accepted connection. See \c default_tcp_policy for details.
+    template <class Policy>
+    class basic_accept_awaitable : public accept_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c basic_accept_awaitable object for asynchronous accept operation.
+        /// \param[in] server
+        ///   The \c tcp_server object to accept new connection.
+        basic_accept_awaitable(tcp_server &server) noexcept : accept_awaitable(server) {}
+
+        /// \brief
+        ///   Get the result of the asynchronous accept operation. Options of \p Policy are
+        ///   applied to the new connection.
+        /// \return
+        ///   A new \c basic_tcp_stream object if succeeded. Otherwise, return a system error code
+        ///   that represents system IO error. The new connection is closed if failed to apply the
+        ///   options.
+        auto await_resume() const noexcept
+            -> std::expected<basic_tcp_stream<Policy>, std::error_code> {
+            auto stream = accept_awaitable::await_resume();
+            if (!stream.has_value()) [[unlikely]]
+                return std::unexpected(stream.error());
+
+            basic_tcp_stream<Policy> result(std::move(*stream));
+
+            auto error = result.apply_options();
+            if (error.value() != 0) [[unlikely]]
+                return std::unexpected(error);
+
+            return result;
+        }
     };
 
 public:
@@ -141,6 +329,76 @@ public:
         return accept_awaitable(*this);
     }
 
+    /// \brief
+    ///   Accept a new incoming TCP connection asynchronously and apply the options of \p Policy
+    ///   to it. This method will suspend this coroutine until a new incoming connection is
+    ///   established or any error occurs.
+    /// \tparam Policy
+    ///   Options of the accepted connection. See \c default_tcp_policy for details.
+    /// \return
+    ///   A new \c basic_tcp_stream object if succeeded. Otherwise, return a system error code that
+    ///   represents system IO error.
+    template <class Policy>
+    [[nodiscard]]
+    auto accept_async() noexcept -> basic_accept_awaitable<Policy> {
+        return basic_accept_awaitable<Policy>(*this);
+    }
+
+    /// \brief
+    ///   Accept a new incoming TCP connection and receive its first bytes asynchronously. This
+    ///   saves a resume and a separate receive submission per connection for short
+    ///   request/response protocols. This method will suspend this coroutine until the first
+    ///   bytes arrive, the peer closes the connection, the first receive times out after
+    ///   \c first_receive_timeout or any error occurs. A connection that times out is returned
+    ///   with no data, so receive from it as usual.
+    ///
+    ///   On Linux, each pending accept holds a direct descriptor slot of the worker. See
+    ///   \c io_context_options::direct_descriptor_count. Accepts without a free slot fall back
+    ///   to a plain accept. On Windows, \c AcceptEx could not time out the receive alone, so only
+    ///   accepts whose first receive never times out receive the first bytes. The end of the
+    ///   buffer is used for addresses by \c AcceptEx, and buffers no larger than
+    ///   \c accept_address_space fall back to a plain accept as well.
+    /// \param[out] data
+    ///   Pointer to start of buffer to receive the first bytes. The buffer must be alive until
+    ///   the accept operation is completed.
+    /// \param size
+    ///   Size in byte of the buffer.
+    /// \return
+    ///   The new connection and number of bytes received if succeeded. Otherwise, return a system
+    ///   error code that represents system IO error.
+    [[nodiscard]]
+    auto accept_async(void *data, std::uint32_t size) noexcept -> accept_receive_awaitable {
+        return this->accept_async(data, size, first_receive_timeout);
+    }
+
+    /// \brief
+    ///   Accept a new incoming TCP connection and receive its first bytes asynchronously with the
+    ///   specified timeout of the first receive. The timeout starts once the connection is
+    ///   accepted, and bounds how long a connection that sends nothing holds this accept and its
+    ///   direct descriptor slot. See \c accept_async(void *, std::uint32_t) for details.
+    /// \tparam Rep
+    ///   Type of the tick count of the timeout.
+    /// \tparam Duration
+    ///   Type of the tick period of the timeout.
+    /// \param[out] data
+    ///   Pointer to start of buffer to receive the first bytes. The buffer must be alive until
+    ///   the accept operation is completed.
+    /// \param size
+    ///   Size in byte of the buffer.
+    /// \param timeout
+    ///   Timeout of the first receive. Zero timeout means never timeout.
+    /// \return
+    ///   The new connection and number of bytes received if succeeded. Otherwise, return a system
+    ///   error code that represents system IO error.
+    template <class Rep, class Duration>
+    [[nodiscard]]
+    auto accept_async(void                                *data,
+                      std::uint32_t                        size,
+                      std::chrono::duration<Rep, Duration> timeout) noexcept
+        -> accept_receive_awaitable {
+        return accept_receive_awaitable(*this, data, size, detail::make_kernel_timespec(timeout));
+    }
+
     /// \brief
     ///   Stop listening and release all resources. Closing a \c tcp_server object will cause errors
     ///   for pending accept operations. This method does nothing if this is an empty \c tcp_server
@@ -1,14 +1,273 @@
 #pragma once
 
+#include "file.hpp"
 #include "inet_address.hpp"
 #include "io_context.hpp"
+#include "rate_limiter.hpp"
+#include "task_context.hpp"
 
 #include <chrono>
 #include <expected>
 #include <system_error>
+#include <type_traits>
+#include <utility>
 
 namespace ossia {
 
+/// \struct default_tcp_policy
+/// \brief
+///   Options of TCP connections that are fixed at compile time. Custom policies should derive from
+///   this policy and hide the options to change, so that new options keep their defaults. Options
+///   are applied once when a \c basic_tcp_stream is accepted or connected, and options that keep
+///   their defaults are skipped at compile time.
+struct default_tcp_policy {
+    /// \brief
+    ///   Enable TCP no-delay mechanism. \c false leaves the system default.
+    static constexpr bool no_delay = false;
+
+    /// \brief
+    ///   Enable keep-alive mechanism. \c false leaves the system default.
+    static constexpr bool keep_alive = false;
+
+    /// \brief
+    ///   Timeout of asynchronous receive operations. Zero means never timeout.
+    static constexpr std::chrono::nanoseconds receive_timeout = std::chrono::nanoseconds::zero();
+
+    /// \brief
+    ///   Extra flags of asynchronous send operations, such as \c MSG_MORE on Linux.
+    static constexpr std::uint32_t send_flags = 0;
+
+    /// \brief
+    ///   Charge asynchronous operations to the rate limiters of the connection. \c false removes
+    ///   rate limiting from the awaitables, and the limiters could not be set.
+    static constexpr bool rate_limited = true;
+};
+
+/// \struct no_delay_tcp_policy
+/// \brief
+///   Options of latency sensitive connections, such as request/response protocols. TCP no-delay
+///   is enabled and other options keep their defaults.
+struct no_delay_tcp_policy : default_tcp_policy {
+    static constexpr bool no_delay = true;
+};
+
+template <class Policy = default_tcp_policy>
+class basic_tcp_stream;
+
+namespace detail {
+
+/// \struct timed_overlapped
+/// \brief
+///   For internal usage. Overlapped structure for TCP operations with a timeout. An operation
+///   that is cancelled for other reasons, such as \c tcp_stream::cancel(), is not reported as
+///   timed out.
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+struct timed_overlapped : overlapped {
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+struct timed_overlapped : multishot_overlapped {
+#endif
+    /// \brief
+    ///   Timeout of the operation. Zero means never timeout. The timeout is clamped to the
+    ///   deadline of the \c task_context of the awaiting coroutine when the operation is issued.
+    kernel_timespec timeout;
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    /// \brief
+    ///   The socket to cancel the operation on once the timer expires.
+    std::uintptr_t socket;
+
+    /// \brief
+    ///   The threadpool timer that cancels the operation.
+    void *timer;
+
+    /// \brief
+    ///   Set by the timer callback if the timer cancelled the operation.
+    bool expired;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    /// \struct expiry_overlapped
+    /// \brief
+    ///   Overlapped structure of the linked timeout. Its result is \c -ETIME if the timeout
+    ///   expired.
+    struct expiry_overlapped : multishot_overlapped {
+        timed_overlapped *owner;
+    };
+
+    /// \brief
+    ///   Completion of the linked timeout.
+    expiry_overlapped expiry;
+
+    /// \brief
+    ///   Number of completions of the operation and its linked timeout that are not reaped yet.
+    ///   The coroutine is resumed once both of them are reaped.
+    std::int32_t pending;
+#endif
+};
+
+/// \struct zero_copy_overlapped
+/// \brief
+///   For internal usage. Overlapped structure for TCP send operations from registered buffers. On
+///   Linux, the operation completes only after the kernel releases the buffer, which is reported
+///   separately from the result of the send operation.
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+struct zero_copy_overlapped : overlapped {};
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+struct zero_copy_overlapped : multishot_overlapped {
+    /// \brief
+    ///   Result of the send operation.
+    std::int32_t bytes;
+};
+#endif
+
+/// \brief
+///   For internal usage. Charge an IO operation to a rate limiter and delay it with a worker
+///   timer if it does not conform yet.
+/// \param[in, out] limiter
+///   The rate limiter to charge the operation to.
+/// \param bytes
+///   Number of bytes to charge.
+/// \param operations
+///   Number of operations to charge.
+/// \param[out] timer
+///   Timer to add to the current worker if the operation is delayed.
+/// \param[in] promise
+///   Promise of the coroutine that issues the operation.
+/// \param expire
+///   Handler that issues the operation once the timer expires.
+/// \param[in] context
+///   User data of the timer.
+/// \retval true
+///   The operation is delayed and will be issued by \p expire.
+/// \retval false
+///   The operation conforms and should be issued now.
+OSSIA_API auto throttle(rate_limiter  &limiter,
+                        std::uint64_t  bytes,
+                        std::uint64_t  operations,
+                        timer_entry   &timer,
+                        promise_base  *promise,
+                        void (*expire)(timer_entry *) noexcept,
+                        void          *context) noexcept -> bool;
+
+/// \brief
+///   For internal usage. Issue an asynchronous TCP send operation. The promise of \p ovlp must be
+///   set.
+/// \param[in, out] ovlp
+///   Overlapped structure of the operation.
+/// \param socket
+///   The socket handle to send data.
+/// \param data
+///   Pointer to start of data to send.
+/// \param size
+///   Size in byte of data to send.
+/// \param flags
+///   Extra flags of the send operation. \c MSG_NOSIGNAL is always used on Linux.
+/// \retval true
+///   The send operation is pending.
+/// \retval false
+///   The send operation is completed or failed immediately.
+OSSIA_API auto submit_tcp_send(overlapped    &ovlp,
+                               std::uintptr_t socket,
+                               const void    *data,
+                               std::uint32_t  size,
+                               std::uint32_t  flags) noexcept -> bool;
+
+/// \brief
+///   For internal usage. Issue an asynchronous TCP send operation from a registered buffer. On
+///   Linux, data is sent with zero-copy from the registered pages. On Windows, this is a regular
+///   send operation.
+/// \param[in, out] ovlp
+///   Overlapped structure of the operation.
+/// \param socket
+///   The socket handle to send data.
+/// \param buffer
+///   The registered buffer that contains the data.
+/// \param size
+///   Size in byte of data to send.
+/// \param flags
+///   Extra flags of the send operation. \c MSG_NOSIGNAL is always used on Linux.
+/// \retval true
+///   The send operation is pending.
+/// \retval false
+///   The send operation is completed or failed immediately.
+OSSIA_API auto submit_tcp_send(zero_copy_overlapped    &ovlp,
+                               std::uintptr_t           socket,
+                               const registered_buffer &buffer,
+                               std::uint32_t            size,
+                               std::uint32_t            flags) noexcept -> bool;
+
+/// \brief
+///   For internal usage. Issue an asynchronous TCP receive operation. The promise of \p ovlp must
+///   be set. The timeout of \p ovlp is clamped to the task deadline before it is issued.
+/// \param[in, out] ovlp
+///   Overlapped structure of the operation.
+/// \param socket
+///   The socket handle to receive data.
+/// \param[out] data
+///   Pointer to start of buffer to receive data.
+/// \param size
+///   Size in byte of buffer to store the received data.
+/// \retval true
+///   The receive operation is pending.
+/// \retval false
+///   The receive operation is completed or failed immediately.
+OSSIA_API auto submit_tcp_receive(timed_overlapped &ovlp,
+                                  std::uintptr_t    socket,
+                                  void             *data,
+                                  std::uint32_t     size) noexcept -> bool;
+
+/// \brief
+///   For internal usage. Issue an asynchronous TCP receive operation into a registered buffer.
+///   See \c submit_tcp_receive for details.
+/// \param[in, out] ovlp
+///   Overlapped structure of the operation.
+/// \param socket
+///   The socket handle to receive data.
+/// \param buffer
+///   The registered buffer to store the received data.
+/// \param size
+///   Size in byte to receive. This value must not be greater than size of \p buffer.
+/// \retval true
+///   The receive operation is pending.
+/// \retval false
+///   The receive operation is completed or failed immediately.
+OSSIA_API auto submit_tcp_receive(timed_overlapped        &ovlp,
+                                  std::uintptr_t           socket,
+                                  const registered_buffer &buffer,
+                                  std::uint32_t            size) noexcept -> bool;
+
+/// \brief
+///   For internal usage. Get the result of an asynchronous TCP send operation.
+/// \param ovlp
+///   Overlapped structure of the operation.
+/// \return
+///   Number of bytes sent if succeeded. Otherwise, return a system error code that represents the
+///   IO error.
+OSSIA_API auto tcp_send_result(const overlapped &ovlp) noexcept
+    -> std::expected<std::uint32_t, std::error_code>;
+
+/// \brief
+///   For internal usage. Get the result of an asynchronous TCP send operation from a registered
+///   buffer.
+/// \param ovlp
+///   Overlapped structure of the operation.
+/// \return
+///   Number of bytes sent if succeeded. Otherwise, return a system error code that represents the
+///   IO error.
+OSSIA_API auto tcp_send_result(const zero_copy_overlapped &ovlp) noexcept
+    -> std::expected<std::uint32_t, std::error_code>;
+
+/// \brief
+///   For internal usage. Get the result of an asynchronous TCP receive operation and release its
+///   timer.
+/// \param ovlp
+///   Overlapped structure of the operation.
+/// \return
+///   Number of bytes received if succeeded. Otherwise, return a system error code that represents
+///   the IO error. \c std::errc::timed_out is returned if the receive operation is timed out.
+OSSIA_API auto tcp_receive_result(const timed_overlapped &ovlp) noexcept
+    -> std::expected<std::uint32_t, std::error_code>;
+
+} // namespace detail
+
 /// \class tcp_stream
 /// \brief
 ///   \c tcp_stream is a class that represents a TCP connection. This class could only be used in
@@ -24,11 +283,20 @@ public:
         ///   Create a new \c connect_awaitable object for asynchronous connect operation.
         /// \param[in] stream
         ///   The \c tcp_stream object to establish connection. The
-        connect_awaitable(tcp_stream &stream, const inet_address &address) noexcept
+        /// \param address
+        ///   The peer address to connect.
+        /// \param timeout
+        ///   Timeout of this connect operation. Zero timeout means never timeout. The timeout is
+        ///   clamped to the deadline of the \c task_context of the awaiting coroutine.
+        connect_awaitable(tcp_stream             &stream,
+                          const inet_address     &address,
+                          detail::kernel_timespec timeout = {}) noexcept
             : m_ovlp(),
               m_socket(),
               m_address(&address),
-              m_stream(&stream) {}
+              m_stream(&stream) {
+            m_ovlp.timeout = timeout;
+        }
 
         /// \brief
         ///   C++20 coroutine API method. Always execute \c await_suspend().
@@ -58,6 +326,7 @@ public:
         ///   Get the result of the asynchronous connect operation.
         /// \return
         ///   Error code of the asynchronous connect operation. The error code is 0 if success.
+        ///   \c std::errc::timed_out is returned if the connect operation is timed out.
         OSSIA_API auto await_resume() const noexcept -> std::error_code;
 
     private:
@@ -66,10 +335,10 @@ public:
         OSSIA_API auto await_suspend() noexcept -> bool;
 
     private:
-        detail::overlapped  m_ovlp;
-        std::uintptr_t      m_socket;
-        const inet_address *m_address;
-        tcp_stream         *m_stream;
+        detail::timed_overlapped m_ovlp;
+        std::uintptr_t           m_socket;
+        const inet_address      *m_address;
+        tcp_stream              *m_stream;
     };
 
     /// \class send_awaitable
@@ -85,11 +354,19 @@ public:
         ///   Pointer to start of data to send.
         /// \param size
         ///   Size in byte of data to send.
-        send_awaitable(std::uintptr_t socket, const void *data, std::uint32_t size) noexcept
+        /// \param[in] limiter
+        ///   Rate limiter to charge this send operation to. The operation is delayed until it
+        ///   conforms to the limiter. Pass \c nullptr to send without rate limiting.
+        send_awaitable(std::uintptr_t socket,
+                       const void    *data,
+                       std::uint32_t  size,
+                       rate_limiter  *limiter = nullptr) noexcept
             : m_ovlp(),
               m_socket(socket),
               m_data(data),
-              m_size(size) {}
+              m_size(size),
+              m_limiter(limiter),
+              m_throttle() {}
 
         /// \brief
         ///   C++20 coroutine API method. Always execute \c await_suspend().
@@ -128,11 +405,27 @@ public:
         ///   Prepare for asynchronous send operation and suspend this coroutine.
         OSSIA_API auto await_suspend() noexcept -> bool;
 
+        /// \brief
+        ///   Issue the send operation.
+        /// \retval true
+        ///   The send operation is pending.
+        /// \retval false
+        ///   The send operation is completed or failed immediately.
+        OSSIA_API auto submit() noexcept -> bool;
+
+        /// \brief
+        ///   Issue the send operation once the rate limiter timer expires.
+        /// \param[in] timer
+        ///   The rate limiter timer of this awaitable.
+        OSSIA_API static auto submit_delayed(detail::timer_entry *timer) noexcept -> void;
+
     private:
-        detail::overlapped m_ovlp;
-        std::uintptr_t     m_socket;
-        const void        *m_data;
-        std::uint32_t      m_size;
+        detail::overlapped  m_ovlp;
+        std::uintptr_t      m_socket;
+        const void         *m_data;
+        std::uint32_t       m_size;
+        rate_limiter       *m_limiter;
+        detail::timer_entry m_throttle;
     };
 
     /// \class receive_awaitable
@@ -148,11 +441,27 @@ public:
         ///   Pointer to start of buffer to receive data.
         /// \param size
         ///   Size in byte of buffer to store the received data.
-        receive_awaitable(std::uintptr_t socket, void *data, std::uint32_t size) noexcept
+        /// \param timeout
+        ///   Timeout of this receive operation. Zero timeout means never timeout. The timeout
+        ///   starts after the rate limiter delay, and it is clamped to the deadline of the
+        ///   \c task_context of the awaiting coroutine.
+        /// \param[in] limiter
+        ///   Rate limiter to charge this receive operation to. The operation is delayed until it
+        ///   conforms to the limiter, and received bytes are charged once it completes. Pass
+        ///   \c nullptr to receive without rate limiting.
+        receive_awaitable(std::uintptr_t          socket,
+                          void                   *data,
+                          std::uint32_t           size,
+                          detail::kernel_timespec timeout = {},
+                          rate_limiter           *limiter = nullptr) noexcept
             : m_ovlp(),
               m_socket(socket),
               m_data(data),
-              m_size(size) {}
+              m_size(size),
+              m_limiter(limiter),
+              m_throttle() {
+            m_ovlp.timeout = timeout;
+        }
 
         /// \brief
         ///   C++20 coroutine API method. Always execute \c await_suspend().
@@ -182,7 +491,8 @@ public:
         ///   Get the result of the asynchronous receive operation.
         /// \return
         ///   Number of bytes received if succeeded. Otherwise, return a system error code that
-        ///   represents the IO error.
+        ///   represents the IO error. \c std::errc::timed_out is returned if the receive operation
+        ///   is timed out.
         OSSIA_API auto await_resume() const noexcept
             -> std::expected<std::uint32_t, std::error_code>;
 
@@ -191,11 +501,27 @@ public:
         ///   Prepare for asynchronous receive operation and suspend this coroutine.
         OSSIA_API auto await_suspend() noexcept -> bool;
 
+        /// \brief
+        ///   Issue the receive operation.
+        /// \retval true
+        ///   The receive operation is pending.
+        /// \retval false
+        ///   The receive operation is completed or failed immediately.
+        OSSIA_API auto submit() noexcept -> bool;
+
+        /// \brief
+        ///   Issue the receive operation once the rate limiter timer expires.
+        /// \param[in] timer
+        ///   The rate limiter timer of this awaitable.
+        OSSIA_API static auto submit_delayed(detail::timer_entry *timer) noexcept -> void;
+
     private:
-        detail::overlapped m_ovlp;
-        std::uintptr_t     m_socket;
-        void              *m_data;
-        std::uint32_t      m_size;
+        detail::timed_overlapped m_ovlp;
+        std::uintptr_t           m_socket;
+        void                    *m_data;
+        std::uint32_t            m_size;
+        rate_limiter            *m_limiter;
+        detail::timer_entry      m_throttle;
     };
 
 public:
@@ -212,7 +538,10 @@ public:
     ///   The peer address of the TCP connection.
     tcp_stream(std::uintptr_t socket, const inet_address &address) noexcept
         : m_socket(socket),
-          m_address(address) {}
+          m_address(address),
+          m_send_limiter(),
+          m_receive_limiter(),
+          m_connecting(static_cast<std::uintptr_t>(-1)) {}
 
     /// \brief
     ///   \c tcp_stream is not copyable.
@@ -280,6 +609,33 @@ public:
         return connect_awaitable(*this, address);
     }
 
+    /// \brief
+    ///   Connect to the specified peer address asynchronously with a timeout. This method will
+    ///   suspend this coroutine until the connection is established, any error occurs or the
+    ///   timeout expires. The timer is managed by the worker's IO muxer and no extra thread is
+    ///   involved on Linux.
+    /// \remarks
+    ///   This method does not affect this \c tcp_stream object if failed to establish new
+    ///   connection.
+    /// \tparam Rep
+    ///   Type of the duration representation.
+    /// \tparam Duration
+    ///   Type of the duration.
+    /// \param address
+    ///   The peer address to connect.
+    /// \param timeout
+    ///   Timeout duration. Use 0 or negative value for never timeout.
+    /// \return
+    ///   A system error code that indicates the result of the connection operation. The error code
+    ///   is 0 if success. \c std::errc::timed_out is returned if the connection is not
+    ///   established before the timeout expires.
+    template <class Rep, class Duration>
+    [[nodiscard]]
+    auto connect_async(const inet_address                  &address,
+                       std::chrono::duration<Rep, Duration> timeout) noexcept -> connect_awaitable {
+        return connect_awaitable(*this, address, detail::make_kernel_timespec(timeout));
+    }
+
     /// \brief
     ///   Send data to the peer TCP endpoint. This method will block current thread until the data
     ///   is sent or any error occurs.
@@ -305,7 +661,7 @@ public:
     ///   the IO error.
     [[nodiscard]]
     auto send_async(const void *data, std::uint32_t size) noexcept -> send_awaitable {
-        return send_awaitable(m_socket, data, size);
+        return send_awaitable(m_socket, data, size, m_send_limiter);
     }
 
     /// \brief
@@ -333,9 +689,58 @@ public:
     ///   represents the IO error.
     [[nodiscard]]
     auto receive_async(void *data, std::uint32_t size) noexcept -> receive_awaitable {
-        return receive_awaitable(m_socket, data, size);
+        return receive_awaitable(m_socket, data, size, {}, m_receive_limiter);
     }
 
+    /// \brief
+    ///   Receive data from the peer TCP endpoint asynchronously with a timeout. This method will
+    ///   suspend this coroutine until the data is received, any error occurs or the timeout
+    ///   expires. The timer is managed by the worker's IO muxer and no extra thread is involved
+    ///   on Linux.
+    /// \tparam Rep
+    ///   Type of the duration representation.
+    /// \tparam Duration
+    ///   Type of the duration.
+    /// \param[out] data
+    ///   Pointer to start of buffer to receive data.
+    /// \param size
+    ///   Size in byte of buffer to store the received data.
+    /// \param timeout
+    ///   Timeout duration. Use 0 or negative value for never timeout.
+    /// \return
+    ///   Number of bytes received if succeeded. Otherwise, return a system error code that
+    ///   represents the IO error. \c std::errc::timed_out is returned if no data is received
+    ///   before the timeout expires.
+    template <class Rep, class Duration>
+    [[nodiscard]]
+    auto receive_async(void                                *data,
+                       std::uint32_t                        size,
+                       std::chrono::duration<Rep, Duration> timeout) noexcept -> receive_awaitable {
+        return receive_awaitable(m_socket, data, size, detail::make_kernel_timespec(timeout),
+                                 m_receive_limiter);
+    }
+
+    /// \brief
+    ///   Send a range of a file to the peer TCP endpoint asynchronously without copying the data
+    ///   into user space. On Linux, file pages are spliced from the page cache into a pipe and
+    ///   from the pipe into the socket by the worker's IO muxer, so the worker is never blocked
+    ///   by disk IO. On Windows, \c TransmitFile is used.
+    /// \param source
+    ///   The file to send. The file must be open for reading and must be valid until the returned
+    ///   task is completed.
+    /// \param offset
+    ///   Offset in byte in the file to start sending from.
+    /// \param size
+    ///   Maximum number of bytes to send.
+    /// \return
+    ///   Number of bytes sent if succeeded. The result is less than \p size only if end of file is
+    ///   reached. Otherwise, return a system error code that represents the IO error.
+    [[nodiscard]]
+    OSSIA_API auto send_file_async(const file   &source,
+                                   std::uint64_t offset,
+                                   std::uint64_t size) noexcept
+        -> future<std::expected<std::uint64_t, std::error_code>>;
+
     /// \brief
     ///   Enable or disable keep-alive mechanism of this TCP connection.
     /// \param enable
@@ -392,6 +797,43 @@ public:
         return this->set_receive_timeout(static_cast<std::uint32_t>(milliseconds));
     }
 
+    /// \brief
+    ///   Set the rate limiter for asynchronous send operations of this TCP connection. Each send
+    ///   operation is charged its size and 1 operation up front, and is delayed by the worker
+    ///   timer until it conforms to the limiter and all of its parents. Blocking sends and
+    ///   \c send_file_async are not limited.
+    /// \param[in] limiter
+    ///   The rate limiter to use. The limiter must belong to the worker that this connection is
+    ///   used in and must outlive all send operations. Pass \c nullptr to disable rate limiting.
+    auto set_send_limiter(rate_limiter *limiter) noexcept -> void {
+        m_send_limiter = limiter;
+    }
+
+    /// \brief
+    ///   Set the rate limiter for asynchronous receive operations of this TCP connection. Each
+    ///   receive operation is charged 1 operation up front and is delayed until the limiter is
+    ///   out of debt. Received bytes are charged after the operation completes, since they are
+    ///   unknown before. Blocking receives are not limited.
+    /// \param[in] limiter
+    ///   The rate limiter to use. The limiter must belong to the worker that this connection is
+    ///   used in and must outlive all receive operations. Pass \c nullptr to disable rate
+    ///   limiting.
+    auto set_receive_limiter(rate_limiter *limiter) noexcept -> void {
+        m_receive_limiter = limiter;
+    }
+
+    /// \brief
+    ///   Cancel all pending asynchronous operations of this TCP connection, including a connect
+    ///   operation in progress. Cancelled operations complete with
+    ///   \c std::errc::operation_canceled. The connection itself stays open, but its
+    ///   stream position is unknown, so it is usually closed afterwards. This method could only be
+    ///   called in workers, and this connection must not be closed until the cancelled operations
+    ///   complete.
+    /// \return
+    ///   A system error code that indicates the result of the operation. The error code is 0 if
+    ///   the cancellation is requested.
+    OSSIA_API auto cancel() noexcept -> std::error_code;
+
     /// \brief
     ///   Close this TCP connection and release all resources. Closing a \c tcp_stream object will
     ///   cause errors for pending IO operations. This method does nothing if this is an empty
@@ -420,6 +862,498 @@ private:
 private:
     std::uintptr_t m_socket;
     inet_address   m_address;
+    rate_limiter  *m_send_limiter;
+    rate_limiter  *m_receive_limiter;
+
+    /// \brief
+    ///   Socket of the connect operation in progress, so that \c cancel could reach it before the
+    ///   connection is established.
+    std::uintptr_t m_connecting;
+
+    template <class Policy>
+    friend class basic_tcp_stream;
+};
+
+/// \class basic_tcp_stream
+/// \brief
+///   A TCP connection whose options are fixed at compile time by \p Policy. Send and receive
+///   awaitables are specialized for the policy: send flags, the receive timeout and rate limiting
+///   are resolved at compile time, and registered buffers are sent and received with their own
+///   operations on Linux. \c tcp_server::accept_async applies the socket options right after
+///   accepting. A \c basic_tcp_stream does not convert to \c tcp_stream implicitly, so that the
+///   policy is not dropped by accident. Use \c base() to pass it to APIs that take a plain
+///   \c tcp_stream.
+/// \tparam Policy
+///   Options of this TCP connection. See \c default_tcp_policy for details.
+template <class Policy>
+class basic_tcp_stream : private tcp_stream {
+public:
+    /// \class connect_awaitable
+    /// \brief
+    ///   Awaitable object for connecting to a TCP server and applying the options of \p Policy.
+    class connect_awaitable : public tcp_stream::connect_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c connect_awaitable object for asynchronous connect operation.
+        /// \param[in] stream
+        ///   The \c basic_tcp_stream object to establish connection.
+        /// \param address
+        ///   The peer address to connect.
+        /// \param timeout
+        ///   Timeout of this connect operation. Zero timeout means never timeout.
+        connect_awaitable(basic_tcp_stream       &stream,
+                          const inet_address     &address,
+                          detail::kernel_timespec timeout = {}) noexcept
+            : tcp_stream::connect_awaitable(stream, address, timeout),
+              m_stream(&stream) {}
+
+        /// \brief
+        ///   Get the result of the asynchronous connect operation and apply the options.
+        /// \return
+        ///   Error code of the asynchronous connect operation or of applying the options. The
+        ///   error code is 0 if success.
+        auto await_resume() const noexcept -> std::error_code {
+            auto error = tcp_stream::connect_awaitable::await_resume();
+            if (error.value() != 0) [[unlikely]]
+                return error;
+            return m_stream->apply_options();
+        }
+
+    private:
+        basic_tcp_stream *m_stream;
+    };
+
+    /// \class basic_send_awaitable
+    /// \brief
+    ///   Awaitable object for sending data with the options of \p Policy. The send flags and
+    ///   rate limiting are resolved at compile time.
+    /// \tparam Buffer
+    ///   Type of the data to send. \c registered_buffer sends from a registered buffer with
+    ///   zero-copy on Linux.
+    template <class Buffer>
+    class basic_send_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c basic_send_awaitable object for asynchronous send operation.
+        /// \param socket
+        ///   The socket handle to send data.
+        /// \param buffer
+        ///   The data to send.
+        /// \param size
+        ///   Size in byte of data to send.
+        /// \param[in] limiter
+        ///   Rate limiter to charge this send operation to. Ignored unless \p Policy is rate
+        ///   limited.
+        basic_send_awaitable(std::uintptr_t socket,
+                             Buffer         buffer,
+                             std::uint32_t  size,
+                             rate_limiter  *limiter) noexcept
+            : m_ovlp(),
+              m_socket(socket),
+              m_buffer(buffer),
+              m_size(size),
+              m_limiter(limiter),
+              m_throttle() {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async send operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            if constexpr (Policy::rate_limited) {
+                if (m_limiter != nullptr &&
+                    detail::throttle(*m_limiter, m_size, 1, m_throttle, m_ovlp.promise,
+                                     &submit_delayed, this))
+                    return true;
+            }
+
+            return this->submit();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous send operation.
+        /// \return
+        ///   Number of bytes sent if succeeded. Otherwise, return a system error code that
+        ///   represents the IO error.
+        auto await_resume() const noexcept -> std::expected<std::uint32_t, std::error_code> {
+            return detail::tcp_send_result(m_ovlp);
+        }
+
+    private:
+        /// \brief
+        ///   Issue the send operation.
+        /// \retval true
+        ///   The send operation is pending.
+        /// \retval false
+        ///   The send operation is completed or failed immediately.
+        auto submit() noexcept -> bool {
+            return detail::submit_tcp_send(m_ovlp, m_socket, m_buffer, m_size, Policy::send_flags);
+        }
+
+        /// \brief
+        ///   Issue the send operation once the rate limiter timer expires.
+        /// \param[in] timer
+        ///   The rate limiter timer of this awaitable.
+        static auto submit_delayed(detail::timer_entry *timer) noexcept -> void {
+            auto *self = static_cast<basic_send_awaitable *>(timer->context);
+            if (!self->submit())
+                detail::io_context_worker::current()->post(timer->promise);
+        }
+
+    private:
+        using overlapped_type = std::conditional_t<std::is_same_v<Buffer, registered_buffer>,
+                                                   detail::zero_copy_overlapped,
+                                                   detail::overlapped>;
+
+        overlapped_type     m_ovlp;
+        std::uintptr_t      m_socket;
+        Buffer              m_buffer;
+        std::uint32_t       m_size;
+        rate_limiter       *m_limiter;
+        detail::timer_entry m_throttle;
+    };
+
+    /// \class basic_receive_awaitable
+    /// \brief
+    ///   Awaitable object for receiving data with the options of \p Policy. The receive timeout
+    ///   and rate limiting are resolved at compile time.
+    /// \tparam Buffer
+    ///   Type of the buffer to receive data into. \c registered_buffer receives into a
+    ///   registered buffer on Linux.
+    template <class Buffer>
+    class basic_receive_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c basic_receive_awaitable object for asynchronous receive operation.
+        /// \param socket
+        ///   The socket handle to receive data.
+        /// \param buffer
+        ///   The buffer to store the received data.
+        /// \param size
+        ///   Size in byte to receive.
+        /// \param[in] limiter
+        ///   Rate limiter to charge this receive operation to. Ignored unless \p Policy is rate
+        ///   limited.
+        basic_receive_awaitable(std::uintptr_t socket,
+                                Buffer         buffer,
+                                std::uint32_t  size,
+                                rate_limiter  *limiter) noexcept
+            : m_ovlp(),
+              m_socket(socket),
+              m_buffer(buffer),
+              m_size(size),
+              m_limiter(limiter),
+              m_throttle() {
+            m_ovlp.timeout = detail::make_kernel_timespec(Policy::receive_timeout);
+        }
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async receive operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+
+            // Received bytes are unknown yet. They are charged once this operation completes.
+            if constexpr (Policy::rate_limited) {
+                if (m_limiter != nullptr &&
+                    detail::throttle(*m_limiter, 0, 1, m_throttle, m_ovlp.promise,
+                                     &submit_delayed, this))
+                    return true;
+            }
+
+            return this->submit();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous receive operation.
+        /// \return
+        ///   Number of bytes received if succeeded. Otherwise, return a system error code that
+        ///   represents the IO error. \c std::errc::timed_out is returned if the receive
+        ///   operation is timed out.
+        auto await_resume() const noexcept -> std::expected<std::uint32_t, std::error_code> {
+            auto result = detail::tcp_receive_result(m_ovlp);
+            if constexpr (Policy::rate_limited) {
+                if (result.has_value() && m_limiter != nullptr)
+                    m_limiter->reserve(*result, 0, std::chrono::steady_clock::now());
+            }
+            return result;
+        }
+
+    private:
+        /// \brief
+        ///   Issue the receive operation.
+        /// \retval true
+        ///   The receive operation is pending.
+        /// \retval false
+        ///   The receive operation is completed or failed immediately.
+        auto submit() noexcept -> bool {
+            return detail::submit_tcp_receive(m_ovlp, m_socket, m_buffer, m_size);
+        }
+
+        /// \brief
+        ///   Issue the receive operation once the rate limiter timer expires.
+        /// \param[in] timer
+        ///   The rate limiter timer of this awaitable.
+        static auto submit_delayed(detail::timer_entry *timer) noexcept -> void {
+            auto *self = static_cast<basic_receive_awaitable *>(timer->context);
+            if (!self->submit())
+                detail::io_context_worker::current()->post(timer->promise);
+        }
+
+    private:
+        detail::timed_overlapped m_ovlp;
+        std::uintptr_t           m_socket;
+        Buffer                   m_buffer;
+        std::uint32_t            m_size;
+        rate_limiter            *m_limiter;
+        detail::timer_entry      m_throttle;
+    };
+
+    /// \brief
+    ///   Awaitable object for sending data with the options of \p Policy.
+    using send_awaitable = basic_send_awaitable<const void *>;
+
+    /// \brief
+    ///   Awaitable object for receiving data with the options of \p Policy.
+    using receive_awaitable = basic_receive_awaitable<void *>;
+
+public:
+    /// \brief
+    ///   Create an empty \c basic_tcp_stream object.
+    basic_tcp_stream() noexcept = default;
+
+    /// \brief
+    ///   Take over a connected \c tcp_stream object. Options are not applied. Call
+    ///   \c apply_options if the connection is not configured yet.
+    /// \param[in, out] stream
+    ///   The \c tcp_stream object to take over. The moved \c tcp_stream object will be empty.
+    explicit basic_tcp_stream(tcp_stream &&stream) noexcept : tcp_stream(std::move(stream)) {}
+
+    /// \brief
+    ///   Get the plain \c tcp_stream of this connection. Operations issued through it do not use
+    ///   the send flags, receive timeout and rate limiting of \p Policy.
+    /// \return
+    ///   Reference to the plain \c tcp_stream of this connection.
+    [[nodiscard]]
+    auto base() noexcept -> tcp_stream & {
+        return *this;
+    }
+
+    /// \brief
+    ///   Get the plain \c tcp_stream of this connection.
+    /// \return
+    ///   Reference to the plain \c tcp_stream of this connection.
+    [[nodiscard]]
+    auto base() const noexcept -> const tcp_stream & {
+        return *this;
+    }
+
+    using tcp_stream::cancel;
+    using tcp_stream::close;
+    using tcp_stream::peer_address;
+    using tcp_stream::receive;
+    using tcp_stream::send;
+    using tcp_stream::send_file_async;
+    using tcp_stream::set_keep_alive;
+    using tcp_stream::set_no_delay;
+    using tcp_stream::set_receive_timeout;
+    using tcp_stream::set_send_timeout;
+
+    /// \brief
+    ///   Apply the options of \p Policy to this TCP connection. Options that keep their defaults
+    ///   are skipped at compile time.
+    /// \return
+    ///   A system error code that indicates the result of the operation. The error code is 0 if
+    ///   success.
+    auto apply_options() noexcept -> std::error_code {
+        if constexpr (Policy::no_delay) {
+            auto error = this->set_no_delay(true);
+            if (error.value() != 0) [[unlikely]]
+                return error;
+        }
+
+        if constexpr (Policy::keep_alive) {
+            auto error = this->set_keep_alive(true);
+            if (error.value() != 0) [[unlikely]]
+                return error;
+        }
+
+        return std::error_code();
+    }
+
+    /// \brief
+    ///   Connect to the specified peer address and apply the options of \p Policy. This method
+    ///   will block current thread until the connection is established or any error occurs.
+    /// \param address
+    ///   The peer address to connect.
+    /// \return
+    ///   A system error code that indicates the result of the connection operation. The error code
+    ///   is 0 if success.
+    auto connect(const inet_address &address) noexcept -> std::error_code {
+        auto error = tcp_stream::connect(address);
+        if (error.value() != 0) [[unlikely]]
+            return error;
+        return this->apply_options();
+    }
+
+    /// \brief
+    ///   Connect to the specified peer address asynchronously and apply the options of
+    ///   \p Policy. This method will suspend this coroutine until the connection is established
+    ///   or any error occurs.
+    /// \param address
+    ///   The peer address to connect.
+    /// \return
+    ///   A system error code that indicates the result of the connection operation. The error code
+    ///   is 0 if success.
+    [[nodiscard]]
+    auto connect_async(const inet_address &address) noexcept -> connect_awaitable {
+        return connect_awaitable(*this, address);
+    }
+
+    /// \brief
+    ///   Connect to the specified peer address asynchronously with a timeout and apply the
+    ///   options of \p Policy. See \c tcp_stream::connect_async for details.
+    /// \tparam Rep
+    ///   Type of the duration representation.
+    /// \tparam Duration
+    ///   Type of the duration.
+    /// \param address
+    ///   The peer address to connect.
+    /// \param timeout
+    ///   Timeout duration. Use 0 or negative value for never timeout.
+    /// \return
+    ///   A system error code that indicates the result of the connection operation. The error code
+    ///   is 0 if success.
+    template <class Rep, class Duration>
+    [[nodiscard]]
+    auto connect_async(const inet_address                  &address,
+                       std::chrono::duration<Rep, Duration> timeout) noexcept -> connect_awaitable {
+        return connect_awaitable(*this, address, detail::make_kernel_timespec(timeout));
+    }
+
+    /// \brief
+    ///   Send data to the peer TCP endpoint asynchronously with the send flags of \p Policy.
+    /// \param data
+    ///   Pointer to start of data to send.
+    /// \param size
+    ///   Size in byte of data to send.
+    /// \return
+    ///   Number of bytes sent if succeeded. Otherwise, return a system error code that represents
+    ///   the IO error.
+    [[nodiscard]]
+    auto send_async(const void *data, std::uint32_t size) noexcept -> send_awaitable {
+        return send_awaitable(m_socket, data, size, m_send_limiter);
+    }
+
+    /// \brief
+    ///   Send data in a registered buffer to the peer TCP endpoint asynchronously with the send
+    ///   flags of \p Policy. On Linux, the data is sent with zero-copy from the registered pages,
+    ///   and this coroutine is resumed only after the kernel releases the buffer, so the buffer
+    ///   could be reused at once. Zero-copy pays off for large sends. The buffer must be acquired
+    ///   from the current worker.
+    /// \param buffer
+    ///   The registered buffer that contains the data.
+    /// \param size
+    ///   Size in byte of data to send. This value must not be greater than size of \p buffer.
+    /// \return
+    ///   Number of bytes sent if succeeded. Otherwise, return a system error code that represents
+    ///   the IO error.
+    [[nodiscard]]
+    auto send_async(const registered_buffer &buffer, std::uint32_t size) noexcept
+        -> basic_send_awaitable<registered_buffer> {
+        return basic_send_awaitable<registered_buffer>(m_socket, buffer, size, m_send_limiter);
+    }
+
+    /// \brief
+    ///   Receive data from the peer TCP endpoint asynchronously with the receive timeout of
+    ///   \p Policy.
+    /// \param[out] data
+    ///   Pointer to start of buffer to receive data.
+    /// \param size
+    ///   Size in byte of buffer to store the received data.
+    /// \return
+    ///   Number of bytes received if succeeded. Otherwise, return a system error code that
+    ///   represents the IO error. Return \c std::errc::timed_out if the timeout expires.
+    [[nodiscard]]
+    auto receive_async(void *data, std::uint32_t size) noexcept -> receive_awaitable {
+        return receive_awaitable(m_socket, data, size, m_receive_limiter);
+    }
+
+    /// \brief
+    ///   Receive data from the peer TCP endpoint into a registered buffer asynchronously with the
+    ///   receive timeout of \p Policy. The kernel does not pin the buffer pages for this request.
+    ///   The buffer must be acquired from the current worker.
+    /// \param buffer
+    ///   The registered buffer to store the received data.
+    /// \param size
+    ///   Size in byte to receive. This value must not be greater than size of \p buffer.
+    /// \return
+    ///   Number of bytes received if succeeded. Otherwise, return a system error code that
+    ///   represents the IO error. Return \c std::errc::timed_out if the timeout expires.
+    [[nodiscard]]
+    auto receive_async(const registered_buffer &buffer, std::uint32_t size) noexcept
+        -> basic_receive_awaitable<registered_buffer> {
+        return basic_receive_awaitable<registered_buffer>(m_socket, buffer, size,
+                                                          m_receive_limiter);
+    }
+
+    using tcp_stream::receive_async;
+
+    /// \brief
+    ///   Set the rate limiter for asynchronous send operations of this TCP connection. See
+    ///   \c tcp_stream::set_send_limiter for details. Only available if \p Policy is rate
+    ///   limited.
+    /// \param[in] limiter
+    ///   The rate limiter to use. Pass \c nullptr to disable rate limiting.
+    auto set_send_limiter(rate_limiter *limiter) noexcept -> void
+        requires(Policy::rate_limited)
+    {
+        m_send_limiter = limiter;
+    }
+
+    /// \brief
+    ///   Set the rate limiter for asynchronous receive operations of this TCP connection. See
+    ///   \c tcp_stream::set_receive_limiter for details. Only available if \p Policy is rate
+    ///   limited.
+    /// \param[in] limiter
+    ///   The rate limiter to use. Pass \c nullptr to disable rate limiting.
+    auto set_receive_limiter(rate_limiter *limiter) noexcept -> void
+        requires(Policy::rate_limited)
+    {
+        m_receive_limiter = limiter;
+    }
 };
 
 } // namespace ossia
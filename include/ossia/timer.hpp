@@ -0,0 +1,94 @@
+#pragma once
+
+#include "io_context.hpp"
+
+#include <cassert>
+#include <chrono>
+
+namespace ossia {
+
+/// \class sleep_awaitable
+/// \brief
+///   Awaitable object for suspending the current coroutine until a time point. The coroutine is
+///   resumed by the timer queue of the current worker, so no IO request is submitted.
+class sleep_awaitable {
+public:
+    /// \brief
+    ///   Create a new \c sleep_awaitable object.
+    /// \param deadline
+    ///   Time point at which the coroutine should be resumed.
+    explicit sleep_awaitable(std::chrono::steady_clock::time_point deadline) noexcept
+        : m_timer{
+              .deadline = deadline,
+              .promise  = nullptr,
+              .expire   = nullptr,
+              .context  = nullptr,
+          } {}
+
+    /// \brief
+    ///   C++20 coroutine API method. Do not suspend if the deadline has passed.
+    /// \retval true
+    ///   The deadline has passed.
+    /// \retval false
+    ///   This coroutine should be suspended.
+    [[nodiscard]]
+    auto await_ready() const noexcept -> bool {
+        return m_timer.deadline <= std::chrono::steady_clock::now();
+    }
+
+    /// \brief
+    ///   Add a timer to the current worker and suspend the coroutine.
+    /// \tparam T
+    ///   Type of promise of current coroutine.
+    /// \param coroutine
+    ///   Current coroutine handle.
+    template <class T>
+    auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> void {
+        m_timer.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+
+        auto *worker = detail::io_context_worker::current();
+        assert(worker != nullptr);
+        worker->add_timer(&m_timer);
+    }
+
+    /// \brief
+    ///   C++20 coroutine API method. Nothing to do.
+    static constexpr auto await_resume() noexcept -> void {}
+
+private:
+    detail::timer_entry m_timer;
+};
+
+/// \brief
+///   Suspend the current coroutine until the specified time point. This method could only be
+///   called in workers.
+/// \param deadline
+///   Time point at which the coroutine should be resumed.
+/// \return
+///   Awaitable object for the sleep operation.
+[[nodiscard]]
+inline auto sleep_until(std::chrono::steady_clock::time_point deadline) noexcept
+    -> sleep_awaitable {
+    return sleep_awaitable(deadline);
+}
+
+/// \brief
+///   Suspend the current coroutine for the specified duration. This method could only be called
+///   in workers.
+/// \tparam Rep
+///   Type of the duration representation.
+/// \tparam Duration
+///   Type of the duration.
+/// \param duration
+///   Time to sleep. The coroutine is resumed in the first iteration of the worker after this
+///   duration.
+/// \return
+///   Awaitable object for the sleep operation.
+template <class Rep, class Duration>
+[[nodiscard]]
+auto sleep_for(std::chrono::duration<Rep, Duration> duration) noexcept -> sleep_awaitable {
+    auto now = std::chrono::steady_clock::now();
+    return sleep_awaitable(now + std::chrono::ceil<std::chrono::steady_clock::duration>(duration));
+}
+
+} // namespace ossia
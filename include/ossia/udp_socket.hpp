@@ -0,0 +1,339 @@
+#pragma once
+
+#include "inet_address.hpp"
+#include "io_context.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <expected>
+#include <system_error>
+
+namespace ossia {
+
+/// \struct udp_datagram
+/// \brief
+///   Information of a received UDP datagram.
+struct udp_datagram {
+    /// \brief
+    ///   Number of bytes stored in the receive buffer.
+    std::uint32_t size;
+
+    /// \brief
+    ///   Whether the datagram is larger than the receive buffer and the rest is discarded.
+    bool truncated;
+
+    /// \brief
+    ///   Address of the sender.
+    inet_address peer;
+
+    /// \brief
+    ///   Time when the datagram arrived at the kernel. This is a software timestamp taken by the
+    ///   network stack, so the difference to \c std::chrono::system_clock::now() is the queueing
+    ///   delay in the kernel socket buffer and in the worker. The value is the epoch if receive
+    ///   timestamps are not enabled or not supported.
+    std::chrono::system_clock::time_point timestamp;
+};
+
+/// \class udp_socket
+/// \brief
+///   \c udp_socket is a class that represents a UDP socket. Multicast group membership and kernel
+///   receive timestamps are supported. This class could only be used in workers.
+class udp_socket {
+public:
+    /// \class send_to_awaitable
+    /// \brief
+    ///   Awaitable object for sending a datagram.
+    class send_to_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c send_to_awaitable object for asynchronous send operation.
+        /// \param socket
+        ///   The socket to send the datagram.
+        /// \param data
+        ///   Pointer to start of data to send.
+        /// \param size
+        ///   Size in byte of data to send.
+        /// \param address
+        ///   Address of the receiver.
+        send_to_awaitable(std::uintptr_t      socket,
+                          const void         *data,
+                          std::uint32_t       size,
+                          const inet_address &address) noexcept
+            : m_ovlp(),
+              m_socket(socket),
+              m_data(data),
+              m_size(size),
+              m_address(address),
+              m_message() {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async send operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            return this->await_suspend();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous send operation.
+        /// \return
+        ///   Number of bytes sent if succeeded. Otherwise, return a system error code that
+        ///   represents the IO error.
+        OSSIA_API auto await_resume() const noexcept
+            -> std::expected<std::uint32_t, std::error_code>;
+
+    private:
+        /// \brief
+        ///   Prepare for asynchronous send operation and suspend this coroutine.
+        OSSIA_API auto await_suspend() noexcept -> bool;
+
+    private:
+        detail::overlapped m_ovlp;
+        std::uintptr_t     m_socket;
+        const void        *m_data;
+        std::uint32_t      m_size;
+        inet_address       m_address;
+
+        /// \brief
+        ///   Storage of the platform-specific message header.
+        alignas(8) std::byte m_message[80];
+    };
+
+    /// \class receive_from_awaitable
+    /// \brief
+    ///   Awaitable object for receiving a datagram.
+    class receive_from_awaitable {
+    public:
+        /// \brief
+        ///   Create a new \c receive_from_awaitable object for asynchronous receive operation.
+        /// \param socket
+        ///   The socket to receive the datagram.
+        /// \param[out] data
+        ///   Pointer to start of buffer to store the datagram.
+        /// \param size
+        ///   Size in byte of the buffer.
+        receive_from_awaitable(std::uintptr_t socket, void *data, std::uint32_t size) noexcept
+            : m_ovlp(),
+              m_socket(socket),
+              m_data(data),
+              m_size(size),
+              m_address(),
+              m_message(),
+              m_control() {}
+
+        /// \brief
+        ///   C++20 coroutine API method. Always execute \c await_suspend().
+        /// \return
+        ///   This function always returns \c false.
+        static constexpr auto await_ready() noexcept -> bool {
+            return false;
+        }
+
+        /// \brief
+        ///   Prepare for async receive operation and suspend the coroutine.
+        /// \tparam T
+        ///   Type of promise of current coroutine.
+        /// \param coroutine
+        ///   Current coroutine handle.
+        /// \retval true
+        ///   This coroutine should be suspended and resumed later.
+        /// \retval false
+        ///   This coroutine should not be suspended and should be resumed immediately.
+        template <class T>
+        auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+            m_ovlp.promise = &static_cast<detail::promise_base &>(coroutine.promise());
+            return this->await_suspend();
+        }
+
+        /// \brief
+        ///   Get the result of the asynchronous receive operation.
+        /// \return
+        ///   Information of the received datagram if succeeded. Otherwise, return a system error
+        ///   code that represents the IO error.
+        OSSIA_API auto await_resume() const noexcept
+            -> std::expected<udp_datagram, std::error_code>;
+
+    private:
+        /// \brief
+        ///   Prepare for asynchronous receive operation and suspend this coroutine.
+        OSSIA_API auto await_suspend() noexcept -> bool;
+
+    private:
+        detail::overlapped m_ovlp;
+        std::uintptr_t     m_socket;
+        void              *m_data;
+        std::uint32_t      m_size;
+        inet_address       m_address;
+
+        /// \brief
+        ///   Storage of the platform-specific message header.
+        alignas(8) std::byte m_message[80];
+
+        /// \brief
+        ///   Storage of ancillary data such as receive timestamps.
+        alignas(8) std::byte m_control[128];
+    };
+
+public:
+    /// \brief
+    ///   Create an empty \c udp_socket object. Empty socket object is not valid for use before
+    ///   binding.
+    OSSIA_API udp_socket() noexcept;
+
+    /// \brief
+    ///   \c udp_socket is not copyable.
+    udp_socket(const udp_socket &other) = delete;
+
+    /// \brief
+    ///   Move constructor of \c udp_socket.
+    /// \param[in, out] other
+    ///   The \c udp_socket object to move. The moved \c udp_socket object will be empty.
+    OSSIA_API udp_socket(udp_socket &&other) noexcept;
+
+    /// \brief
+    ///   Close the socket and destroy this object.
+    OSSIA_API ~udp_socket();
+
+    /// \brief
+    ///   \c udp_socket is not copyable.
+    auto operator=(const udp_socket &other) = delete;
+
+    /// \brief
+    ///   Move assignment operator of \c udp_socket.
+    /// \param[in, out] other
+    ///   The \c udp_socket object to move. The moved \c udp_socket object will be empty.
+    /// \return
+    ///   Reference to this \c udp_socket object.
+    OSSIA_API auto operator=(udp_socket &&other) noexcept -> udp_socket &;
+
+    /// \brief
+    ///   Get local address of this socket. It is undefined behavior to get local address of an
+    ///   empty socket.
+    /// \return
+    ///   Local address of this socket.
+    [[nodiscard]]
+    auto local_address() const noexcept -> const inet_address & {
+        return m_address;
+    }
+
+    /// \brief
+    ///   Create a socket and bind it to the specified address. \c SO_REUSEADDR is enabled so that
+    ///   multiple receivers could share the same multicast port. Use port 0 for a socket that is
+    ///   only used for sending.
+    /// \param[in] address
+    ///   The address to bind. The address could be either an IPv4 or IPv6 address.
+    /// \return
+    ///   An \c std::error_code object that represents system error. The error code is 0 if this
+    ///   operation is succeeded.
+    OSSIA_API auto bind(const inet_address &address) noexcept -> std::error_code;
+
+    /// \brief
+    ///   Send a datagram asynchronously. This method will suspend this coroutine until the
+    ///   datagram is sent or any error occurs.
+    /// \param data
+    ///   Pointer to start of data to send.
+    /// \param size
+    ///   Size in byte of data to send.
+    /// \param address
+    ///   Address of the receiver.
+    /// \return
+    ///   Number of bytes sent if succeeded. Otherwise, return a system error code that represents
+    ///   the IO error.
+    [[nodiscard]]
+    auto send_to_async(const void *data, std::uint32_t size, const inet_address &address) noexcept
+        -> send_to_awaitable {
+        return send_to_awaitable(m_socket, data, size, address);
+    }
+
+    /// \brief
+    ///   Receive a datagram asynchronously. This method will suspend this coroutine until a
+    ///   datagram is received or any error occurs.
+    /// \param[out] data
+    ///   Pointer to start of buffer to store the datagram.
+    /// \param size
+    ///   Size in byte of the buffer.
+    /// \return
+    ///   Information of the received datagram if succeeded. Otherwise, return a system error code
+    ///   that represents the IO error.
+    [[nodiscard]]
+    auto receive_from_async(void *data, std::uint32_t size) noexcept -> receive_from_awaitable {
+        return receive_from_awaitable(m_socket, data, size);
+    }
+
+    /// \brief
+    ///   Join a multicast group. The group address must have the same family as this socket.
+    /// \param group
+    ///   Address of the multicast group.
+    /// \param interface_index
+    ///   Index of the network interface to join the group on. Use 0 to let the system choose the
+    ///   interface by routing table.
+    /// \return
+    ///   A system error code that indicates the result of the operation. The error code is 0 if
+    ///   success. \c std::errc::invalid_argument is returned if \p group is not a multicast
+    ///   address.
+    OSSIA_API auto join_group(const ip_address &group, std::uint32_t interface_index = 0) noexcept
+        -> std::error_code;
+
+    /// \brief
+    ///   Leave a multicast group that is joined by \c join_group.
+    /// \param group
+    ///   Address of the multicast group.
+    /// \param interface_index
+    ///   Index of the network interface that the group is joined on.
+    /// \return
+    ///   A system error code that indicates the result of the operation. The error code is 0 if
+    ///   success.
+    OSSIA_API auto leave_group(const ip_address &group, std::uint32_t interface_index = 0) noexcept
+        -> std::error_code;
+
+    /// \brief
+    ///   Set the network interface to send multicast datagrams from.
+    /// \param interface_index
+    ///   Index of the network interface. Use 0 to let the system choose the interface by routing
+    ///   table.
+    /// \return
+    ///   A system error code that indicates the result of the operation. The error code is 0 if
+    ///   success.
+    OSSIA_API auto set_multicast_interface(std::uint32_t interface_index) noexcept
+        -> std::error_code;
+
+    /// \brief
+    ///   Enable or disable kernel software receive timestamps with \c SO_TIMESTAMPING. Once
+    ///   enabled, \c udp_datagram::timestamp of received datagrams is set to the time when the
+    ///   datagram arrived at the network stack.
+    /// \param enable
+    ///   \c true to enable receive timestamps. \c false to disable receive timestamps.
+    /// \return
+    ///   A system error code that indicates the result of the operation. The error code is 0 if
+    ///   success. \c std::errc::operation_not_supported is returned on platforms without kernel
+    ///   receive timestamps.
+    OSSIA_API auto set_receive_timestamps(bool enable) noexcept -> std::error_code;
+
+    /// \brief
+    ///   Close this socket and release all resources. Closing a \c udp_socket object will cause
+    ///   errors for pending IO operations. This method does nothing if this is an empty
+    ///   \c udp_socket object.
+    OSSIA_API auto close() noexcept -> void;
+
+private:
+    std::uintptr_t m_socket;
+    inet_address   m_address;
+};
+
+} // namespace ossia
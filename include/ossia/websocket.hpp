@@ -0,0 +1,527 @@
+#pragma once
+
+#include "connection_pool.hpp"
+#include "tcp_server.hpp"
+
+#include <expected>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace ossia {
+
+/// \enum websocket_opcode
+/// \brief
+///   Opcodes of WebSocket frames. See RFC 6455 section 5.2.
+enum class websocket_opcode : std::uint8_t {
+    continuation = 0x0,
+    text         = 0x1,
+    binary       = 0x2,
+    close        = 0x8,
+    ping         = 0x9,
+    pong         = 0xA,
+};
+
+/// \enum websocket_parse_error
+/// \brief
+///   Errors that could occur when parsing WebSocket frame headers.
+enum class websocket_parse_error {
+    /// \brief
+    ///   More data is required to parse the frame header.
+    incomplete,
+
+    /// \brief
+    ///   The frame header is malformed.
+    invalid,
+};
+
+/// \struct websocket_frame
+/// \brief
+///   Parsed WebSocket frame header.
+struct websocket_frame {
+    /// \brief
+    ///   Whether this is the final fragment of a message.
+    bool fin;
+
+    /// \brief
+    ///   Whether the payload of this frame is masked.
+    bool masked;
+
+    /// \brief
+    ///   Opcode of this frame.
+    websocket_opcode opcode;
+
+    /// \brief
+    ///   Masking key of this frame. The key is stored in the same byte order as on the wire so
+    ///   that it could be passed to \c websocket_mask directly.
+    std::uint32_t mask;
+
+    /// \brief
+    ///   Size in byte of the frame header.
+    std::uint32_t header_size;
+
+    /// \brief
+    ///   Size in byte of the frame payload.
+    std::uint64_t payload_size;
+};
+
+/// \brief
+///   Parse a WebSocket frame header. Only the header is parsed and the payload may be incomplete.
+///   Extensions are not supported and frames with any RSV bit set are rejected.
+/// \param data
+///   Received data that starts with a frame header.
+/// \return
+///   The parsed frame header if succeeded. Otherwise, return a \c websocket_parse_error that
+///   indicates the parse error.
+[[nodiscard]]
+OSSIA_API auto parse_websocket_frame(std::span<const char> data) noexcept
+    -> std::expected<websocket_frame, websocket_parse_error>;
+
+/// \brief
+///   Mask or unmask WebSocket payload in place. Payload is processed 32 bytes at a time with AVX2
+///   or 16 bytes at a time with SSE2 when available.
+/// \param[in, out] data
+///   The payload to be masked or unmasked.
+/// \param mask
+///   Masking key in the same byte order as on the wire.
+OSSIA_API auto websocket_mask(std::span<char> data, std::uint32_t mask) noexcept -> void;
+
+/// \brief
+///   Serialize an unmasked WebSocket frame and append it to the output buffer. Frames sent by
+///   servers must not be masked.
+/// \param opcode
+///   Opcode of the frame.
+/// \param fin
+///   Whether this is the final fragment of a message.
+/// \param payload
+///   Payload of the frame.
+/// \param[out] output
+///   The output buffer to append the serialized frame.
+OSSIA_API auto write_websocket_frame(websocket_opcode opcode,
+                                     bool             fin,
+                                     std::string_view payload,
+                                     std::string     &output) -> void;
+
+/// \brief
+///   Serialize a masked WebSocket frame and append it to the output buffer. Frames sent by
+///   clients must be masked.
+/// \param opcode
+///   Opcode of the frame.
+/// \param fin
+///   Whether this is the final fragment of a message.
+/// \param payload
+///   Payload of the frame.
+/// \param mask
+///   Masking key in the same byte order as on the wire.
+/// \param[out] output
+///   The output buffer to append the serialized frame.
+OSSIA_API auto write_websocket_frame(websocket_opcode opcode,
+                                     bool             fin,
+                                     std::string_view payload,
+                                     std::uint32_t    mask,
+                                     std::string     &output) -> void;
+
+/// \brief
+///   Calculate \c Sec-WebSocket-Accept header value for the specified \c Sec-WebSocket-Key.
+/// \param key
+///   Value of the \c Sec-WebSocket-Key header field.
+/// \return
+///   Value of the \c Sec-WebSocket-Accept header field.
+[[nodiscard]]
+OSSIA_API auto websocket_accept_key(std::string_view key) -> std::string;
+
+/// \struct websocket_message
+/// \brief
+///   A complete WebSocket message. Fragmented messages are reassembled.
+struct websocket_message {
+    /// \brief
+    ///   Opcode of this message. This could be \c text, \c binary or \c close.
+    websocket_opcode opcode;
+
+    /// \brief
+    ///   Payload of this message. Payload refers to the receive buffer of the stream and is only
+    ///   valid until the next receive operation. Text payload is not validated as UTF-8.
+    std::string_view payload;
+};
+
+/// \class websocket_stream
+/// \brief
+///   WebSocket connection over \c tcp_stream. Frames are parsed and unmasked in place, and
+///   unfragmented messages are never copied. Ping, pong and close frames are handled
+///   automatically when receiving messages. This class could only be used in workers.
+class websocket_stream {
+public:
+    /// \brief
+    ///   Default initial capacity in byte of the receive buffer.
+    static constexpr std::size_t default_buffer_size = 16384;
+
+    /// \brief
+    ///   Default maximum size in byte of a single message.
+    static constexpr std::size_t default_message_limit = 1048576;
+
+    /// \brief
+    ///   Default interval to send ping frames to idle peers.
+    static constexpr std::chrono::seconds default_ping_interval{30};
+
+    /// \brief
+    ///   Create an empty \c websocket_stream object. Empty \c websocket_stream object is not
+    ///   connected to any peer.
+    OSSIA_API websocket_stream() noexcept;
+
+    /// \brief
+    ///   \c websocket_stream is not copyable.
+    websocket_stream(const websocket_stream &other) = delete;
+
+    /// \brief
+    ///   Move constructor of \c websocket_stream. It is undefined behavior to move a stream with
+    ///   pending operations.
+    /// \param[in, out] other
+    ///   The \c websocket_stream object to move. The moved object will be empty.
+    websocket_stream(websocket_stream &&other) noexcept = default;
+
+    /// \brief
+    ///   Destroy this WebSocket connection and close the underlying TCP connection.
+    ~websocket_stream() = default;
+
+    /// \brief
+    ///   \c websocket_stream is not copyable.
+    auto operator=(const websocket_stream &other) = delete;
+
+    /// \brief
+    ///   Move assignment of \c websocket_stream. It is undefined behavior to move a stream with
+    ///   pending operations.
+    /// \param[in, out] other
+    ///   The \c websocket_stream object to move. The moved object will be empty.
+    /// \return
+    ///   Reference to this \c websocket_stream object.
+    auto operator=(websocket_stream &&other) noexcept -> websocket_stream & = default;
+
+    /// \brief
+    ///   Accept the WebSocket opening handshake from a client. A \c 101 response is sent if the
+    ///   handshake request is valid. Otherwise, an error response is sent.
+    /// \param stream
+    ///   The TCP connection to perform the handshake on.
+    /// \param limit
+    ///   Maximum size in byte of a single message.
+    /// \return
+    ///   The WebSocket connection if succeeded. Otherwise, return a system error code.
+    ///   \c std::errc::protocol_error is returned if the handshake request is invalid.
+    [[nodiscard]]
+    OSSIA_API static auto accept_async(tcp_stream  stream,
+                                       std::size_t limit = default_message_limit) noexcept
+        -> future<std::expected<websocket_stream, std::error_code>>;
+
+    /// \brief
+    ///   Connect to a WebSocket server and perform the opening handshake.
+    /// \param address
+    ///   Address of the WebSocket server.
+    /// \param host
+    ///   Value of the \c Host header field.
+    /// \param target
+    ///   Request target of the handshake request, such as \c /chat.
+    /// \param limit
+    ///   Maximum size in byte of a single message.
+    /// \return
+    ///   The WebSocket connection if succeeded. Otherwise, return a system error code.
+    ///   \c std::errc::protocol_error is returned if the server rejects the handshake.
+    [[nodiscard]]
+    OSSIA_API static auto connect_async(const inet_address &address,
+                                        std::string_view    host,
+                                        std::string_view    target,
+                                        std::size_t         limit = default_message_limit) noexcept
+        -> future<std::expected<websocket_stream, std::error_code>>;
+
+    /// \brief
+    ///   Get the underlying TCP connection.
+    /// \return
+    ///   Reference to the underlying TCP connection.
+    [[nodiscard]]
+    auto tcp() noexcept -> tcp_stream & {
+        return m_stream;
+    }
+
+    /// \brief
+    ///   Set interval to send ping frames. A ping frame is sent if nothing is received from the
+    ///   peer within the interval, and the connection is considered dead if still nothing is
+    ///   received within another interval. The timer is driven by the worker's IO muxer.
+    /// \tparam Rep
+    ///   Type of the duration representation.
+    /// \tparam Duration
+    ///   Type of the duration.
+    /// \param interval
+    ///   The ping interval. Use 0 or negative value to disable ping.
+    template <class Rep, class Duration>
+    auto set_ping_interval(std::chrono::duration<Rep, Duration> interval) noexcept -> void {
+        auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(interval);
+        m_ping_interval   = milliseconds.count() < 0 ? std::chrono::milliseconds() : milliseconds;
+    }
+
+    /// \brief
+    ///   Receive the next message. Control frames are handled internally: ping frames are replied
+    ///   with pong frames, and close frames are echoed and returned as a \c close message. Queued
+    ///   frames are sent before waiting for more data.
+    /// \return
+    ///   The received message if succeeded. Otherwise, return a system error code.
+    ///   \c std::errc::protocol_error is returned if the peer violates the protocol,
+    ///   \c std::errc::message_size is returned if the message exceeds the size limit,
+    ///   \c std::errc::timed_out is returned if the peer does not respond to ping, and
+    ///   \c std::errc::connection_reset is returned if the connection is closed without a close
+    ///   frame.
+    [[nodiscard]]
+    OSSIA_API auto receive_async() noexcept
+        -> future<std::expected<websocket_message, std::error_code>>;
+
+    /// \brief
+    ///   Send a frame to the peer. Frames are masked automatically for client connections. If
+    ///   another send operation is in progress, the frame is queued and sent by that operation
+    ///   together with other queued frames.
+    /// \param opcode
+    ///   Opcode of the frame.
+    /// \param payload
+    ///   Payload of the frame.
+    /// \param fin
+    ///   Whether this is the final fragment of a message. Use \c false and \c continuation frames
+    ///   to send fragmented messages.
+    /// \return
+    ///   A system error code that indicates the result of the send operation. The error code is 0
+    ///   if succeeded.
+    [[nodiscard]]
+    OSSIA_API auto send_async(websocket_opcode opcode,
+                              std::string_view payload,
+                              bool             fin = true) noexcept -> future<std::error_code>;
+
+    /// \brief
+    ///   Queue a frame without sending it. Queued frames are sent together by the next
+    ///   \c send_async or \c flush_async, or before \c receive_async waits for more data. This
+    ///   could be used to batch replies to pipelined messages into a single send operation.
+    /// \param opcode
+    ///   Opcode of the frame.
+    /// \param payload
+    ///   Payload of the frame. The payload is copied into the output buffer.
+    /// \param fin
+    ///   Whether this is the final fragment of a message.
+    OSSIA_API auto queue(websocket_opcode opcode, std::string_view payload, bool fin = true)
+        -> void;
+
+    /// \brief
+    ///   Send all queued frames. If another send operation is in progress, this method returns
+    ///   immediately and the queued frames are sent by that operation.
+    /// \return
+    ///   A system error code that indicates the result of the send operation. The error code is 0
+    ///   if succeeded.
+    [[nodiscard]]
+    OSSIA_API auto flush_async() noexcept -> future<std::error_code>;
+
+    /// \brief
+    ///   Send a close frame to the peer. The peer's close frame will be returned by
+    ///   \c receive_async.
+    /// \param code
+    ///   Status code of the close frame.
+    /// \return
+    ///   A system error code that indicates the result of the send operation. The error code is 0
+    ///   if succeeded.
+    [[nodiscard]]
+    OSSIA_API auto close_async(std::uint16_t code = 1000) noexcept -> future<std::error_code>;
+
+    /// \brief
+    ///   Get size in byte of frames that are queued but not sent yet. This could be used to apply
+    ///   backpressure to slow peers.
+    /// \return
+    ///   Size in byte of queued frames.
+    [[nodiscard]]
+    auto pending_size() const noexcept -> std::size_t {
+        return m_pending.size() + m_sending.size();
+    }
+
+private:
+    /// \brief
+    ///   Create a new WebSocket stream over a TCP connection.
+    /// \param stream
+    ///   The underlying TCP connection.
+    /// \param client
+    ///   Whether this is a client connection.
+    /// \param limit
+    ///   Maximum size in byte of a single message.
+    websocket_stream(tcp_stream stream, bool client, std::size_t limit);
+
+    /// \brief
+    ///   Take over an accepted TCP connection with a pooled server stream. The receive buffer is
+    ///   allocated if this stream has none.
+    /// \param stream
+    ///   The underlying TCP connection.
+    /// \param limit
+    ///   Maximum size in byte of a single message.
+    /// \throws std::bad_alloc
+    ///   Thrown if failed to allocate the receive buffer.
+    OSSIA_API auto open(tcp_stream stream, std::size_t limit) -> void;
+
+    /// \brief
+    ///   Close the TCP connection and reset this stream in place so that it could be pooled for
+    ///   a new server connection. Buffers that have grown larger than
+    ///   \c detail::max_retained_buffer for large messages are released.
+    /// \retval true
+    ///   This stream is ready for a new connection.
+    /// \retval false
+    ///   Failed to allocate a new receive buffer. This stream should be released.
+    OSSIA_API auto recycle() noexcept -> bool;
+
+    /// \brief
+    ///   Perform the server side of the opening handshake on the TCP connection of this stream.
+    /// \return
+    ///   A system error code that indicates the result of the handshake.
+    ///   \c std::errc::protocol_error is returned if the handshake request is invalid.
+    OSSIA_API auto accept_handshake_async() noexcept -> future<std::error_code>;
+
+    /// \brief
+    ///   Make room for receiving more data. Handled data is discarded and the buffer may grow up
+    ///   to the message size limit.
+    /// \retval true
+    ///   There is free space in the receive buffer.
+    /// \retval false
+    ///   The receive buffer is full and could not grow anymore.
+    auto prepare() -> bool;
+
+private:
+    tcp_stream                m_stream;
+    std::unique_ptr<char[]>   m_data;
+    std::size_t               m_begin;
+    std::size_t               m_cursor;
+    std::size_t               m_end;
+    std::size_t               m_capacity;
+    std::size_t               m_limit;
+    std::size_t               m_message_size;
+    websocket_opcode          m_message_opcode;
+    bool                      m_client;
+    bool                      m_flushing;
+    bool                      m_close_sent;
+    bool                      m_ping_sent;
+    std::uint64_t             m_random;
+    std::chrono::milliseconds m_ping_interval;
+    std::string               m_pending;
+    std::string               m_sending;
+
+    friend class websocket_server;
+    friend class detail::connection_pool<websocket_stream>;
+};
+
+/// \class websocket_server
+/// \brief
+///   WebSocket server based on \c tcp_server. Each accepted connection performs the opening
+///   handshake and is then served by a user-defined handler. This class could only be used in
+///   workers.
+class websocket_server {
+public:
+    /// \brief
+    ///   Create a new \c websocket_server object. Empty server object is not valid for use before
+    ///   binding.
+    websocket_server() noexcept = default;
+
+    /// \brief
+    ///   Get local address of this server. It is undefined behavior to get local address of an
+    ///   empty server.
+    /// \return
+    ///   Local address of this server.
+    [[nodiscard]]
+    auto local_address() const noexcept -> const inet_address & {
+        return m_server.local_address();
+    }
+
+    /// \brief
+    ///   Start listening on the specified address. \c SO_REUSEPORT is enabled so that each worker
+    ///   could bind its own server to the same address.
+    /// \param[in] address
+    ///   The address to bind. The address could be either an IPv4 or IPv6 address.
+    /// \return
+    ///   An \c std::error_code object that represents system error. The error code is 0 if this
+    ///   operation is succeeded.
+    auto bind(const inet_address &address) noexcept -> std::error_code {
+        return m_server.bind(address);
+    }
+
+    /// \brief
+    ///   Stop listening. Pending accept operation will fail and \c run will return.
+    auto close() noexcept -> void {
+        m_server.close();
+    }
+
+    /// \brief
+    ///   Accept incoming connections and serve them in current worker until this server is closed.
+    ///   WebSocket streams are pooled per worker, so that their buffers are reused across
+    ///   connections.
+    /// \tparam Handler
+    ///   Type of the connection handler. The handler is invoked as
+    ///   <tt>handler(websocket_stream &)</tt> and should return \c future<>. Each connection holds
+    ///   its own copy of the handler.
+    /// \param handler
+    ///   The connection handler.
+    /// \param limit
+    ///   Maximum size in byte of a single message.
+    template <class Handler>
+    auto run(Handler     handler,
+             std::size_t limit = websocket_stream::default_message_limit) noexcept -> future<> {
+        while (true) {
+            auto stream = co_await m_server.accept_async<no_delay_tcp_policy>();
+            if (!stream.has_value()) [[unlikely]] {
+                if (stream.error() == std::errc::connection_aborted)
+                    continue;
+                co_return;
+            }
+
+            schedule(serve_pooled(std::move(stream->base()), handler, limit));
+        }
+    }
+
+    /// \brief
+    ///   Perform the opening handshake on a single connection and serve it with the handler.
+    /// \tparam Handler
+    ///   Type of the connection handler. See \c run for details.
+    /// \param stream
+    ///   The connection to be served.
+    /// \param handler
+    ///   The connection handler.
+    /// \param limit
+    ///   Maximum size in byte of a single message.
+    template <class Handler>
+    static auto serve(tcp_stream  stream,
+                      Handler     handler,
+                      std::size_t limit = websocket_stream::default_message_limit) noexcept
+        -> future<> {
+        auto websocket = co_await websocket_stream::accept_async(std::move(stream), limit);
+        if (!websocket.has_value()) [[unlikely]]
+            co_return;
+
+        co_await handler(*websocket);
+    }
+
+private:
+    /// \brief
+    ///   Serve a single connection with a WebSocket stream taken from the connection pool of the
+    ///   current worker.
+    /// \tparam Handler
+    ///   Type of the connection handler. See \c run for details.
+    /// \param stream
+    ///   The connection to be served.
+    /// \param handler
+    ///   The connection handler.
+    /// \param limit
+    ///   Maximum size in byte of a single message.
+    template <class Handler>
+    static auto serve_pooled(tcp_stream stream, Handler handler, std::size_t limit) noexcept
+        -> future<> {
+        auto &pool      = detail::connection_pool<websocket_stream>::local();
+        auto  websocket = pool.acquire();
+        websocket->open(std::move(stream), limit);
+
+        auto error = co_await websocket->accept_handshake_async();
+        if (!error) [[likely]]
+            co_await handler(*websocket);
+
+        pool.release(std::move(websocket));
+    }
+
+private:
+    tcp_server m_server;
+};
+
+} // namespace ossia
@@ -0,0 +1,409 @@
+#include "ossia/file.hpp"
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+#    include <Windows.h>
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <fcntl.h>
+#    include <liburing.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include <cassert>
+#include <string>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+/// \brief
+///   Difference in 100 nanoseconds between 1601-01-01 and the UNIX epoch.
+static constexpr std::int64_t filetime_epoch = 116444736000000000LL;
+
+/// \brief
+///   Convert a null-terminated UTF-8 path into a wide string.
+/// \param[in] path
+///   The UTF-8 path to be converted.
+/// \param[out] error
+///   Error code if failed to convert the path.
+/// \return
+///   The converted wide string. The string is empty if failed.
+static auto to_wide_path(const char *path, DWORD &error) noexcept -> std::wstring {
+    int length = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, path, -1, nullptr, 0);
+    if (length <= 0) [[unlikely]] {
+        error = GetLastError();
+        return std::wstring();
+    }
+
+    std::wstring result(static_cast<std::size_t>(length), L'\0');
+    MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, path, -1, result.data(), length);
+    result.pop_back();
+
+    error = 0;
+    return result;
+}
+
+/// \brief
+///   Convert \c BY_HANDLE_FILE_INFORMATION into \c file_status.
+static auto to_file_status(const BY_HANDLE_FILE_INFORMATION &info) noexcept -> file_status {
+    auto time = (static_cast<std::int64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) |
+                static_cast<std::int64_t>(info.ftLastWriteTime.dwLowDateTime);
+
+    auto since_epoch = std::chrono::duration<std::int64_t, std::ratio<1, 10000000>>(
+        time - filetime_epoch);
+
+    return file_status{
+        .size            = (static_cast<std::uint64_t>(info.nFileSizeHigh) << 32) |
+                           info.nFileSizeLow,
+        .id              = (static_cast<std::uint64_t>(info.nFileIndexHigh) << 32) |
+                           info.nFileIndexLow,
+        .last_write_time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch)),
+        .is_regular      = (info.dwFileAttributes &
+                            (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_DEVICE)) == 0,
+        .is_directory    = (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0,
+    };
+}
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+static_assert(sizeof(struct statx) <= 256);
+static_assert(alignof(struct statx) <= 8);
+
+/// \brief
+///   Acquire a submission queue entry from current worker.
+/// \param[out] ovlp
+///   Overlapped structure to store error code if failed to acquire a submission queue entry.
+/// \return
+///   The submission queue entry. Return \c nullptr if failed.
+static auto acquire_sqe(overlapped &ovlp) noexcept -> io_uring_sqe * {
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    return static_cast<io_uring_sqe *>(worker->acquire_sqe(ovlp.result));
+}
+#endif
+
+auto file::open_awaitable::await_resume() const noexcept -> std::expected<file, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (m_ovlp.error == 0) [[likely]]
+        return file(m_handle);
+
+    return std::unexpected(std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_ovlp.result >= 0) [[likely]]
+        return file(static_cast<std::uintptr_t>(m_ovlp.result));
+
+    return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+#endif
+}
+
+auto file::open_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    // There is no asynchronous open on Windows. Open the file synchronously and resume
+    // immediately.
+    DWORD error = 0;
+    auto  path  = to_wide_path(m_path, error);
+    if (error != 0) [[unlikely]] {
+        m_ovlp.error = error;
+        return false;
+    }
+
+    DWORD access = 0;
+    if ((m_mode & file_mode::read) == file_mode::read)
+        access |= GENERIC_READ;
+    if ((m_mode & file_mode::write) == file_mode::write)
+        access |= GENERIC_WRITE;
+
+    DWORD disposition = OPEN_EXISTING;
+    if ((m_mode & file_mode::exclusive) == file_mode::exclusive)
+        disposition = CREATE_NEW;
+    else if ((m_mode & (file_mode::create | file_mode::truncate)) ==
+             (file_mode::create | file_mode::truncate))
+        disposition = CREATE_ALWAYS;
+    else if ((m_mode & file_mode::create) == file_mode::create)
+        disposition = OPEN_ALWAYS;
+    else if ((m_mode & file_mode::truncate) == file_mode::truncate)
+        disposition = TRUNCATE_EXISTING;
+
+    HANDLE handle = CreateFileW(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                disposition, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+                                nullptr);
+    if (handle == INVALID_HANDLE_VALUE) [[unlikely]] {
+        m_ovlp.error = GetLastError();
+        return false;
+    }
+
+    { // Register to IOCP.
+        auto *worker = io_context_worker::current();
+        assert(worker != nullptr);
+        if (CreateIoCompletionPort(handle, worker->muxer(), 0, 0) == nullptr) [[unlikely]] {
+            m_ovlp.error = GetLastError();
+            CloseHandle(handle);
+            return false;
+        }
+    }
+
+    // Disable IOCP notification once IO is handled immediately.
+    if (SetFileCompletionNotificationModes(handle, FILE_SKIP_SET_EVENT_ON_HANDLE |
+                                                       FILE_SKIP_COMPLETION_PORT_ON_SUCCESS) ==
+        FALSE) [[unlikely]] {
+        m_ovlp.error = GetLastError();
+        CloseHandle(handle);
+        return false;
+    }
+
+    m_handle     = reinterpret_cast<std::uintptr_t>(handle);
+    m_ovlp.error = 0;
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    int flags = O_CLOEXEC;
+    if ((m_mode & file_mode::read_write) == file_mode::read_write)
+        flags |= O_RDWR;
+    else if ((m_mode & file_mode::write) == file_mode::write)
+        flags |= O_WRONLY;
+    else
+        flags |= O_RDONLY;
+
+    if ((m_mode & file_mode::create) == file_mode::create)
+        flags |= O_CREAT;
+    if ((m_mode & file_mode::truncate) == file_mode::truncate)
+        flags |= O_TRUNC;
+    if ((m_mode & file_mode::exclusive) == file_mode::exclusive)
+        flags |= O_EXCL;
+
+    io_uring_sqe *sqe = acquire_sqe(m_ovlp);
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+    io_uring_prep_openat(sqe, AT_FDCWD, m_path, flags, 0644);
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+auto file::status_awaitable::await_resume() const noexcept
+    -> std::expected<file_status, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (m_ovlp.error != 0) [[unlikely]]
+        return std::unexpected(
+            std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
+
+    return to_file_status(*reinterpret_cast<const BY_HANDLE_FILE_INFORMATION *>(m_buffer));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_ovlp.result < 0) [[unlikely]]
+        return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+
+    const auto *info = reinterpret_cast<const struct statx *>(m_buffer);
+    auto        time = std::chrono::seconds(info->stx_mtime.tv_sec) +
+                std::chrono::nanoseconds(info->stx_mtime.tv_nsec);
+
+    return file_status{
+        .size            = info->stx_size,
+        .id              = info->stx_ino,
+        .last_write_time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(time)),
+        .is_regular      = S_ISREG(info->stx_mode),
+        .is_directory    = S_ISDIR(info->stx_mode),
+    };
+#endif
+}
+
+auto file::status_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    static_assert(sizeof(BY_HANDLE_FILE_INFORMATION) <= sizeof(m_buffer));
+
+    // There is no asynchronous status query on Windows. Query synchronously and resume
+    // immediately.
+    auto  *info   = reinterpret_cast<BY_HANDLE_FILE_INFORMATION *>(m_buffer);
+    HANDLE handle = reinterpret_cast<HANDLE>(m_handle);
+
+    if (m_path != nullptr) {
+        DWORD error = 0;
+        auto  path  = to_wide_path(m_path, error);
+        if (error != 0) [[unlikely]] {
+            m_ovlp.error = error;
+            return false;
+        }
+
+        // Directories could only be opened with backup semantics.
+        handle = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) [[unlikely]] {
+            m_ovlp.error = GetLastError();
+            return false;
+        }
+    }
+
+    m_ovlp.error = GetFileInformationByHandle(handle, info) == FALSE ? GetLastError() : 0;
+
+    if (m_path != nullptr)
+        CloseHandle(handle);
+
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    io_uring_sqe *sqe = acquire_sqe(m_ovlp);
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+    auto *info = reinterpret_cast<struct statx *>(m_buffer);
+    if (m_path != nullptr)
+        io_uring_prep_statx(sqe, AT_FDCWD, m_path, AT_STATX_SYNC_AS_STAT, STATX_BASIC_STATS, info);
+    else
+        io_uring_prep_statx(sqe, static_cast<int>(m_handle), "", AT_EMPTY_PATH,
+                            STATX_BASIC_STATS, info);
+
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+auto file::read_awaitable::await_resume() const noexcept
+    -> std::expected<std::uint32_t, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (m_ovlp.error == 0) [[likely]]
+        return m_ovlp.bytes_transferred;
+
+    // Reading at end of file is not an error.
+    if (m_ovlp.error == ERROR_HANDLE_EOF)
+        return 0;
+
+    return std::unexpected(std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_ovlp.result >= 0) [[likely]]
+        return static_cast<std::uint32_t>(m_ovlp.result);
+
+    return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+#endif
+}
+
+auto file::read_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    m_ovlp.offset      = static_cast<std::uint32_t>(m_offset);
+    m_ovlp.offset_high = static_cast<std::uint32_t>(m_offset >> 32);
+
+    // Read returned immediately. Do not suspend this coroutine.
+    DWORD bytes = 0;
+    if (ReadFile(reinterpret_cast<HANDLE>(m_handle), m_data, m_size, &bytes,
+                 reinterpret_cast<LPOVERLAPPED>(&m_ovlp)) == TRUE) {
+        m_ovlp.error             = 0;
+        m_ovlp.bytes_transferred = bytes;
+        return false;
+    }
+
+    DWORD error = GetLastError();
+    if (error == ERROR_IO_PENDING) [[likely]]
+        return true;
+
+    m_ovlp.error = error;
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    io_uring_sqe *sqe = acquire_sqe(m_ovlp);
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+    if (m_buffer_index >= 0)
+        io_uring_prep_read_fixed(sqe, static_cast<int>(m_handle), m_data, m_size, m_offset,
+                                 m_buffer_index);
+    else
+        io_uring_prep_read(sqe, static_cast<int>(m_handle), m_data, m_size, m_offset);
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+auto file::write_awaitable::await_resume() const noexcept
+    -> std::expected<std::uint32_t, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (m_ovlp.error == 0) [[likely]]
+        return m_ovlp.bytes_transferred;
+
+    return std::unexpected(std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_ovlp.result >= 0) [[likely]]
+        return static_cast<std::uint32_t>(m_ovlp.result);
+
+    return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+#endif
+}
+
+auto file::write_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    m_ovlp.offset      = static_cast<std::uint32_t>(m_offset);
+    m_ovlp.offset_high = static_cast<std::uint32_t>(m_offset >> 32);
+
+    // Write returned immediately. Do not suspend this coroutine.
+    DWORD bytes = 0;
+    if (WriteFile(reinterpret_cast<HANDLE>(m_handle), m_data, m_size, &bytes,
+                  reinterpret_cast<LPOVERLAPPED>(&m_ovlp)) == TRUE) {
+        m_ovlp.error             = 0;
+        m_ovlp.bytes_transferred = bytes;
+        return false;
+    }
+
+    DWORD error = GetLastError();
+    if (error == ERROR_IO_PENDING) [[likely]]
+        return true;
+
+    m_ovlp.error = error;
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    io_uring_sqe *sqe = acquire_sqe(m_ovlp);
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+    if (m_buffer_index >= 0)
+        io_uring_prep_write_fixed(sqe, static_cast<int>(m_handle), m_data, m_size, m_offset,
+                                  m_buffer_index);
+    else
+        io_uring_prep_write(sqe, static_cast<int>(m_handle), m_data, m_size, m_offset);
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+file::file() noexcept : m_handle(invalid_handle) {}
+
+file::file(file &&other) noexcept : m_handle(other.m_handle) {
+    other.m_handle = invalid_handle;
+}
+
+file::~file() {
+    close();
+}
+
+auto file::operator=(file &&other) noexcept -> file & {
+    if (this == &other) [[unlikely]]
+        return *this;
+
+    close();
+
+    m_handle       = other.m_handle;
+    other.m_handle = invalid_handle;
+    return *this;
+}
+
+auto file::close() noexcept -> void {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (m_handle != invalid_handle) {
+        CloseHandle(reinterpret_cast<HANDLE>(m_handle));
+        m_handle = invalid_handle;
+    }
+#else
+    if (m_handle != invalid_handle) {
+        ::close(static_cast<int>(m_handle));
+        m_handle = invalid_handle;
+    }
+#endif
+}
@@ -0,0 +1,169 @@
+#include "ossia/futex.hpp"
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+#    include <Windows.h>
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <liburing.h>
+#    include <linux/futex.h>
+#    include <sys/eventfd.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+// io_uring_prep_futex_wait is available since liburing 2.5.
+#    if defined(IO_URING_VERSION_MAJOR) &&                                                         \
+        (IO_URING_VERSION_MAJOR * 100 + IO_URING_VERSION_MINOR >= 205)
+#        define OSSIA_IO_URING_FUTEX 1
+#    else
+#        define OSSIA_IO_URING_FUTEX 0
+#    endif
+
+/// \brief
+///   Checks if \c IORING_OP_FUTEX_WAIT is supported by current kernel. The result is probed once
+///   with a temporary ring so that distribution kernels with backported features are detected.
+[[nodiscard]]
+static auto futex_wait_supported() noexcept -> bool {
+#    if OSSIA_IO_URING_FUTEX
+    static const bool supported = []() noexcept -> bool {
+        io_uring ring;
+        if (io_uring_queue_init(1, &ring, 0) != 0)
+            return false;
+
+        bool            result = false;
+        io_uring_probe *probe  = io_uring_get_probe_ring(&ring);
+        if (probe != nullptr) {
+            result = io_uring_opcode_supported(probe, IORING_OP_FUTEX_WAIT);
+            io_uring_free_probe(probe);
+        }
+
+        io_uring_queue_exit(&ring);
+        return result;
+    }();
+
+    return supported;
+#    else
+    return false;
+#    endif
+}
+#endif
+
+auto futex::wait_awaitable::await_resume() noexcept -> std::error_code {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return std::error_code(static_cast<int>(m_ovlp.error), std::system_category());
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    // The futex word has been changed before the kernel started waiting.
+    if (m_ovlp.result >= 0 || m_ovlp.result == -EAGAIN) [[likely]]
+        return {};
+
+    return std::error_code(-m_ovlp.result, std::system_category());
+#endif
+}
+
+auto futex::wait_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    m_ovlp.error = ERROR_NOT_SUPPORTED;
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    futex *owner = m_futex;
+
+    // Register as a waiter before checking the futex word again, so that a notifier either sees
+    // this waiter or this waiter sees the new value.
+    if (!owner->is_native()) {
+        owner->m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (owner->m_word.load(std::memory_order_seq_cst) != m_expected) {
+            // A notifier may have claimed this waiter already. The token it posted causes a
+            // spurious wakeup later, which is allowed.
+            std::uint32_t waiters = owner->m_waiters.load(std::memory_order_relaxed);
+            while (waiters != 0 &&
+                   !owner->m_waiters.compare_exchange_weak(waiters, waiters - 1,
+                                                           std::memory_order_relaxed)) {}
+            m_ovlp.result = 0;
+            return false;
+        }
+    }
+
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    auto *sqe = static_cast<io_uring_sqe *>(worker->acquire_sqe(m_ovlp.result));
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+#    if OSSIA_IO_URING_FUTEX
+    if (owner->is_native()) {
+        auto *word = reinterpret_cast<std::uint32_t *>(&owner->m_word);
+        io_uring_prep_futex_wait(sqe, word, m_expected, FUTEX_BITSET_MATCH_ANY,
+                                 FUTEX2_SIZE_U32 | FUTEX2_PRIVATE, 0);
+    } else
+#    endif
+    {
+        io_uring_prep_read(sqe, static_cast<int>(owner->m_handle), &m_counter, sizeof(m_counter),
+                           0);
+    }
+
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+futex::futex(std::uint32_t value) : m_word(value), m_waiters(), m_handle(invalid_handle) {
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (futex_wait_supported())
+        return;
+
+    // Each read of a semaphore eventfd consumes one token, so one notification wakes one waiter.
+    int handle = eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE);
+    if (handle == -1) [[unlikely]]
+        throw std::system_error(errno, std::system_category(), "Failed to create eventfd");
+
+    m_handle = static_cast<std::uintptr_t>(handle);
+#endif
+}
+
+futex::~futex() {
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_handle != invalid_handle)
+        close(static_cast<int>(m_handle));
+#endif
+}
+
+auto futex::notify(std::uint32_t count) noexcept -> void {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    (void)count;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (this->is_native()) {
+        syscall(SYS_futex, &m_word, FUTEX_WAKE_PRIVATE, std::min<std::uint32_t>(count, INT_MAX),
+                nullptr, nullptr, 0);
+        return;
+    }
+
+    // Claim waiters so that concurrent notifiers do not post more tokens than waiters.
+    std::uint32_t waiters = m_waiters.load(std::memory_order_seq_cst);
+    std::uint32_t claimed = 0;
+    while (waiters != 0) {
+        claimed = std::min(waiters, count);
+        if (m_waiters.compare_exchange_weak(waiters, waiters - claimed, std::memory_order_seq_cst))
+            break;
+        claimed = 0;
+    }
+
+    if (claimed == 0)
+        return;
+
+    std::uint64_t tokens = claimed;
+    [[maybe_unused]] auto result = write(static_cast<int>(m_handle), &tokens, sizeof(tokens));
+#endif
+}
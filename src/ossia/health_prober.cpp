@@ -0,0 +1,250 @@
+#include "ossia/health_prober.hpp"
+#include "ossia/timer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+struct ossia::detail::probe_shard {
+    /// \brief
+    ///   Number of probes of this shard in flight.
+    std::uint32_t in_flight;
+
+    /// \brief
+    ///   The coroutine waiting for probes of this shard to finish.
+    promise_base *waiter;
+};
+
+/// \class probe_shard_awaitable
+/// \brief
+///   Awaitable object that suspends the coroutine running a shard until a probe of the shard
+///   finishes.
+class probe_shard_awaitable {
+public:
+    /// \brief
+    ///   Create a new \c probe_shard_awaitable object.
+    /// \param[in, out] shard
+    ///   The shard to wait for.
+    explicit probe_shard_awaitable(probe_shard &shard) noexcept : m_shard(&shard) {}
+
+    /// \brief
+    ///   C++20 coroutine API method. Always execute \c await_suspend().
+    /// \return
+    ///   This function always returns \c false.
+    static constexpr auto await_ready() noexcept -> bool {
+        return false;
+    }
+
+    /// \brief
+    ///   Suspend the coroutine until a probe of the shard finishes.
+    /// \tparam T
+    ///   Type of promise of current coroutine.
+    /// \param coroutine
+    ///   Current coroutine handle.
+    template <class T>
+    auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> void {
+        m_shard->waiter = &static_cast<promise_base &>(coroutine.promise());
+    }
+
+    /// \brief
+    ///   C++20 coroutine API method. Nothing to do.
+    static constexpr auto await_resume() noexcept -> void {}
+
+private:
+    probe_shard *m_shard;
+};
+
+// Layout of the packed status of an endpoint:
+//   bits 0-1:   endpoint_health
+//   bit 2:      the latest probe succeeded
+//   bits 3-15:  consecutive probes with the same result
+//   bits 16-30: error value of the latest probe
+//   bit 31:     the error belongs to the generic category instead of the system category
+//   bits 32-63: latency of the latest probe in microseconds
+
+/// \brief
+///   Maximum number of consecutive probes that could be packed.
+static constexpr std::uint64_t max_consecutive = 0x1FFF;
+
+/// \brief
+///   Maximum error value that could be packed.
+static constexpr std::uint64_t max_error_value = 0x7FFF;
+
+/// \brief
+///   Flag of the packed status that marks errors of the generic category.
+static constexpr std::uint64_t generic_error_flag = std::uint64_t(1) << 31;
+
+health_prober::health_prober(std::vector<inet_address>    endpoints,
+                             std::size_t                  workers,
+                             const health_prober_options &options) noexcept
+    : m_endpoints(std::move(endpoints)),
+      m_options(options),
+      m_workers(std::max<std::size_t>(workers, 1)),
+      m_states(std::make_unique<std::atomic_uint64_t[]>(m_endpoints.size())),
+      m_next_shard(),
+      m_stopped(),
+      m_probes(),
+      m_failures() {}
+
+auto health_prober::run() noexcept -> future<> {
+    std::size_t first = m_next_shard.fetch_add(1, std::memory_order_relaxed);
+    if (first >= m_workers) [[unlikely]]
+        co_return;
+
+    probe_shard shard{
+        .in_flight = 0,
+        .waiter    = nullptr,
+    };
+
+    std::uint32_t limit = std::max<std::uint32_t>(m_options.max_in_flight, 1);
+
+    while (!m_stopped.load(std::memory_order_relaxed)) {
+        auto round = std::chrono::steady_clock::now();
+
+        // Endpoints are interleaved between shards, so that endpoints listed together do not
+        // load a single worker.
+        for (std::size_t i = first; i < m_endpoints.size(); i += m_workers) {
+            while (shard.in_flight >= limit)
+                co_await probe_shard_awaitable(shard);
+
+            if (m_stopped.load(std::memory_order_relaxed)) [[unlikely]]
+                break;
+
+            shard.in_flight += 1;
+            schedule(this->probe(i, shard));
+        }
+
+        co_await sleep_until(round + m_options.interval);
+    }
+
+    // Probes refer to the shard, so it must outlive them.
+    while (shard.in_flight != 0)
+        co_await probe_shard_awaitable(shard);
+}
+
+auto health_prober::status(std::size_t index) const noexcept -> probe_status {
+    std::uint64_t packed = m_states[index].load(std::memory_order_relaxed);
+
+    std::error_code error;
+    if (auto value = static_cast<int>((packed >> 16) & max_error_value); value != 0) {
+        if ((packed & generic_error_flag) != 0)
+            error = std::error_code(value, std::generic_category());
+        else
+            error = std::error_code(value, std::system_category());
+    }
+
+    return probe_status{
+        .health      = static_cast<endpoint_health>(packed & 0x3),
+        .succeeded   = (packed & 0x4) != 0,
+        .consecutive = static_cast<std::uint16_t>((packed >> 3) & max_consecutive),
+        .error       = error,
+        .latency     = std::chrono::microseconds(packed >> 32),
+    };
+}
+
+auto health_prober::healthy_count() const noexcept -> std::size_t {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < m_endpoints.size(); ++i) {
+        std::uint64_t packed = m_states[i].load(std::memory_order_relaxed);
+        if (static_cast<endpoint_health>(packed & 0x3) == endpoint_health::healthy)
+            count += 1;
+    }
+    return count;
+}
+
+auto health_prober::probe(std::size_t index, probe_shard &shard) noexcept -> future<> {
+    auto start = std::chrono::steady_clock::now();
+
+    // The deadline bounds every IO operation of this probe with a linked timeout.
+    task_context context = task_context{}.with_timeout(m_options.timeout);
+    co_await set_task_context(&context);
+
+    tcp_stream      stream;
+    std::error_code error = co_await stream.connect_async(m_endpoints[index]);
+    if (!error && (!m_options.request.empty() || !m_options.response.empty()))
+        error = co_await this->exchange(stream);
+
+    stream.close();
+    this->record(index, error, std::chrono::steady_clock::now() - start);
+
+    shard.in_flight -= 1;
+    if (shard.waiter != nullptr) {
+        io_context_worker::current()->post(shard.waiter);
+        shard.waiter = nullptr;
+    }
+}
+
+auto health_prober::exchange(tcp_stream &stream) noexcept -> future<std::error_code> {
+    const std::string &request = m_options.request;
+    for (std::size_t sent = 0; sent < request.size();) {
+        auto size   = static_cast<std::uint32_t>(request.size() - sent);
+        auto result = co_await stream.send_async(request.data() + sent, size);
+        if (!result.has_value()) [[unlikely]]
+            co_return result.error();
+        sent += *result;
+    }
+
+    // Only the expected prefix is received. Anything after it is dropped with the connection.
+    const std::string &response = m_options.response;
+    std::size_t        expected = std::max<std::size_t>(response.size(), 1);
+
+    char buffer[256];
+    for (std::size_t received = 0; received < expected;) {
+        auto size   = static_cast<std::uint32_t>(std::min(expected - received, sizeof(buffer)));
+        auto result = co_await stream.receive_async(buffer, size);
+        if (!result.has_value()) [[unlikely]]
+            co_return result.error();
+        if (*result == 0) [[unlikely]]
+            co_return std::make_error_code(std::errc::connection_reset);
+
+        std::size_t compared = std::min<std::size_t>(*result, response.size() - received);
+        if (std::memcmp(buffer, response.data() + received, compared) != 0) [[unlikely]]
+            co_return std::make_error_code(std::errc::protocol_error);
+
+        received += *result;
+    }
+
+    co_return std::error_code();
+}
+
+auto health_prober::record(std::size_t                         index,
+                           std::error_code                     error,
+                           std::chrono::steady_clock::duration latency) noexcept -> void {
+    // Only the worker that owns the endpoint writes its status, so no atomic read-modify-write
+    // is required.
+    std::uint64_t previous    = m_states[index].load(std::memory_order_relaxed);
+    bool          succeeded   = !error;
+    bool          last        = (previous & 0x4) != 0;
+    std::uint64_t consecutive = (previous >> 3) & max_consecutive;
+    auto          health      = static_cast<endpoint_health>(previous & 0x3);
+
+    consecutive = (last == succeeded) ? std::min(consecutive + 1, max_consecutive) : 1;
+    if (succeeded && consecutive >= m_options.healthy_threshold)
+        health = endpoint_health::healthy;
+    else if (!succeeded && consecutive >= m_options.unhealthy_threshold)
+        health = endpoint_health::unhealthy;
+
+    std::uint64_t packed = static_cast<std::uint64_t>(health) | (consecutive << 3);
+    if (succeeded) {
+        packed |= 0x4;
+    } else {
+        auto value  = static_cast<std::uint64_t>(error.value()) & max_error_value;
+        packed     |= value << 16;
+        if (error.category() == std::generic_category())
+            packed |= generic_error_flag;
+    }
+
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    auto limit        = static_cast<std::int64_t>(std::numeric_limits<std::uint32_t>::max());
+    auto clamped      = std::clamp<std::int64_t>(microseconds, 0, limit);
+    packed           |= static_cast<std::uint64_t>(clamped) << 32;
+
+    m_states[index].store(packed, std::memory_order_relaxed);
+
+    m_probes.fetch_add(1, std::memory_order_relaxed);
+    if (!succeeded)
+        m_failures.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,154 @@
+#include "ossia/hedging.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+hedge_race::hedge_race() noexcept
+    : m_streams(),
+      m_start_times(),
+      m_elapsed(),
+      m_running(),
+      m_pending(),
+      m_winner(-1),
+      m_failed(),
+      m_waiter(),
+      m_timer(),
+      m_timer_armed() {}
+
+auto hedge_race::elapsed(std::size_t index) const noexcept -> std::chrono::steady_clock::duration {
+    if (m_running[index])
+        return std::chrono::steady_clock::now() - m_start_times[index];
+    return m_elapsed[index];
+}
+
+auto hedge_race::start(std::size_t index) noexcept -> void {
+    m_start_times[index] = std::chrono::steady_clock::now();
+    m_running[index]     = true;
+    m_pending           += 1;
+}
+
+auto hedge_race::finish(std::size_t index, bool succeeded) noexcept -> bool {
+    m_elapsed[index]  = std::chrono::steady_clock::now() - m_start_times[index];
+    m_running[index]  = false;
+    m_pending        -= 1;
+
+    // A later success replaces the first failure. Results after the winner are dropped.
+    bool keep = !this->is_done() && (succeeded || !m_failed);
+    if (succeeded && !this->is_done()) {
+        m_winner = static_cast<int>(index);
+        this->cancel();
+    } else if (!succeeded) {
+        m_failed = true;
+    }
+
+    this->wake();
+    return keep;
+}
+
+auto hedge_race::cancel() noexcept -> void {
+    for (std::size_t i = 0; i < 2; ++i) {
+        if (m_running[i])
+            m_streams[i].cancel();
+    }
+}
+
+auto hedge_race::suspend(promise_base                         *promise,
+                         std::chrono::steady_clock::time_point deadline) noexcept -> void {
+    m_waiter = promise;
+    if (deadline == std::chrono::steady_clock::time_point::max())
+        return;
+
+    m_timer = timer_entry{
+        .deadline = deadline,
+        .promise  = promise,
+        .expire   = [](timer_entry *timer) noexcept -> void {
+            auto *self          = static_cast<hedge_race *>(timer->context);
+            self->m_timer_armed = false;
+            self->wake();
+        },
+        .context  = this,
+    };
+
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+    worker->add_timer(&m_timer);
+    m_timer_armed = true;
+}
+
+auto hedge_race::resume() noexcept -> void {
+    if (m_timer_armed) {
+        io_context_worker::current()->cancel_timer(&m_timer);
+        m_timer_armed = false;
+    }
+}
+
+auto hedge_race::wake() noexcept -> void {
+    if (m_waiter == nullptr)
+        return;
+
+    io_context_worker::current()->post(m_waiter);
+    m_waiter = nullptr;
+}
+
+hedging_client::hedging_client(std::vector<inet_address> replicas,
+                               const hedging_options    &options) noexcept
+    : m_replicas(std::move(replicas)),
+      m_options(options),
+      m_next_replica(),
+      m_budget(options.budget_burst),
+      m_delay(options.initial_delay),
+      m_stats(),
+      m_samples(),
+      m_sample_count() {}
+
+auto hedging_client::begin_request() noexcept -> std::size_t {
+    m_stats.requests += 1;
+    m_budget          = std::min(m_budget + m_options.budget_ratio, m_options.budget_burst);
+
+    std::size_t replica = m_next_replica;
+    m_next_replica      = (m_next_replica + 1) % m_replicas.size();
+    return replica;
+}
+
+auto hedging_client::acquire_hedge() noexcept -> bool {
+    if (m_budget < 1) {
+        m_stats.throttled_hedges += 1;
+        return false;
+    }
+
+    m_budget       -= 1;
+    m_stats.hedges += 1;
+    return true;
+}
+
+auto hedging_client::end_request(const hedge_race &race) noexcept -> void {
+    if (race.winner() == 1)
+        m_stats.hedge_wins += 1;
+    else if (race.winner() < 0)
+        m_stats.failures += 1;
+
+    // Primary attempts that lose are still running. Their latency so far is a lower bound.
+    auto latency = race.elapsed(0);
+    if (m_samples.size() < sample_capacity)
+        m_samples.push_back(latency);
+    else
+        m_samples[m_sample_count % sample_capacity] = latency;
+
+    m_sample_count += 1;
+    if (m_sample_count % sample_interval != 0)
+        return;
+
+    std::vector<std::chrono::steady_clock::duration> sorted(m_samples);
+
+    double position = m_options.percentile * static_cast<double>(sorted.size() - 1);
+    auto   rank     = static_cast<std::size_t>(std::ceil(position));
+    rank            = std::min(rank, sorted.size() - 1);
+
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank),
+                     sorted.end());
+    m_delay = std::max(sorted[rank], m_options.min_delay);
+}
@@ -0,0 +1,619 @@
+#include "ossia/hpack.hpp"
+
+#include <array>
+#include <cstring>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+/// \brief
+///   Static table of HPACK. See RFC 7541 appendix A.
+static constexpr std::pair<std::string_view, std::string_view> static_table[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+static_assert(std::size(static_table) == hpack_table::static_size);
+
+/// \brief
+///   Size in byte of the overhead of each dynamic table entry.
+inline constexpr std::size_t entry_overhead = 32;
+
+/// \brief
+///   Symbol of the end-of-string code, which must never appear in encoded strings.
+inline constexpr std::size_t huffman_eos = 256;
+
+/// \brief
+///   Code lengths of the HPACK Huffman code in symbol order. The code is canonical, so codes are
+///   derived from lengths. See RFC 7541 appendix B.
+static constexpr std::uint8_t huffman_lengths[257] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28, 28, 28, 28, 28,
+    28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28, 6,  10, 10, 12, 13, 6,  8,  11,
+    10, 10, 8,  11, 8,  6,  6,  6,  5,  5,  5,  6,  6,  6,  6,  6,  6,  6,  7,  8,
+    15, 6,  12, 10, 13, 6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+    7,  7,  7,  7,  7,  7,  7,  7,  8,  7,  8,  13, 19, 13, 14, 6,  15, 5,  6,  5,
+    6,  5,  6,  6,  6,  5,  7,  7,  6,  6,  6,  5,  6,  7,  6,  5,  5,  6,  7,  7,
+    7,  7,  7,  15, 11, 14, 13, 28, 20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23,
+    23, 23, 24, 23, 24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23, 21, 21, 22, 21,
+    23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23, 26, 26, 20, 19, 22, 23, 22, 25,
+    26, 26, 26, 27, 27, 26, 24, 25, 19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26,
+    28, 27, 27, 27, 20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26, 30,
+};
+
+/// \brief
+///   Assign canonical Huffman codes: shorter codes first, and symbols in order within the same
+///   length.
+/// \return
+///   Huffman code of each symbol, aligned to the least significant bit.
+[[nodiscard]]
+static consteval auto make_huffman_codes() noexcept -> std::array<std::uint32_t, 257> {
+    std::array<std::uint32_t, 257> codes{};
+
+    std::uint32_t code = 0;
+    for (std::uint8_t length = 1; length <= 30; ++length) {
+        for (std::size_t symbol = 0; symbol < codes.size(); ++symbol) {
+            if (huffman_lengths[symbol] == length)
+                codes[symbol] = code++;
+        }
+        code <<= 1;
+    }
+
+    return codes;
+}
+
+/// \brief
+///   Huffman code of each symbol.
+static constexpr auto huffman_codes = make_huffman_codes();
+
+/// \brief
+///   Transition flag: a symbol is emitted.
+inline constexpr std::uint8_t huffman_emit = 0x1;
+
+/// \brief
+///   Transition flag: the end-of-string code is decoded, which is an error.
+inline constexpr std::uint8_t huffman_fail = 0x2;
+
+/// \brief
+///   Transition flag: the string may end after this transition. Remaining bits are less than 8
+///   bits of the end-of-string code.
+inline constexpr std::uint8_t huffman_accept = 0x4;
+
+/// \struct huffman_transition
+/// \brief
+///   Transition of the Huffman decoder for 4 input bits.
+struct huffman_transition {
+    std::uint8_t state;
+    std::uint8_t flags;
+    std::uint8_t symbol;
+};
+
+/// \brief
+///   Build the decoding state machine. States are internal nodes of the Huffman tree, and each
+///   state has a transition for every 4-bit input.
+/// \return
+///   Transitions indexed by <tt>state * 16 + input</tt>.
+[[nodiscard]]
+static consteval auto make_huffman_transitions() noexcept
+    -> std::array<huffman_transition, 256 * 16> {
+    // Children of internal nodes. Leaves are stored as -(symbol + 1).
+    std::array<std::array<std::int16_t, 2>, 256> children{};
+    std::array<std::uint8_t, 256>                depth{};
+    std::array<bool, 256>                        all_ones{};
+
+    std::size_t node_count = 1;
+    all_ones[0]            = true;
+
+    for (std::size_t symbol = 0; symbol < huffman_codes.size(); ++symbol) {
+        std::size_t node = 0;
+        for (std::uint8_t i = huffman_lengths[symbol]; i > 0; --i) {
+            std::size_t bit = (huffman_codes[symbol] >> (i - 1)) & 1;
+            if (i == 1) {
+                children[node][bit] = static_cast<std::int16_t>(-static_cast<int>(symbol) - 1);
+                break;
+            }
+
+            if (children[node][bit] == 0) {
+                children[node][bit] = static_cast<std::int16_t>(node_count);
+                depth[node_count]    = static_cast<std::uint8_t>(depth[node] + 1);
+                all_ones[node_count] = all_ones[node] && bit == 1;
+                node_count += 1;
+            }
+
+            node = static_cast<std::size_t>(children[node][bit]);
+        }
+    }
+
+    std::array<huffman_transition, 256 * 16> transitions{};
+    for (std::size_t state = 0; state < node_count; ++state) {
+        for (std::size_t input = 0; input < 16; ++input) {
+            huffman_transition &transition = transitions[state * 16 + input];
+
+            std::size_t node = state;
+            for (std::size_t i = 4; i > 0; --i) {
+                std::int16_t child = children[node][(input >> (i - 1)) & 1];
+                if (child >= 0) {
+                    node = static_cast<std::size_t>(child);
+                    continue;
+                }
+
+                auto symbol = static_cast<std::size_t>(-child - 1);
+                if (symbol == huffman_eos) {
+                    transition.flags = huffman_fail;
+                    break;
+                }
+
+                transition.flags  = huffman_emit;
+                transition.symbol = static_cast<std::uint8_t>(symbol);
+                node              = 0;
+            }
+
+            if (transition.flags == huffman_fail)
+                continue;
+
+            transition.state = static_cast<std::uint8_t>(node);
+            if (node == 0 || (all_ones[node] && depth[node] <= 7))
+                transition.flags |= huffman_accept;
+        }
+    }
+
+    return transitions;
+}
+
+/// \brief
+///   Transition table of the Huffman decoder.
+static constexpr auto huffman_transitions = make_huffman_transitions();
+
+auto ossia::hpack_huffman_size(std::string_view data) noexcept -> std::size_t {
+    std::size_t bits = 0;
+    for (char c : data)
+        bits += huffman_lengths[static_cast<std::uint8_t>(c)];
+    return (bits + 7) / 8;
+}
+
+auto ossia::hpack_huffman_encode(std::string_view data, std::string &output) -> void {
+    std::uint64_t buffer = 0;
+    std::size_t   bits   = 0;
+
+    for (char c : data) {
+        auto symbol = static_cast<std::uint8_t>(c);
+        buffer      = (buffer << huffman_lengths[symbol]) | huffman_codes[symbol];
+        bits       += huffman_lengths[symbol];
+
+        while (bits >= 8) {
+            bits -= 8;
+            output.push_back(static_cast<char>(buffer >> bits));
+        }
+    }
+
+    // Pad with the most significant bits of the end-of-string code, which are all ones.
+    if (bits != 0) {
+        buffer = (buffer << (8 - bits)) | (0xFF >> bits);
+        output.push_back(static_cast<char>(buffer));
+    }
+}
+
+auto ossia::hpack_huffman_decode(std::string_view data, std::string &output) -> bool {
+    std::uint8_t state  = 0;
+    bool         accept = true;
+
+    for (char c : data) {
+        auto byte = static_cast<std::uint8_t>(c);
+        for (std::uint8_t input : {static_cast<std::uint8_t>(byte >> 4),
+                                   static_cast<std::uint8_t>(byte & 0xF)}) {
+            const huffman_transition &transition = huffman_transitions[state * 16 + input];
+            if (transition.flags & huffman_fail) [[unlikely]]
+                return false;
+
+            if (transition.flags & huffman_emit)
+                output.push_back(static_cast<char>(transition.symbol));
+
+            state  = transition.state;
+            accept = (transition.flags & huffman_accept) != 0;
+        }
+    }
+
+    return accept;
+}
+
+auto hpack_header_list::add(std::string_view name, std::string_view value) -> void {
+    m_fields.push_back(field{
+        .offset     = static_cast<std::uint32_t>(m_storage.size()),
+        .name_size  = static_cast<std::uint32_t>(name.size()),
+        .value_size = static_cast<std::uint32_t>(value.size()),
+    });
+
+    m_storage.append(name);
+    m_storage.append(value);
+}
+
+auto hpack_header_list::find(std::string_view name) const noexcept
+    -> std::optional<std::string_view> {
+    for (std::size_t i = 0; i < m_fields.size(); ++i) {
+        if (this->name(i) == name)
+            return this->value(i);
+    }
+
+    return std::nullopt;
+}
+
+auto hpack_table::get(std::size_t index, std::string_view &name, std::string_view &value) const
+    noexcept -> bool {
+    if (index == 0) [[unlikely]]
+        return false;
+
+    if (index <= static_size) {
+        name  = static_table[index - 1].first;
+        value = static_table[index - 1].second;
+        return true;
+    }
+
+    index -= static_size + 1;
+    if (index >= m_entries.size()) [[unlikely]]
+        return false;
+
+    name  = m_entries[index].first;
+    value = m_entries[index].second;
+    return true;
+}
+
+auto hpack_table::find(std::string_view name, std::string_view value, bool &exact) const noexcept
+    -> std::size_t {
+    std::size_t name_index = 0;
+    exact                  = false;
+
+    for (std::size_t i = 0; i < static_size; ++i) {
+        if (static_table[i].first != name)
+            continue;
+
+        if (static_table[i].second == value) {
+            exact = true;
+            return i + 1;
+        }
+
+        if (name_index == 0)
+            name_index = i + 1;
+    }
+
+    for (std::size_t i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].first != name)
+            continue;
+
+        if (m_entries[i].second == value) {
+            exact = true;
+            return static_size + i + 1;
+        }
+
+        if (name_index == 0)
+            name_index = static_size + i + 1;
+    }
+
+    return name_index;
+}
+
+auto hpack_table::insert(std::string_view name, std::string_view value) -> void {
+    std::size_t size = name.size() + value.size() + entry_overhead;
+    if (size > m_max_size) {
+        this->evict(0);
+        return;
+    }
+
+    // The name or value may refer to an entry that is about to be evicted. See RFC 7541
+    // section 4.4. Copy them before evicting.
+    std::pair<std::string, std::string> entry(name, value);
+    this->evict(m_max_size - size);
+    m_entries.push_front(std::move(entry));
+    m_size += size;
+}
+
+auto hpack_table::resize(std::size_t max_size) noexcept -> void {
+    m_max_size = max_size;
+    this->evict(max_size);
+}
+
+auto hpack_table::evict(std::size_t max_size) noexcept -> void {
+    while (m_size > max_size) {
+        const auto &entry  = m_entries.back();
+        m_size            -= entry.first.size() + entry.second.size() + entry_overhead;
+        m_entries.pop_back();
+    }
+}
+
+/// \brief
+///   Decode an HPACK integer. See RFC 7541 section 5.1.
+/// \param[in, out] data
+///   The header block. The integer is removed from the front.
+/// \param prefix
+///   Number of bits of the prefix in the first byte.
+/// \return
+///   The decoded integer. Return \c std::nullopt if the integer is truncated or too large.
+[[nodiscard]]
+static auto decode_integer(std::string_view &data, std::uint8_t prefix) noexcept
+    -> std::optional<std::uint32_t> {
+    if (data.empty()) [[unlikely]]
+        return std::nullopt;
+
+    std::uint32_t mask  = (1U << prefix) - 1;
+    std::uint32_t value = static_cast<std::uint8_t>(data.front()) & mask;
+    data.remove_prefix(1);
+
+    if (value < mask)
+        return value;
+
+    for (std::uint32_t shift = 0; !data.empty(); shift += 7) {
+        // Integers larger than 2^28 are never needed by HTTP/2 and are rejected.
+        if (shift > 21) [[unlikely]]
+            return std::nullopt;
+
+        auto byte = static_cast<std::uint8_t>(data.front());
+        data.remove_prefix(1);
+
+        value += static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+
+    return std::nullopt;
+}
+
+/// \brief
+///   Decode an HPACK string literal. See RFC 7541 section 5.2.
+/// \param[in, out] data
+///   The header block. The string is removed from the front.
+/// \param[out] buffer
+///   Buffer to store a Huffman-decoded string.
+/// \return
+///   The decoded string. It refers either to \p data or to \p buffer.
+[[nodiscard]]
+static auto decode_string(std::string_view &data, std::string &buffer)
+    -> std::expected<std::string_view, hpack_error> {
+    if (data.empty()) [[unlikely]]
+        return std::unexpected(hpack_error::invalid);
+
+    bool huffman = (static_cast<std::uint8_t>(data.front()) & 0x80) != 0;
+    auto length  = decode_integer(data, 7);
+    if (!length.has_value() || *length > data.size()) [[unlikely]]
+        return std::unexpected(hpack_error::invalid);
+
+    std::string_view result = data.substr(0, *length);
+    data.remove_prefix(*length);
+
+    if (!huffman)
+        return result;
+
+    buffer.clear();
+    if (!hpack_huffman_decode(result, buffer)) [[unlikely]]
+        return std::unexpected(hpack_error::invalid_huffman);
+
+    return std::string_view(buffer);
+}
+
+auto hpack_decoder::decode(std::string_view   block,
+                           hpack_header_list &headers,
+                           std::size_t        max_list_size) -> std::expected<void, hpack_error> {
+    bool first = true;
+    while (!block.empty()) {
+        auto byte = static_cast<std::uint8_t>(block.front());
+
+        // Dynamic table size update. It is only allowed at the start of a header block.
+        if ((byte & 0xE0) == 0x20) {
+            auto size = decode_integer(block, 5);
+            if (!size.has_value() || !first || *size > m_max_table_size) [[unlikely]]
+                return std::unexpected(hpack_error::invalid_table_size);
+
+            m_table.resize(*size);
+            continue;
+        }
+
+        first = false;
+
+        std::string_view name;
+        std::string_view value;
+
+        if (byte & 0x80) {
+            // Indexed header field.
+            auto index = decode_integer(block, 7);
+            if (!index.has_value()) [[unlikely]]
+                return std::unexpected(hpack_error::invalid);
+            if (!m_table.get(*index, name, value)) [[unlikely]]
+                return std::unexpected(hpack_error::invalid_index);
+        } else {
+            // Literal header field with incremental indexing, without indexing or never indexed.
+            bool         indexing = (byte & 0x40) != 0;
+            std::uint8_t prefix   = indexing ? 6 : 4;
+
+            auto index = decode_integer(block, prefix);
+            if (!index.has_value()) [[unlikely]]
+                return std::unexpected(hpack_error::invalid);
+
+            if (*index != 0) {
+                std::string_view ignored;
+                if (!m_table.get(*index, name, ignored)) [[unlikely]]
+                    return std::unexpected(hpack_error::invalid_index);
+            } else {
+                auto result = decode_string(block, m_name);
+                if (!result.has_value()) [[unlikely]]
+                    return std::unexpected(result.error());
+                name = *result;
+            }
+
+            auto result = decode_string(block, m_value);
+            if (!result.has_value()) [[unlikely]]
+                return std::unexpected(result.error());
+            value = *result;
+
+            if (indexing) {
+                // The name may refer to an entry that is evicted by the insertion.
+                headers.add(name, value);
+                m_table.insert(name, value);
+                if (headers.list_size() > max_list_size) [[unlikely]]
+                    return std::unexpected(hpack_error::header_list_too_large);
+                continue;
+            }
+        }
+
+        headers.add(name, value);
+        if (headers.list_size() > max_list_size) [[unlikely]]
+            return std::unexpected(hpack_error::header_list_too_large);
+    }
+
+    return {};
+}
+
+/// \brief
+///   Encode an HPACK integer and append it to the output buffer.
+/// \param value
+///   The integer to be encoded.
+/// \param prefix
+///   Number of bits of the prefix in the first byte.
+/// \param pattern
+///   Bits of the first byte above the prefix.
+/// \param[out] output
+///   The output buffer.
+static auto encode_integer(std::size_t   value,
+                           std::uint8_t  prefix,
+                           std::uint8_t  pattern,
+                           std::string  &output) -> void {
+    std::size_t mask = (std::size_t{1} << prefix) - 1;
+    if (value < mask) {
+        output.push_back(static_cast<char>(pattern | value));
+        return;
+    }
+
+    output.push_back(static_cast<char>(pattern | mask));
+    value -= mask;
+    while (value >= 0x80) {
+        output.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    output.push_back(static_cast<char>(value));
+}
+
+/// \brief
+///   Encode an HPACK string literal and append it to the output buffer. Huffman encoding is used
+///   if it is shorter.
+/// \param data
+///   The string to be encoded.
+/// \param[out] output
+///   The output buffer.
+static auto encode_string(std::string_view data, std::string &output) -> void {
+    std::size_t size = hpack_huffman_size(data);
+    if (size < data.size()) {
+        encode_integer(size, 7, 0x80, output);
+        hpack_huffman_encode(data, output);
+        return;
+    }
+
+    encode_integer(data.size(), 7, 0, output);
+    output.append(data);
+}
+
+/// \brief
+///   Checks if a header field should be added to the dynamic table. Values that rarely repeat
+///   would only evict useful entries.
+/// \param name
+///   Name of the header field.
+/// \param value
+///   Value of the header field.
+/// \param max_table_size
+///   Maximum size in byte of the dynamic table.
+[[nodiscard]]
+static auto should_index(std::string_view name,
+                         std::string_view value,
+                         std::size_t      max_table_size) noexcept -> bool {
+    if (name == ":path" || name == "content-length" || name == "date" || name == "etag")
+        return false;
+    return (name.size() + value.size() + entry_overhead) * 4 <= max_table_size * 3;
+}
+
+auto hpack_encoder::encode(std::string_view name,
+                           std::string_view value,
+                           std::string     &output,
+                           bool             sensitive) -> void {
+    if (m_pending_update) {
+        encode_integer(m_table.max_size(), 5, 0x20, output);
+        m_pending_update = false;
+    }
+
+    bool        exact = false;
+    std::size_t index = m_table.find(name, value, exact);
+
+    if (exact && !sensitive) {
+        encode_integer(index, 7, 0x80, output);
+        return;
+    }
+
+    if (sensitive) {
+        encode_integer(index, 4, 0x10, output);
+    } else if (should_index(name, value, m_table.max_size())) {
+        encode_integer(index, 6, 0x40, output);
+        m_table.insert(name, value);
+    } else {
+        encode_integer(index, 4, 0x00, output);
+    }
+
+    if (index == 0)
+        encode_string(name, output);
+    encode_string(value, output);
+}
@@ -0,0 +1,1014 @@
+#include "ossia/http2.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+/// \brief
+///   Maximum size in byte of a single IO request.
+static constexpr std::size_t max_io_size = std::numeric_limits<std::uint32_t>::max();
+
+/// \brief
+///   Minimum capacity in byte of the receive buffer.
+static constexpr std::size_t min_buffer_size = 65536;
+
+/// \brief
+///   Initial and maximum size in byte of flow control windows. See RFC 9113 section 6.9.
+static constexpr std::int64_t default_window_size = 65535;
+static constexpr std::int64_t max_window_size     = 0x7FFFFFFF;
+
+/// \brief
+///   Identifiers of HTTP/2 settings. See RFC 9113 section 6.5.2.
+enum class settings_id : std::uint16_t {
+    header_table_size      = 0x1,
+    enable_push            = 0x2,
+    max_concurrent_streams = 0x3,
+    initial_window_size    = 0x4,
+    max_frame_size         = 0x5,
+    max_header_list_size   = 0x6,
+};
+
+/// \brief
+///   Read a big-endian 32-bit integer.
+/// \param data
+///   Pointer to the first byte of the integer.
+/// \return
+///   The integer in host byte order.
+[[nodiscard]]
+static auto read_uint32(const char *data) noexcept -> std::uint32_t {
+    auto *bytes = reinterpret_cast<const std::uint8_t *>(data);
+    return (static_cast<std::uint32_t>(bytes[0]) << 24) |
+           (static_cast<std::uint32_t>(bytes[1]) << 16) |
+           (static_cast<std::uint32_t>(bytes[2]) << 8) | static_cast<std::uint32_t>(bytes[3]);
+}
+
+/// \brief
+///   Append a big-endian 32-bit integer to the output buffer.
+/// \param value
+///   The integer to be appended.
+/// \param[out] output
+///   The output buffer.
+static auto write_uint32(std::uint32_t value, std::string &output) -> void {
+    output.push_back(static_cast<char>(value >> 24));
+    output.push_back(static_cast<char>(value >> 16));
+    output.push_back(static_cast<char>(value >> 8));
+    output.push_back(static_cast<char>(value));
+}
+
+/// \brief
+///   Append a setting to the payload of a \c SETTINGS frame.
+/// \param id
+///   Identifier of the setting.
+/// \param value
+///   Value of the setting.
+/// \param[out] output
+///   The payload buffer.
+static auto write_setting(settings_id id, std::uint32_t value, std::string &output) -> void {
+    output.push_back(static_cast<char>(static_cast<std::uint16_t>(id) >> 8));
+    output.push_back(static_cast<char>(static_cast<std::uint16_t>(id)));
+    write_uint32(value, output);
+}
+
+/// \brief
+///   Get size of the connection-level receive window. It is raised to the stream-level window so
+///   that a single stream could use its whole window.
+/// \param settings
+///   Settings announced to the peer.
+/// \return
+///   Size in byte of the connection-level receive window.
+[[nodiscard]]
+static auto connection_window_size(const http2_settings &settings) noexcept -> std::int64_t {
+    return std::max<std::int64_t>(default_window_size, settings.initial_window_size);
+}
+
+/// \brief
+///   Remove padding from the payload of a \c DATA or \c HEADERS frame.
+/// \param flags
+///   Flags of the frame.
+/// \param[in, out] payload
+///   Payload of the frame.
+/// \retval true
+///   The padding is valid and removed.
+/// \retval false
+///   The padding is longer than the payload.
+[[nodiscard]]
+static auto remove_padding(std::uint8_t flags, std::string_view &payload) noexcept -> bool {
+    if ((flags & http2_flag_padded) == 0)
+        return true;
+
+    if (payload.empty()) [[unlikely]]
+        return false;
+
+    auto padding = static_cast<std::uint8_t>(payload.front());
+    if (padding >= payload.size()) [[unlikely]]
+        return false;
+
+    payload = payload.substr(1, payload.size() - 1 - padding);
+    return true;
+}
+
+/// \brief
+///   Checks if a request header list is well-formed. See RFC 9113 section 8.3.1.
+/// \param headers
+///   Header list of the request.
+/// \retval true
+///   The header list is well-formed.
+/// \retval false
+///   The header list is malformed.
+[[nodiscard]]
+static auto is_valid_request(const hpack_header_list &headers) noexcept -> bool {
+    bool method  = false;
+    bool scheme  = false;
+    bool path    = false;
+    bool connect = false;
+    bool regular = false;
+
+    for (std::size_t i = 0; i < headers.size(); ++i) {
+        std::string_view name = headers.name(i);
+        if (name.empty()) [[unlikely]]
+            return false;
+
+        // Header names must be lowercase.
+        if (std::any_of(name.begin(), name.end(), [](char c) { return c >= 'A' && c <= 'Z'; }))
+            return false;
+
+        if (name.front() != ':') {
+            regular = true;
+            if (name == "connection" || name == "keep-alive" || name == "transfer-encoding" ||
+                name == "upgrade" || name == "proxy-connection") [[unlikely]]
+                return false;
+            continue;
+        }
+
+        // Pseudo-header fields must precede regular header fields and must not be repeated.
+        if (regular) [[unlikely]]
+            return false;
+
+        bool *seen = nullptr;
+        if (name == ":method") {
+            seen    = &method;
+            connect = (headers.value(i) == "CONNECT");
+        } else if (name == ":scheme") {
+            seen = &scheme;
+        } else if (name == ":path") {
+            seen = &path;
+            if (headers.value(i).empty()) [[unlikely]]
+                return false;
+        } else if (name != ":authority") {
+            return false;
+        }
+
+        if (seen != nullptr) {
+            if (*seen) [[unlikely]]
+                return false;
+            *seen = true;
+        }
+    }
+
+    return method && (connect || (scheme && path));
+}
+
+auto ossia::parse_http2_frame_header(std::span<const char> data) noexcept
+    -> std::optional<http2_frame_header> {
+    if (data.size() < http2_frame_header_size)
+        return std::nullopt;
+
+    auto *bytes = reinterpret_cast<const std::uint8_t *>(data.data());
+    return http2_frame_header{
+        .length    = (static_cast<std::uint32_t>(bytes[0]) << 16) |
+                     (static_cast<std::uint32_t>(bytes[1]) << 8) | bytes[2],
+        .type      = static_cast<http2_frame_type>(bytes[3]),
+        .flags     = bytes[4],
+        .stream_id = read_uint32(data.data() + 5) & 0x7FFFFFFF,
+    };
+}
+
+auto ossia::write_http2_frame_header(const http2_frame_header &header, std::string &output)
+    -> void {
+    output.push_back(static_cast<char>(header.length >> 16));
+    output.push_back(static_cast<char>(header.length >> 8));
+    output.push_back(static_cast<char>(header.length));
+    output.push_back(static_cast<char>(header.type));
+    output.push_back(static_cast<char>(header.flags));
+    write_uint32(header.stream_id & 0x7FFFFFFF, output);
+}
+
+http2_connection::http2_connection(tcp_stream            stream,
+                                   bool                  client,
+                                   const http2_settings &settings,
+                                   std::size_t           limit)
+    : m_stream(std::move(stream)),
+      m_client(client),
+      m_closed(),
+      m_preface_received(client),
+      m_settings_received(),
+      m_limit(limit),
+      m_settings(settings),
+      m_peer_max_concurrent_streams(std::numeric_limits<std::uint32_t>::max()),
+      m_peer_initial_window_size(default_window_size),
+      m_peer_max_frame_size(16384),
+      m_send_window(default_window_size),
+      m_receive_window(connection_window_size(settings)),
+      m_last_stream_id(),
+      m_next_stream_id(1),
+      m_header_stream_id(),
+      m_header_end_stream(),
+      m_header_block(),
+      m_decoder(settings.header_table_size),
+      m_encoder(),
+      m_scratch(),
+      m_encoded(),
+      m_authority(),
+      m_streams(),
+      m_ready(),
+      m_data(),
+      m_begin(),
+      m_end(),
+      m_capacity(std::max<std::size_t>(min_buffer_size,
+                                       settings.max_frame_size + http2_frame_header_size)),
+      m_pending(),
+      m_sending(),
+      m_writer() {
+    m_data = std::make_unique_for_overwrite<char[]>(m_capacity);
+}
+
+auto http2_connection::start(const std::shared_ptr<http2_connection> &self) -> void {
+    http2_connection &connection = *self;
+    if (connection.m_client)
+        connection.m_pending.append(http2_client_preface);
+
+    const http2_settings &settings = connection.m_settings;
+
+    std::string payload;
+    write_setting(settings_id::header_table_size, settings.header_table_size, payload);
+    if (connection.m_client)
+        write_setting(settings_id::enable_push, 0, payload);
+    write_setting(settings_id::max_concurrent_streams, settings.max_concurrent_streams, payload);
+    write_setting(settings_id::initial_window_size, settings.initial_window_size, payload);
+    write_setting(settings_id::max_frame_size, settings.max_frame_size, payload);
+    write_setting(settings_id::max_header_list_size, settings.max_header_list_size, payload);
+    connection.queue_frame(http2_frame_type::settings, 0, 0, payload);
+
+    std::int64_t window = connection_window_size(settings);
+    if (window > default_window_size)
+        connection.queue_window_update(0, static_cast<std::uint32_t>(window - default_window_size));
+
+    schedule(write_loop(self));
+}
+
+auto http2_connection::receive_async() noexcept -> future<std::error_code> {
+    while (true) {
+        if (m_closed) [[unlikely]]
+            co_return std::make_error_code(std::errc::connection_aborted);
+
+        char *data = m_data.get();
+        if (!m_preface_received && m_end - m_begin >= http2_client_preface.size()) {
+            if (std::string_view(data + m_begin, http2_client_preface.size()) !=
+                http2_client_preface) [[unlikely]] {
+                this->queue_goaway(http2_error_code::protocol_error);
+                co_return std::make_error_code(std::errc::protocol_error);
+            }
+
+            m_begin            += http2_client_preface.size();
+            m_preface_received  = true;
+        }
+
+        // Handle all complete frames before receiving more data.
+        bool handled = false;
+        while (m_preface_received) {
+            auto header = parse_http2_frame_header(
+                std::span<const char>(data + m_begin, m_end - m_begin));
+            if (!header.has_value())
+                break;
+
+            if (header->length > m_settings.max_frame_size) [[unlikely]] {
+                this->queue_goaway(http2_error_code::frame_size_error);
+                co_return std::make_error_code(std::errc::protocol_error);
+            }
+
+            std::size_t size = http2_frame_header_size + header->length;
+            if (m_end - m_begin < size)
+                break;
+
+            std::string_view payload(data + m_begin + http2_frame_header_size, header->length);
+            http2_error_code error = this->handle_frame(*header, payload);
+            m_begin += size;
+            handled  = true;
+
+            if (error != http2_error_code::no_error) [[unlikely]] {
+                this->queue_goaway(error);
+                co_return std::make_error_code(std::errc::protocol_error);
+            }
+        }
+
+        if (handled)
+            co_return std::error_code();
+
+        // Move unhandled data to the front and receive more data.
+        std::memmove(data, data + m_begin, m_end - m_begin);
+        m_end   -= m_begin;
+        m_begin  = 0;
+
+        auto size   = static_cast<std::uint32_t>(m_capacity - m_end);
+        auto result = co_await m_stream.receive_async(data + m_end, size);
+        if (!result.has_value()) [[unlikely]]
+            co_return result.error();
+        if (*result == 0)
+            co_return std::make_error_code(std::errc::connection_reset);
+
+        m_end += *result;
+    }
+}
+
+auto http2_connection::respond_async(http2_stream &stream) noexcept -> future<> {
+    if (!m_closed && !stream.reset) {
+        const http2_response &response = stream.response;
+
+        char status[8];
+        auto status_end = std::to_chars(status, status + sizeof(status), response.m_status).ptr;
+
+        m_encoded.clear();
+        m_encoder.encode(":status", std::string_view(status, status_end), m_encoded);
+
+        const hpack_header_list &headers = response.m_headers;
+        for (std::size_t i = 0; i < headers.size(); ++i)
+            m_encoder.encode(headers.name(i), headers.value(i), m_encoded);
+
+        if (!headers.find("content-length").has_value()) {
+            char length[24];
+            auto end = std::to_chars(length, length + sizeof(length), response.m_body.size()).ptr;
+            m_encoder.encode("content-length", std::string_view(length, end), m_encoded);
+        }
+
+        this->queue_headers(stream.id, m_encoded, response.m_body.empty());
+        if (!response.m_body.empty())
+            static_cast<void>(co_await this->send_body_async(stream, response.m_body));
+    }
+
+    m_streams.erase(stream.id);
+}
+
+auto http2_connection::request_async(std::string_view method,
+                                     std::string_view path,
+                                     std::string_view body) noexcept
+    -> future<std::expected<http2_response, std::error_code>> {
+    if (m_closed) [[unlikely]]
+        co_return std::unexpected(std::make_error_code(std::errc::connection_reset));
+
+    if (m_streams.size() >= m_peer_max_concurrent_streams || m_next_stream_id > max_window_size)
+        co_return std::unexpected(std::make_error_code(std::errc::resource_unavailable_try_again));
+
+    std::uint32_t id  = m_next_stream_id;
+    m_next_stream_id += 2;
+
+    auto owned = std::make_unique<http2_stream>(http2_stream{
+        .id               = id,
+        .remote_closed    = false,
+        .reset            = false,
+        .dispatched       = true,
+        .headers_received = false,
+        .send_window      = m_peer_initial_window_size,
+        .receive_window   = m_settings.initial_window_size,
+        .waiter           = nullptr,
+        .request          = http2_request(),
+        .response         = http2_response(),
+    });
+
+    http2_stream &stream = *owned;
+    m_streams.emplace(id, std::move(owned));
+
+    m_encoded.clear();
+    m_encoder.encode(":method", method, m_encoded);
+    m_encoder.encode(":scheme", "http", m_encoded);
+    if (!m_authority.empty())
+        m_encoder.encode(":authority", m_authority, m_encoded);
+    m_encoder.encode(":path", path, m_encoded);
+
+    if (!body.empty()) {
+        char length[24];
+        auto end = std::to_chars(length, length + sizeof(length), body.size()).ptr;
+        m_encoder.encode("content-length", std::string_view(length, end), m_encoded);
+    }
+
+    this->queue_headers(id, m_encoded, body.empty());
+
+    bool sent = body.empty() || co_await this->send_body_async(stream, body);
+    while (sent && !stream.remote_closed && !stream.reset && !m_closed)
+        co_await wait_awaitable(stream.waiter);
+
+    std::expected<http2_response, std::error_code> result;
+    if (stream.remote_closed && !stream.reset)
+        result = std::move(stream.response);
+    else
+        result = std::unexpected(std::make_error_code(std::errc::connection_reset));
+
+    m_streams.erase(id);
+    co_return result;
+}
+
+auto http2_connection::close(bool cancel) noexcept -> void {
+    m_closed = true;
+    wake(m_writer);
+    this->wake_streams();
+
+    if (cancel)
+        static_cast<void>(m_stream.cancel());
+}
+
+auto http2_connection::write_loop(std::shared_ptr<http2_connection> self) noexcept -> future<> {
+    http2_connection &connection = *self;
+
+    while (true) {
+        // Wait until frames are queued. Frames queued by all coroutines resumed in the same loop
+        // iteration are sent together.
+        if (connection.m_pending.empty()) {
+            if (connection.m_closed)
+                co_return;
+            co_await wait_awaitable(connection.m_writer);
+            continue;
+        }
+
+        connection.m_sending.swap(connection.m_pending);
+
+        std::size_t sent = 0;
+        while (sent < connection.m_sending.size()) {
+            std::size_t size = std::min(connection.m_sending.size() - sent, max_io_size);
+            auto result      = co_await connection.m_stream.send_async(
+                connection.m_sending.data() + sent, static_cast<std::uint32_t>(size));
+
+            if (!result.has_value()) [[unlikely]] {
+                connection.m_pending.clear();
+                connection.m_sending.clear();
+                connection.close();
+                co_return;
+            }
+
+            sent += *result;
+        }
+
+        connection.m_sending.clear();
+    }
+}
+
+auto http2_connection::handle_frame(const http2_frame_header &header, std::string_view payload)
+    -> http2_error_code {
+    // A header block must not be interleaved with any other frame.
+    if (m_header_stream_id != 0 && (header.type != http2_frame_type::continuation ||
+                                    header.stream_id != m_header_stream_id)) [[unlikely]]
+        return http2_error_code::protocol_error;
+
+    // The first frame from the peer must be SETTINGS.
+    if (!m_settings_received && header.type != http2_frame_type::settings) [[unlikely]]
+        return http2_error_code::protocol_error;
+
+    switch (header.type) {
+    case http2_frame_type::data:
+        return this->handle_data(header, payload);
+
+    case http2_frame_type::headers:
+        return this->handle_headers(header, payload);
+
+    case http2_frame_type::priority:
+        if (header.stream_id == 0) [[unlikely]]
+            return http2_error_code::protocol_error;
+        if (header.length != 5) [[unlikely]]
+            this->reset_stream(header.stream_id, http2_error_code::frame_size_error);
+        return http2_error_code::no_error;
+
+    case http2_frame_type::rst_stream: {
+        if (header.stream_id == 0 || this->is_idle(header.stream_id)) [[unlikely]]
+            return http2_error_code::protocol_error;
+        if (header.length != 4) [[unlikely]]
+            return http2_error_code::frame_size_error;
+
+        auto iter = m_streams.find(header.stream_id);
+        if (iter == m_streams.end())
+            return http2_error_code::no_error;
+
+        http2_stream &stream = *iter->second;
+        stream.reset         = true;
+        wake(stream.waiter);
+        if (!stream.dispatched)
+            m_streams.erase(iter);
+        return http2_error_code::no_error;
+    }
+
+    case http2_frame_type::settings:
+        return this->handle_settings(header, payload);
+
+    case http2_frame_type::push_promise:
+        // Clients disable server push and servers never receive it.
+        return http2_error_code::protocol_error;
+
+    case http2_frame_type::ping:
+        if (header.stream_id != 0) [[unlikely]]
+            return http2_error_code::protocol_error;
+        if (header.length != 8) [[unlikely]]
+            return http2_error_code::frame_size_error;
+        if ((header.flags & http2_flag_ack) == 0)
+            this->queue_frame(http2_frame_type::ping, http2_flag_ack, 0, payload);
+        return http2_error_code::no_error;
+
+    case http2_frame_type::goaway:
+        // Streams in progress are completed and the peer closes the connection afterwards.
+        if (header.stream_id != 0) [[unlikely]]
+            return http2_error_code::protocol_error;
+        if (header.length < 8) [[unlikely]]
+            return http2_error_code::frame_size_error;
+        return http2_error_code::no_error;
+
+    case http2_frame_type::window_update:
+        return this->handle_window_update(header, payload);
+
+    case http2_frame_type::continuation:
+        if (m_header_stream_id == 0) [[unlikely]]
+            return http2_error_code::protocol_error;
+
+        m_header_block.append(payload);
+        if (m_header_block.size() > m_settings.max_header_list_size) [[unlikely]]
+            return http2_error_code::enhance_your_calm;
+
+        if (header.flags & http2_flag_end_headers)
+            return this->handle_header_block();
+        return http2_error_code::no_error;
+    }
+
+    // Frames of unknown types are ignored.
+    return http2_error_code::no_error;
+}
+
+auto http2_connection::handle_data(const http2_frame_header &header, std::string_view payload)
+    -> http2_error_code {
+    if (header.stream_id == 0) [[unlikely]]
+        return http2_error_code::protocol_error;
+
+    // Flow control counts the whole payload including padding.
+    if (header.length > m_receive_window) [[unlikely]]
+        return http2_error_code::flow_control_error;
+
+    m_receive_window -= header.length;
+
+    std::int64_t window = connection_window_size(m_settings);
+    if (m_receive_window < window / 2) {
+        this->queue_window_update(0, static_cast<std::uint32_t>(window - m_receive_window));
+        m_receive_window = window;
+    }
+
+    if (!remove_padding(header.flags, payload)) [[unlikely]]
+        return http2_error_code::protocol_error;
+
+    auto iter = m_streams.find(header.stream_id);
+    if (iter == m_streams.end()) {
+        if (this->is_idle(header.stream_id)) [[unlikely]]
+            return http2_error_code::protocol_error;
+        this->reset_stream(header.stream_id, http2_error_code::stream_closed);
+        return http2_error_code::no_error;
+    }
+
+    http2_stream &stream = *iter->second;
+    if (stream.remote_closed || (m_client && !stream.headers_received)) [[unlikely]] {
+        this->reset_stream(stream.id, stream.remote_closed ? http2_error_code::stream_closed
+                                                           : http2_error_code::protocol_error);
+        return http2_error_code::no_error;
+    }
+
+    if (header.length > stream.receive_window) [[unlikely]] {
+        this->reset_stream(stream.id, http2_error_code::flow_control_error);
+        return http2_error_code::no_error;
+    }
+
+    stream.receive_window -= header.length;
+
+    std::string &body = m_client ? stream.response.m_body : stream.request.m_body;
+    if (body.size() + payload.size() > m_limit) [[unlikely]] {
+        this->reset_stream(stream.id, m_client ? http2_error_code::cancel
+                                               : http2_error_code::refused_stream);
+        return http2_error_code::no_error;
+    }
+
+    body.append(payload);
+    if (header.flags & http2_flag_end_stream) {
+        this->finish_stream(stream);
+        return http2_error_code::no_error;
+    }
+
+    if (stream.receive_window < m_settings.initial_window_size / 2) {
+        auto increment = m_settings.initial_window_size - stream.receive_window;
+        this->queue_window_update(stream.id, static_cast<std::uint32_t>(increment));
+        stream.receive_window = m_settings.initial_window_size;
+    }
+
+    return http2_error_code::no_error;
+}
+
+auto http2_connection::handle_headers(const http2_frame_header &header, std::string_view payload)
+    -> http2_error_code {
+    if (header.stream_id == 0) [[unlikely]]
+        return http2_error_code::protocol_error;
+
+    if (!remove_padding(header.flags, payload)) [[unlikely]]
+        return http2_error_code::protocol_error;
+
+    // Stream priority is deprecated and ignored.
+    if (header.flags & http2_flag_priority) {
+        if (payload.size() < 5) [[unlikely]]
+            return http2_error_code::frame_size_error;
+        payload.remove_prefix(5);
+    }
+
+    m_header_stream_id  = header.stream_id;
+    m_header_end_stream = (header.flags & http2_flag_end_stream) != 0;
+    m_header_block.assign(payload);
+
+    if (header.flags & http2_flag_end_headers)
+        return this->handle_header_block();
+    return http2_error_code::no_error;
+}
+
+auto http2_connection::handle_header_block() -> http2_error_code {
+    std::uint32_t id   = m_header_stream_id;
+    m_header_stream_id = 0;
+
+    auto          iter   = m_streams.find(id);
+    http2_stream *stream = (iter == m_streams.end()) ? nullptr : iter->second.get();
+
+    // The header block must always be decoded to keep the dynamic table in sync with the peer.
+    hpack_header_list *headers = &m_scratch;
+    m_scratch.clear();
+
+    bool opened  = false;
+    bool refused = false;
+    if (!m_client && stream == nullptr && this->is_idle(id)) {
+        if ((id & 1) == 0) [[unlikely]]
+            return http2_error_code::protocol_error;
+
+        m_last_stream_id = id;
+        refused          = m_streams.size() >= m_settings.max_concurrent_streams;
+        if (!refused) {
+            auto owned = std::make_unique<http2_stream>(http2_stream{
+                .id               = id,
+                .remote_closed    = false,
+                .reset            = false,
+                .dispatched       = false,
+                .headers_received = true,
+                .send_window      = m_peer_initial_window_size,
+                .receive_window   = m_settings.initial_window_size,
+                .waiter           = nullptr,
+                .request          = http2_request(),
+                .response         = http2_response(),
+            });
+
+            stream = owned.get();
+            stream->request.m_stream_id = id;
+            headers = &stream->request.m_headers;
+            m_streams.emplace(id, std::move(owned));
+            opened = true;
+        }
+    } else if (m_client && stream == nullptr && this->is_idle(id)) [[unlikely]] {
+        return http2_error_code::protocol_error;
+    }
+
+    auto result = m_decoder.decode(m_header_block, *headers, m_settings.max_header_list_size);
+    if (!result.has_value()) [[unlikely]]
+        return http2_error_code::compression_error;
+
+    if (stream == nullptr) {
+        // The stream is refused, or has already been closed or reset.
+        this->reset_stream(id, refused ? http2_error_code::refused_stream
+                                       : http2_error_code::stream_closed);
+        return http2_error_code::no_error;
+    }
+
+    if (stream->remote_closed) [[unlikely]] {
+        this->reset_stream(id, http2_error_code::stream_closed);
+        return http2_error_code::no_error;
+    }
+
+    if (opened) {
+        if (!is_valid_request(*headers)) [[unlikely]] {
+            this->reset_stream(id, http2_error_code::protocol_error);
+            return http2_error_code::no_error;
+        }
+    } else if (m_client && !stream->headers_received) {
+        // Response header block. Informational responses are skipped.
+        auto status = m_scratch.find(":status");
+
+        std::uint16_t code = 0;
+        if (status.has_value())
+            std::from_chars(status->data(), status->data() + status->size(), code);
+
+        if (code < 100 || code > 999) [[unlikely]] {
+            this->reset_stream(id, http2_error_code::protocol_error);
+            return http2_error_code::no_error;
+        }
+
+        if (code < 200)
+            return http2_error_code::no_error;
+
+        stream->headers_received  = true;
+        stream->response.m_status = code;
+        for (std::size_t i = 0; i < m_scratch.size(); ++i) {
+            if (!m_scratch.name(i).starts_with(':'))
+                stream->response.m_headers.add(m_scratch.name(i), m_scratch.value(i));
+        }
+    } else if (!m_header_end_stream) [[unlikely]] {
+        // Trailers must end the stream. Their fields are ignored.
+        this->reset_stream(id, http2_error_code::protocol_error);
+        return http2_error_code::no_error;
+    }
+
+    if (m_header_end_stream)
+        this->finish_stream(*stream);
+    return http2_error_code::no_error;
+}
+
+auto http2_connection::handle_settings(const http2_frame_header &header, std::string_view payload)
+    -> http2_error_code {
+    if (header.stream_id != 0) [[unlikely]]
+        return http2_error_code::protocol_error;
+
+    if (header.flags & http2_flag_ack) {
+        if (header.length != 0) [[unlikely]]
+            return http2_error_code::frame_size_error;
+        return http2_error_code::no_error;
+    }
+
+    if (header.length % 6 != 0) [[unlikely]]
+        return http2_error_code::frame_size_error;
+
+    m_settings_received = true;
+    for (std::size_t i = 0; i < payload.size(); i += 6) {
+        auto id    = static_cast<settings_id>((static_cast<std::uint8_t>(payload[i]) << 8) |
+                                              static_cast<std::uint8_t>(payload[i + 1]));
+        auto value = read_uint32(payload.data() + i + 2);
+
+        switch (id) {
+        case settings_id::header_table_size:
+            m_encoder.set_max_table_size(std::min<std::uint32_t>(value, 4096));
+            break;
+
+        case settings_id::enable_push:
+            if (value > 1) [[unlikely]]
+                return http2_error_code::protocol_error;
+            break;
+
+        case settings_id::max_concurrent_streams:
+            m_peer_max_concurrent_streams = value;
+            break;
+
+        case settings_id::initial_window_size: {
+            if (value > max_window_size) [[unlikely]]
+                return http2_error_code::flow_control_error;
+
+            // The change applies to the send windows of all existing streams.
+            std::int64_t delta = static_cast<std::int64_t>(value) - m_peer_initial_window_size;
+            for (auto &[stream_id, stream] : m_streams) {
+                stream->send_window += delta;
+                if (stream->send_window > max_window_size) [[unlikely]]
+                    return http2_error_code::flow_control_error;
+            }
+
+            m_peer_initial_window_size = value;
+            this->wake_streams();
+            break;
+        }
+
+        case settings_id::max_frame_size:
+            if (value < 16384 || value > 16777215) [[unlikely]]
+                return http2_error_code::protocol_error;
+            m_peer_max_frame_size = value;
+            break;
+
+        default:
+            // Maximum header list size is advisory. Unknown settings are ignored.
+            break;
+        }
+    }
+
+    this->queue_frame(http2_frame_type::settings, http2_flag_ack, 0, std::string_view());
+    return http2_error_code::no_error;
+}
+
+auto http2_connection::handle_window_update(const http2_frame_header &header,
+                                            std::string_view          payload) -> http2_error_code {
+    if (header.length != 4) [[unlikely]]
+        return http2_error_code::frame_size_error;
+
+    std::uint32_t increment = read_uint32(payload.data()) & 0x7FFFFFFF;
+    if (header.stream_id == 0) {
+        if (increment == 0) [[unlikely]]
+            return http2_error_code::protocol_error;
+
+        m_send_window += increment;
+        if (m_send_window > max_window_size) [[unlikely]]
+            return http2_error_code::flow_control_error;
+
+        this->wake_streams();
+        return http2_error_code::no_error;
+    }
+
+    auto iter = m_streams.find(header.stream_id);
+    if (iter == m_streams.end()) {
+        if (this->is_idle(header.stream_id)) [[unlikely]]
+            return http2_error_code::protocol_error;
+        return http2_error_code::no_error;
+    }
+
+    http2_stream &stream = *iter->second;
+    if (increment == 0) [[unlikely]] {
+        this->reset_stream(stream.id, http2_error_code::protocol_error);
+        return http2_error_code::no_error;
+    }
+
+    stream.send_window += increment;
+    if (stream.send_window > max_window_size) [[unlikely]] {
+        this->reset_stream(stream.id, http2_error_code::flow_control_error);
+        return http2_error_code::no_error;
+    }
+
+    wake(stream.waiter);
+    return http2_error_code::no_error;
+}
+
+auto http2_connection::is_idle(std::uint32_t id) const noexcept -> bool {
+    // Even streams are never opened since server push is not used.
+    if ((id & 1) == 0)
+        return true;
+    return m_client ? id >= m_next_stream_id : id > m_last_stream_id;
+}
+
+auto http2_connection::finish_stream(http2_stream &stream) -> void {
+    stream.remote_closed = true;
+    if (m_client) {
+        wake(stream.waiter);
+        return;
+    }
+
+    stream.dispatched = true;
+    m_ready.push_back(&stream);
+}
+
+auto http2_connection::reset_stream(std::uint32_t id, http2_error_code error) -> void {
+    std::string payload;
+    write_uint32(static_cast<std::uint32_t>(error), payload);
+    this->queue_frame(http2_frame_type::rst_stream, 0, id, payload);
+
+    auto iter = m_streams.find(id);
+    if (iter == m_streams.end())
+        return;
+
+    http2_stream &stream = *iter->second;
+    stream.reset         = true;
+    wake(stream.waiter);
+    if (!stream.dispatched)
+        m_streams.erase(iter);
+}
+
+auto http2_connection::queue_frame(http2_frame_type type,
+                                   std::uint8_t     flags,
+                                   std::uint32_t    stream_id,
+                                   std::string_view payload) -> void {
+    if (m_closed) [[unlikely]]
+        return;
+
+    write_http2_frame_header(
+        http2_frame_header{
+            .length    = static_cast<std::uint32_t>(payload.size()),
+            .type      = type,
+            .flags     = flags,
+            .stream_id = stream_id,
+        },
+        m_pending);
+
+    m_pending.append(payload);
+    wake(m_writer);
+}
+
+auto http2_connection::queue_window_update(std::uint32_t stream_id, std::uint32_t increment)
+    -> void {
+    std::string payload;
+    write_uint32(increment, payload);
+    this->queue_frame(http2_frame_type::window_update, 0, stream_id, payload);
+}
+
+auto http2_connection::queue_goaway(http2_error_code error) -> void {
+    std::string payload;
+    write_uint32(m_last_stream_id, payload);
+    write_uint32(static_cast<std::uint32_t>(error), payload);
+    this->queue_frame(http2_frame_type::goaway, 0, 0, payload);
+    this->close();
+}
+
+auto http2_connection::queue_headers(std::uint32_t    stream_id,
+                                     std::string_view block,
+                                     bool             end_stream) -> void {
+    auto type  = http2_frame_type::headers;
+    auto flags = static_cast<std::uint8_t>(end_stream ? http2_flag_end_stream : 0);
+
+    do {
+        std::size_t size = std::min<std::size_t>(block.size(), m_peer_max_frame_size);
+        if (size == block.size())
+            flags |= http2_flag_end_headers;
+
+        this->queue_frame(type, flags, stream_id, block.substr(0, size));
+        block.remove_prefix(size);
+
+        type  = http2_frame_type::continuation;
+        flags = 0;
+    } while (!block.empty());
+}
+
+auto http2_connection::send_body_async(http2_stream &stream, std::string_view body) noexcept
+    -> future<bool> {
+    while (!body.empty()) {
+        while (!m_closed && !stream.reset && (m_send_window <= 0 || stream.send_window <= 0))
+            co_await wait_awaitable(stream.waiter);
+
+        if (m_closed || stream.reset) [[unlikely]]
+            co_return false;
+
+        auto size = std::min<std::size_t>({
+            body.size(),
+            static_cast<std::size_t>(m_send_window),
+            static_cast<std::size_t>(stream.send_window),
+            m_peer_max_frame_size,
+        });
+
+        auto flags = static_cast<std::uint8_t>(size == body.size() ? http2_flag_end_stream : 0);
+        this->queue_frame(http2_frame_type::data, flags, stream.id, body.substr(0, size));
+        body.remove_prefix(size);
+
+        m_send_window      -= static_cast<std::int64_t>(size);
+        stream.send_window -= static_cast<std::int64_t>(size);
+    }
+
+    co_return true;
+}
+
+auto http2_connection::wake(promise_base *&waiter) noexcept -> void {
+    if (waiter == nullptr)
+        return;
+
+    io_context_worker::current()->post(waiter);
+    waiter = nullptr;
+}
+
+auto http2_connection::wake_streams() noexcept -> void {
+    for (auto &[id, stream] : m_streams)
+        wake(stream->waiter);
+}
+
+auto http2_client::connect_async(const inet_address &address,
+                                 std::string_view    authority,
+                                 http2_settings      settings) noexcept -> future<std::error_code> {
+    tcp_stream stream;
+
+    auto error = co_await stream.connect_async(address);
+    if (error.value() != 0) [[unlikely]]
+        co_return error;
+
+    stream.set_no_delay(true);
+    this->close();
+
+    m_connection = std::make_shared<http2_connection>(std::move(stream), true, settings,
+                                                      default_response_limit);
+    m_connection->set_authority(authority);
+
+    http2_connection::start(m_connection);
+    schedule(read_loop(m_connection));
+
+    co_return std::error_code();
+}
+
+auto http2_client::close() noexcept -> void {
+    if (m_connection == nullptr)
+        return;
+
+    m_connection->close(true);
+    m_connection.reset();
+}
+
+auto http2_client::request(std::shared_ptr<http2_connection> connection,
+                           std::string_view                  method,
+                           std::string_view                  path,
+                           std::string_view                  body) noexcept
+    -> future<std::expected<http2_response, std::error_code>> {
+    if (connection == nullptr) [[unlikely]]
+        co_return std::unexpected(std::make_error_code(std::errc::not_connected));
+    co_return co_await connection->request_async(method, path, body);
+}
+
+auto http2_client::read_loop(std::shared_ptr<http2_connection> connection) noexcept -> future<> {
+    while (true) {
+        auto error = co_await connection->receive_async();
+        if (error.value() != 0)
+            break;
+    }
+
+    connection->close();
+}
@@ -0,0 +1,544 @@
+#include "ossia/http_parser.hpp"
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#    include <emmintrin.h>
+#endif
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+using namespace ossia;
+
+/// \struct char_range
+/// \brief
+///   Inclusive range of bytes that terminates a scan.
+struct char_range {
+    std::uint8_t low;
+    std::uint8_t high;
+};
+
+/// \brief
+///   Bytes that are not allowed in tokens. Method and header field names are tokens. See RFC 9110
+///   section 5.6.2.
+static constexpr char_range token_delimiters[]{
+    {0x00, 0x20}, {0x22, 0x22}, {0x28, 0x29}, {0x2C, 0x2C}, {0x2F, 0x2F},
+    {0x3A, 0x40}, {0x5B, 0x5D}, {0x7B, 0x7B}, {0x7D, 0x7D}, {0x7F, 0xFF},
+};
+
+/// \brief
+///   Bytes that terminate request target. Whitespaces and control characters are not allowed in
+///   request target.
+static constexpr char_range target_delimiters[]{
+    {0x00, 0x20},
+    {0x7F, 0x7F},
+};
+
+/// \brief
+///   Bytes that terminate header field values. Control characters except horizontal tab are not
+///   allowed in field values, so CR and LF are also found here.
+static constexpr char_range value_delimiters[]{
+    {0x00, 0x08},
+    {0x0A, 0x1F},
+    {0x7F, 0x7F},
+};
+
+/// \brief
+///   Create a lookup table from byte ranges for scalar scanning.
+/// \tparam N
+///   Number of ranges.
+/// \param ranges
+///   Byte ranges to be marked in the lookup table.
+/// \return
+///   A lookup table that marks bytes in \p ranges as \c true.
+template <std::size_t N>
+[[nodiscard]]
+static constexpr auto make_table(const char_range (&ranges)[N]) noexcept -> std::array<bool, 256> {
+    std::array<bool, 256> table{};
+    for (const auto &range : ranges) {
+        for (unsigned c = range.low; c <= range.high; ++c)
+            table[c] = true;
+    }
+    return table;
+}
+
+static constexpr auto token_delimiter_table  = make_table(token_delimiters);
+static constexpr auto target_delimiter_table = make_table(target_delimiters);
+static constexpr auto value_delimiter_table  = make_table(value_delimiters);
+
+/// \brief
+///   Find the first byte in the specified byte ranges. Input is scanned 32 bytes at a time with
+///   AVX2 or 16 bytes at a time with SSE2 when available, and the tail is scanned with a lookup
+///   table.
+/// \tparam N
+///   Number of byte ranges.
+/// \param first
+///   Pointer to start of the data to be scanned.
+/// \param last
+///   Pointer to end of the data to be scanned.
+/// \param ranges
+///   Byte ranges to find.
+/// \param table
+///   Lookup table that is created from \p ranges.
+/// \return
+///   Pointer to the first byte in \p ranges. Return \p last if not found.
+template <std::size_t N>
+[[nodiscard]]
+static auto find_char(const char *first,
+                      const char *last,
+                      const char_range (&ranges)[N],
+                      const std::array<bool, 256> &table) noexcept -> const char * {
+#if defined(__AVX2__)
+    while (last - first >= 32) {
+        __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+        __m256i mask = _mm256_setzero_si256();
+
+        for (const auto &range : ranges) {
+            __m256i low    = _mm256_set1_epi8(static_cast<char>(range.low));
+            __m256i limit  = _mm256_set1_epi8(static_cast<char>(range.high - range.low));
+            __m256i offset = _mm256_sub_epi8(data, low);
+            __m256i match  = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, limit), offset);
+            mask           = _mm256_or_si256(mask, match);
+        }
+
+        auto bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(mask));
+        if (bits != 0)
+            return first + std::countr_zero(bits);
+
+        first += 32;
+    }
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    while (last - first >= 16) {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        __m128i mask = _mm_setzero_si128();
+
+        // Unsigned range check: (c - low) <= (high - low).
+        for (const auto &range : ranges) {
+            __m128i low    = _mm_set1_epi8(static_cast<char>(range.low));
+            __m128i limit  = _mm_set1_epi8(static_cast<char>(range.high - range.low));
+            __m128i offset = _mm_sub_epi8(data, low);
+            __m128i match  = _mm_cmpeq_epi8(_mm_min_epu8(offset, limit), offset);
+            mask           = _mm_or_si128(mask, match);
+        }
+
+        auto bits = static_cast<std::uint32_t>(_mm_movemask_epi8(mask));
+        if (bits != 0)
+            return first + std::countr_zero(bits);
+
+        first += 16;
+    }
+#else
+    static_cast<void>(ranges);
+#endif
+
+    while (first != last && !table[static_cast<std::uint8_t>(*first)])
+        ++first;
+
+    return first;
+}
+
+/// \brief
+///   Skip a line ending. Both CRLF and bare LF are accepted as line ending.
+/// \param first
+///   Pointer to start of the line ending.
+/// \param last
+///   Pointer to end of the buffer.
+/// \return
+///   Pointer to the byte after the line ending if succeeded. Otherwise, return an
+///   \c http_parse_error that represents the parse error.
+[[nodiscard]]
+static auto skip_line_end(const char *first, const char *last) noexcept
+    -> std::expected<const char *, http_parse_error> {
+    if (first == last)
+        return std::unexpected(http_parse_error::incomplete);
+
+    if (*first == '\n')
+        return first + 1;
+
+    if (*first != '\r')
+        return std::unexpected(http_parse_error::invalid);
+
+    if (last - first < 2)
+        return std::unexpected(http_parse_error::incomplete);
+
+    if (first[1] != '\n')
+        return std::unexpected(http_parse_error::invalid);
+
+    return first + 2;
+}
+
+/// \brief
+///   Convert an ASCII character into lower case.
+/// \param c
+///   The character to be converted.
+/// \return
+///   Lower case of \p c if \p c is an upper case ASCII letter. Otherwise, return \p c as is.
+[[nodiscard]]
+static constexpr auto to_lower(char c) noexcept -> char {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+}
+
+/// \brief
+///   Checks if a string equals to a lower-case ASCII string case-insensitively.
+/// \param value
+///   The string to be compared.
+/// \param lower
+///   The lower-case string to be compared with.
+/// \retval true
+///   The two strings are equal.
+/// \retval false
+///   The two strings are not equal.
+[[nodiscard]]
+static auto equals_ignore_case(std::string_view value, std::string_view lower) noexcept -> bool {
+    if (value.size() != lower.size())
+        return false;
+
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (to_lower(value[i]) != lower[i])
+            return false;
+    }
+
+    return true;
+}
+
+/// \brief
+///   Parse a decimal \c Content-Length value.
+/// \param value
+///   The header field value.
+/// \return
+///   The parsed value if succeeded. Otherwise, return \c std::nullopt.
+[[nodiscard]]
+static auto parse_content_length(std::string_view value) noexcept -> std::optional<std::uint64_t> {
+    if (value.empty())
+        return std::nullopt;
+
+    std::uint64_t result = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9')
+            return std::nullopt;
+
+        if (result > (std::numeric_limits<std::uint64_t>::max() - 9) / 10) [[unlikely]]
+            return std::nullopt;
+
+        result = result * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+
+    return result;
+}
+
+auto http_request::header(std::string_view name) const noexcept -> std::optional<std::string_view> {
+    for (std::uint32_t i = 0; i < m_header_count; ++i) {
+        std::string_view field = m_headers[i].name;
+        if (field.size() != name.size())
+            continue;
+
+        bool match = true;
+        for (std::size_t j = 0; j < name.size() && match; ++j)
+            match = (to_lower(field[j]) == to_lower(name[j]));
+
+        if (match)
+            return m_headers[i].value;
+    }
+
+    return std::nullopt;
+}
+
+auto ossia::parse_http_request(std::string_view data, http_request &request) noexcept
+    -> std::expected<std::size_t, http_parse_error> {
+    const char *const begin = data.data();
+    const char *const end   = begin + data.size();
+    const char       *p     = begin;
+
+    // Ignore empty lines before the request line. See RFC 9112 section 2.2.
+    while (p != end && (*p == '\r' || *p == '\n'))
+        ++p;
+
+    { // Method.
+        const char *method = p;
+        p                  = find_char(p, end, token_delimiters, token_delimiter_table);
+        if (p == end)
+            return std::unexpected(http_parse_error::incomplete);
+        if (p == method || *p != ' ')
+            return std::unexpected(http_parse_error::invalid);
+
+        request.m_method = std::string_view(method, p);
+        ++p;
+    }
+
+    { // Request target.
+        const char *target = p;
+        p                  = find_char(p, end, target_delimiters, target_delimiter_table);
+        if (p == end)
+            return std::unexpected(http_parse_error::incomplete);
+        if (p == target || *p != ' ')
+            return std::unexpected(http_parse_error::invalid);
+
+        request.m_target = std::string_view(target, p);
+        ++p;
+    }
+
+    { // HTTP version.
+        constexpr std::string_view prefix = "HTTP/1.";
+
+        auto available = static_cast<std::size_t>(end - p);
+        if (available <= prefix.size()) {
+            if (std::memcmp(p, prefix.data(), available) != 0)
+                return std::unexpected(http_parse_error::invalid);
+            return std::unexpected(http_parse_error::incomplete);
+        }
+
+        if (std::memcmp(p, prefix.data(), prefix.size()) != 0)
+            return std::unexpected(http_parse_error::invalid);
+
+        char minor = p[prefix.size()];
+        if (minor < '0' || minor > '9')
+            return std::unexpected(http_parse_error::invalid);
+
+        request.m_minor_version = minor - '0';
+        p += prefix.size() + 1;
+
+        auto next = skip_line_end(p, end);
+        if (!next.has_value())
+            return std::unexpected(next.error());
+
+        p = *next;
+    }
+
+    request.m_header_count   = 0;
+    request.m_content_length = 0;
+    request.m_is_chunked     = false;
+    request.m_body           = std::string_view();
+
+    bool has_content_length    = false;
+    bool has_transfer_encoding = false;
+    bool has_close             = false;
+    bool has_keep_alive        = false;
+
+    while (true) {
+        if (p == end)
+            return std::unexpected(http_parse_error::incomplete);
+
+        // Empty line terminates the header section.
+        if (*p == '\r' || *p == '\n') {
+            auto next = skip_line_end(p, end);
+            if (!next.has_value())
+                return std::unexpected(next.error());
+
+            p = *next;
+            break;
+        }
+
+        if (request.m_header_count == http_request::max_headers) [[unlikely]]
+            return std::unexpected(http_parse_error::too_many_headers);
+
+        // Field name. Whitespaces between field name and colon and obsolete line folding are
+        // rejected here. See RFC 9112 section 5.
+        const char *name = p;
+        p                = find_char(p, end, token_delimiters, token_delimiter_table);
+        if (p == end)
+            return std::unexpected(http_parse_error::incomplete);
+        if (p == name || *p != ':')
+            return std::unexpected(http_parse_error::invalid);
+
+        std::string_view field_name(name, p);
+        ++p;
+
+        // Field value without leading and trailing whitespaces.
+        while (p != end && (*p == ' ' || *p == '\t'))
+            ++p;
+
+        const char *value = p;
+        p                 = find_char(p, end, value_delimiters, value_delimiter_table);
+        if (p == end)
+            return std::unexpected(http_parse_error::incomplete);
+
+        const char *value_end = p;
+        while (value_end != value && (value_end[-1] == ' ' || value_end[-1] == '\t'))
+            --value_end;
+
+        auto next = skip_line_end(p, end);
+        if (!next.has_value())
+            return std::unexpected(next.error());
+
+        p = *next;
+
+        std::string_view field_value(value, value_end);
+        request.m_headers[request.m_header_count++] = http_header{field_name, field_value};
+
+        // Header fields that affect message framing and connection management.
+        if (equals_ignore_case(field_name, "content-length")) {
+            auto length = parse_content_length(field_value);
+            if (!length.has_value())
+                return std::unexpected(http_parse_error::invalid);
+            if (has_content_length && *length != request.m_content_length)
+                return std::unexpected(http_parse_error::invalid);
+
+            has_content_length       = true;
+            request.m_content_length = *length;
+        } else if (equals_ignore_case(field_name, "transfer-encoding")) {
+            if (has_transfer_encoding || !equals_ignore_case(field_value, "chunked"))
+                return std::unexpected(http_parse_error::unsupported_transfer_coding);
+
+            has_transfer_encoding = true;
+            request.m_is_chunked  = true;
+        } else if (equals_ignore_case(field_name, "connection")) {
+            std::string_view options = field_value;
+            while (!options.empty()) {
+                std::size_t      comma  = options.find(',');
+                std::string_view option = options.substr(0, comma);
+                options = (comma == std::string_view::npos) ? std::string_view()
+                                                            : options.substr(comma + 1);
+
+                while (!option.empty() && (option.front() == ' ' || option.front() == '\t'))
+                    option.remove_prefix(1);
+                while (!option.empty() && (option.back() == ' ' || option.back() == '\t'))
+                    option.remove_suffix(1);
+
+                has_close      = has_close || equals_ignore_case(option, "close");
+                has_keep_alive = has_keep_alive || equals_ignore_case(option, "keep-alive");
+            }
+        }
+    }
+
+    // A message with both Transfer-Encoding and Content-Length may be a request smuggling attack.
+    // See RFC 9112 section 6.1.
+    if (has_transfer_encoding && has_content_length)
+        return std::unexpected(http_parse_error::invalid);
+
+    if (request.m_minor_version >= 1)
+        request.m_keep_alive = !has_close;
+    else
+        request.m_keep_alive = has_keep_alive && !has_close;
+
+    return static_cast<std::size_t>(p - begin);
+}
+
+/// \brief
+///   Convert a hexadecimal digit into its value.
+/// \param c
+///   The character to be converted.
+/// \return
+///   Value of the hexadecimal digit. Return -1 if \p c is not a hexadecimal digit.
+[[nodiscard]]
+static constexpr auto hex_value(char c) noexcept -> int {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/// \brief
+///   Walk through a chunked body. The buffer is only modified when \p Decode is \c true.
+/// \tparam Decode
+///   Whether to move chunk data to the beginning of the buffer.
+/// \param[in, out] data
+///   Buffer that starts with the chunked body.
+/// \return
+///   Size of the encoded and decoded body if succeeded. Otherwise, return an \c http_parse_error
+///   that represents the parse error.
+template <bool Decode>
+[[nodiscard]]
+static auto walk_chunked(std::span<char> data) noexcept
+    -> std::expected<http_chunked_result, http_parse_error> {
+    char *const       begin  = data.data();
+    const char *const end    = begin + data.size();
+    const char       *p      = begin;
+    std::size_t       output = 0;
+
+    while (true) {
+        // Chunk size.
+        std::uint64_t size   = 0;
+        const char   *digits = p;
+        for (int value; p != end && (value = hex_value(*p)) >= 0; ++p) {
+            if (size > (std::numeric_limits<std::uint64_t>::max() >> 4)) [[unlikely]]
+                return std::unexpected(http_parse_error::invalid);
+            size = (size << 4) | static_cast<std::uint64_t>(value);
+        }
+
+        if (p == end)
+            return std::unexpected(http_parse_error::incomplete);
+        if (p == digits)
+            return std::unexpected(http_parse_error::invalid);
+
+        // Chunk extensions are ignored.
+        if (*p == ';' || *p == ' ' || *p == '\t') {
+            p = find_char(p, end, value_delimiters, value_delimiter_table);
+            if (p == end)
+                return std::unexpected(http_parse_error::incomplete);
+        }
+
+        auto next = skip_line_end(p, end);
+        if (!next.has_value())
+            return std::unexpected(next.error());
+
+        p = *next;
+
+        // Last chunk.
+        if (size == 0)
+            break;
+
+        if (static_cast<std::uint64_t>(end - p) < size)
+            return std::unexpected(http_parse_error::incomplete);
+
+        if constexpr (Decode)
+            std::memmove(begin + output, p, static_cast<std::size_t>(size));
+
+        p += size;
+        output += static_cast<std::size_t>(size);
+
+        next = skip_line_end(p, end);
+        if (!next.has_value())
+            return std::unexpected(next.error());
+
+        p = *next;
+    }
+
+    // Trailer section is ignored.
+    while (true) {
+        if (p == end)
+            return std::unexpected(http_parse_error::incomplete);
+
+        if (*p == '\r' || *p == '\n') {
+            auto next = skip_line_end(p, end);
+            if (!next.has_value())
+                return std::unexpected(next.error());
+
+            p = *next;
+            break;
+        }
+
+        p = find_char(p, end, value_delimiters, value_delimiter_table);
+        if (p == end)
+            return std::unexpected(http_parse_error::incomplete);
+
+        auto next = skip_line_end(p, end);
+        if (!next.has_value())
+            return std::unexpected(next.error());
+
+        p = *next;
+    }
+
+    return http_chunked_result{
+        .consumed = static_cast<std::size_t>(p - begin),
+        .size     = output,
+    };
+}
+
+auto ossia::decode_http_chunked(std::span<char> data) noexcept
+    -> std::expected<http_chunked_result, http_parse_error> {
+    // Validate the whole chunked body before modifying the buffer so that incomplete bodies could
+    // be parsed again once more data is received.
+    auto result = walk_chunked<false>(data);
+    if (!result.has_value())
+        return result;
+
+    return walk_chunked<true>(data);
+}
@@ -0,0 +1,223 @@
+#include "ossia/http_server.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+/// \brief
+///   Get reason phrase of the specified status code.
+/// \param status
+///   The status code.
+/// \return
+///   Reason phrase of the status code. An empty string is returned for unknown status codes.
+[[nodiscard]]
+static auto reason_phrase(std::uint16_t status) noexcept -> std::string_view {
+    switch (status) {
+    case 100: return "Continue";
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 303: return "See Other";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 412: return "Precondition Failed";
+    case 413: return "Content Too Large";
+    case 414: return "URI Too Long";
+    case 415: return "Unsupported Media Type";
+    case 416: return "Range Not Satisfiable";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    case 505: return "HTTP Version Not Supported";
+    default:  return "";
+    }
+}
+
+/// \brief
+///   Append status line of an HTTP/1.1 response to the output buffer.
+/// \param status
+///   Status code of the response.
+/// \param[out] output
+///   The output buffer.
+static auto write_status_line(std::uint16_t status, std::string &output) -> void {
+    char code[3]{
+        static_cast<char>('0' + status / 100 % 10),
+        static_cast<char>('0' + status / 10 % 10),
+        static_cast<char>('0' + status % 10),
+    };
+
+    output.append("HTTP/1.1 ");
+    output.append(code, sizeof(code));
+    output.push_back(' ');
+    output.append(reason_phrase(status));
+    output.append("\r\n");
+}
+
+/// \brief
+///   Append \c Content-Length header field to the output buffer.
+/// \param length
+///   Length in byte of the body.
+/// \param[out] output
+///   The output buffer.
+static auto write_content_length(std::size_t length, std::string &output) -> void {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), length);
+
+    output.append("Content-Length: ");
+    output.append(buffer, result.ptr);
+    output.append("\r\n");
+}
+
+http_input::http_input(std::size_t capacity, std::size_t limit)
+    : m_data(std::make_unique_for_overwrite<char[]>(capacity)),
+      m_begin(),
+      m_end(),
+      m_capacity(capacity),
+      m_limit(limit) {}
+
+auto http_input::next(http_request &request) noexcept -> std::expected<std::size_t, std::uint16_t> {
+    char       *data = m_data.get() + m_begin;
+    std::size_t size = m_end - m_begin;
+
+    if (size == 0)
+        return 0;
+
+    auto header = parse_http_request(std::string_view(data, size), request);
+    if (!header.has_value()) {
+        switch (header.error()) {
+        case http_parse_error::incomplete:
+            // The request could never be completed without exceeding the limit.
+            if (size >= m_limit) [[unlikely]]
+                return std::unexpected(431);
+            return 0;
+
+        case http_parse_error::too_many_headers:            return std::unexpected(431);
+        case http_parse_error::unsupported_transfer_coding: return std::unexpected(501);
+        case http_parse_error::invalid:                     return std::unexpected(400);
+        }
+
+        return std::unexpected(400);
+    }
+
+    if (request.is_chunked()) {
+        auto body = decode_http_chunked(std::span<char>(data + *header, size - *header));
+        if (!body.has_value()) {
+            if (body.error() != http_parse_error::incomplete)
+                return std::unexpected(400);
+            if (size >= m_limit) [[unlikely]]
+                return std::unexpected(413);
+            return 0;
+        }
+
+        request.set_body(std::string_view(data + *header, body->size));
+        return *header + body->consumed;
+    }
+
+    if (request.content_length() > m_limit - *header) [[unlikely]]
+        return std::unexpected(413);
+
+    auto length = static_cast<std::size_t>(request.content_length());
+    if (size - *header < length)
+        return 0;
+
+    request.set_body(std::string_view(data + *header, length));
+    return *header + length;
+}
+
+auto http_input::prepare() -> void {
+    // Move unhandled data to the beginning of the buffer.
+    if (m_begin != 0) {
+        std::memmove(m_data.get(), m_data.get() + m_begin, m_end - m_begin);
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+
+    // Grow the buffer if it is full.
+    if (m_end == m_capacity && m_capacity < m_limit) {
+        std::size_t capacity = std::min(m_capacity * 2, m_limit);
+        auto        data     = std::make_unique_for_overwrite<char[]>(capacity);
+
+        std::memcpy(data.get(), m_data.get(), m_end);
+        m_data     = std::move(data);
+        m_capacity = capacity;
+    }
+}
+
+auto http_input::reset(std::size_t max_capacity, std::size_t capacity) -> void {
+    m_begin = 0;
+    m_end   = 0;
+
+    if (m_capacity > max_capacity) [[unlikely]] {
+        m_data     = std::make_unique_for_overwrite<char[]>(capacity);
+        m_capacity = capacity;
+    }
+}
+
+auto http_connection::recycle() noexcept -> bool {
+    // Release large buffers kept by large requests.
+    try {
+        input.reset(std::max(buffer_size, max_retained_buffer), buffer_size);
+    } catch (...) {
+        return false;
+    }
+
+    if (response.body().capacity() > max_retained_buffer)
+        std::string().swap(response.body());
+    if (output.capacity() > max_retained_buffer)
+        std::string().swap(output);
+
+    response.clear();
+    output.clear();
+    return true;
+}
+
+auto detail::write_http_response(const http_request  &request,
+                                 const http_response &response,
+                                 std::string         &output) -> void {
+    std::uint16_t status = response.status();
+
+    write_status_line(status, output);
+
+    // 1xx, 204 and 304 responses never have a body.
+    bool has_body = !(status < 200 || status == 204 || status == 304);
+    if (has_body)
+        write_content_length(response.body().size(), output);
+
+    if (!response.keep_alive())
+        output.append("Connection: close\r\n");
+    else if (request.minor_version() == 0)
+        output.append("Connection: keep-alive\r\n");
+
+    output.append(response.headers());
+    output.append("\r\n");
+
+    if (has_body && request.method() != "HEAD")
+        output.append(response.body());
+}
+
+auto detail::write_http_error(std::uint16_t status, std::string &output) -> void {
+    write_status_line(status, output);
+    write_content_length(0, output);
+    output.append("Connection: close\r\n\r\n");
+}
@@ -0,0 +1,105 @@
+#include "ossia/huge_page.hpp"
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <Windows.h>
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <sys/mman.h>
+#endif
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+using namespace ossia;
+
+huge_page_buffer::huge_page_buffer(std::size_t size) : m_data(), m_size(), m_is_huge_page() {
+    size = (size + huge_page_size - 1) & ~(huge_page_size - 1);
+    if (size == 0) [[unlikely]]
+        size = huge_page_size;
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    // Large pages require SeLockMemoryPrivilege and may not be available.
+    SIZE_T large_page = GetLargePageMinimum();
+    if (large_page != 0 && size % large_page == 0) {
+        m_data = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                              PAGE_READWRITE);
+        if (m_data != nullptr) {
+            m_size         = size;
+            m_is_huge_page = true;
+            return;
+        }
+    }
+
+    m_data = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (m_data == nullptr) [[unlikely]]
+        throw std::bad_alloc();
+
+    m_size = size;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    // Huge pages must be reserved by the administrator in /proc/sys/vm/nr_hugepages.
+    void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+        m_data         = data;
+        m_size         = size;
+        m_is_huge_page = true;
+        return;
+    }
+
+    // Over-allocate normal pages so that the buffer could be aligned to the huge page size, which
+    // is required for the kernel to back it with transparent huge pages.
+    std::size_t reserved = size + huge_page_size;
+    data = ::mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) [[unlikely]]
+        throw std::bad_alloc();
+
+    auto start   = reinterpret_cast<std::uintptr_t>(data);
+    auto aligned = (start + huge_page_size - 1) & ~(huge_page_size - 1);
+
+    if (aligned != start)
+        ::munmap(data, aligned - start);
+    if (std::size_t tail = reserved - (aligned - start) - size; tail != 0)
+        ::munmap(reinterpret_cast<void *>(aligned + size), tail);
+
+    m_data = reinterpret_cast<void *>(aligned);
+    m_size = size;
+
+    // Transparent huge pages are best effort. Failure is not an error.
+    ::madvise(m_data, m_size, MADV_HUGEPAGE);
+#endif
+}
+
+huge_page_buffer::~huge_page_buffer() {
+    if (m_data == nullptr)
+        return;
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    VirtualFree(m_data, 0, MEM_RELEASE);
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    ::munmap(m_data, m_size);
+#endif
+}
+
+auto huge_page_buffer::operator=(huge_page_buffer &&other) noexcept -> huge_page_buffer & {
+    if (this == &other) [[unlikely]]
+        return *this;
+
+    { // Release current buffer.
+        huge_page_buffer discard(std::move(*this));
+    }
+
+    m_data               = other.m_data;
+    m_size               = other.m_size;
+    m_is_huge_page       = other.m_is_huge_page;
+    other.m_data         = nullptr;
+    other.m_size         = 0;
+    other.m_is_huge_page = false;
+
+    return *this;
+}
@@ -10,13 +10,23 @@
 #    include <WinSock2.h>
 #    include <Windows.h>
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <dirent.h>
+#    include <fcntl.h>
 #    include <liburing.h>
+#    include <sched.h>
+#    include <sys/eventfd.h>
 #    include <sys/utsname.h>
+#    include <unistd.h>
 #else
 #    error "Unsupported operating system"
 #endif
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
 #include <system_error>
 #include <thread>
 
@@ -27,7 +37,44 @@ using namespace ossia::detail;
 ///   Current worker for the calling thread.
 static thread_local io_context_worker *current_worker;
 
+/// \brief
+///   Function called by workers at the start of each iteration. See \c set_iteration_hook.
+static std::atomic<void (*)() noexcept> iteration_hook;
+
+auto ossia::detail::set_iteration_hook(void (*hook)() noexcept) noexcept -> void {
+    iteration_hook.store(hook, std::memory_order_release);
+}
+
+/// \brief
+///   Call the iteration hook if any.
+static auto run_iteration_hook() noexcept -> void {
+    if (auto *hook = iteration_hook.load(std::memory_order_acquire); hook != nullptr)
+        hook();
+}
+
+/// \brief
+///   Indices of submission counters of workers.
+enum submission_counter {
+    pending_count,
+    overflowed_count,
+    rejected_count,
+};
+
 #if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+static_assert(sizeof(kernel_timespec) == sizeof(__kernel_timespec));
+static_assert(offsetof(kernel_timespec, seconds) == offsetof(__kernel_timespec, tv_sec));
+static_assert(offsetof(kernel_timespec, nanoseconds) == offsetof(__kernel_timespec, tv_nsec));
+static_assert(sizeof(submission_entry) == sizeof(io_uring_sqe));
+static_assert(alignof(submission_entry) >= alignof(io_uring_sqe));
+
+/// \brief
+///   Maximum number of submission queue entries supported by the kernel.
+inline constexpr std::uint32_t max_submission_queue_entries = 32768;
+
+/// \brief
+///   Maximum number of completion queue entries supported by the kernel.
+inline constexpr std::uint32_t max_completion_queue_entries = 2 * 32768;
+
 /// \brief
 ///   Create an unsigned int that represents a version number.
 /// \param major
@@ -121,44 +168,221 @@ auto io_uring_setup_features() noexcept -> std::uint32_t {
 
     return features;
 }
+
+/// \brief
+///   Create \c io_uring setup parameters.
+/// \param flags
+///   \c io_uring setup flags.
+/// \param cq_entries
+///   Number of completion queue entries.
+/// \param wq_fd
+///   File descriptor of the ring to share the async worker backend with.
+/// \return
+///   The \c io_uring setup parameters.
+[[nodiscard]]
+static auto make_io_uring_params(std::uint32_t flags,
+                                 std::uint32_t cq_entries,
+                                 std::uint32_t wq_fd) noexcept -> io_uring_params {
+    return io_uring_params{
+        .sq_entries     = 0,
+        .cq_entries     = cq_entries,
+        .flags          = flags | IORING_SETUP_CQSIZE,
+        .sq_thread_cpu  = 0,
+        .sq_thread_idle = 0,
+        .features       = io_uring_setup_features(),
+        .wq_fd          = wq_fd,
+        .resv           = {},
+        .sq_off         = {},
+        .cq_off         = {},
+    };
+}
+
+/// \brief
+///   Get size in byte of memory required by \c IORING_SETUP_NO_MMAP rings. Submission queue
+///   entries are placed at the start of the memory and followed by the rings, so that each of them
+///   is placed in its own huge page.
+/// \param sq_entries
+///   Number of submission queue entries.
+/// \param cq_entries
+///   Number of completion queue entries.
+/// \return
+///   Size in byte of memory required by the rings.
+[[nodiscard]]
+static auto ring_memory_size(std::uint32_t sq_entries, std::uint32_t cq_entries) noexcept
+    -> std::size_t {
+    // The kernel rounds the number of entries up to power of 2.
+    std::size_t sqes  = std::bit_ceil(sq_entries) * sizeof(io_uring_sqe);
+    std::size_t rings = 4096 + std::bit_ceil(sq_entries) * sizeof(std::uint32_t) +
+                        std::bit_ceil(cq_entries) * sizeof(io_uring_cqe);
+
+    sqes = (sqes + huge_page_buffer::huge_page_size - 1) & ~(huge_page_buffer::huge_page_size - 1);
+    return sqes + rings;
+}
+
+/// \brief
+///   Checks if \c IORING_OP_FIXED_FD_INSTALL is supported by the kernel.
+/// \param[in] ring
+///   The \c io_uring to probe.
+[[nodiscard]]
+static auto fixed_fd_install_supported(io_uring *ring) noexcept -> bool {
+    // io_uring_prep_fixed_fd_install is available since liburing 2.6.
+#    if defined(IO_URING_VERSION_MAJOR) &&                                                         \
+        (IO_URING_VERSION_MAJOR * 100 + IO_URING_VERSION_MINOR >= 206)
+    bool            result = false;
+    io_uring_probe *probe  = io_uring_get_probe_ring(ring);
+    if (probe != nullptr) {
+        result = io_uring_opcode_supported(probe, IORING_OP_FIXED_FD_INSTALL);
+        io_uring_free_probe(probe);
+    }
+
+    return result;
+#    else
+    (void)ring;
+    return false;
+#    endif
+}
 #endif
 
-io_context_worker::io_context_worker()
+io_context_worker::io_context_worker() : io_context_worker(io_context_options{}, nullptr) {}
+
+io_context_worker::io_context_worker(const io_context_options &options,
+                                     const io_context_worker  *backend)
     : m_is_running(),
       m_thread_id(),
       m_muxer(),
       m_tasks(),
+      m_poll_handle(invalid_poll_handle),
+      m_async_worker_cpus(options.async_worker_cpus),
+      m_configured_thread(),
+      m_async_worker_limits(),
+      m_ring_memory(),
+      m_buffer_memory(),
+      m_buffer_size(options.registered_buffer_size),
+      m_free_buffers(),
+      m_available_buffers(),
+      m_free_descriptors(),
+      m_completion_batch(options.max_completion_batch == 0 ? SIZE_MAX
+                                                           : options.max_completion_batch),
+      m_largest_completion_batch(),
+      m_overflow_policy(options.submission_overflow),
+      m_overflow(),
+      m_submission_counters(),
+      m_completion_overflows(),
+      m_timers(),
+      m_shedding_target(std::max(options.shedding_target,
+                                 std::chrono::steady_clock::duration::zero())),
+      m_shedding_interval(options.shedding_interval),
+      m_overload_deadline(),
+      m_overloaded(),
+      m_queue_delay(),
+      m_overload_events(),
+      m_shed_requests(),
+      m_paused_accepts(),
+      m_admission_waiters(),
       m_should_stop() {
     m_tasks.reserve(64);
 
+    if (options.registered_buffer_count != 0) {
+        std::size_t size = static_cast<std::size_t>(options.registered_buffer_count) *
+                           options.registered_buffer_size;
+        m_buffer_memory  = huge_page_buffer(size);
+
+        // Buffers are acquired from the back. Hand out lower indices first.
+        m_free_buffers.reserve(options.registered_buffer_count);
+        for (std::uint32_t i = options.registered_buffer_count; i != 0; --i)
+            m_free_buffers.push_back(i - 1);
+        m_available_buffers.store(options.registered_buffer_count, std::memory_order_relaxed);
+    }
+
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     m_muxer = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
     if (m_muxer == nullptr) [[unlikely]]
         throw std::system_error(GetLastError(), std::system_category(), "Failed to create IOCP");
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    std::uint32_t flags = io_uring_setup_flags();
+    std::uint32_t wq_fd = 0;
+
+    // Share the async worker backend of another ring.
+    if (backend != nullptr && options.share_async_workers) {
+        flags |= IORING_SETUP_ATTACH_WQ;
+        wq_fd  = static_cast<std::uint32_t>(static_cast<io_uring *>(backend->m_muxer)->ring_fd);
+    }
+
+    // Clamp entries to kernel limits so that the ring memory matches sizes used by the kernel.
+    std::uint32_t sq_entries = std::clamp<std::uint32_t>(options.submission_queue_entries, 1,
+                                                         max_submission_queue_entries);
+    std::uint32_t cq_entries = static_cast<std::uint32_t>(
+        std::min<std::uint64_t>(std::uint64_t(sq_entries) * options.completion_queue_factor,
+                                max_completion_queue_entries));
+    cq_entries = std::max(cq_entries, sq_entries);
+
+    huge_page_buffer ring_memory;
+    if (options.huge_page_rings)
+        ring_memory = huge_page_buffer(ring_memory_size(sq_entries, cq_entries));
+
     io_uring *ring = static_cast<io_uring *>(std::malloc(sizeof(io_uring)));
     assert(ring != nullptr);
 
-    io_uring_params params{
-        .sq_entries     = 0,
-        .cq_entries     = 0,
-        .flags          = io_uring_setup_flags(),
-        .sq_thread_cpu  = 0,
-        .sq_thread_idle = 0,
-        .features       = io_uring_setup_features(),
-        .wq_fd          = 0,
-        .resv           = {},
-        .sq_off         = {},
-        .cq_off         = {},
-    };
+    io_uring_params params = make_io_uring_params(flags, cq_entries, wq_fd);
+    int             result = -EINVAL;
+
+    // Older kernels only accept physically contiguous memory for rings. Fall back to rings mapped
+    // by the kernel if the memory is rejected.
+    if (ring_memory.data() != nullptr) {
+        params.flags |= IORING_SETUP_NO_MMAP;
+        result        = io_uring_queue_init_mem(sq_entries, ring, &params, ring_memory.data(),
+                                                ring_memory.size());
+        if (result >= 0)
+            m_ring_memory = std::move(ring_memory);
+        else
+            params = make_io_uring_params(flags, cq_entries, wq_fd);
+    }
+
+    if (result < 0)
+        result = io_uring_queue_init_params(sq_entries, ring, &params);
 
-    int result = io_uring_queue_init_params(32768, ring, &params);
-    if (result != 0) [[unlikely]] {
+    if (result < 0) [[unlikely]] {
         std::free(ring);
         throw std::system_error(-result, std::system_category(), "Failed to create io_uring");
     }
 
+    // Limits are stored in the ring and applied to every thread that submits to it. Kernels
+    // before 5.15 do not support this and keep their defaults.
+    if (options.max_bounded_async_workers != 0 || options.max_unbounded_async_workers != 0) {
+        unsigned int values[2]{options.max_bounded_async_workers,
+                               options.max_unbounded_async_workers};
+        io_uring_register_iowq_max_workers(ring, values);
+    }
+
     m_muxer = ring;
+
+    if (options.registered_buffer_count != 0) {
+        std::vector<iovec> buffers(options.registered_buffer_count);
+        for (std::uint32_t i = 0; i < options.registered_buffer_count; ++i) {
+            buffers[i].iov_base = static_cast<std::byte *>(m_buffer_memory.data()) +
+                                  static_cast<std::size_t>(i) * options.registered_buffer_size;
+            buffers[i].iov_len  = options.registered_buffer_size;
+        }
+
+        result = io_uring_register_buffers(ring, buffers.data(),
+                                           static_cast<unsigned>(buffers.size()));
+        if (result < 0) [[unlikely]] {
+            io_uring_queue_exit(ring);
+            std::free(ring);
+            throw std::system_error(-result, std::system_category(),
+                                    "Failed to register buffers");
+        }
+    }
+
+    // Direct descriptors are only useful if they could be installed as regular descriptors, so
+    // that accepted connections work with all IO operations. Accepts fall back to regular
+    // descriptors if the table is not registered.
+    if (options.direct_descriptor_count != 0 && fixed_fd_install_supported(ring) &&
+        io_uring_register_files_sparse(ring, options.direct_descriptor_count) == 0) {
+        m_free_descriptors.reserve(options.direct_descriptor_count);
+        for (std::uint32_t i = options.direct_descriptor_count; i != 0; --i)
+            m_free_descriptors.push_back(i - 1);
+    }
 #endif
 }
 
@@ -167,110 +391,264 @@ io_context_worker::~io_context_worker() {
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     CloseHandle(m_muxer);
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
-    io_uring *ring = static_cast<io_uring *>(std::malloc(sizeof(io_uring)));
+    io_uring *ring = static_cast<io_uring *>(m_muxer);
+    if (m_buffer_memory.data() != nullptr)
+        io_uring_unregister_buffers(ring);
+
+    if (m_poll_handle != invalid_poll_handle) {
+        io_uring_unregister_eventfd(ring);
+        ::close(static_cast<int>(m_poll_handle));
+    }
+
     io_uring_queue_exit(ring);
     std::free(ring);
 #endif
 }
 
-auto io_context_worker::run() noexcept -> void {
-    if (m_is_running.exchange(true, std::memory_order_relaxed)) [[unlikely]]
-        return;
+/// \brief
+///   Hint the CPU to fetch the cache line at \p address. Overlapped structures and promises live
+///   in coroutine frames scattered over the heap, so they are usually cold when completions are
+///   handled.
+/// \param[in] address
+///   Address to prefetch.
+static auto prefetch(const void *address) noexcept -> void {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
 
-    current_worker = this;
+/// \brief
+///   Resume tasks and release finished coroutine stacks. \p tasks is cleared after all tasks are
+///   resumed.
+/// \param[in, out] tasks
+///   Tasks to be resumed.
+/// \param[out] last_resume
+///   Time at which the last task is resumed. The clock is only read if this is not \c nullptr.
+static auto resume_tasks(std::vector<promise_base *>           &tasks,
+                         std::chrono::steady_clock::time_point *last_resume = nullptr) noexcept
+    -> void {
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        // Fetch the next promise while the current coroutine is running.
+        if (i + 1 < tasks.size())
+            prefetch(tasks[i + 1]);
+        else if (last_resume != nullptr)
+            *last_resume = std::chrono::steady_clock::now();
+
+        const promise_base *task         = tasks[i];
+        promise_base       &stack_bottom = task->stack_bottom();
+        task->coroutine().resume();
+        if (stack_bottom.coroutine().done())
+            stack_bottom.release();
+    }
 
-#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
-    m_should_stop.store(false, std::memory_order_relaxed);
-    m_thread_id.store(GetCurrentThreadId(), std::memory_order_relaxed);
+    tasks.clear();
+}
 
+/// \brief
+///   Get time to block for completions before the next timer expires. Workers block for at most 1
+///   second so that stop requests are noticed.
+/// \param deadline
+///   Deadline of the earliest timer.
+/// \return
+///   Time to block for completions.
+[[nodiscard]]
+static auto wait_duration(std::chrono::steady_clock::time_point deadline) noexcept
+    -> std::chrono::nanoseconds {
+    constexpr std::chrono::nanoseconds max_wait = std::chrono::seconds(1);
+    if (deadline == std::chrono::steady_clock::time_point::max()) [[likely]]
+        return max_wait;
+
+    auto remaining = deadline - std::chrono::steady_clock::now();
+    return std::clamp<std::chrono::nanoseconds>(remaining, std::chrono::nanoseconds(0), max_wait);
+}
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+/// \brief
+///   Dequeue completion packets from the IOCP and push coroutines of completed IO requests into
+///   \p tasks.
+/// \param muxer
+///   The IOCP handle.
+/// \param timeout
+///   Milliseconds to wait for the first completion packet.
+/// \param[out] tasks
+///   Task queue to push coroutines into.
+/// \param max_events
+///   Maximum number of completion packets to dequeue.
+/// \return
+///   Number of completion packets dequeued.
+static auto reap_completions(HANDLE                       muxer,
+                             DWORD                        timeout,
+                             std::vector<promise_base *> &tasks,
+                             std::size_t                  max_events) noexcept -> std::size_t {
     BOOL         result;
     DWORD        bytes;
     ULONG_PTR    key;
     LPOVERLAPPED ovlp;
     DWORD        error;
 
-    std::vector<promise_base *> tasks;
-    tasks.reserve(64);
+    std::size_t count = 0;
+    while (count < max_events) {
+        result  = GetQueuedCompletionStatus(muxer, &bytes, &key, &ovlp, timeout);
+        timeout = 0;
+
+        if (result == FALSE) {
+            error = GetLastError();
+            if (error == WAIT_TIMEOUT)
+                break;
+        } else {
+            error = 0;
+        }
 
-    while (!m_should_stop.load(std::memory_order_relaxed)) [[likely]] {
-        // Wait for 1 second.
-        result = GetQueuedCompletionStatus(m_muxer, &bytes, &key, &ovlp, 1000);
-
-        while (true) {
-            if (result == FALSE) {
-                error = GetLastError();
-                if (error == WAIT_TIMEOUT)
-                    break;
-            } else {
-                error = 0;
-            }
+        if (ovlp != nullptr) {
+            auto *o = reinterpret_cast<overlapped *>(ovlp);
 
-            if (ovlp != nullptr) {
-                auto *o = reinterpret_cast<overlapped *>(ovlp);
+            o->error             = error;
+            o->bytes_transferred = bytes;
 
-                o->error             = error;
-                o->bytes_transferred = bytes;
+            tasks.push_back(o->promise);
+        }
+
+        ++count;
+    }
 
-                m_tasks.push_back(o->promise);
+    return count;
+}
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+/// \brief
+///   Maximum number of completion queue entries that are peeked at a time.
+inline constexpr unsigned completion_peek_size = 64;
+
+/// \brief
+///   Handle completion queue entries that are ready in the ring. Coroutines of completed IO
+///   requests are pushed into \p tasks, and multishot operations are handed to their completion
+///   handlers. Entries are peeked in batches and the completion queue head is published once per
+///   batch.
+/// \param[in] ring
+///   The \c io_uring to handle completions of.
+/// \param[out] tasks
+///   Task queue to push coroutines into.
+/// \param max_events
+///   Maximum number of completion queue entries to handle.
+/// \return
+///   Number of completion queue entries handled.
+static auto reap_completions(io_uring                    *ring,
+                             std::vector<promise_base *> &tasks,
+                             std::size_t                  max_events) noexcept -> std::size_t {
+    io_uring_cqe *cqes[completion_peek_size];
+    std::size_t   count = 0;
+
+    while (count < max_events) {
+        auto     limit = static_cast<unsigned>(
+            std::min<std::size_t>(completion_peek_size, max_events - count));
+        unsigned ready = io_uring_peek_batch_cqe(ring, cqes, limit);
+        if (ready == 0)
+            break;
+
+        for (unsigned i = 0; i < ready; ++i)
+            prefetch(reinterpret_cast<void *>(cqes[i]->user_data & ~std::uint64_t(multishot_tag)));
+
+        for (unsigned i = 0; i < ready; ++i) {
+            const io_uring_cqe *cqe  = cqes[i];
+            auto                data = static_cast<std::uintptr_t>(cqe->user_data);
+
+            if ((data & multishot_tag) != 0) {
+                auto *ovlp   = reinterpret_cast<multishot_overlapped *>(data & ~multishot_tag);
+                ovlp->flags  = static_cast<std::int32_t>(cqe->flags);
+                ovlp->result = cqe->res;
+                ovlp->complete(ovlp);
+            } else if (data != 0) {
+                auto *ovlp   = reinterpret_cast<overlapped *>(data);
+                ovlp->flags  = static_cast<std::int32_t>(cqe->flags);
+                ovlp->result = cqe->res;
+                prefetch(ovlp->promise);
+                tasks.push_back(ovlp->promise);
             }
+        }
+
+        // Publish the completion queue head once for the whole batch.
+        io_uring_cq_advance(ring, ready);
+        count += ready;
+
+        if (ready < limit)
+            break;
+    }
 
-            result = GetQueuedCompletionStatus(m_muxer, &bytes, &key, &ovlp, 0);
+    return count;
+}
+#endif
+
+auto io_context_worker::run() noexcept -> void {
+    if (m_is_running.exchange(true, std::memory_order_relaxed)) [[unlikely]]
+        return;
+
+    current_worker = this;
+
+    std::vector<promise_base *> tasks;
+    tasks.reserve(64);
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    m_should_stop.store(false, std::memory_order_relaxed);
+    m_thread_id.store(GetCurrentThreadId(), std::memory_order_relaxed);
+    this->apply_thread_options();
+
+    while (!m_should_stop.load(std::memory_order_relaxed)) [[likely]] {
+        run_iteration_hook();
+        auto deadline = this->expire_timers();
+
+        // Wait for 1 second or until the next timer expires. Do not block if there are tasks
+        // posted in the previous iteration.
+        DWORD wait = 0;
+        if (m_tasks.empty()) [[likely]] {
+            auto duration = std::chrono::ceil<std::chrono::milliseconds>(wait_duration(deadline));
+            wait          = static_cast<DWORD>(duration.count());
         }
 
+        this->record_completion_batch(
+            reap_completions(m_muxer, wait, m_tasks, m_completion_batch));
+
         // Handle tasks.
         tasks.swap(m_tasks);
-        for (const auto *task : tasks) {
-            promise_base &stack_bottom = task->stack_bottom();
-            task->coroutine().resume();
-            if (stack_bottom.coroutine().done())
-                stack_bottom.release();
-        }
-
-        tasks.clear();
+        this->resume_and_measure(tasks);
     }
 
     m_thread_id.store(0, std::memory_order_relaxed);
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
     m_should_stop.store(false, std::memory_order_relaxed);
     m_thread_id.store(gettid(), std::memory_order_relaxed);
+    this->apply_thread_options();
 
     __kernel_timespec timeout{};
 
     io_uring     *ring = static_cast<io_uring *>(m_muxer);
     io_uring_cqe *cqe  = nullptr;
 
-    std::vector<promise_base *> tasks;
-    tasks.reserve(64);
-
     while (!m_should_stop.load(std::memory_order_relaxed)) [[likely]] {
-        // Wait for 1 second.
-        timeout.tv_sec  = 1;
-        timeout.tv_nsec = 0;
+        run_iteration_hook();
+
+        auto deadline = this->expire_timers();
+        this->flush_overflow();
+
+        if (m_tasks.empty()) [[likely]] {
+            // Wait for 1 second or until the next timer expires.
+            auto duration   = wait_duration(deadline).count();
+            timeout.tv_sec  = duration / 1000000000;
+            timeout.tv_nsec = duration % 1000000000;
+            io_uring_submit_and_wait_timeout(ring, &cqe, 1, &timeout, nullptr);
+        } else {
+            // Do not block if there are tasks posted in the previous iteration.
+            io_uring_submit(ring);
+        }
 
-        int result = io_uring_submit_and_wait_timeout(ring, &cqe, 1, &timeout, nullptr);
-        while (result >= 0) {
-            auto *ovlp = static_cast<overlapped *>(io_uring_cqe_get_data(cqe));
+        this->record_completion_batch(reap_completions(ring, m_tasks, m_completion_batch));
 
-            if (ovlp != nullptr) {
-                ovlp->flags  = cqe->flags;
-                ovlp->result = cqe->res;
-                m_tasks.push_back(ovlp->promise);
-            }
-
-            io_uring_cqe_seen(ring, cqe);
-            result = io_uring_peek_cqe(ring, &cqe);
-        }
+        // Backlogged completions are handled in the next iteration.
+        this->flush_completion_overflow();
 
         // Handle tasks.
         tasks.swap(m_tasks);
-        for (const auto *task : tasks) {
-            promise_base &stack_bottom = task->stack_bottom();
-            task->coroutine().resume();
-            if (stack_bottom.coroutine().done())
-                stack_bottom.release();
-        }
-
-        tasks.clear();
+        this->resume_and_measure(tasks);
     }
 
     m_thread_id.store(0, std::memory_order_relaxed);
@@ -280,10 +658,424 @@ auto io_context_worker::run() noexcept -> void {
     m_is_running.store(false, std::memory_order_relaxed);
 }
 
+auto io_context_worker::poll_once(std::size_t max_events) noexcept -> std::size_t {
+    if (m_is_running.exchange(true, std::memory_order_relaxed)) [[unlikely]]
+        return 0;
+
+    // The host loop may drive several workers in the same thread.
+    io_context_worker *previous = current_worker;
+    current_worker              = this;
+
+    std::size_t                 count = 0;
+    std::vector<promise_base *> tasks;
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    m_thread_id.store(GetCurrentThreadId(), std::memory_order_relaxed);
+    this->apply_thread_options();
+    run_iteration_hook();
+    this->expire_timers();
+
+    count = reap_completions(m_muxer, 0, m_tasks, max_events);
+    this->record_completion_batch(count);
+    tasks.swap(m_tasks);
+    this->resume_and_measure(tasks);
+
+    // Keep the task queue buffer if no task is posted.
+    if (m_tasks.empty())
+        m_tasks.swap(tasks);
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    m_thread_id.store(gettid(), std::memory_order_relaxed);
+    this->apply_thread_options();
+
+    // Consume the readiness notification before handling completions. Completions posted after
+    // this point signal the poll handle again.
+    if (m_poll_handle != invalid_poll_handle) {
+        std::uint64_t value;
+        [[maybe_unused]] auto result = ::read(static_cast<int>(m_poll_handle), &value,
+                                              sizeof(value));
+    }
+
+    io_uring *ring = static_cast<io_uring *>(m_muxer);
+    run_iteration_hook();
+    this->expire_timers();
+    this->flush_overflow();
+    io_uring_submit(ring);
+
+    count = reap_completions(ring, m_tasks, max_events);
+    this->record_completion_batch(count);
+    this->flush_completion_overflow();
+
+    tasks.swap(m_tasks);
+    this->resume_and_measure(tasks);
+
+    // Keep the task queue buffer if no task is posted.
+    if (m_tasks.empty())
+        m_tasks.swap(tasks);
+
+    // Submit IO requests issued by the resumed tasks. They will not be submitted by anyone else
+    // until the next call.
+    this->flush_overflow();
+    io_uring_submit(ring);
+
+    // Posted tasks, parked requests and completions left by max_events do not signal the eventfd
+    // again. Signal the poll handle so that the host loop calls this method again.
+    bool pending = !m_tasks.empty() || !m_overflow.empty() || io_uring_cq_ready(ring) != 0 ||
+                   io_uring_cq_has_overflow(ring);
+    if (pending && m_poll_handle != invalid_poll_handle) {
+        std::uint64_t value = 1;
+        [[maybe_unused]] auto result = ::write(static_cast<int>(m_poll_handle), &value,
+                                               sizeof(value));
+    }
+#endif
+
+    m_thread_id.store(0, std::memory_order_relaxed);
+    current_worker = previous;
+    m_is_running.store(false, std::memory_order_relaxed);
+
+    return count;
+}
+
+auto io_context_worker::poll_handle() noexcept -> std::expected<std::uintptr_t, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return std::unexpected(std::make_error_code(std::errc::operation_not_supported));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_poll_handle != invalid_poll_handle)
+        return m_poll_handle;
+
+    int handle = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (handle == -1) [[unlikely]]
+        return std::unexpected(std::error_code(errno, std::system_category()));
+
+    int result = io_uring_register_eventfd(static_cast<io_uring *>(m_muxer), handle);
+    if (result < 0) [[unlikely]] {
+        ::close(handle);
+        return std::unexpected(std::error_code(-result, std::system_category()));
+    }
+
+    m_poll_handle = static_cast<std::uintptr_t>(handle);
+    return m_poll_handle;
+#endif
+}
+
 auto io_context_worker::current() noexcept -> io_context_worker * {
     return current_worker;
 }
 
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+/// \brief
+///   Count kernel async worker threads of the specified thread. Async worker threads are named
+///   \c iou-wrk-<tid> after the thread that owns them.
+/// \param thread
+///   Thread ID of the owner thread.
+/// \return
+///   Number of async worker threads that are alive.
+[[nodiscard]]
+static auto count_async_worker_threads(std::size_t thread) noexcept -> std::uint32_t {
+    char expected[32];
+    int  length = std::snprintf(expected, sizeof(expected), "iou-wrk-%zu\n", thread);
+
+    DIR *tasks = ::opendir("/proc/self/task");
+    if (tasks == nullptr) [[unlikely]]
+        return 0;
+
+    std::uint32_t count = 0;
+    while (dirent *entry = ::readdir(tasks)) {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        char path[sizeof(entry->d_name) + 8];
+        std::snprintf(path, sizeof(path), "%s/comm", entry->d_name);
+
+        int handle = ::openat(::dirfd(tasks), path, O_RDONLY | O_CLOEXEC);
+        if (handle == -1)
+            continue;
+
+        char    name[32];
+        ssize_t size = ::read(handle, name, sizeof(name));
+        ::close(handle);
+
+        if (size == length && std::memcmp(name, expected, static_cast<std::size_t>(size)) == 0)
+            ++count;
+    }
+
+    ::closedir(tasks);
+    return count;
+}
+#endif
+
+auto io_context_worker::stats() const noexcept -> worker_stats {
+    const auto &counters = m_submission_counters;
+
+    worker_stats result{
+        .bounded_async_worker_limit   = m_async_worker_limits[0].load(std::memory_order_relaxed),
+        .unbounded_async_worker_limit = m_async_worker_limits[1].load(std::memory_order_relaxed),
+        .async_worker_threads         = 0,
+        .available_buffers            = m_available_buffers.load(std::memory_order_relaxed),
+        .huge_page_ring               = m_ring_memory.is_huge_page(),
+        .huge_page_buffers            = m_buffer_memory.is_huge_page(),
+        .pending_submissions          = counters[pending_count].load(std::memory_order_relaxed),
+        .overflowed_submissions       = counters[overflowed_count].load(std::memory_order_relaxed),
+        .rejected_submissions         = counters[rejected_count].load(std::memory_order_relaxed),
+        .completion_overflows         = m_completion_overflows.load(std::memory_order_relaxed),
+        .dropped_completions          = 0,
+        .largest_completion_batch     = m_largest_completion_batch.load(std::memory_order_relaxed),
+        .queue_delay                  = m_queue_delay.load(std::memory_order_relaxed),
+        .overloaded                   = m_overloaded.load(std::memory_order_relaxed),
+        .overload_events              = m_overload_events.load(std::memory_order_relaxed),
+        .shed_requests                = m_shed_requests.load(std::memory_order_relaxed),
+        .paused_accepts               = m_paused_accepts.load(std::memory_order_relaxed),
+    };
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    std::size_t thread = m_thread_id.load(std::memory_order_relaxed);
+    if (thread != 0)
+        result.async_worker_threads = count_async_worker_threads(thread);
+
+    // The kernel counts dropped completions in the shared ring memory.
+    io_uring                 *ring = static_cast<io_uring *>(m_muxer);
+    std::atomic_ref<unsigned> dropped(*ring->cq.koverflow);
+    result.dropped_completions = dropped.load(std::memory_order_relaxed);
+#endif
+
+    return result;
+}
+
+auto io_context_worker::apply_thread_options() noexcept -> void {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    m_configured_thread = GetCurrentThreadId();
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    std::size_t thread = static_cast<std::size_t>(gettid());
+    if (m_configured_thread == thread) [[likely]]
+        return;
+
+    m_configured_thread = thread;
+    io_uring *ring      = static_cast<io_uring *>(m_muxer);
+
+    // The async worker backend of this thread is created on its first submission.
+    io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (sqe != nullptr) [[likely]] {
+        io_uring_prep_nop(sqe);
+        io_uring_sqe_set_data(sqe, nullptr);
+    }
+
+    io_uring_submit(ring);
+
+    // Affinity applies to the async worker threads of the calling thread only.
+    if (!m_async_worker_cpus.empty()) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (std::uint32_t cpu : m_async_worker_cpus) {
+            if (cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &cpus);
+        }
+
+        io_uring_register_iowq_aff(ring, sizeof(cpus), &cpus);
+    }
+
+    // Zero values read current limits without changing them.
+    unsigned int values[2]{};
+    if (io_uring_register_iowq_max_workers(ring, values) == 0) {
+        m_async_worker_limits[0].store(values[0], std::memory_order_relaxed);
+        m_async_worker_limits[1].store(values[1], std::memory_order_relaxed);
+    }
+#endif
+}
+
+auto io_context_worker::acquire_sqes(void **sqes, std::uint32_t count) noexcept
+    -> std::int32_t {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    (void)sqes;
+    (void)count;
+    return -static_cast<std::int32_t>(std::errc::operation_not_supported);
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    io_uring *ring = static_cast<io_uring *>(m_muxer);
+
+    // Requests are parked once any request is parked so that submission order is kept.
+    if (m_overflow.empty() && io_uring_sq_space_left(ring) >= count) [[likely]] {
+        for (std::uint32_t i = 0; i < count; ++i)
+            sqes[i] = io_uring_get_sqe(ring);
+        return 0;
+    }
+
+    if (m_overflow_policy == submission_overflow_policy::fail) {
+        auto &rejected = m_submission_counters[rejected_count];
+        rejected.store(rejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return -EAGAIN;
+    }
+
+    // Deque elements are not moved by insertion at the end, so the entries stay valid while they
+    // are prepared.
+    for (std::uint32_t i = 0; i < count; ++i)
+        sqes[i] = &m_overflow.emplace_back();
+
+    auto &overflowed = m_submission_counters[overflowed_count];
+    overflowed.store(overflowed.load(std::memory_order_relaxed) + count,
+                     std::memory_order_relaxed);
+    m_submission_counters[pending_count].store(m_overflow.size(), std::memory_order_relaxed);
+
+    return 0;
+#endif
+}
+
+auto io_context_worker::flush_overflow() noexcept -> void {
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_overflow.empty()) [[likely]]
+        return;
+
+    io_uring *ring = static_cast<io_uring *>(m_muxer);
+    while (!m_overflow.empty()) {
+        // Linked requests must be moved into the same submission.
+        std::size_t length = 1;
+        while (length < m_overflow.size()) {
+            const auto *sqe = reinterpret_cast<const io_uring_sqe *>(&m_overflow[length - 1]);
+            if ((sqe->flags & (IOSQE_IO_LINK | IOSQE_IO_HARDLINK)) == 0)
+                break;
+            ++length;
+        }
+
+        if (io_uring_sq_space_left(ring) < length) {
+            // Stop if the kernel does not take any request, such as -EBUSY when completions are
+            // backlogged. The rest is retried in the next iteration.
+            if (io_uring_submit(ring) <= 0 || io_uring_sq_space_left(ring) < length)
+                break;
+            continue;
+        }
+
+        for (std::size_t i = 0; i < length; ++i) {
+            std::memcpy(io_uring_get_sqe(ring), &m_overflow.front(), sizeof(io_uring_sqe));
+            m_overflow.pop_front();
+        }
+    }
+
+    m_submission_counters[pending_count].store(m_overflow.size(), std::memory_order_relaxed);
+#endif
+}
+
+auto io_context_worker::flush_completion_overflow() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    io_uring *ring = static_cast<io_uring *>(m_muxer);
+    if (!io_uring_cq_has_overflow(ring)) [[likely]]
+        return false;
+
+    m_completion_overflows.store(m_completion_overflows.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+
+    // Entering the kernel for events moves backlogged completions into the completion queue as
+    // space allows.
+    io_uring_get_events(ring);
+    return true;
+#endif
+}
+
+/// \brief
+///   Compare deadlines of timers so that the timer heap of workers is a min-heap.
+/// \param[in] lhs
+///   The first timer to compare.
+/// \param[in] rhs
+///   The second timer to compare.
+/// \retval true
+///   \p lhs expires after \p rhs.
+/// \retval false
+///   \p lhs expires no later than \p rhs.
+[[nodiscard]]
+static auto expires_later(const timer_entry *lhs, const timer_entry *rhs) noexcept -> bool {
+    return lhs->deadline > rhs->deadline;
+}
+
+auto io_context_worker::add_timer(timer_entry *timer) noexcept -> void {
+    m_timers.push_back(timer);
+    std::push_heap(m_timers.begin(), m_timers.end(), expires_later);
+}
+
+auto io_context_worker::cancel_timer(timer_entry *timer) noexcept -> bool {
+    auto iter = std::find(m_timers.begin(), m_timers.end(), timer);
+    if (iter == m_timers.end())
+        return false;
+
+    // Timers are rarely cancelled and the heap is small. Rebuild the heap rather than sifting.
+    *iter = m_timers.back();
+    m_timers.pop_back();
+    std::make_heap(m_timers.begin(), m_timers.end(), expires_later);
+
+    return true;
+}
+
+auto io_context_worker::expire_timers() noexcept -> std::chrono::steady_clock::time_point {
+    if (m_timers.empty()) [[likely]]
+        return std::chrono::steady_clock::time_point::max();
+
+    auto now = std::chrono::steady_clock::now();
+    while (!m_timers.empty()) {
+        timer_entry *timer = m_timers.front();
+        if (timer->deadline > now)
+            return timer->deadline;
+
+        std::pop_heap(m_timers.begin(), m_timers.end(), expires_later);
+        m_timers.pop_back();
+
+        // Handlers may add new timers. They are handled in this loop if they have expired.
+        if (timer->expire != nullptr)
+            timer->expire(timer);
+        else
+            m_tasks.push_back(timer->promise);
+    }
+
+    return std::chrono::steady_clock::time_point::max();
+}
+
+auto io_context_worker::wait_for_admission(timer_entry *entry) noexcept -> void {
+    m_paused_accepts.fetch_add(1, std::memory_order_relaxed);
+    m_admission_waiters.push_back(entry);
+}
+
+auto io_context_worker::resume_and_measure(std::vector<promise_base *> &tasks) noexcept -> void {
+    if (m_shedding_target == std::chrono::steady_clock::duration::zero()) [[likely]] {
+        resume_tasks(tasks);
+        return;
+    }
+
+    // The queue delay of an iteration is the time that the last task waits from reaping its
+    // completion to being resumed. An idle iteration has no queue delay.
+    auto reaped      = std::chrono::steady_clock::now();
+    auto last_resume = reaped;
+    resume_tasks(tasks, &last_resume);
+
+    this->update_queue_delay(last_resume - reaped, std::chrono::steady_clock::now());
+}
+
+auto io_context_worker::update_queue_delay(std::chrono::steady_clock::duration   delay,
+                                           std::chrono::steady_clock::time_point now) noexcept
+    -> void {
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count();
+    m_queue_delay.store(static_cast<std::uint64_t>(nanoseconds), std::memory_order_relaxed);
+
+    // Like CoDel, a standing queue rather than a burst means overload: the worker is overloaded
+    // once the queue delay has stayed above the target for a whole interval.
+    if (delay < m_shedding_target) {
+        m_overload_deadline = std::chrono::steady_clock::time_point();
+        if (m_overloaded.exchange(false, std::memory_order_relaxed)) {
+            for (timer_entry *waiter : m_admission_waiters) {
+                if (waiter->expire != nullptr)
+                    waiter->expire(waiter);
+                else
+                    m_tasks.push_back(waiter->promise);
+            }
+            m_admission_waiters.clear();
+        }
+        return;
+    }
+
+    if (m_overload_deadline == std::chrono::steady_clock::time_point()) {
+        m_overload_deadline = now + m_shedding_interval;
+        return;
+    }
+
+    if (now >= m_overload_deadline && !m_overloaded.exchange(true, std::memory_order_relaxed))
+        m_overload_events.fetch_add(1, std::memory_order_relaxed);
+}
+
 auto io_context_worker::schedule(promise_base *promise) noexcept -> void {
     m_tasks.push_back(promise);
 
@@ -301,22 +1093,21 @@ auto io_context_worker::schedule(promise_base *promise) noexcept -> void {
 #endif
 }
 
-io_context::io_context()
-    : m_is_running(),
-      m_worker_count(std::max<std::size_t>(1, std::thread::hardware_concurrency())),
-      m_workers(std::make_unique<io_context_worker[]>(m_worker_count)) {
-#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
-    WSADATA data;
-    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) [[unlikely]]
-        throw std::system_error(WSAGetLastError(), std::system_category(),
-                                "Failed to start WinSock");
-#endif
-}
+io_context::io_context() : io_context(0, io_context_options{}) {}
+
+io_context::io_context(std::size_t count) : io_context(count, io_context_options{}) {}
 
-io_context::io_context(std::size_t count)
+io_context::io_context(std::size_t count, const io_context_options &options)
     : m_is_running(),
       m_worker_count(count ? count : std::max<std::size_t>(1, std::thread::hardware_concurrency())),
-      m_workers(std::make_unique<io_context_worker[]>(m_worker_count)) {
+      m_workers() {
+    if (options.coroutine_frame_pool)
+        enable_frame_pool();
+
+    // All workers share the async worker backend of the first worker.
+    for (std::size_t i = 0; i < m_worker_count; ++i)
+        m_workers.emplace_back(options, i == 0 ? nullptr : &m_workers.front());
+
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     WSADATA data;
     if (WSAStartup(MAKEWORD(2, 2), &data) != 0) [[unlikely]]
@@ -0,0 +1,219 @@
+#include "ossia/load_balancer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+
+using namespace ossia;
+
+/// \brief
+///   Generate a non-zero random seed for the power of two choices.
+/// \return
+///   A non-zero random seed.
+[[nodiscard]]
+static auto random_seed() noexcept -> std::uint64_t {
+    std::random_device device;
+    std::uint64_t      seed = (static_cast<std::uint64_t>(device()) << 32) | device();
+    return seed | 1;
+}
+
+load_balancer::load_balancer(const std::vector<inet_address> &endpoints,
+                             const load_balancer_options     &options) noexcept
+    : m_endpoints(),
+      m_options(options),
+      m_random(random_seed()),
+      m_ejected() {
+    assert(!endpoints.empty());
+
+    auto initial_latency = std::chrono::duration<double, std::nano>(options.initial_latency);
+    auto now             = std::chrono::steady_clock::now();
+
+    m_endpoints.reserve(endpoints.size());
+    for (const auto &address : endpoints) {
+        m_endpoints.push_back(endpoint{
+            .address         = address,
+            .latency         = initial_latency.count(),
+            .updated         = now,
+            .in_flight       = 0,
+            .failures        = 0,
+            .ejection_count  = 0,
+            .ejected_until   = {},
+            .idle            = {},
+            .total_requests  = 0,
+            .total_failures  = 0,
+            .total_ejections = 0,
+        });
+    }
+}
+
+auto load_balancer::pick() noexcept -> std::size_t {
+    std::size_t count = m_endpoints.size();
+    if (count == 1)
+        return 0;
+
+    // Pick two distinct endpoints. Modulo bias is negligible for any sane number of endpoints.
+    std::uint64_t random = this->next_random();
+    std::size_t   first  = static_cast<std::size_t>(random % count);
+    std::size_t   second = static_cast<std::size_t>((random >> 32) % (count - 1));
+    if (second >= first)
+        second += 1;
+
+    // Reading the clock is only necessary when some endpoints are ejected.
+    if (m_ejected != 0) [[unlikely]] {
+        auto now            = std::chrono::steady_clock::now();
+        bool first_ejected  = this->is_ejected(m_endpoints[first], now);
+        bool second_ejected = this->is_ejected(m_endpoints[second], now);
+
+        if (first_ejected && second_ejected) {
+            // Fall back to the next available endpoint. Every endpoint could only be ejected if
+            // the ejection ratio allows it, and then any endpoint is as good as another.
+            for (std::size_t i = 1; i < count; ++i) {
+                std::size_t index = (first + i) % count;
+                if (!this->is_ejected(m_endpoints[index], now))
+                    return index;
+            }
+            return first;
+        }
+
+        if (first_ejected)
+            return second;
+        if (second_ejected)
+            return first;
+    }
+
+    const endpoint &lhs = m_endpoints[first];
+    const endpoint &rhs = m_endpoints[second];
+    return (cost(rhs) < cost(lhs)) ? second : first;
+}
+
+auto load_balancer::begin_request(std::size_t index) noexcept
+    -> std::chrono::steady_clock::time_point {
+    endpoint &target        = m_endpoints[index];
+    target.in_flight       += 1;
+    target.total_requests  += 1;
+    return std::chrono::steady_clock::now();
+}
+
+auto load_balancer::end_request(std::size_t                           index,
+                                std::chrono::steady_clock::time_point start,
+                                bool                                  succeeded) noexcept -> void {
+    auto      now    = std::chrono::steady_clock::now();
+    endpoint &target = m_endpoints[index];
+
+    assert(target.in_flight > 0);
+    target.in_flight -= 1;
+
+    // Peak EWMA: latency peaks are taken at once, and the average decays towards new samples by
+    // the time passed since the last update rather than by the number of samples.
+    double sample  = std::chrono::duration<double, std::nano>(now - start).count();
+    double elapsed = std::chrono::duration<double, std::nano>(now - target.updated).count();
+    double decay   = std::chrono::duration<double, std::nano>(m_options.decay_time).count();
+
+    if (sample > target.latency || decay <= 0) {
+        target.latency = sample;
+    } else {
+        double weight  = std::exp(-std::max(elapsed, 0.0) / decay);
+        target.latency = target.latency * weight + sample * (1 - weight);
+    }
+    target.updated = std::max(target.updated, now);
+
+    if (succeeded) {
+        target.failures       = 0;
+        target.ejection_count = 0;
+        return;
+    }
+
+    target.failures       += 1;
+    target.total_failures += 1;
+
+    if (m_options.ejection_failures == 0 || target.failures < m_options.ejection_failures)
+        return;
+    if (this->is_ejected(target, now))
+        return;
+
+    auto max_ejected = static_cast<std::size_t>(
+        std::floor(m_options.max_ejection_ratio * static_cast<double>(m_endpoints.size())));
+    if (m_ejected >= max_ejected)
+        return;
+
+    target.failures         = 0;
+    target.ejection_count  += 1;
+    target.total_ejections += 1;
+
+    auto duration        = m_options.ejection_time * target.ejection_count;
+    target.ejected_until = now + std::min(duration, m_options.max_ejection_time);
+    m_ejected           += 1;
+
+    // Connections to an ejected endpoint are likely broken as well.
+    target.idle.clear();
+}
+
+auto load_balancer::stats(std::size_t index) const noexcept -> endpoint_stats {
+    using duration = std::chrono::steady_clock::duration;
+
+    const endpoint &target  = m_endpoints[index];
+    auto            latency = std::chrono::duration<double, std::nano>(target.latency);
+
+    return endpoint_stats{
+        .latency          = std::chrono::duration_cast<duration>(latency),
+        .in_flight        = target.in_flight,
+        .idle_connections = static_cast<std::uint32_t>(target.idle.size()),
+        .ejected          = target.ejected_until > std::chrono::steady_clock::now(),
+        .requests         = target.total_requests,
+        .failures         = target.total_failures,
+        .ejections        = target.total_ejections,
+    };
+}
+
+auto load_balancer::is_ejected(endpoint                             &target,
+                               std::chrono::steady_clock::time_point now) noexcept -> bool {
+    if (target.ejected_until == std::chrono::steady_clock::time_point{})
+        return false;
+
+    if (target.ejected_until > now)
+        return true;
+
+    // The ejection time is over. Requests are sent to the endpoint again, and it is ejected for
+    // longer if it keeps failing.
+    target.ejected_until  = {};
+    m_ejected            -= 1;
+    return false;
+}
+
+auto load_balancer::next_random() noexcept -> std::uint64_t {
+    m_random ^= m_random >> 12;
+    m_random ^= m_random << 25;
+    m_random ^= m_random >> 27;
+    return m_random * 0x2545F4914F6CDD1DULL;
+}
+
+auto load_balancer::take_connection(std::size_t index, tcp_stream &stream) noexcept -> bool {
+    endpoint &target = m_endpoints[index];
+    if (target.idle.empty())
+        return false;
+
+    // Reuse the most recently used connection. If it has expired, older ones have expired too.
+    idle_connection &latest = target.idle.back();
+    if (std::chrono::steady_clock::now() - latest.since >= m_options.idle_timeout) {
+        target.idle.clear();
+        return false;
+    }
+
+    stream = std::move(latest.stream);
+    target.idle.pop_back();
+    return true;
+}
+
+auto load_balancer::keep_connection(std::size_t index, tcp_stream &&stream) noexcept -> void {
+    endpoint &target = m_endpoints[index];
+    if (target.idle.size() >= m_options.max_idle_connections)
+        return;
+    if (target.ejected_until != std::chrono::steady_clock::time_point{})
+        return;
+
+    target.idle.push_back(idle_connection{
+        .stream = std::move(stream),
+        .since  = std::chrono::steady_clock::now(),
+    });
+}
@@ -0,0 +1,262 @@
+#include "ossia/poll.hpp"
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <liburing.h>
+#endif
+
+#include <cassert>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+struct poll_watcher::state {
+    std::uintptr_t handle;
+    poll_event     events;
+};
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+struct poll_watcher::state : multishot_overlapped {
+    /// \brief
+    ///   The file descriptor to watch.
+    std::uintptr_t handle;
+
+    /// \brief
+    ///   Events to watch for.
+    poll_event events;
+
+    /// \brief
+    ///   Events reported by the kernel that are not taken by \c next yet.
+    poll_event ready;
+
+    /// \brief
+    ///   Error reported by the kernel that is not taken by \c next yet.
+    std::int32_t error;
+
+    /// \brief
+    ///   Whether the poll request is submitted and not terminated yet.
+    bool armed;
+
+    /// \brief
+    ///   Whether this watcher is cancelled.
+    bool cancelled;
+
+    /// \brief
+    ///   Whether the watcher is destroyed. The state is released once the kernel terminates the
+    ///   poll request.
+    bool orphaned;
+
+    /// \brief
+    ///   Handle completions of the multishot poll request.
+    static auto on_complete(multishot_overlapped *ovlp) noexcept -> void;
+
+    /// \brief
+    ///   Get user data of the multishot poll request.
+    [[nodiscard]]
+    auto user_data() noexcept -> std::uintptr_t {
+        return reinterpret_cast<std::uintptr_t>(static_cast<multishot_overlapped *>(this)) |
+               multishot_tag;
+    }
+};
+
+auto poll_watcher::state::on_complete(multishot_overlapped *ovlp) noexcept -> void {
+    auto *self = static_cast<state *>(ovlp);
+
+    if ((static_cast<std::uint32_t>(self->flags) & IORING_CQE_F_MORE) == 0)
+        self->armed = false;
+
+    if (self->result >= 0)
+        self->ready |= static_cast<poll_event>(self->result);
+    else if (self->result == -ECANCELED)
+        self->cancelled = true;
+    else
+        self->error = -self->result;
+
+    if (self->orphaned) {
+        if (!self->armed)
+            delete self;
+        return;
+    }
+
+    // Wake up the waiting coroutine once. Later completions are accumulated until the coroutine
+    // takes them.
+    if (self->promise != nullptr &&
+        (self->ready != poll_event::none || self->error != 0 || !self->armed)) {
+        io_context_worker::current()->post(self->promise);
+        self->promise = nullptr;
+    }
+}
+
+/// \brief
+///   Acquire a submission queue entry from current worker.
+/// \param[out] error
+///   Negative error code if failed to acquire a submission queue entry.
+/// \return
+///   The submission queue entry. Return \c nullptr if failed.
+static auto acquire_sqe(std::int32_t &error) noexcept -> io_uring_sqe * {
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    return static_cast<io_uring_sqe *>(worker->acquire_sqe(error));
+}
+#endif
+
+auto poll_awaitable::await_resume() const noexcept -> std::expected<poll_event, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return std::unexpected(std::make_error_code(std::errc::operation_not_supported));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_ovlp.result >= 0) [[likely]]
+        return static_cast<poll_event>(m_ovlp.result);
+
+    return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+#endif
+}
+
+auto poll_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    // IOCP could not report readiness of arbitrary handles.
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    io_uring_sqe *sqe = acquire_sqe(m_ovlp.result);
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+    io_uring_prep_poll_add(sqe, static_cast<int>(m_handle), static_cast<unsigned>(m_events));
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+auto poll_watcher::next_awaitable::await_ready() const noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return true;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_state == nullptr) [[unlikely]]
+        return true;
+
+    return m_state->ready != poll_event::none || m_state->error != 0 || m_state->cancelled;
+#endif
+}
+
+auto poll_watcher::next_awaitable::await_resume() const noexcept
+    -> std::expected<poll_event, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return std::unexpected(std::make_error_code(std::errc::operation_not_supported));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_state == nullptr) [[unlikely]]
+        return std::unexpected(std::make_error_code(std::errc::bad_file_descriptor));
+
+    if (m_state->ready != poll_event::none) {
+        poll_event ready = m_state->ready;
+        m_state->ready   = poll_event::none;
+        return ready;
+    }
+
+    if (m_state->error != 0) {
+        int error      = m_state->error;
+        m_state->error = 0;
+        return std::unexpected(std::error_code(error, std::system_category()));
+    }
+
+    return std::unexpected(std::make_error_code(std::errc::operation_canceled));
+#endif
+}
+
+auto poll_watcher::next_awaitable::await_suspend(promise_base *promise) noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    (void)promise;
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    // Submit the poll request for the first time, or again if the kernel terminated it.
+    if (!m_state->armed) {
+        std::int32_t  error = 0;
+        io_uring_sqe *sqe   = acquire_sqe(error);
+        if (sqe == nullptr) [[unlikely]] {
+            m_state->error = -error;
+            return false;
+        }
+
+        io_uring_prep_poll_multishot(sqe, static_cast<int>(m_state->handle),
+                                     static_cast<unsigned>(m_state->events));
+        io_uring_sqe_set_flags(sqe, 0);
+        io_uring_sqe_set_data64(sqe, m_state->user_data());
+
+        m_state->armed = true;
+    }
+
+    m_state->promise = promise;
+    return true;
+#endif
+}
+
+poll_watcher::poll_watcher(std::uintptr_t handle, poll_event events) : m_state() {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    m_state = new state{
+        .handle = handle,
+        .events = events,
+    };
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    m_state           = new state();
+    m_state->complete = &state::on_complete;
+    m_state->handle   = handle;
+    m_state->events   = events;
+#endif
+}
+
+poll_watcher::~poll_watcher() {
+    if (m_state == nullptr)
+        return;
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    // The kernel still refers to the state. Release it once the poll request is terminated.
+    if (m_state->armed) {
+        this->cancel();
+        m_state->orphaned = true;
+        return;
+    }
+#endif
+
+    delete m_state;
+}
+
+auto poll_watcher::operator=(poll_watcher &&other) noexcept -> poll_watcher & {
+    if (this == &other) [[unlikely]]
+        return *this;
+
+    { // Release current state.
+        poll_watcher discard(std::move(*this));
+    }
+
+    m_state       = other.m_state;
+    other.m_state = nullptr;
+    return *this;
+}
+
+auto poll_watcher::cancel() noexcept -> void {
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_state == nullptr || m_state->cancelled)
+        return;
+
+    m_state->cancelled = true;
+
+    // The waiting coroutine is resumed by the final completion of the poll request.
+    if (m_state->armed) {
+        std::int32_t  error = 0;
+        io_uring_sqe *sqe   = acquire_sqe(error);
+        if (sqe == nullptr) [[unlikely]]
+            return;
+
+        io_uring_prep_poll_remove(sqe, m_state->user_data());
+        io_uring_sqe_set_flags(sqe, 0);
+        io_uring_sqe_set_data(sqe, nullptr);
+        return;
+    }
+
+    if (m_state->promise != nullptr) {
+        io_context_worker::current()->post(m_state->promise);
+        m_state->promise = nullptr;
+    }
+#endif
+}
@@ -0,0 +1,178 @@
+#include "ossia/promise.hpp"
+#include "ossia/huge_page.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+/// \brief
+///   Size classes of pooled frames are multiples of this value.
+inline constexpr std::size_t frame_granularity = 64;
+
+/// \brief
+///   Number of frame size classes. Larger frames are allocated from the global heap.
+inline constexpr std::size_t frame_class_count = 64;
+
+/// \brief
+///   Maximum size in byte of pooled frames.
+inline constexpr std::size_t max_pooled_frame = frame_granularity * frame_class_count;
+
+/// \brief
+///   Size in byte of the chunks that threads carve from the shared slabs at a time.
+inline constexpr std::size_t frame_chunk_size = 64 * 1024;
+
+/// \brief
+///   Whether the frame pool is enabled.
+static std::atomic_bool frame_pool_enabled;
+
+/// \struct frame_block
+/// \brief
+///   A free coroutine frame in the frame pool.
+struct frame_block {
+    frame_block *next;
+};
+
+/// \struct frame_pool
+/// \brief
+///   Process-wide state of the frame pool. Slabs are never released, so frames could be released
+///   in any thread, even after the thread that allocated them exits.
+struct frame_pool {
+    std::mutex                    mutex;
+    std::vector<huge_page_buffer> slabs;
+    std::byte                    *cursor;
+    std::byte                    *end;
+
+    /// \brief
+    ///   Free frames donated by threads that have exited.
+    frame_block *free[frame_class_count];
+};
+
+/// \brief
+///   Get the process-wide frame pool. The pool is intentionally never destroyed, since frames may
+///   be released during static destruction.
+[[nodiscard]]
+static auto global_frame_pool() noexcept -> frame_pool & {
+    static frame_pool *instance = new frame_pool();
+    return *instance;
+}
+
+/// \struct frame_cache
+/// \brief
+///   Thread-local free lists of the frame pool.
+struct frame_cache {
+    frame_block *free[frame_class_count];
+    std::byte   *cursor;
+    std::byte   *end;
+
+    /// \brief
+    ///   Donate free frames to the process-wide pool.
+    ~frame_cache() {
+        frame_pool     &pool = global_frame_pool();
+        std::lock_guard lock(pool.mutex);
+
+        for (std::size_t i = 0; i < frame_class_count; ++i) {
+            while (free[i] != nullptr) {
+                frame_block *block = free[i];
+                free[i]            = block->next;
+                block->next        = pool.free[i];
+                pool.free[i]       = block;
+            }
+        }
+    }
+};
+
+/// \brief
+///   Free lists of the calling thread.
+static thread_local frame_cache thread_frame_cache;
+
+/// \brief
+///   Allocate a new frame of the specified size class for the calling thread.
+/// \param cache
+///   Frame cache of the calling thread.
+/// \param index
+///   Index of the size class.
+/// \return
+///   Pointer to the new frame.
+/// \throws std::bad_alloc
+///   Thrown if failed to allocate a new slab.
+[[nodiscard]]
+static auto refill_frame(frame_cache &cache, std::size_t index) -> void * {
+    std::size_t size = (index + 1) * frame_granularity;
+    if (static_cast<std::size_t>(cache.end - cache.cursor) >= size) [[likely]] {
+        void *frame   = cache.cursor;
+        cache.cursor += size;
+        return frame;
+    }
+
+    frame_pool     &pool = global_frame_pool();
+    std::lock_guard lock(pool.mutex);
+
+    // Reuse frames donated by exited threads first.
+    if (pool.free[index] != nullptr) {
+        cache.free[index] = pool.free[index];
+        pool.free[index]  = nullptr;
+
+        frame_block *block = cache.free[index];
+        cache.free[index]  = block->next;
+        return block;
+    }
+
+    if (static_cast<std::size_t>(pool.end - pool.cursor) < frame_chunk_size) {
+        huge_page_buffer slab(huge_page_buffer::huge_page_size);
+        pool.cursor = static_cast<std::byte *>(slab.data());
+        pool.end    = pool.cursor + slab.size();
+        pool.slabs.push_back(std::move(slab));
+    }
+
+    // The rest of the current chunk is dropped. It is less than a frame.
+    cache.cursor  = pool.cursor;
+    cache.end     = pool.cursor + frame_chunk_size;
+    pool.cursor  += frame_chunk_size;
+
+    void *frame   = cache.cursor;
+    cache.cursor += size;
+    return frame;
+}
+
+auto ossia::detail::allocate_frame(std::size_t size) -> void * {
+    if (size > max_pooled_frame) [[unlikely]]
+        return ::operator new(size);
+
+    std::size_t index = (size + frame_granularity - 1) / frame_granularity - 1;
+
+    // Frames allocated before the pool is enabled may be released into the pool later, so they
+    // are rounded up to their size class as well.
+    if (!frame_pool_enabled.load(std::memory_order_relaxed))
+        return ::operator new((index + 1) * frame_granularity);
+
+    frame_cache &cache = thread_frame_cache;
+    if (frame_block *block = cache.free[index]; block != nullptr) [[likely]] {
+        cache.free[index] = block->next;
+        return block;
+    }
+
+    return refill_frame(cache, index);
+}
+
+auto ossia::detail::deallocate_frame(void *frame, std::size_t size) noexcept -> void {
+    // The pool is never disabled once enabled, so pooled frames never reach the global heap.
+    if (size > max_pooled_frame || !frame_pool_enabled.load(std::memory_order_relaxed)) {
+        ::operator delete(frame);
+        return;
+    }
+
+    std::size_t  index = (size + frame_granularity - 1) / frame_granularity - 1;
+    frame_cache &cache = thread_frame_cache;
+
+    auto *block       = static_cast<frame_block *>(frame);
+    block->next       = cache.free[index];
+    cache.free[index] = block;
+}
+
+auto ossia::detail::enable_frame_pool() noexcept -> void {
+    frame_pool_enabled.store(true, std::memory_order_relaxed);
+}
@@ -0,0 +1,92 @@
+#include "ossia/rate_limiter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ossia;
+
+/// \brief
+///   Round a number of nanoseconds to a duration of the steady clock.
+/// \param nanoseconds
+///   The number of nanoseconds to convert.
+/// \return
+///   The rounded duration.
+[[nodiscard]]
+static auto to_duration(double nanoseconds) noexcept -> std::chrono::steady_clock::duration {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::nanoseconds(std::llround(nanoseconds)));
+}
+
+auto rate_limiter::delay(double cost, std::chrono::steady_clock::time_point now) const noexcept
+    -> double {
+    if (m_limit.rate <= 0) [[unlikely]]
+        return 0;
+
+    double interval = 1e9 / m_limit.rate;
+    if (m_limit.algorithm == rate_limit_algorithm::gcra) {
+        // The request conforms if it arrives no earlier than its theoretical arrival time minus
+        // the burst tolerance.
+        auto arrival   = std::max(m_arrival_time, now) + to_duration(cost * interval);
+        auto tolerance = to_duration(static_cast<double>(m_limit.burst) * interval);
+        return std::max(std::chrono::duration<double, std::nano>(arrival - tolerance - now).count(),
+                        0.0);
+    }
+
+    double elapsed   = std::chrono::duration<double, std::nano>(now - m_last_update).count();
+    double available = std::min(m_tokens + std::max(elapsed, 0.0) / interval,
+                                static_cast<double>(m_limit.burst));
+    return available >= cost ? 0 : (cost - available) * interval;
+}
+
+auto rate_limiter::charge(double cost, std::chrono::steady_clock::time_point now) noexcept
+    -> void {
+    if (m_limit.rate <= 0) [[unlikely]]
+        return;
+
+    double interval = 1e9 / m_limit.rate;
+    if (m_limit.algorithm == rate_limit_algorithm::gcra) {
+        m_arrival_time = std::max(m_arrival_time, now) + to_duration(cost * interval);
+        return;
+    }
+
+    double elapsed = std::chrono::duration<double, std::nano>(now - m_last_update).count();
+    if (elapsed > 0) {
+        m_tokens      = std::min(m_tokens + elapsed / interval, static_cast<double>(m_limit.burst));
+        m_last_update = now;
+    }
+
+    m_tokens -= cost;
+}
+
+auto rate_limiter::try_acquire(std::uint64_t                         bytes,
+                               std::uint64_t                         operations,
+                               std::chrono::steady_clock::time_point now) noexcept -> bool {
+    // Check every limiter before charging so that a rejected request costs nothing.
+    for (const rate_limiter *limiter = this; limiter != nullptr; limiter = limiter->m_parent) {
+        if (limiter->delay(limiter->cost(bytes, operations), now) > 0)
+            return false;
+    }
+
+    for (rate_limiter *limiter = this; limiter != nullptr; limiter = limiter->m_parent)
+        limiter->charge(limiter->cost(bytes, operations), now);
+
+    return true;
+}
+
+auto rate_limiter::reserve(std::uint64_t                         bytes,
+                           std::uint64_t                         operations,
+                           std::chrono::steady_clock::time_point now) noexcept
+    -> std::chrono::steady_clock::time_point {
+    double wait = 0;
+    for (rate_limiter *limiter = this; limiter != nullptr; limiter = limiter->m_parent) {
+        double cost = limiter->cost(bytes, operations);
+        wait        = std::max(wait, limiter->delay(cost, now));
+        limiter->charge(cost, now);
+    }
+
+    if (wait <= 0) [[likely]]
+        return now;
+
+    auto nanoseconds = std::chrono::nanoseconds(static_cast<std::int64_t>(std::ceil(wait)));
+    return now + std::chrono::ceil<std::chrono::steady_clock::duration>(nanoseconds);
+}
@@ -0,0 +1,362 @@
+#include "ossia/resp.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace ossia;
+
+/// \brief
+///   Maximum size in byte of a message that could be addressed by \c resp_node.
+static constexpr std::size_t max_message_size = std::numeric_limits<std::uint32_t>::max();
+
+/// \struct resp_parser
+/// \brief
+///   State of a single RESP parse operation.
+struct resp_parser {
+    /// \brief
+    ///   The data to be parsed.
+    std::string_view data;
+
+    /// \brief
+    ///   Current offset in byte of \c data.
+    std::size_t cursor;
+
+    /// \brief
+    ///   Output nodes in pre-order.
+    std::vector<detail::resp_node> &nodes;
+};
+
+/// \brief
+///   Read a CRLF-terminated line from current cursor and move the cursor past the line.
+/// \param[in, out] parser
+///   The parser state.
+/// \param[out] line
+///   The line without CRLF.
+/// \return
+///   A \c resp_parse_error if failed to read the line.
+static auto read_line(resp_parser &parser, std::string_view &line) noexcept
+    -> std::expected<void, resp_parse_error> {
+    const char *begin = parser.data.data() + parser.cursor;
+    std::size_t size  = parser.data.size() - parser.cursor;
+
+    const auto *cr = static_cast<const char *>(std::memchr(begin, '\r', size));
+    if (cr == nullptr)
+        return std::unexpected(resp_parse_error::incomplete);
+
+    std::size_t length = static_cast<std::size_t>(cr - begin);
+    if (length + 1 == size)
+        return std::unexpected(resp_parse_error::incomplete);
+    if (cr[1] != '\n')
+        return std::unexpected(resp_parse_error::invalid);
+
+    line           = std::string_view(begin, length);
+    parser.cursor += length + 2;
+    return {};
+}
+
+/// \brief
+///   Parse a signed decimal integer. RESP allows an optional plus sign.
+/// \param line
+///   The line to be parsed. The whole line must be a valid integer.
+/// \param[out] value
+///   The parsed integer.
+/// \retval true
+///   The line is a valid integer.
+/// \retval false
+///   The line is not a valid integer.
+static auto parse_integer(std::string_view line, std::int64_t &value) noexcept -> bool {
+    if (line.starts_with('+'))
+        line.remove_prefix(1);
+    if (line.empty())
+        return false;
+
+    auto [ptr, ec] = std::from_chars(line.data(), line.data() + line.size(), value);
+    return ec == std::errc() && ptr == line.data() + line.size();
+}
+
+/// \brief
+///   Parse a single value and its children from current cursor.
+/// \param[in, out] parser
+///   The parser state.
+/// \param depth
+///   Nesting depth of this value.
+/// \return
+///   A \c resp_parse_error if failed to parse the value.
+static auto parse_value(resp_parser &parser, std::size_t depth) noexcept
+    -> std::expected<void, resp_parse_error> {
+    if (depth >= resp_message::max_depth) [[unlikely]]
+        return std::unexpected(resp_parse_error::invalid);
+
+    // Attributes are out-of-band metadata of the following value and are discarded.
+    while (true) {
+        if (parser.cursor >= parser.data.size())
+            return std::unexpected(resp_parse_error::incomplete);
+
+        char        prefix = parser.data[parser.cursor++];
+        std::size_t index  = parser.nodes.size();
+        std::string_view line;
+
+        if (auto result = read_line(parser, line); !result.has_value())
+            return result;
+
+        if (parser.cursor > max_message_size) [[unlikely]]
+            return std::unexpected(resp_parse_error::invalid);
+
+        detail::resp_node node{
+            .type    = static_cast<resp_type>(prefix),
+            .size    = 0,
+            .span    = 1,
+            .offset  = static_cast<std::uint32_t>(line.data() - parser.data.data()),
+            .length  = static_cast<std::uint32_t>(line.size()),
+            .integer = 0,
+        };
+
+        switch (prefix) {
+        case '+':
+        case '-':
+            parser.nodes.push_back(node);
+            return {};
+
+        case ',':
+            if (line.empty())
+                return std::unexpected(resp_parse_error::invalid);
+            parser.nodes.push_back(node);
+            return {};
+
+        case '(': {
+            std::string_view digits = line;
+            if (digits.starts_with('+') || digits.starts_with('-'))
+                digits.remove_prefix(1);
+            if (digits.empty() || digits.find_first_not_of("0123456789") != digits.npos)
+                return std::unexpected(resp_parse_error::invalid);
+            parser.nodes.push_back(node);
+            return {};
+        }
+
+        case ':':
+            if (!parse_integer(line, node.integer))
+                return std::unexpected(resp_parse_error::invalid);
+            node.length = 0;
+            parser.nodes.push_back(node);
+            return {};
+
+        case '_':
+            if (!line.empty())
+                return std::unexpected(resp_parse_error::invalid);
+            node.length = 0;
+            parser.nodes.push_back(node);
+            return {};
+
+        case '#':
+            if (line != "t" && line != "f")
+                return std::unexpected(resp_parse_error::invalid);
+            node.integer = (line[0] == 't');
+            node.length  = 0;
+            parser.nodes.push_back(node);
+            return {};
+
+        case '$':
+        case '!':
+        case '=': {
+            std::int64_t length;
+            if (!parse_integer(line, length))
+                return std::unexpected(resp_parse_error::invalid);
+
+            // RESP2 null bulk string.
+            if (length == -1 && prefix == '$') {
+                node.type   = resp_type::null;
+                node.length = 0;
+                parser.nodes.push_back(node);
+                return {};
+            }
+
+            if (length < 0 || static_cast<std::uint64_t>(length) > max_message_size)
+                return std::unexpected(resp_parse_error::invalid);
+
+            // Verbatim strings start with a 3-byte format and a colon.
+            if (prefix == '=' && length < 4)
+                return std::unexpected(resp_parse_error::invalid);
+
+            std::size_t size = static_cast<std::size_t>(length);
+            if (parser.data.size() - parser.cursor < size + 2)
+                return std::unexpected(resp_parse_error::incomplete);
+
+            const char *payload = parser.data.data() + parser.cursor;
+            if (payload[size] != '\r' || payload[size + 1] != '\n')
+                return std::unexpected(resp_parse_error::invalid);
+
+            parser.cursor += size + 2;
+            if (parser.cursor > max_message_size) [[unlikely]]
+                return std::unexpected(resp_parse_error::invalid);
+
+            node.offset = static_cast<std::uint32_t>(payload - parser.data.data());
+            node.length = static_cast<std::uint32_t>(size);
+            parser.nodes.push_back(node);
+            return {};
+        }
+
+        case '*':
+        case '%':
+        case '~':
+        case '>':
+        case '|': {
+            std::int64_t count;
+            if (!parse_integer(line, count))
+                return std::unexpected(resp_parse_error::invalid);
+
+            // RESP2 null array.
+            if (count == -1 && prefix == '*') {
+                node.type   = resp_type::null;
+                node.length = 0;
+                parser.nodes.push_back(node);
+                return {};
+            }
+
+            if (count < 0 || count > std::numeric_limits<std::uint32_t>::max() / 2)
+                return std::unexpected(resp_parse_error::invalid);
+
+            if (prefix == '%' || prefix == '|')
+                count *= 2;
+
+            node.size   = static_cast<std::uint32_t>(count);
+            node.length = 0;
+            parser.nodes.push_back(node);
+
+            for (std::int64_t i = 0; i < count; ++i) {
+                if (auto result = parse_value(parser, depth + 1); !result.has_value())
+                    return result;
+            }
+
+            if (prefix == '|') {
+                parser.nodes.resize(index);
+                continue;
+            }
+
+            parser.nodes[index].span = static_cast<std::uint32_t>(parser.nodes.size() - index);
+            return {};
+        }
+
+        default:
+            // Streamed strings and aggregates are not supported.
+            return std::unexpected(resp_parse_error::invalid);
+        }
+    }
+}
+
+auto ossia::parse_resp(std::string_view data, resp_message &message) noexcept
+    -> std::expected<std::size_t, resp_parse_error> {
+    message.m_nodes.clear();
+
+    resp_parser parser{
+        .data   = data,
+        .cursor = 0,
+        .nodes  = message.m_nodes,
+    };
+
+    if (auto result = parse_value(parser, 0); !result.has_value()) {
+        message.m_nodes.clear();
+        return std::unexpected(result.error());
+    }
+
+    message.m_storage.reset();
+    message.m_data = data.data();
+    message.m_size = parser.cursor;
+    return parser.cursor;
+}
+
+auto resp_value::number() const noexcept -> double {
+    switch (m_node->type) {
+    case resp_type::integer:
+        return static_cast<double>(m_node->integer);
+
+    case resp_type::double_number:
+    case resp_type::big_number: {
+        std::string_view text = string();
+        if (text.starts_with('+'))
+            text.remove_prefix(1);
+
+        double value;
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec == std::errc() || ec == std::errc::result_out_of_range)
+            return value;
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    default:
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+auto resp_message::detach() -> void {
+    if (m_storage != nullptr && m_storage.get() == m_data)
+        return;
+
+    auto storage = std::make_unique_for_overwrite<char[]>(m_size);
+    std::memcpy(storage.get(), m_data, m_size);
+
+    m_storage = std::move(storage);
+    m_data    = m_storage.get();
+}
+
+/// \brief
+///   Append a type prefix, a decimal integer and CRLF to the output buffer.
+/// \param prefix
+///   The type prefix.
+/// \param value
+///   The integer to be serialized.
+/// \param[out] output
+///   The output buffer.
+static auto write_header(char prefix, std::int64_t value, std::string &output) -> void {
+    char buffer[24];
+    buffer[0] = prefix;
+
+    auto [ptr, ec] = std::to_chars(buffer + 1, buffer + sizeof(buffer) - 2, value);
+    ptr[0]         = '\r';
+    ptr[1]         = '\n';
+
+    output.append(buffer, static_cast<std::size_t>(ptr + 2 - buffer));
+}
+
+auto ossia::write_resp_command(std::span<const std::string_view> args, std::string &output)
+    -> void {
+    std::size_t size = 16;
+    for (std::string_view arg : args)
+        size += arg.size() + 16;
+    output.reserve(output.size() + size);
+
+    write_header('*', static_cast<std::int64_t>(args.size()), output);
+    for (std::string_view arg : args)
+        write_resp_bulk_string(arg, output);
+}
+
+auto ossia::write_resp_simple_string(std::string_view value, std::string &output) -> void {
+    output.push_back('+');
+    output.append(value);
+    output.append("\r\n");
+}
+
+auto ossia::write_resp_error(std::string_view message, std::string &output) -> void {
+    output.push_back('-');
+    output.append(message);
+    output.append("\r\n");
+}
+
+auto ossia::write_resp_integer(std::int64_t value, std::string &output) -> void {
+    write_header(':', value, output);
+}
+
+auto ossia::write_resp_bulk_string(std::string_view value, std::string &output) -> void {
+    write_header('$', static_cast<std::int64_t>(value.size()), output);
+    output.append(value);
+    output.append("\r\n");
+}
+
+auto ossia::write_resp_null(std::string &output) -> void {
+    output.append("$-1\r\n");
+}
+
+auto ossia::write_resp_aggregate(resp_type type, std::size_t size, std::string &output) -> void {
+    write_header(static_cast<char>(type), static_cast<std::int64_t>(size), output);
+}
@@ -0,0 +1,251 @@
+#include "ossia/resp_client.hpp"
+
+#include <cstring>
+#include <limits>
+
+using namespace ossia;
+
+/// \brief
+///   Maximum size in byte of a single send or receive operation.
+static constexpr std::size_t max_io_size = std::numeric_limits<std::uint32_t>::max();
+
+struct resp_client::request {
+    /// \brief
+    ///   C++20 coroutine API method. Always suspend until the reply is received.
+    /// \return
+    ///   This function always returns \c false.
+    static constexpr auto await_ready() noexcept -> bool {
+        return false;
+    }
+
+    /// \brief
+    ///   Store the waiting coroutine and suspend it.
+    /// \tparam T
+    ///   Type of promise of current coroutine.
+    /// \param coroutine
+    ///   Current coroutine handle.
+    template <class T>
+    auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> void {
+        promise = &static_cast<detail::promise_base &>(coroutine.promise());
+    }
+
+    /// \brief
+    ///   C++20 coroutine API method. The result is read from \c result.
+    static constexpr auto await_resume() noexcept -> void {}
+
+    /// \brief
+    ///   Promise of the coroutine that is waiting for the reply.
+    detail::promise_base *promise;
+
+    /// \brief
+    ///   Next command in the pipeline.
+    request *next;
+
+    /// \brief
+    ///   The reply or the error.
+    std::expected<resp_message, std::error_code> result;
+};
+
+resp_client::resp_client(std::size_t limit) noexcept
+    : m_stream(),
+      m_data(),
+      m_begin(),
+      m_end(),
+      m_capacity(),
+      m_limit(limit),
+      m_head(),
+      m_tail(),
+      m_flushing(),
+      m_receiving(),
+      m_error(),
+      m_pending(),
+      m_sending() {}
+
+resp_client::resp_client(tcp_stream stream, std::size_t limit) noexcept
+    : m_stream(std::move(stream)),
+      m_data(),
+      m_begin(),
+      m_end(),
+      m_capacity(),
+      m_limit(limit),
+      m_head(),
+      m_tail(),
+      m_flushing(),
+      m_receiving(),
+      m_error(),
+      m_pending(),
+      m_sending() {}
+
+resp_client::~resp_client() = default;
+
+auto resp_client::connect_async(const inet_address &address) noexcept
+    -> future<std::error_code> {
+    tcp_stream stream;
+
+    auto error = co_await stream.connect_async(address);
+    if (error) [[unlikely]]
+        co_return error;
+
+    stream.set_no_delay(true);
+
+    m_stream = std::move(stream);
+    m_begin  = 0;
+    m_end    = 0;
+    m_error  = std::error_code();
+    m_pending.clear();
+
+    co_return std::error_code();
+}
+
+auto resp_client::execute_async(std::span<const std::string_view> args) noexcept
+    -> future<std::expected<resp_message, std::error_code>> {
+    if (m_error) [[unlikely]]
+        co_return std::unexpected(m_error);
+
+    write_resp_command(args, m_pending);
+
+    request command{
+        .promise = nullptr,
+        .next    = nullptr,
+        .result  = std::unexpected(std::error_code()),
+    };
+
+    if (m_tail == nullptr)
+        m_head = &command;
+    else
+        m_tail->next = &command;
+    m_tail = &command;
+
+    // Commands issued in this iteration are sent together by a single flush in the next
+    // iteration.
+    if (!m_flushing) {
+        m_flushing = true;
+        schedule(flush());
+    }
+
+    if (!m_receiving) {
+        m_receiving = true;
+        schedule(receive_loop());
+    }
+
+    co_await command;
+    co_return std::move(command.result);
+}
+
+auto resp_client::flush() noexcept -> future<> {
+    while (!m_pending.empty() && !m_error) {
+        m_sending.swap(m_pending);
+
+        std::size_t sent = 0;
+        while (sent < m_sending.size()) {
+            std::size_t size   = std::min<std::size_t>(m_sending.size() - sent, max_io_size);
+            auto        result = co_await m_stream.send_async(m_sending.data() + sent,
+                                                              static_cast<std::uint32_t>(size));
+
+            if (!result.has_value()) [[unlikely]] {
+                m_sending.clear();
+                m_flushing = false;
+                this->fail(result.error());
+                co_return;
+            }
+
+            sent += *result;
+        }
+
+        m_sending.clear();
+    }
+
+    m_flushing = false;
+}
+
+auto resp_client::receive_loop() noexcept -> future<> {
+    auto *worker = detail::io_context_worker::current();
+
+    resp_message reply;
+    while (m_head != nullptr && !m_error) {
+        auto parsed = parse_resp(std::string_view(m_data.get() + m_begin, m_end - m_begin), reply);
+        if (parsed.has_value()) {
+            m_begin += *parsed;
+
+            // Out-of-band push messages are not replies to commands.
+            if (reply.root().type() == resp_type::push)
+                continue;
+
+            // The receive buffer is reused for following replies.
+            reply.detach();
+
+            request *command = m_head;
+            m_head           = command->next;
+            if (m_head == nullptr)
+                m_tail = nullptr;
+
+            command->result = std::move(reply);
+            worker->post(command->promise);
+            continue;
+        }
+
+        if (parsed.error() == resp_parse_error::invalid) [[unlikely]] {
+            this->fail(std::make_error_code(std::errc::protocol_error));
+            break;
+        }
+
+        // Make room for the rest of the reply.
+        if (m_begin != 0) {
+            std::memmove(m_data.get(), m_data.get() + m_begin, m_end - m_begin);
+            m_end  -= m_begin;
+            m_begin = 0;
+        }
+
+        if (m_end == m_capacity) {
+            if (m_capacity >= m_limit) [[unlikely]] {
+                this->fail(std::make_error_code(std::errc::message_size));
+                break;
+            }
+
+            std::size_t capacity = std::max(default_buffer_size, m_capacity * 2);
+            capacity             = std::min(capacity, m_limit);
+
+            auto data = std::make_unique_for_overwrite<char[]>(capacity);
+            if (m_end != 0)
+                std::memcpy(data.get(), m_data.get(), m_end);
+
+            m_data     = std::move(data);
+            m_capacity = capacity;
+        }
+
+        std::size_t size   = std::min(m_capacity - m_end, max_io_size);
+        auto        result = co_await m_stream.receive_async(m_data.get() + m_end,
+                                                             static_cast<std::uint32_t>(size));
+
+        if (!result.has_value()) [[unlikely]] {
+            this->fail(result.error());
+            break;
+        }
+
+        if (*result == 0) [[unlikely]] {
+            this->fail(std::make_error_code(std::errc::connection_reset));
+            break;
+        }
+
+        m_end += *result;
+    }
+
+    m_receiving = false;
+}
+
+auto resp_client::fail(std::error_code error) noexcept -> void {
+    auto *worker = detail::io_context_worker::current();
+
+    m_error = error;
+    m_pending.clear();
+
+    while (m_head != nullptr) {
+        request *command = m_head;
+        m_head           = command->next;
+
+        command->result = std::unexpected(error);
+        worker->post(command->promise);
+    }
+
+    m_tail = nullptr;
+}
@@ -0,0 +1,301 @@
+#include "ossia/signal_set.hpp"
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <liburing.h>
+#    include <pthread.h>
+#    include <signal.h>
+#    include <sys/signalfd.h>
+#    include <ucontext.h>
+#    include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+inline constexpr std::uintptr_t invalid_handle = static_cast<std::uintptr_t>(-1);
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+static_assert(sizeof(signalfd_siginfo) <= 128);
+
+/// \struct signal_registry
+/// \brief
+///   Process-wide reference counts and previous actions of signals owned by \c signal_set.
+struct signal_registry {
+    std::mutex       mutex;
+    std::uint32_t    count[65];
+    struct sigaction previous[65];
+};
+
+/// \brief
+///   Get the process-wide signal registry.
+[[nodiscard]]
+static auto registry() noexcept -> signal_registry & {
+    static signal_registry instance{};
+    return instance;
+}
+
+/// \brief
+///   Signals that are contained by any \c signal_set. Bit \c i-1 stands for signal \c i.
+static std::atomic_uint64_t owned_signals;
+
+/// \brief
+///   Value of \c owned_signals that the signal mask of the calling thread is synchronized with.
+static thread_local std::uint64_t synced_signals;
+
+/// \brief
+///   Signals blocked in the calling thread by \c signal_set. Signals that were blocked before are
+///   not included, so that they are left blocked once released. This is atomic because the
+///   forwarding handler updates it as well. The handler must not go through \c __tls_get_addr,
+///   which may allocate, so the initial-exec model is used even in shared library builds.
+[[gnu::tls_model("initial-exec")]]
+static constinit thread_local std::atomic_uint64_t blocked_signals;
+
+/// \brief
+///   Convert a bit mask of signals to a signal set.
+/// \param signals
+///   Bit mask of signals. Bit \c i-1 stands for signal \c i.
+/// \return
+///   The signal set.
+[[nodiscard]]
+static auto make_sigset(std::uint64_t signals) noexcept -> sigset_t {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int i = 1; i <= 64; ++i) {
+        if ((signals & (std::uint64_t(1) << (i - 1))) != 0)
+            sigaddset(&mask, i);
+    }
+    return mask;
+}
+
+/// \brief
+///   Signal handler for threads that have not blocked a signal owned by \c signal_set. The signal
+///   is blocked in the interrupted thread once the handler returns, and raised again so that it is
+///   left pending for the process and read by the \c signalfd. The interrupted thread unblocks
+///   the signal again in \c sync_signal_mask once the signal is released.
+static auto forward_signal(int signal, siginfo_t *info, void *context) noexcept -> void {
+    (void)info;
+    auto *uc = static_cast<ucontext_t *>(context);
+    sigaddset(&uc->uc_sigmask, signal);
+    blocked_signals.fetch_or(std::uint64_t(1) << (signal - 1), std::memory_order_relaxed);
+    kill(getpid(), signal);
+}
+
+/// \brief
+///   Block signals contained by any \c signal_set in the calling thread and unblock signals that
+///   are released by all of them. Workers call this in each iteration through the iteration hook,
+///   so the signal masks of all workers follow the signals owned by \c signal_set objects.
+static auto sync_signal_mask() noexcept -> void {
+    std::uint64_t owned   = owned_signals.load(std::memory_order_acquire);
+    std::uint64_t blocked = blocked_signals.load(std::memory_order_relaxed);
+
+    // The forwarding handler may block a signal without changing the owned signals.
+    if (owned == synced_signals && (blocked & ~owned) == 0) [[likely]]
+        return;
+
+    // Only signals that are not blocked yet are recorded, so that blocks of the user are kept.
+    if (std::uint64_t added = owned & ~blocked; owned != synced_signals && added != 0) {
+        sigset_t mask = make_sigset(added);
+        sigset_t previous;
+        pthread_sigmask(SIG_BLOCK, &mask, &previous);
+
+        for (int i = 1; i <= 64; ++i) {
+            std::uint64_t bit = std::uint64_t(1) << (i - 1);
+            if ((added & bit) != 0 && sigismember(&previous, i) == 0)
+                blocked_signals.fetch_or(bit, std::memory_order_relaxed);
+        }
+    }
+
+    synced_signals = owned;
+
+    blocked = blocked_signals.load(std::memory_order_relaxed);
+    if (std::uint64_t removed = blocked & ~owned; removed != 0) {
+        sigset_t mask = make_sigset(removed);
+        blocked_signals.fetch_and(~removed, std::memory_order_relaxed);
+        pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
+    }
+}
+
+/// \brief
+///   Install the forwarding handler for the specified signal if this is the first reference, and
+///   block the signal in the calling thread. Workers block the signal in their next iteration.
+/// \param signal
+///   The signal to acquire.
+/// \return
+///   A system error code that indicates the result of the operation.
+static auto acquire_signal(int signal) noexcept -> std::error_code {
+    signal_registry &r = registry();
+    std::lock_guard  lock(r.mutex);
+
+    if (r.count[signal] == 0) {
+        struct sigaction action{};
+        action.sa_sigaction = &forward_signal;
+        action.sa_flags     = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+
+        if (sigaction(signal, &action, &r.previous[signal]) == -1) [[unlikely]]
+            return std::error_code(errno, std::system_category());
+
+        owned_signals.fetch_or(std::uint64_t(1) << (signal - 1), std::memory_order_release);
+
+        // Workers follow the owned signals in each iteration.
+        set_iteration_hook(&sync_signal_mask);
+    }
+
+    ++r.count[signal];
+    sync_signal_mask();
+
+    return {};
+}
+
+/// \brief
+///   Release a reference of the specified signal. The previous signal action is restored and the
+///   signal is unblocked in the calling thread if this is the last reference. Workers unblock the
+///   signal in their next iteration.
+/// \param signal
+///   The signal to release.
+static auto release_signal(int signal) noexcept -> void {
+    signal_registry &r = registry();
+    std::lock_guard  lock(r.mutex);
+
+    assert(r.count[signal] != 0);
+    if (--r.count[signal] != 0)
+        return;
+
+    sigaction(signal, &r.previous[signal], nullptr);
+    owned_signals.fetch_and(~(std::uint64_t(1) << (signal - 1)), std::memory_order_release);
+    sync_signal_mask();
+}
+#endif
+
+auto signal_set::wait_awaitable::await_resume() const noexcept
+    -> std::expected<int, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return std::unexpected(std::make_error_code(std::errc::operation_not_supported));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_ovlp.result < 0) [[unlikely]]
+        return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+
+    if (m_ovlp.result != sizeof(signalfd_siginfo)) [[unlikely]]
+        return std::unexpected(std::make_error_code(std::errc::io_error));
+
+    const auto *info = reinterpret_cast<const signalfd_siginfo *>(m_info);
+    return static_cast<int>(info->ssi_signo);
+#endif
+}
+
+auto signal_set::wait_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_handle == invalid_handle) [[unlikely]] {
+        m_ovlp.result = -EBADF;
+        return false;
+    }
+
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    auto *sqe = static_cast<io_uring_sqe *>(worker->acquire_sqe(m_ovlp.result));
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+    io_uring_prep_read(sqe, static_cast<int>(m_handle), m_info, sizeof(signalfd_siginfo), 0);
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+signal_set::signal_set() noexcept : m_handle(invalid_handle), m_signals() {}
+
+signal_set::signal_set(std::initializer_list<int> signals)
+    : m_handle(invalid_handle),
+      m_signals() {
+    for (int signal : signals) {
+        std::error_code error = this->add(signal);
+        if (error.value() != 0) [[unlikely]] {
+            this->clear();
+            throw std::system_error(error, "Failed to add signal");
+        }
+    }
+}
+
+signal_set::signal_set(signal_set &&other) noexcept
+    : m_handle(other.m_handle),
+      m_signals(other.m_signals) {
+    other.m_handle  = invalid_handle;
+    other.m_signals = 0;
+}
+
+signal_set::~signal_set() {
+    this->clear();
+}
+
+auto signal_set::operator=(signal_set &&other) noexcept -> signal_set & {
+    if (this == &other) [[unlikely]]
+        return *this;
+
+    this->clear();
+
+    m_handle        = other.m_handle;
+    m_signals       = other.m_signals;
+    other.m_handle  = invalid_handle;
+    other.m_signals = 0;
+
+    return *this;
+}
+
+auto signal_set::add(int signal) noexcept -> std::error_code {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    (void)signal;
+    return std::make_error_code(std::errc::operation_not_supported);
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (signal <= 0 || signal > 64 || signal == SIGKILL || signal == SIGSTOP) [[unlikely]]
+        return std::make_error_code(std::errc::invalid_argument);
+
+    if (this->contains(signal))
+        return {};
+
+    std::error_code error = acquire_signal(signal);
+    if (error.value() != 0) [[unlikely]]
+        return error;
+
+    std::uint64_t signals = m_signals | (std::uint64_t(1) << (signal - 1));
+    sigset_t      mask    = make_sigset(signals);
+
+    // Update the mask of the existing signalfd so that pending wait operations are not affected.
+    int fd     = (m_handle == invalid_handle) ? -1 : static_cast<int>(m_handle);
+    int result = signalfd(fd, &mask, SFD_CLOEXEC);
+    if (result == -1) [[unlikely]] {
+        int code = errno;
+        release_signal(signal);
+        return std::error_code(code, std::system_category());
+    }
+
+    m_handle  = static_cast<std::uintptr_t>(result);
+    m_signals = signals;
+
+    return {};
+#endif
+}
+
+auto signal_set::clear() noexcept -> void {
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    for (int i = 1; i <= 64; ++i) {
+        if ((m_signals & (std::uint64_t(1) << (i - 1))) != 0)
+            release_signal(i);
+    }
+
+    if (m_handle != invalid_handle)
+        close(static_cast<int>(m_handle));
+#endif
+
+    m_handle  = invalid_handle;
+    m_signals = 0;
+}
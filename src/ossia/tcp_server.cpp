@@ -9,11 +9,23 @@
 #    include <netinet/in.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 using namespace ossia;
 using namespace ossia::detail;
 
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+// io_uring_prep_fixed_fd_install is available since liburing 2.6.
+#    if defined(IO_URING_VERSION_MAJOR) &&                                                         \
+        (IO_URING_VERSION_MAJOR * 100 + IO_URING_VERSION_MINOR >= 206)
+#        define OSSIA_IO_URING_FIXED_FD_INSTALL 1
+#    else
+#        define OSSIA_IO_URING_FIXED_FD_INSTALL 0
+#    endif
+#endif
+
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
 inline constexpr std::uintptr_t invalid_socket = INVALID_SOCKET;
 #else
@@ -41,6 +53,29 @@ auto tcp_server::accept_awaitable::await_resume() const noexcept
 }
 
 auto tcp_server::accept_awaitable::await_suspend() noexcept -> bool {
+    // Stop taking new connections while the worker is overloaded. They wait in the listen backlog
+    // instead of adding to the queue delay of accepted connections.
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    if (worker->is_overloaded()) [[unlikely]] {
+        m_admission.promise = m_ovlp.promise;
+        m_admission.expire  = &submit_admitted;
+        m_admission.context = this;
+        worker->wait_for_admission(&m_admission);
+        return true;
+    }
+
+    return this->submit();
+}
+
+auto tcp_server::accept_awaitable::submit_admitted(timer_entry *entry) noexcept -> void {
+    auto *self = static_cast<accept_awaitable *>(entry->context);
+    if (!self->submit())
+        io_context_worker::current()->post(entry->promise);
+}
+
+auto tcp_server::accept_awaitable::submit() noexcept -> bool {
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     // Create a new socket for the incoming connection.
     auto *addr = reinterpret_cast<sockaddr *>(&m_address);
@@ -75,12 +110,24 @@ auto tcp_server::accept_awaitable::await_suspend() noexcept -> bool {
     LPFN_ACCEPTEX accept_ex = reinterpret_cast<LPFN_ACCEPTEX>(m_server->m_accept_ex);
     assert(accept_ex != nullptr);
 
+    // Receive the first bytes together with the connection if the buffer has room for data
+    // besides the addresses that AcceptEx places after the data. AcceptEx could not time out the
+    // receive alone, so accepts with a timeout of the first receive only accept.
+    bool  has_timeout = (m_timeout.seconds != 0 || m_timeout.nanoseconds != 0);
+    void *output      = &m_address;
+    DWORD receive     = 0;
+    if (m_size > accept_address_space && !has_timeout) {
+        output  = m_data;
+        receive = m_size - accept_address_space;
+    }
+
     // Try to accept a new incoming connection.
     // FIXME: Is it safe to make bytes a temporary variable?
     DWORD bytes = 0;
-    if (accept_ex(m_server->m_socket, m_socket, &m_address, 0, 0, sizeof(m_address) + 16, &bytes,
+    if (accept_ex(m_server->m_socket, m_socket, output, receive, 0, accept_address_space, &bytes,
                   reinterpret_cast<LPOVERLAPPED>(&m_ovlp)) == TRUE) {
-        m_ovlp.error = 0;
+        m_ovlp.error             = 0;
+        m_ovlp.bytes_transferred = bytes;
         return false;
     }
 
@@ -95,17 +142,18 @@ auto tcp_server::accept_awaitable::await_suspend() noexcept -> bool {
     auto *worker = io_context_worker::current();
     assert(worker != nullptr);
 
-    io_uring     *ring = static_cast<io_uring *>(worker->muxer());
-    io_uring_sqe *sqe  = io_uring_get_sqe(ring);
-    while (sqe == nullptr) [[unlikely]] {
-        int result = io_uring_submit(ring);
-        if (result < 0) [[unlikely]] {
-            m_ovlp.result = result;
-            return false;
-        }
-
-        sqe = io_uring_get_sqe(ring);
+#    if OSSIA_IO_URING_FIXED_FD_INSTALL
+    // Link the first receive if a direct descriptor slot is available.
+    if (m_size != 0) {
+        std::int32_t slot = worker->acquire_direct_descriptor();
+        if (slot >= 0)
+            return this->submit_linked(slot);
     }
+#    endif
+
+    auto *sqe = static_cast<io_uring_sqe *>(worker->acquire_sqe(m_ovlp.result));
+    if (sqe == nullptr) [[unlikely]]
+        return false;
 
     // m_socket is not used on Linux. A dirty hack, but works.
     sockaddr  *addr    = reinterpret_cast<sockaddr *>(&m_address);
@@ -121,6 +169,132 @@ auto tcp_server::accept_awaitable::await_suspend() noexcept -> bool {
 #endif
 }
 
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+auto tcp_server::accept_awaitable::submit_linked(std::int32_t slot) noexcept -> bool {
+#    if OSSIA_IO_URING_FIXED_FD_INSTALL
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    // The first receive is linked with a timeout, so a connection that sends nothing does not
+    // hold the slot for long.
+    bool          has_timeout = (m_timeout.seconds != 0 || m_timeout.nanoseconds != 0);
+    std::uint32_t count       = has_timeout ? 5 : 4;
+
+    void *entries[5];
+    if (std::int32_t error = worker->acquire_sqes(entries, count); error != 0) [[unlikely]] {
+        worker->release_direct_descriptor(slot);
+        m_ovlp.result = error;
+        return false;
+    }
+
+    m_slot    = slot;
+    m_pending = static_cast<std::int32_t>(count);
+    for (auto &step : m_steps) {
+        step.complete = &complete_linked;
+        step.owner    = this;
+    }
+
+    // m_socket is not used on Linux. A dirty hack, but works.
+    sockaddr  *addr    = reinterpret_cast<sockaddr *>(&m_address);
+    socklen_t *addrlen = reinterpret_cast<socklen_t *>(&m_socket);
+    *addrlen           = sizeof(m_address);
+
+    auto  index = static_cast<unsigned>(slot);
+    auto **sqes = reinterpret_cast<io_uring_sqe **>(entries);
+
+    // Operations after the accept are cancelled if the accept fails, so the slot stays empty.
+    // Once the connection is in the slot, hard links make sure that the slot is always closed.
+    // Direct descriptors have no close-on-exec flag. The installed descriptor has it by default.
+    io_uring_prep_accept_direct(sqes[0], m_server->m_socket, addr, addrlen, 0, index);
+    io_uring_sqe_set_flags(sqes[0], IOSQE_IO_LINK);
+
+    // Install the connection as a regular descriptor so that it works with all IO operations.
+    io_uring_prep_fixed_fd_install(sqes[1], static_cast<int>(index), 0);
+    io_uring_sqe_set_flags(sqes[1], IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK);
+
+    io_uring_prep_recv(sqes[2], static_cast<int>(index), m_data, m_size, 0);
+    io_uring_sqe_set_flags(sqes[2], IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK);
+
+    // A receive that times out is cancelled and the connection is returned without data.
+    if (has_timeout) {
+        auto *timeout = reinterpret_cast<__kernel_timespec *>(&m_timeout);
+        io_uring_prep_link_timeout(sqes[3], timeout, 0);
+        io_uring_sqe_set_flags(sqes[3], IOSQE_IO_HARDLINK);
+    }
+
+    io_uring_prep_close_direct(sqes[count - 1], index);
+    io_uring_sqe_set_flags(sqes[count - 1], 0);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        auto *step = static_cast<multishot_overlapped *>(&m_steps[i]);
+        io_uring_sqe_set_data64(sqes[i], reinterpret_cast<std::uintptr_t>(step) | multishot_tag);
+    }
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#    else
+    (void)slot;
+    return false;
+#    endif
+}
+
+auto tcp_server::accept_awaitable::complete_linked(multishot_overlapped *ovlp) noexcept -> void {
+    auto *self = static_cast<linked_overlapped *>(ovlp)->owner;
+    if (--self->m_pending != 0)
+        return;
+
+    // The slot is empty once the close operation is completed.
+    auto *worker = io_context_worker::current();
+    worker->release_direct_descriptor(self->m_slot);
+    worker->post(self->m_ovlp.promise);
+}
+#endif
+
+auto tcp_server::accept_receive_awaitable::await_resume() const noexcept
+    -> std::expected<accepted_stream, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    bool has_timeout = (m_timeout.seconds != 0 || m_timeout.nanoseconds != 0);
+    if (m_size <= accept_address_space || has_timeout || m_ovlp.error != 0) {
+        auto stream = accept_awaitable::await_resume();
+        if (!stream.has_value()) [[unlikely]]
+            return std::unexpected(stream.error());
+        return accepted_stream{std::move(*stream), 0};
+    }
+
+    // AcceptEx places the remote address after the received data.
+    inet_address address;
+    std::memcpy(&address, static_cast<char *>(m_data) + (m_size - accept_address_space),
+                sizeof(address));
+
+    return accepted_stream{
+        tcp_stream(m_socket, address),
+        static_cast<std::uint32_t>(m_ovlp.bytes_transferred),
+    };
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_slot < 0) {
+        auto stream = accept_awaitable::await_resume();
+        if (!stream.has_value()) [[unlikely]]
+            return std::unexpected(stream.error());
+        return accepted_stream{std::move(*stream), 0};
+    }
+
+    // The connection is closed with the slot if it failed to be installed.
+    std::int32_t accepted  = m_steps[0].result;
+    std::int32_t installed = m_steps[1].result;
+    std::int32_t received  = m_steps[2].result;
+
+    if (accepted < 0) [[unlikely]]
+        return std::unexpected(std::error_code(-accepted, std::system_category()));
+    if (installed < 0) [[unlikely]]
+        return std::unexpected(std::error_code(-installed, std::system_category()));
+
+    return accepted_stream{
+        tcp_stream(installed, m_address),
+        static_cast<std::uint32_t>(std::max(received, 0)),
+    };
+#endif
+}
+
 tcp_server::tcp_server() noexcept : m_socket(invalid_socket), m_address() {
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     m_accept_ex = nullptr;
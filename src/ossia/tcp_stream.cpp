@@ -5,12 +5,16 @@
 #    include <WinSock2.h>
 #    include <mswsock.h>
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <fcntl.h>
 #    include <liburing.h>
 #    include <netinet/in.h>
 #    include <netinet/tcp.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <type_traits>
+#include <vector>
 
 using namespace ossia;
 using namespace ossia::detail;
@@ -21,9 +25,412 @@ inline constexpr std::uintptr_t invalid_socket = INVALID_SOCKET;
 inline constexpr std::uintptr_t invalid_socket = static_cast<std::uintptr_t>(-1);
 #endif
 
+/// \brief
+///   Clamp the timeout of an IO operation to the deadline of the task context of a coroutine.
+/// \param promise
+///   Promise of the coroutine that issues the IO operation.
+/// \param[in, out] timeout
+///   Timeout of the IO operation. Zero means never timeout.
+/// \retval true
+///   The IO operation could be issued with \p timeout.
+/// \retval false
+///   The deadline has passed and the IO operation should time out at once.
+[[nodiscard]]
+static auto clamp_to_deadline(const promise_base &promise, kernel_timespec &timeout) noexcept
+    -> bool {
+    const task_context *context = promise.context();
+    if (context == nullptr || !context->has_deadline()) [[likely]]
+        return true;
+
+    auto remaining = context->remaining();
+    if (remaining <= std::chrono::steady_clock::duration::zero())
+        return false;
+
+    auto current = std::chrono::seconds(timeout.seconds) +
+                   std::chrono::nanoseconds(timeout.nanoseconds);
+    if (current == std::chrono::nanoseconds::zero() || remaining < current)
+        timeout = make_kernel_timespec(remaining);
+
+    return true;
+}
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+/// \brief
+///   Start a threadpool timer that cancels a pending operation once its timeout expires. Nothing
+///   is done if the operation has no timeout.
+/// \param[in, out] ovlp
+///   Overlapped structure of the pending operation.
+/// \param socket
+///   The socket that the operation is pending on.
+static auto start_timeout(timed_overlapped &ovlp, std::uintptr_t socket) noexcept -> void {
+    if (ovlp.timeout.seconds == 0 && ovlp.timeout.nanoseconds == 0)
+        return;
+
+    // Only a cancellation made by the timer is reported as a timeout.
+    auto callback = [](PTP_CALLBACK_INSTANCE, PVOID context, PTP_TIMER) -> void {
+        auto *target = static_cast<timed_overlapped *>(context);
+        if (CancelIoEx(reinterpret_cast<HANDLE>(target->socket),
+                       reinterpret_cast<LPOVERLAPPED>(target)) == TRUE)
+            target->expired = true;
+    };
+
+    ovlp.socket     = socket;
+    PTP_TIMER timer = CreateThreadpoolTimer(callback, &ovlp, nullptr);
+    if (timer != nullptr) [[likely]] {
+        // Negative due time means relative time in 100 nanoseconds.
+        auto time = -(ovlp.timeout.seconds * 10000000 + ovlp.timeout.nanoseconds / 100);
+        FILETIME due{
+            .dwLowDateTime  = static_cast<DWORD>(time),
+            .dwHighDateTime = static_cast<DWORD>(time >> 32),
+        };
+
+        SetThreadpoolTimer(timer, &due, 0, 0);
+        ovlp.timer = timer;
+    }
+}
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+/// \brief
+///   Completion handler of an operation with a linked timeout. The awaiting coroutine is resumed
+///   once both the operation and the timeout are completed, so that the timeout is never reaped
+///   after the awaitable is destroyed.
+/// \param[in] ovlp
+///   The \c timed_overlapped object of the operation.
+static auto complete_timed(multishot_overlapped *ovlp) noexcept -> void {
+    auto *self = static_cast<timed_overlapped *>(ovlp);
+    if (--self->pending == 0)
+        io_context_worker::current()->post(self->promise);
+}
+
+/// \brief
+///   Completion handler of a linked timeout.
+/// \param[in] ovlp
+///   The \c expiry member of the \c timed_overlapped object of the operation.
+static auto complete_expiry(multishot_overlapped *ovlp) noexcept -> void {
+    complete_timed(static_cast<timed_overlapped::expiry_overlapped *>(ovlp)->owner);
+}
+
+/// \brief
+///   Link a timeout to an operation. The completions of both are handled by the overlapped
+///   structure of the operation.
+/// \param[in, out] ovlp
+///   Overlapped structure of the operation.
+/// \param[out] operation
+///   The prepared submission queue entry of the operation.
+/// \param[out] timeout
+///   The submission queue entry right after \p operation to prepare the timeout in.
+static auto link_timeout(timed_overlapped &ovlp,
+                         io_uring_sqe     *operation,
+                         io_uring_sqe     *timeout) noexcept -> void {
+    ovlp.complete        = &complete_timed;
+    ovlp.expiry.complete = &complete_expiry;
+    ovlp.expiry.owner    = &ovlp;
+    ovlp.pending         = 2;
+
+    io_uring_sqe_set_flags(operation, IOSQE_IO_LINK);
+    auto *step = static_cast<multishot_overlapped *>(&ovlp);
+    io_uring_sqe_set_data64(operation, reinterpret_cast<std::uintptr_t>(step) | multishot_tag);
+
+    io_uring_prep_link_timeout(timeout, reinterpret_cast<__kernel_timespec *>(&ovlp.timeout), 0);
+    io_uring_sqe_set_flags(timeout, 0);
+    step = static_cast<multishot_overlapped *>(&ovlp.expiry);
+    io_uring_sqe_set_data64(timeout, reinterpret_cast<std::uintptr_t>(step) | multishot_tag);
+}
+#endif
+
+/// \brief
+///   Check whether an operation is cancelled by its timeout rather than by other cancellations,
+///   and release its timer on Windows.
+/// \param ovlp
+///   Overlapped structure of the completed operation.
+/// \return
+///   Whether the operation is cancelled by its timeout.
+[[nodiscard]]
+static auto release_timeout(const timed_overlapped &ovlp) noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (ovlp.timer == nullptr)
+        return false;
+
+    auto *timer = static_cast<PTP_TIMER>(ovlp.timer);
+    SetThreadpoolTimer(timer, nullptr, 0, 0);
+    WaitForThreadpoolTimerCallbacks(timer, TRUE);
+    CloseThreadpoolTimer(timer);
+
+    return ovlp.expired && ovlp.error == ERROR_OPERATION_ABORTED;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    // The timeout completes with -ETIME only if it expired. It is not issued if the operation
+    // failed to be issued, and its result is left 0 then.
+    return ovlp.result == -ECANCELED && ovlp.expiry.result == -ETIME;
+#endif
+}
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+/// \brief
+///   Maximum number of bytes that could be sent by a single \c TransmitFile call.
+static constexpr std::uint64_t max_transmit_size = 2147483646;
+
+/// \class transmit_awaitable
+/// \brief
+///   Awaitable object for sending part of a file with \c TransmitFile.
+class transmit_awaitable {
+public:
+    /// \brief
+    ///   Create a new \c transmit_awaitable object for asynchronous transmit operation.
+    /// \param socket
+    ///   The socket to send data to.
+    /// \param handle
+    ///   The file to send data from.
+    /// \param offset
+    ///   Offset in byte in the file to start sending from.
+    /// \param size
+    ///   Number of bytes to send.
+    transmit_awaitable(std::uintptr_t socket,
+                       std::uintptr_t handle,
+                       std::uint64_t  offset,
+                       std::uint32_t  size) noexcept
+        : m_ovlp(),
+          m_socket(socket),
+          m_handle(handle),
+          m_size(size) {
+        m_ovlp.offset      = static_cast<std::uint32_t>(offset);
+        m_ovlp.offset_high = static_cast<std::uint32_t>(offset >> 32);
+    }
+
+    /// \brief
+    ///   C++20 coroutine API method. Always execute \c await_suspend().
+    static constexpr auto await_ready() noexcept -> bool {
+        return false;
+    }
+
+    /// \brief
+    ///   Prepare for async transmit operation and suspend the coroutine.
+    template <class T>
+    auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+        m_ovlp.promise = &static_cast<promise_base &>(coroutine.promise());
+
+        auto *ovlp = reinterpret_cast<LPOVERLAPPED>(&m_ovlp);
+        if (TransmitFile(static_cast<SOCKET>(m_socket), reinterpret_cast<HANDLE>(m_handle),
+                         m_size, 0, ovlp, nullptr, 0) == TRUE) {
+            DWORD bytes = 0;
+            DWORD flags = 0;
+            WSAGetOverlappedResult(static_cast<SOCKET>(m_socket), ovlp, &bytes, FALSE, &flags);
+
+            m_ovlp.error             = 0;
+            m_ovlp.bytes_transferred = bytes;
+            return false;
+        }
+
+        DWORD error = WSAGetLastError();
+        if (error == WSA_IO_PENDING || error == ERROR_IO_PENDING) [[likely]]
+            return true;
+
+        m_ovlp.error = error;
+        return false;
+    }
+
+    /// \brief
+    ///   Get the result of the asynchronous transmit operation.
+    /// \return
+    ///   Number of bytes sent if succeeded. Otherwise, return a system error code.
+    auto await_resume() const noexcept -> std::expected<std::uint32_t, std::error_code> {
+        if (m_ovlp.error == 0) [[likely]]
+            return m_ovlp.bytes_transferred;
+
+        return std::unexpected(
+            std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
+    }
+
+private:
+    overlapped     m_ovlp;
+    std::uintptr_t m_socket;
+    std::uintptr_t m_handle;
+    std::uint32_t  m_size;
+};
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+/// \brief
+///   Preferred capacity in byte of pipes used for splicing.
+static constexpr int splice_pipe_size = 1048576;
+
+/// \brief
+///   Maximum number of idle pipes kept by each thread.
+static constexpr std::size_t max_idle_pipes = 16;
+
+/// \struct splice_pipe
+/// \brief
+///   A pipe that is used as the intermediate buffer between a file and a socket.
+struct splice_pipe {
+    int           read;
+    int           write;
+    std::uint32_t capacity;
+};
+
+/// \class splice_pipe_pool
+/// \brief
+///   Per-thread pool of empty pipes. Creating a pipe and resizing its buffer for each transfer
+///   costs several system calls, so pipes are reused once they are drained.
+class splice_pipe_pool {
+public:
+    /// \brief
+    ///   Create an empty pipe pool.
+    splice_pipe_pool() noexcept = default;
+
+    /// \brief
+    ///   Close all idle pipes and destroy this pool.
+    ~splice_pipe_pool() {
+        for (const auto &pipe : m_pipes)
+            close(pipe);
+    }
+
+    /// \brief
+    ///   Take an empty pipe from this pool or create a new one.
+    /// \return
+    ///   An empty pipe if succeeded. Otherwise, return a system error code.
+    auto acquire() noexcept -> std::expected<splice_pipe, std::error_code> {
+        if (!m_pipes.empty()) {
+            splice_pipe pipe = m_pipes.back();
+            m_pipes.pop_back();
+            return pipe;
+        }
+
+        int fds[2];
+        if (::pipe2(fds, O_CLOEXEC) == -1) [[unlikely]]
+            return std::unexpected(std::error_code(errno, std::system_category()));
+
+        // Larger pipes move more pages per splice. This is not fatal if the limit is exceeded.
+        ::fcntl(fds[1], F_SETPIPE_SZ, splice_pipe_size);
+
+        int capacity = ::fcntl(fds[1], F_GETPIPE_SZ);
+        if (capacity <= 0) [[unlikely]] {
+            int error = errno;
+            ::close(fds[0]);
+            ::close(fds[1]);
+            return std::unexpected(std::error_code(error, std::system_category()));
+        }
+
+        return splice_pipe{
+            .read     = fds[0],
+            .write    = fds[1],
+            .capacity = static_cast<std::uint32_t>(capacity),
+        };
+    }
+
+    /// \brief
+    ///   Return an empty pipe to this pool.
+    /// \param pipe
+    ///   The pipe to be returned. The pipe must be drained.
+    auto release(const splice_pipe &pipe) noexcept -> void {
+        if (m_pipes.size() >= max_idle_pipes) {
+            close(pipe);
+            return;
+        }
+
+        try {
+            m_pipes.push_back(pipe);
+        } catch (...) {
+            close(pipe);
+        }
+    }
+
+    /// \brief
+    ///   Close a pipe.
+    /// \param pipe
+    ///   The pipe to be closed.
+    static auto close(const splice_pipe &pipe) noexcept -> void {
+        ::close(pipe.read);
+        ::close(pipe.write);
+    }
+
+private:
+    std::vector<splice_pipe> m_pipes;
+};
+
+static thread_local splice_pipe_pool splice_pipes;
+
+/// \class splice_awaitable
+/// \brief
+///   Awaitable object for moving data between a pipe and a file or socket.
+class splice_awaitable {
+public:
+    /// \brief
+    ///   Create a new \c splice_awaitable object for asynchronous splice operation.
+    /// \param input
+    ///   The file descriptor to move data from.
+    /// \param offset
+    ///   Offset in byte in \p input to start reading from. Use -1 for pipes and sockets.
+    /// \param output
+    ///   The file descriptor to move data to.
+    /// \param size
+    ///   Maximum number of bytes to move.
+    /// \param flags
+    ///   Splice flags.
+    splice_awaitable(int           input,
+                     std::int64_t  offset,
+                     int           output,
+                     std::uint32_t size,
+                     unsigned      flags) noexcept
+        : m_ovlp(),
+          m_input(input),
+          m_offset(offset),
+          m_output(output),
+          m_size(size),
+          m_flags(flags) {}
+
+    /// \brief
+    ///   C++20 coroutine API method. Always execute \c await_suspend().
+    static constexpr auto await_ready() noexcept -> bool {
+        return false;
+    }
+
+    /// \brief
+    ///   Prepare for async splice operation and suspend the coroutine.
+    template <class T>
+    auto await_suspend(std::coroutine_handle<T> coroutine) noexcept -> bool {
+        m_ovlp.promise = &static_cast<promise_base &>(coroutine.promise());
+
+        auto *worker = io_context_worker::current();
+        assert(worker != nullptr);
+
+        auto *sqe = static_cast<io_uring_sqe *>(worker->acquire_sqe(m_ovlp.result));
+        if (sqe == nullptr) [[unlikely]]
+            return false;
+
+        io_uring_prep_splice(sqe, m_input, m_offset, m_output, -1, m_size, m_flags);
+        io_uring_sqe_set_flags(sqe, 0);
+        io_uring_sqe_set_data(sqe, &m_ovlp);
+
+        // IO tasks will be submitted by the worker after this coroutine is suspended.
+        return true;
+    }
+
+    /// \brief
+    ///   Get the result of the asynchronous splice operation.
+    /// \return
+    ///   Number of bytes moved if succeeded. Otherwise, return a system error code.
+    auto await_resume() const noexcept -> std::expected<std::uint32_t, std::error_code> {
+        if (m_ovlp.result >= 0) [[likely]]
+            return static_cast<std::uint32_t>(m_ovlp.result);
+
+        return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+    }
+
+private:
+    overlapped    m_ovlp;
+    int           m_input;
+    std::int64_t  m_offset;
+    int           m_output;
+    std::uint32_t m_size;
+    unsigned      m_flags;
+};
+#endif
+
 auto tcp_stream::connect_awaitable::await_resume() const noexcept -> std::error_code {
+    m_stream->m_connecting = invalid_socket;
+
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
-    if (m_ovlp.error == 0) {
+    DWORD error = m_ovlp.error;
+    if (release_timeout(m_ovlp))
+        error = WSAETIMEDOUT;
+
+    if (error == 0) {
         if (m_stream->m_socket != invalid_socket)
             closesocket(static_cast<SOCKET>(m_stream->m_socket));
 
@@ -36,7 +443,7 @@ auto tcp_stream::connect_awaitable::await_resume() const noexcept -> std::error_
     if (m_socket != invalid_socket)
         closesocket(static_cast<SOCKET>(m_socket));
 
-    return std::error_code(static_cast<int>(m_ovlp.error), std::system_category());
+    return std::error_code(static_cast<int>(error), std::system_category());
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
     if (m_ovlp.result == 0) {
         if (m_stream->m_socket != invalid_socket)
@@ -51,11 +458,26 @@ auto tcp_stream::connect_awaitable::await_resume() const noexcept -> std::error_
     if (m_socket != invalid_socket)
         ::close(static_cast<int>(m_socket));
 
+    if (release_timeout(m_ovlp))
+        return std::make_error_code(std::errc::timed_out);
+
     return std::error_code(-m_ovlp.result, std::system_category());
 #endif
 }
 
 auto tcp_stream::connect_awaitable::await_suspend() noexcept -> bool {
+    m_socket = invalid_socket;
+
+    // The timeout starts now, so it is clamped to the deadline of the task at this point.
+    if (!clamp_to_deadline(*m_ovlp.promise, m_ovlp.timeout)) [[unlikely]] {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+        m_ovlp.error = WSAETIMEDOUT;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+        m_ovlp.result = -ETIMEDOUT;
+#endif
+        return false;
+    }
+
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     auto  *addr = reinterpret_cast<const sockaddr *>(m_address);
     SOCKET s    = WSASocketW(addr->sa_family, SOCK_STREAM, IPPROTO_TCP, nullptr, 0,
@@ -143,11 +565,16 @@ auto tcp_stream::connect_awaitable::await_suspend() noexcept -> bool {
     }
 
     DWORD error = WSAGetLastError();
-    if (error == ERROR_IO_PENDING) [[likely]]
-        return true;
+    if (error != ERROR_IO_PENDING) [[unlikely]] {
+        m_ovlp.error = error;
+        return false;
+    }
 
-    m_ovlp.error = error;
-    return false;
+    // Cancel the pending connect operation once the timer expires.
+    start_timeout(m_ovlp, m_socket);
+
+    m_stream->m_connecting = m_socket;
+    return true;
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
     auto *addr = reinterpret_cast<const sockaddr *>(m_address);
     int   s    = ::socket(addr->sa_family, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
@@ -163,173 +590,393 @@ auto tcp_stream::connect_awaitable::await_suspend() noexcept -> bool {
     auto *worker = io_context_worker::current();
     assert(worker != nullptr);
 
-    io_uring     *ring = static_cast<io_uring *>(worker->muxer());
-    io_uring_sqe *sqe  = io_uring_get_sqe(ring);
-    while (sqe == nullptr) [[unlikely]] {
-        int result = io_uring_submit(ring);
-        if (result < 0) [[unlikely]] {
-            m_ovlp.result = result;
-            return false;
-        }
+    // Linked timeout requires both SQEs to be submitted together.
+    bool          has_timeout = (m_ovlp.timeout.seconds != 0 || m_ovlp.timeout.nanoseconds != 0);
+    std::uint32_t required    = has_timeout ? 2 : 1;
 
-        sqe = io_uring_get_sqe(ring);
+    void        *sqes[2]{};
+    std::int32_t result = worker->acquire_sqes(sqes, required);
+    if (result != 0) [[unlikely]] {
+        m_ovlp.result = result;
+        return false;
     }
 
+    auto     *sqe = static_cast<io_uring_sqe *>(sqes[0]);
     socklen_t len = addr->sa_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
     io_uring_prep_connect(sqe, s, addr, len);
     io_uring_sqe_set_flags(sqe, 0);
     io_uring_sqe_set_data(sqe, &m_ovlp);
 
+    if (has_timeout)
+        link_timeout(m_ovlp, sqe, static_cast<io_uring_sqe *>(sqes[1]));
+
+    // Cancelling the stream cancels this connect operation as well.
+    m_stream->m_connecting = m_socket;
+
     // IO tasks will be submitted by the worker after this coroutine is suspended.
     return true;
 #endif
 }
 
-auto tcp_stream::send_awaitable::await_resume() const noexcept
-    -> std::expected<std::uint32_t, std::error_code> {
-#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
-    if (m_ovlp.error == 0) [[likely]]
-        return m_ovlp.bytes_transferred;
+auto ossia::detail::throttle(rate_limiter  &limiter,
+                             std::uint64_t  bytes,
+                             std::uint64_t  operations,
+                             timer_entry   &timer,
+                             promise_base  *promise,
+                             void (*expire)(timer_entry *) noexcept,
+                             void          *context) noexcept -> bool {
+    auto now      = std::chrono::steady_clock::now();
+    auto deadline = limiter.reserve(bytes, operations, now);
+    if (deadline <= now) [[likely]]
+        return false;
 
-    return std::unexpected(std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
-#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
-    if (m_ovlp.result >= 0) [[likely]]
-        return static_cast<std::uint32_t>(m_ovlp.result);
+    timer.deadline = deadline;
+    timer.promise  = promise;
+    timer.expire   = expire;
+    timer.context  = context;
 
-    return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
-#endif
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+    worker->add_timer(&timer);
+
+    return true;
 }
 
-auto tcp_stream::send_awaitable::await_suspend() noexcept -> bool {
+auto ossia::detail::submit_tcp_send(overlapped    &ovlp,
+                                    std::uintptr_t socket,
+                                    const void    *data,
+                                    std::uint32_t  size,
+                                    std::uint32_t  flags) noexcept -> bool {
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     DWORD  bytes = 0;
     WSABUF buffer{
-        .len = m_size,
-        .buf = static_cast<char *>(const_cast<void *>(m_data)),
+        .len = size,
+        .buf = static_cast<char *>(const_cast<void *>(data)),
     };
 
     // Send returned immediately. Do not suspend this coroutine.
-    if (WSASend(m_socket, &buffer, 1, &bytes, 0, reinterpret_cast<LPOVERLAPPED>(&m_ovlp),
+    if (WSASend(socket, &buffer, 1, &bytes, flags, reinterpret_cast<LPOVERLAPPED>(&ovlp),
                 nullptr) == TRUE) [[unlikely]] {
-        m_ovlp.error             = 0;
-        m_ovlp.bytes_transferred = bytes;
+        ovlp.error             = 0;
+        ovlp.bytes_transferred = bytes;
         return false;
     }
 
     DWORD error = WSAGetLastError();
 
     if (error == 0) {
-        m_ovlp.error             = 0;
-        m_ovlp.bytes_transferred = bytes;
+        ovlp.error             = 0;
+        ovlp.bytes_transferred = bytes;
         return false;
     }
 
     if (error == WSA_IO_PENDING) [[likely]]
         return true;
 
-    m_ovlp.error = error;
+    ovlp.error = error;
     return false;
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
     auto *worker = io_context_worker::current();
     assert(worker != nullptr);
 
-    io_uring     *ring = static_cast<io_uring *>(worker->muxer());
-    io_uring_sqe *sqe  = io_uring_get_sqe(ring);
-    while (sqe == nullptr) [[unlikely]] {
-        int result = io_uring_submit(ring);
-        if (result < 0) [[unlikely]] {
-            m_ovlp.result = result;
-            return false;
-        }
-
-        sqe = io_uring_get_sqe(ring);
-    }
+    auto *sqe = static_cast<io_uring_sqe *>(worker->acquire_sqe(ovlp.result));
+    if (sqe == nullptr) [[unlikely]]
+        return false;
 
-    io_uring_prep_send(sqe, m_socket, m_data, m_size, MSG_NOSIGNAL);
+    io_uring_prep_send(sqe, static_cast<int>(socket), data, size,
+                       static_cast<int>(flags) | MSG_NOSIGNAL);
     io_uring_sqe_set_flags(sqe, 0);
-    io_uring_sqe_set_data(sqe, &m_ovlp);
+    io_uring_sqe_set_data(sqe, &ovlp);
 
     // IO tasks will be submitted by the worker after this coroutine is suspended.
     return true;
 #endif
 }
 
-auto tcp_stream::receive_awaitable::await_resume() const noexcept
-    -> std::expected<std::uint32_t, std::error_code> {
-#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
-    if (m_ovlp.error == 0) [[likely]]
-        return m_ovlp.bytes_transferred;
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+/// \brief
+///   Completion handler of zero-copy send operations. The send result comes first, and the
+///   awaiting coroutine is resumed once the kernel reports that the buffer is released.
+/// \param[in, out] ovlp
+///   The \c zero_copy_overlapped object of the operation.
+static auto complete_zero_copy(multishot_overlapped *ovlp) noexcept -> void {
+    if ((ovlp->flags & IORING_CQE_F_NOTIF) == 0) {
+        static_cast<zero_copy_overlapped *>(ovlp)->bytes = ovlp->result;
+
+        // No notification follows if the send operation failed before taking the buffer.
+        if ((ovlp->flags & IORING_CQE_F_MORE) != 0)
+            return;
+    }
+
+    io_context_worker::current()->post(ovlp->promise);
+}
+#endif
 
-    return std::unexpected(std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
+auto ossia::detail::submit_tcp_send(zero_copy_overlapped    &ovlp,
+                                    std::uintptr_t           socket,
+                                    const registered_buffer &buffer,
+                                    std::uint32_t            size,
+                                    std::uint32_t            flags) noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return submit_tcp_send(static_cast<overlapped &>(ovlp), socket, buffer.data, size, flags);
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
-    if (m_ovlp.result >= 0) [[likely]]
-        return static_cast<std::uint32_t>(m_ovlp.result);
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    auto *sqe = static_cast<io_uring_sqe *>(worker->acquire_sqe(ovlp.bytes));
+    if (sqe == nullptr) [[unlikely]]
+        return false;
 
-    return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+    ovlp.complete = &complete_zero_copy;
+
+    // A registered buffer could only be sent with zero-copy. A plain send does not accept it,
+    // and write operations on sockets could raise SIGPIPE.
+    io_uring_prep_send_zc_fixed(sqe, static_cast<int>(socket), buffer.data, size,
+                                static_cast<int>(flags) | MSG_NOSIGNAL, 0, buffer.index);
+    io_uring_sqe_set_flags(sqe, 0);
+    auto *step = static_cast<multishot_overlapped *>(&ovlp);
+    io_uring_sqe_set_data64(sqe, reinterpret_cast<std::uintptr_t>(step) | multishot_tag);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
 #endif
 }
 
-auto tcp_stream::receive_awaitable::await_suspend() noexcept -> bool {
+/// \brief
+///   Issue an asynchronous TCP receive operation with the timeout of the overlapped structure.
+/// \tparam Buffer
+///   Type of the buffer to receive data into. Either \c void* or \c registered_buffer.
+/// \param[in, out] ovlp
+///   Overlapped structure of the operation.
+/// \param socket
+///   The socket handle to receive data.
+/// \param buffer
+///   The buffer to store the received data.
+/// \param size
+///   Size in byte to receive.
+/// \retval true
+///   The receive operation is pending.
+/// \retval false
+///   The receive operation is completed or failed immediately.
+template <class Buffer>
+static auto submit_receive(timed_overlapped &ovlp,
+                           std::uintptr_t    socket,
+                           const Buffer     &buffer,
+                           std::uint32_t     size) noexcept -> bool {
+    // The timeout starts now, so it is clamped to the deadline of the task at this point.
+    if (!clamp_to_deadline(*ovlp.promise, ovlp.timeout)) [[unlikely]] {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+        ovlp.error = WSAETIMEDOUT;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+        ovlp.result = -ETIMEDOUT;
+#endif
+        return false;
+    }
+
+    void *data;
+    if constexpr (std::is_same_v<Buffer, registered_buffer>)
+        data = buffer.data;
+    else
+        data = buffer;
+
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     DWORD  bytes = 0;
     DWORD  flags = 0;
-    WSABUF buffer{
-        .len = m_size,
-        .buf = static_cast<char *>(m_data),
+    WSABUF wsabuf{
+        .len = size,
+        .buf = static_cast<char *>(data),
     };
 
     // Receive returned immediately. Do not suspend this coroutine.
-    if (WSARecv(m_socket, &buffer, 1, &bytes, &flags, reinterpret_cast<LPOVERLAPPED>(&m_ovlp),
+    if (WSARecv(socket, &wsabuf, 1, &bytes, &flags, reinterpret_cast<LPOVERLAPPED>(&ovlp),
                 nullptr) == TRUE) [[unlikely]] {
-        m_ovlp.error             = 0;
-        m_ovlp.bytes_transferred = bytes;
+        ovlp.error             = 0;
+        ovlp.bytes_transferred = bytes;
         return false;
     }
 
     DWORD error = WSAGetLastError();
 
     if (error == 0) {
-        m_ovlp.error             = 0;
-        m_ovlp.bytes_transferred = bytes;
+        ovlp.error             = 0;
+        ovlp.bytes_transferred = bytes;
         return false;
     }
 
-    if (error == WSA_IO_PENDING) [[likely]]
-        return true;
+    if (error != WSA_IO_PENDING) [[unlikely]] {
+        ovlp.error = error;
+        return false;
+    }
 
-    m_ovlp.error = error;
-    return false;
+    // Cancel the pending receive operation once the timer expires.
+    start_timeout(ovlp, socket);
+
+    return true;
 #elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
     auto *worker = io_context_worker::current();
     assert(worker != nullptr);
 
-    io_uring     *ring = static_cast<io_uring *>(worker->muxer());
-    io_uring_sqe *sqe  = io_uring_get_sqe(ring);
-    while (sqe == nullptr) [[unlikely]] {
-        int result = io_uring_submit(ring);
-        if (result < 0) [[unlikely]] {
-            m_ovlp.result = result;
-            return false;
-        }
+    // Linked timeout requires both SQEs to be submitted together.
+    bool          has_timeout = (ovlp.timeout.seconds != 0 || ovlp.timeout.nanoseconds != 0);
+    std::uint32_t required    = has_timeout ? 2 : 1;
 
-        sqe = io_uring_get_sqe(ring);
+    void        *sqes[2]{};
+    std::int32_t result = worker->acquire_sqes(sqes, required);
+    if (result != 0) [[unlikely]] {
+        ovlp.result = result;
+        return false;
     }
 
-    io_uring_prep_recv(sqe, m_socket, m_data, m_size, 0);
+    // Registered buffers could only be received into by read operations. Sockets ignore the
+    // offset.
+    auto *sqe = static_cast<io_uring_sqe *>(sqes[0]);
+    if constexpr (std::is_same_v<Buffer, registered_buffer>)
+        io_uring_prep_read_fixed(sqe, static_cast<int>(socket), data, size, 0,
+                                 static_cast<int>(buffer.index));
+    else
+        io_uring_prep_recv(sqe, static_cast<int>(socket), data, size, 0);
     io_uring_sqe_set_flags(sqe, 0);
-    io_uring_sqe_set_data(sqe, &m_ovlp);
+    io_uring_sqe_set_data(sqe, &ovlp);
+
+    if (has_timeout)
+        link_timeout(ovlp, sqe, static_cast<io_uring_sqe *>(sqes[1]));
 
     // IO tasks will be submitted by the worker after this coroutine is suspended.
     return true;
 #endif
 }
 
-tcp_stream::tcp_stream() noexcept : m_socket(invalid_socket), m_address() {}
+auto ossia::detail::submit_tcp_receive(timed_overlapped &ovlp,
+                                       std::uintptr_t    socket,
+                                       void             *data,
+                                       std::uint32_t     size) noexcept -> bool {
+    return submit_receive(ovlp, socket, data, size);
+}
+
+auto ossia::detail::submit_tcp_receive(timed_overlapped        &ovlp,
+                                       std::uintptr_t           socket,
+                                       const registered_buffer &buffer,
+                                       std::uint32_t            size) noexcept -> bool {
+    return submit_receive(ovlp, socket, buffer, size);
+}
+
+auto ossia::detail::tcp_send_result(const overlapped &ovlp) noexcept
+    -> std::expected<std::uint32_t, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (ovlp.error == 0) [[likely]]
+        return ovlp.bytes_transferred;
+
+    return std::unexpected(std::error_code(static_cast<int>(ovlp.error), std::system_category()));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (ovlp.result >= 0) [[likely]]
+        return static_cast<std::uint32_t>(ovlp.result);
+
+    return std::unexpected(std::error_code(-ovlp.result, std::system_category()));
+#endif
+}
+
+auto ossia::detail::tcp_send_result(const zero_copy_overlapped &ovlp) noexcept
+    -> std::expected<std::uint32_t, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    return tcp_send_result(static_cast<const overlapped &>(ovlp));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (ovlp.bytes >= 0) [[likely]]
+        return static_cast<std::uint32_t>(ovlp.bytes);
+
+    return std::unexpected(std::error_code(-ovlp.bytes, std::system_category()));
+#endif
+}
+
+auto ossia::detail::tcp_receive_result(const timed_overlapped &ovlp) noexcept
+    -> std::expected<std::uint32_t, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (release_timeout(ovlp))
+        return std::unexpected(std::make_error_code(std::errc::timed_out));
+
+    if (ovlp.error == 0) [[likely]]
+        return ovlp.bytes_transferred;
+
+    return std::unexpected(std::error_code(static_cast<int>(ovlp.error), std::system_category()));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (ovlp.result >= 0) [[likely]]
+        return static_cast<std::uint32_t>(ovlp.result);
+
+    if (release_timeout(ovlp))
+        return std::unexpected(std::make_error_code(std::errc::timed_out));
+
+    return std::unexpected(std::error_code(-ovlp.result, std::system_category()));
+#endif
+}
+
+auto tcp_stream::send_awaitable::submit_delayed(timer_entry *timer) noexcept -> void {
+    auto *self = static_cast<send_awaitable *>(timer->context);
+    if (!self->submit())
+        io_context_worker::current()->post(timer->promise);
+}
+
+auto tcp_stream::receive_awaitable::submit_delayed(timer_entry *timer) noexcept -> void {
+    auto *self = static_cast<receive_awaitable *>(timer->context);
+    if (!self->submit())
+        io_context_worker::current()->post(timer->promise);
+}
+
+auto tcp_stream::send_awaitable::await_resume() const noexcept
+    -> std::expected<std::uint32_t, std::error_code> {
+    return tcp_send_result(m_ovlp);
+}
+
+auto tcp_stream::send_awaitable::await_suspend() noexcept -> bool {
+    if (m_limiter != nullptr &&
+        throttle(*m_limiter, m_size, 1, m_throttle, m_ovlp.promise, &submit_delayed, this))
+        return true;
+
+    return this->submit();
+}
+
+auto tcp_stream::send_awaitable::submit() noexcept -> bool {
+    return submit_tcp_send(m_ovlp, m_socket, m_data, m_size, 0);
+}
+
+auto tcp_stream::receive_awaitable::await_resume() const noexcept
+    -> std::expected<std::uint32_t, std::error_code> {
+    auto result = tcp_receive_result(m_ovlp);
+
+    // Charge received bytes. The next operation waits if this one goes over the limit.
+    if (result.has_value() && m_limiter != nullptr)
+        m_limiter->reserve(*result, 0, std::chrono::steady_clock::now());
+
+    return result;
+}
+
+auto tcp_stream::receive_awaitable::await_suspend() noexcept -> bool {
+    // Received bytes are unknown yet. They are charged once this operation completes.
+    if (m_limiter != nullptr &&
+        throttle(*m_limiter, 0, 1, m_throttle, m_ovlp.promise, &submit_delayed, this))
+        return true;
+
+    return this->submit();
+}
+
+auto tcp_stream::receive_awaitable::submit() noexcept -> bool {
+    return submit_tcp_receive(m_ovlp, m_socket, m_data, m_size);
+}
+
+tcp_stream::tcp_stream() noexcept
+    : m_socket(invalid_socket),
+      m_address(),
+      m_send_limiter(),
+      m_receive_limiter(),
+      m_connecting(invalid_socket) {}
 
 tcp_stream::tcp_stream(tcp_stream &&other) noexcept
     : m_socket(other.m_socket),
-      m_address(other.m_address) {
-    other.m_socket = invalid_socket;
+      m_address(other.m_address),
+      m_send_limiter(other.m_send_limiter),
+      m_receive_limiter(other.m_receive_limiter),
+      m_connecting(invalid_socket) {
+    other.m_socket          = invalid_socket;
+    other.m_send_limiter    = nullptr;
+    other.m_receive_limiter = nullptr;
 }
 
 tcp_stream::~tcp_stream() {
@@ -342,10 +989,14 @@ auto tcp_stream::operator=(tcp_stream &&other) noexcept -> tcp_stream & {
 
     close();
 
-    m_socket  = other.m_socket;
-    m_address = other.m_address;
+    m_socket          = other.m_socket;
+    m_address         = other.m_address;
+    m_send_limiter    = other.m_send_limiter;
+    m_receive_limiter = other.m_receive_limiter;
 
-    other.m_socket = invalid_socket;
+    other.m_socket          = invalid_socket;
+    other.m_send_limiter    = nullptr;
+    other.m_receive_limiter = nullptr;
     return *this;
 }
 
@@ -468,6 +1119,80 @@ auto tcp_stream::receive(void *data, std::uint32_t size) noexcept
 #endif
 }
 
+auto tcp_stream::send_file_async(const file   &source,
+                                 std::uint64_t offset,
+                                 std::uint64_t size) noexcept
+    -> future<std::expected<std::uint64_t, std::error_code>> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    std::uint64_t sent = 0;
+    while (sent < size) {
+        auto chunk  = static_cast<std::uint32_t>(std::min(size - sent, max_transmit_size));
+        auto result = co_await transmit_awaitable(m_socket, source.native_handle(),
+                                                  offset + sent, chunk);
+
+        if (!result.has_value()) [[unlikely]]
+            co_return std::unexpected(result.error());
+
+        // End of file.
+        if (*result == 0)
+            break;
+
+        sent += *result;
+    }
+
+    co_return sent;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    auto pipe = splice_pipes.acquire();
+    if (!pipe.has_value()) [[unlikely]]
+        co_return std::unexpected(pipe.error());
+
+    int input  = static_cast<int>(source.native_handle());
+    int output = static_cast<int>(m_socket);
+
+    // The two splices are not linked: a short or empty file splice must be observed before
+    // draining, otherwise the socket splice would wait for data that never comes.
+    std::uint64_t sent = 0;
+    while (sent < size) {
+        auto chunk  = static_cast<std::uint32_t>(std::min<std::uint64_t>(size - sent,
+                                                                          pipe->capacity));
+        auto filled = co_await splice_awaitable(input, static_cast<std::int64_t>(offset + sent),
+                                                pipe->write, chunk, SPLICE_F_MOVE);
+
+        if (!filled.has_value()) [[unlikely]] {
+            splice_pipes.release(*pipe);
+            co_return std::unexpected(filled.error());
+        }
+
+        // End of file.
+        if (*filled == 0)
+            break;
+
+        std::uint32_t pending = *filled;
+        while (pending != 0) {
+            unsigned flags = SPLICE_F_MOVE;
+            if (sent + pending < size)
+                flags |= SPLICE_F_MORE;
+
+            auto drained = co_await splice_awaitable(pipe->read, -1, output, pending, flags);
+
+            // The pipe still holds data and could not be reused.
+            if (!drained.has_value() || *drained == 0) [[unlikely]] {
+                splice_pipe_pool::close(*pipe);
+                if (!drained.has_value())
+                    co_return std::unexpected(drained.error());
+                co_return std::unexpected(std::make_error_code(std::errc::connection_reset));
+            }
+
+            pending -= *drained;
+            sent    += *drained;
+        }
+    }
+
+    splice_pipes.release(*pipe);
+    co_return sent;
+#endif
+}
+
 auto tcp_stream::set_keep_alive(bool enable) noexcept -> std::error_code {
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     DWORD value = enable ? 1 : 0;
@@ -504,6 +1229,53 @@ auto tcp_stream::set_no_delay(bool enable) noexcept -> std::error_code {
 #endif
 }
 
+/// \brief
+///   Cancel all pending asynchronous operations of a socket.
+/// \param socket
+///   The socket to cancel operations of.
+/// \return
+///   A system error code that indicates the result of the operation. The error code is 0 if the
+///   cancellation is requested.
+static auto cancel_socket(std::uintptr_t socket) noexcept -> std::error_code {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (CancelIoEx(reinterpret_cast<HANDLE>(socket), nullptr) == FALSE) {
+        DWORD error = GetLastError();
+        if (error != ERROR_NOT_FOUND) [[unlikely]]
+            return std::error_code(static_cast<int>(error), std::system_category());
+    }
+
+    return std::error_code();
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    std::int32_t error = 0;
+    auto        *sqe   = static_cast<io_uring_sqe *>(worker->acquire_sqe(error));
+    if (sqe == nullptr) [[unlikely]]
+        return std::error_code(-error, std::system_category());
+
+    // The result of the cancel request itself is not needed.
+    io_uring_prep_cancel_fd(sqe, static_cast<int>(socket), IORING_ASYNC_CANCEL_ALL);
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, nullptr);
+
+    return std::error_code();
+#endif
+}
+
+auto tcp_stream::cancel() noexcept -> std::error_code {
+    // The socket of a connect operation is not owned by this stream until it is connected.
+    if (m_connecting != invalid_socket) {
+        if (auto error = cancel_socket(m_connecting); error.value() != 0) [[unlikely]]
+            return error;
+    }
+
+    if (m_socket == invalid_socket) [[unlikely]]
+        return std::error_code();
+
+    return cancel_socket(m_socket);
+}
+
 auto tcp_stream::close() noexcept -> void {
 #if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
     if (m_socket != invalid_socket) {
@@ -0,0 +1,524 @@
+#include "ossia/udp_socket.hpp"
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+#    include <WS2tcpip.h>
+#    include <WinSock2.h>
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <liburing.h>
+#    include <linux/errqueue.h>
+#    include <linux/net_tstamp.h>
+#    include <netinet/in.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+#endif
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+using namespace ossia;
+using namespace ossia::detail;
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+inline constexpr std::uintptr_t invalid_socket = INVALID_SOCKET;
+
+/// \struct message_header
+/// \brief
+///   Arguments of \c WSASendTo and \c WSARecvFrom that must be valid until the operation is
+///   completed.
+struct message_header {
+    WSABUF buffer;
+    INT    address_length;
+    DWORD  flags;
+};
+#else
+inline constexpr std::uintptr_t invalid_socket = static_cast<std::uintptr_t>(-1);
+
+/// \struct message_header
+/// \brief
+///   Arguments of \c sendmsg and \c recvmsg that must be valid until the operation is completed.
+struct message_header {
+    msghdr header;
+    iovec  buffer;
+};
+#endif
+
+static_assert(sizeof(message_header) <= 80);
+static_assert(alignof(message_header) <= 8);
+
+/// \brief
+///   Get size of the socket address structure of the specified address.
+[[nodiscard]]
+static auto address_length(const inet_address &address) noexcept -> int {
+    return address.is_ipv4() ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+}
+
+auto udp_socket::send_to_awaitable::await_resume() const noexcept
+    -> std::expected<std::uint32_t, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (m_ovlp.error == 0) [[likely]]
+        return m_ovlp.bytes_transferred;
+
+    return std::unexpected(std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_ovlp.result >= 0) [[likely]]
+        return static_cast<std::uint32_t>(m_ovlp.result);
+
+    return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+#endif
+}
+
+auto udp_socket::send_to_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    auto *message = ::new (m_message) message_header{
+        .buffer =
+            WSABUF{
+                .len = m_size,
+                .buf = static_cast<char *>(const_cast<void *>(m_data)),
+            },
+        .address_length = address_length(m_address),
+        .flags          = 0,
+    };
+
+    // Send returned immediately. Do not suspend this coroutine.
+    DWORD bytes = 0;
+    if (WSASendTo(static_cast<SOCKET>(m_socket), &message->buffer, 1, &bytes, 0,
+                  reinterpret_cast<const sockaddr *>(&m_address), message->address_length,
+                  reinterpret_cast<LPOVERLAPPED>(&m_ovlp), nullptr) == 0) {
+        m_ovlp.error             = 0;
+        m_ovlp.bytes_transferred = bytes;
+        return false;
+    }
+
+    DWORD error = WSAGetLastError();
+    if (error == WSA_IO_PENDING) [[likely]]
+        return true;
+
+    m_ovlp.error = error;
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    auto *message = ::new (m_message) message_header{
+        .header = {},
+        .buffer =
+            iovec{
+                .iov_base = const_cast<void *>(m_data),
+                .iov_len  = m_size,
+            },
+    };
+
+    message->header.msg_name    = &m_address;
+    message->header.msg_namelen = static_cast<socklen_t>(address_length(m_address));
+    message->header.msg_iov     = &message->buffer;
+    message->header.msg_iovlen  = 1;
+
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    auto *sqe = static_cast<io_uring_sqe *>(worker->acquire_sqe(m_ovlp.result));
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+    io_uring_prep_sendmsg(sqe, static_cast<int>(m_socket), &message->header, 0);
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+auto udp_socket::receive_from_awaitable::await_resume() const noexcept
+    -> std::expected<udp_datagram, std::error_code> {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    // The datagram is larger than the buffer. The buffer is filled and the rest is discarded.
+    if (m_ovlp.error == WSAEMSGSIZE) {
+        return udp_datagram{
+            .size      = m_size,
+            .truncated = true,
+            .peer      = m_address,
+            .timestamp = {},
+        };
+    }
+
+    if (m_ovlp.error != 0) [[unlikely]]
+        return std::unexpected(
+            std::error_code(static_cast<int>(m_ovlp.error), std::system_category()));
+
+    return udp_datagram{
+        .size      = m_ovlp.bytes_transferred,
+        .truncated = false,
+        .peer      = m_address,
+        .timestamp = {},
+    };
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    if (m_ovlp.result < 0) [[unlikely]]
+        return std::unexpected(std::error_code(-m_ovlp.result, std::system_category()));
+
+    auto *message = std::launder(
+        reinterpret_cast<message_header *>(const_cast<std::byte *>(m_message)));
+
+    udp_datagram datagram{
+        .size      = static_cast<std::uint32_t>(m_ovlp.result),
+        .truncated = (message->header.msg_flags & MSG_TRUNC) != 0,
+        .peer      = m_address,
+        .timestamp = {},
+    };
+
+    // Software receive timestamp is stored in the first timespec of SCM_TIMESTAMPING.
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&message->header); cmsg != nullptr;
+         cmsg          = CMSG_NXTHDR(&message->header, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPING)
+            continue;
+
+        scm_timestamping timestamps;
+        std::memcpy(&timestamps, CMSG_DATA(cmsg), sizeof(timestamps));
+
+        auto time = std::chrono::seconds(timestamps.ts[0].tv_sec) +
+                    std::chrono::nanoseconds(timestamps.ts[0].tv_nsec);
+
+        datagram.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(time));
+        break;
+    }
+
+    return datagram;
+#endif
+}
+
+auto udp_socket::receive_from_awaitable::await_suspend() noexcept -> bool {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    auto *message = ::new (m_message) message_header{
+        .buffer =
+            WSABUF{
+                .len = m_size,
+                .buf = static_cast<char *>(m_data),
+            },
+        .address_length = sizeof(m_address),
+        .flags          = 0,
+    };
+
+    // Receive returned immediately. Do not suspend this coroutine.
+    DWORD bytes = 0;
+    if (WSARecvFrom(static_cast<SOCKET>(m_socket), &message->buffer, 1, &bytes, &message->flags,
+                    reinterpret_cast<sockaddr *>(&m_address), &message->address_length,
+                    reinterpret_cast<LPOVERLAPPED>(&m_ovlp), nullptr) == 0) {
+        m_ovlp.error             = 0;
+        m_ovlp.bytes_transferred = bytes;
+        return false;
+    }
+
+    DWORD error = WSAGetLastError();
+    if (error == WSA_IO_PENDING) [[likely]]
+        return true;
+
+    m_ovlp.error = error;
+    return false;
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    auto *message = ::new (m_message) message_header{
+        .header = {},
+        .buffer =
+            iovec{
+                .iov_base = m_data,
+                .iov_len  = m_size,
+            },
+    };
+
+    message->header.msg_name       = &m_address;
+    message->header.msg_namelen    = sizeof(m_address);
+    message->header.msg_iov        = &message->buffer;
+    message->header.msg_iovlen     = 1;
+    message->header.msg_control    = m_control;
+    message->header.msg_controllen = sizeof(m_control);
+
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+
+    auto *sqe = static_cast<io_uring_sqe *>(worker->acquire_sqe(m_ovlp.result));
+    if (sqe == nullptr) [[unlikely]]
+        return false;
+
+    io_uring_prep_recvmsg(sqe, static_cast<int>(m_socket), &message->header, 0);
+    io_uring_sqe_set_flags(sqe, 0);
+    io_uring_sqe_set_data(sqe, &m_ovlp);
+
+    // IO tasks will be submitted by the worker after this coroutine is suspended.
+    return true;
+#endif
+}
+
+udp_socket::udp_socket() noexcept : m_socket(invalid_socket), m_address() {}
+
+udp_socket::udp_socket(udp_socket &&other) noexcept
+    : m_socket(other.m_socket),
+      m_address(other.m_address) {
+    other.m_socket = invalid_socket;
+}
+
+udp_socket::~udp_socket() {
+    close();
+}
+
+auto udp_socket::operator=(udp_socket &&other) noexcept -> udp_socket & {
+    if (this == &other) [[unlikely]]
+        return *this;
+
+    close();
+
+    m_socket  = other.m_socket;
+    m_address = other.m_address;
+
+    other.m_socket = invalid_socket;
+    return *this;
+}
+
+auto udp_socket::bind(const inet_address &address) noexcept -> std::error_code {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    // Create a new socket.
+    auto  *addr = reinterpret_cast<const sockaddr *>(&address);
+    SOCKET s    = WSASocketW(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP, nullptr, 0,
+                             WSA_FLAG_OVERLAPPED | WSA_FLAG_NO_HANDLE_INHERIT);
+
+    if (s == invalid_socket) [[unlikely]]
+        return std::error_code(WSAGetLastError(), std::system_category());
+
+    { // Enable SO_REUSEADDR option.
+        DWORD value = TRUE;
+        if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&value),
+                       sizeof(value)) == SOCKET_ERROR) {
+            DWORD error = WSAGetLastError();
+            closesocket(s);
+            return std::error_code(static_cast<int>(error), std::system_category());
+        }
+    }
+
+    // Register the socket to IOCP.
+    auto *worker = io_context_worker::current();
+    assert(worker != nullptr);
+    if (CreateIoCompletionPort(reinterpret_cast<HANDLE>(s), worker->muxer(), 0, 0) == nullptr)
+        [[unlikely]] {
+        DWORD error = GetLastError();
+        closesocket(s);
+        return std::error_code(static_cast<int>(error), std::system_category());
+    }
+
+    // Disable IOCP notification if IO event is handled immediately.
+    if (SetFileCompletionNotificationModes(reinterpret_cast<HANDLE>(s),
+                                           FILE_SKIP_SET_EVENT_ON_HANDLE |
+                                               FILE_SKIP_COMPLETION_PORT_ON_SUCCESS) == FALSE)
+        [[unlikely]] {
+        DWORD error = GetLastError();
+        closesocket(s);
+        return std::error_code(static_cast<int>(error), std::system_category());
+    }
+
+    // Bind the socket to the specified address.
+    if (::bind(s, addr, address_length(address)) == SOCKET_ERROR) [[unlikely]] {
+        DWORD error = WSAGetLastError();
+        closesocket(s);
+        return std::error_code(static_cast<int>(error), std::system_category());
+    }
+
+    // Get the actual port if the system chooses one.
+    inet_address local   = address;
+    int          addrlen = sizeof(local);
+    if (getsockname(s, reinterpret_cast<sockaddr *>(&local), &addrlen) == SOCKET_ERROR)
+        [[unlikely]] {
+        DWORD error = WSAGetLastError();
+        closesocket(s);
+        return std::error_code(static_cast<int>(error), std::system_category());
+    }
+
+    close();
+
+    m_socket  = s;
+    m_address = local;
+
+    return std::error_code();
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    // Create a new socket.
+    auto *addr = reinterpret_cast<const sockaddr *>(&address);
+    int   s    = ::socket(addr->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+
+    if (s == -1) [[unlikely]]
+        return std::error_code(errno, std::system_category());
+
+    { // Enable SO_REUSEADDR option.
+        int value = 1;
+        if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value)) == -1) {
+            int error = errno;
+            ::close(s);
+            return std::error_code(error, std::system_category());
+        }
+    }
+
+    // Bind the socket to the specified address.
+    if (::bind(s, addr, static_cast<socklen_t>(address_length(address))) == -1) [[unlikely]] {
+        int error = errno;
+        ::close(s);
+        return std::error_code(error, std::system_category());
+    }
+
+    // Get the actual port if the system chooses one.
+    inet_address local   = address;
+    socklen_t    addrlen = sizeof(local);
+    if (getsockname(s, reinterpret_cast<sockaddr *>(&local), &addrlen) == -1) [[unlikely]] {
+        int error = errno;
+        ::close(s);
+        return std::error_code(error, std::system_category());
+    }
+
+    close();
+
+    m_socket  = static_cast<std::uintptr_t>(s);
+    m_address = local;
+
+    return std::error_code();
+#endif
+}
+
+/// \brief
+///   Join or leave a multicast group.
+/// \param socket
+///   The socket to change group membership.
+/// \param group
+///   Address of the multicast group.
+/// \param interface_index
+///   Index of the network interface.
+/// \param join
+///   \c true to join the group. \c false to leave the group.
+/// \return
+///   A system error code that indicates the result of the operation.
+static auto set_membership(std::uintptr_t    socket,
+                           const ip_address &group,
+                           std::uint32_t     interface_index,
+                           bool              join) noexcept -> std::error_code {
+    if (!group.is_ipv4_multicast() && !group.is_ipv6_multicast()) [[unlikely]]
+        return std::make_error_code(std::errc::invalid_argument);
+
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    int result = 0;
+    if (group.is_ipv4()) {
+        // Interface index is accepted in form of 0.0.0.0/8 address.
+        ip_mreq request{};
+        std::memcpy(&request.imr_multiaddr, group.address(), sizeof(request.imr_multiaddr));
+        request.imr_interface.s_addr = to_network_endian(interface_index);
+
+        result = setsockopt(static_cast<SOCKET>(socket), IPPROTO_IP,
+                            join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+                            reinterpret_cast<const char *>(&request), sizeof(request));
+    } else {
+        ipv6_mreq request{};
+        std::memcpy(&request.ipv6mr_multiaddr, group.address(), sizeof(request.ipv6mr_multiaddr));
+        request.ipv6mr_interface = interface_index;
+
+        result = setsockopt(static_cast<SOCKET>(socket), IPPROTO_IPV6,
+                            join ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP,
+                            reinterpret_cast<const char *>(&request), sizeof(request));
+    }
+
+    if (result == SOCKET_ERROR)
+        return std::error_code(WSAGetLastError(), std::system_category());
+
+    return std::error_code();
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    int result = 0;
+    if (group.is_ipv4()) {
+        ip_mreqn request{};
+        std::memcpy(&request.imr_multiaddr, group.address(), sizeof(request.imr_multiaddr));
+        request.imr_ifindex = static_cast<int>(interface_index);
+
+        result = setsockopt(static_cast<int>(socket), IPPROTO_IP,
+                            join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &request,
+                            sizeof(request));
+    } else {
+        ipv6_mreq request{};
+        std::memcpy(&request.ipv6mr_multiaddr, group.address(), sizeof(request.ipv6mr_multiaddr));
+        request.ipv6mr_interface = interface_index;
+
+        result = setsockopt(static_cast<int>(socket), IPPROTO_IPV6,
+                            join ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP, &request, sizeof(request));
+    }
+
+    if (result == -1)
+        return std::error_code(errno, std::system_category());
+
+    return std::error_code();
+#endif
+}
+
+auto udp_socket::join_group(const ip_address &group, std::uint32_t interface_index) noexcept
+    -> std::error_code {
+    return set_membership(m_socket, group, interface_index, true);
+}
+
+auto udp_socket::leave_group(const ip_address &group, std::uint32_t interface_index) noexcept
+    -> std::error_code {
+    return set_membership(m_socket, group, interface_index, false);
+}
+
+auto udp_socket::set_multicast_interface(std::uint32_t interface_index) noexcept
+    -> std::error_code {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    int result = 0;
+    if (m_address.is_ipv4()) {
+        // Interface index is accepted in form of 0.0.0.0/8 address.
+        DWORD value = to_network_endian(interface_index);
+        result      = setsockopt(static_cast<SOCKET>(m_socket), IPPROTO_IP, IP_MULTICAST_IF,
+                                 reinterpret_cast<const char *>(&value), sizeof(value));
+    } else {
+        DWORD value = interface_index;
+        result      = setsockopt(static_cast<SOCKET>(m_socket), IPPROTO_IPV6, IPV6_MULTICAST_IF,
+                                 reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    if (result == SOCKET_ERROR)
+        return std::error_code(WSAGetLastError(), std::system_category());
+
+    return std::error_code();
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    int result = 0;
+    if (m_address.is_ipv4()) {
+        ip_mreqn value{};
+        value.imr_ifindex = static_cast<int>(interface_index);
+        result = setsockopt(static_cast<int>(m_socket), IPPROTO_IP, IP_MULTICAST_IF, &value,
+                            sizeof(value));
+    } else {
+        int value = static_cast<int>(interface_index);
+        result    = setsockopt(static_cast<int>(m_socket), IPPROTO_IPV6, IPV6_MULTICAST_IF, &value,
+                               sizeof(value));
+    }
+
+    if (result == -1)
+        return std::error_code(errno, std::system_category());
+
+    return std::error_code();
+#endif
+}
+
+auto udp_socket::set_receive_timestamps(bool enable) noexcept -> std::error_code {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    (void)enable;
+    return std::make_error_code(std::errc::operation_not_supported);
+#elif defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+    int value = enable ? (SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE) : 0;
+    if (setsockopt(static_cast<int>(m_socket), SOL_SOCKET, SO_TIMESTAMPING, &value,
+                   sizeof(value)) == -1)
+        return std::error_code(errno, std::system_category());
+
+    return std::error_code();
+#endif
+}
+
+auto udp_socket::close() noexcept -> void {
+#if defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
+    if (m_socket != invalid_socket) {
+        closesocket(static_cast<SOCKET>(m_socket));
+        m_socket = invalid_socket;
+    }
+#else
+    if (m_socket != invalid_socket) {
+        ::close(static_cast<int>(m_socket));
+        m_socket = invalid_socket;
+    }
+#endif
+}
@@ -0,0 +1,988 @@
+#include "ossia/websocket.hpp"
+#include "ossia/http_parser.hpp"
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#    include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <random>
+
+using namespace ossia;
+
+/// \brief
+///   GUID that is appended to \c Sec-WebSocket-Key to calculate \c Sec-WebSocket-Accept. See
+///   RFC 6455 section 1.3.
+static constexpr std::string_view websocket_guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+/// \brief
+///   Extra receive buffer space reserved for frame headers and interleaved control frames beyond
+///   the message size limit.
+static constexpr std::size_t frame_overhead = 256;
+
+/// \brief
+///   Maximum size in byte of a single send or receive operation.
+static constexpr std::size_t max_io_size = std::numeric_limits<std::uint32_t>::max();
+
+/// \brief
+///   Process a single 64-byte block of SHA-1.
+/// \param[in, out] state
+///   The SHA-1 state to be updated.
+/// \param block
+///   Pointer to start of the 64-byte block.
+static auto sha1_block(std::uint32_t (&state)[5], const std::uint8_t *block) noexcept -> void {
+    std::uint32_t w[80];
+    for (std::size_t i = 0; i < 16; ++i) {
+        w[i] = (static_cast<std::uint32_t>(block[i * 4]) << 24) |
+               (static_cast<std::uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<std::uint32_t>(block[i * 4 + 2]) << 8) |
+               static_cast<std::uint32_t>(block[i * 4 + 3]);
+    }
+
+    for (std::size_t i = 16; i < 80; ++i)
+        w[i] = std::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    std::uint32_t a = state[0];
+    std::uint32_t b = state[1];
+    std::uint32_t c = state[2];
+    std::uint32_t d = state[3];
+    std::uint32_t e = state[4];
+
+    for (std::size_t i = 0; i < 80; ++i) {
+        std::uint32_t f;
+        std::uint32_t k;
+
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+
+        std::uint32_t temp = std::rotl(a, 5) + f + e + k + w[i];
+
+        e = d;
+        d = c;
+        c = std::rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+/// \brief
+///   Calculate SHA-1 digest of the specified data. SHA-1 is only used for the WebSocket opening
+///   handshake and is not used for security purposes.
+/// \param data
+///   The data to be hashed.
+/// \return
+///   SHA-1 digest of the data.
+[[nodiscard]]
+static auto sha1(std::string_view data) noexcept -> std::array<std::uint8_t, 20> {
+    std::uint32_t state[5]{0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    const auto *input = reinterpret_cast<const std::uint8_t *>(data.data());
+    std::size_t size  = data.size();
+
+    while (size >= 64) {
+        sha1_block(state, input);
+        input += 64;
+        size  -= 64;
+    }
+
+    // Pad the last block with a single bit and message length in bits.
+    std::uint8_t block[64]{};
+    std::memcpy(block, input, size);
+    block[size] = 0x80;
+
+    if (size >= 56) {
+        sha1_block(state, block);
+        std::memset(block, 0, sizeof(block));
+    }
+
+    std::uint64_t bits = static_cast<std::uint64_t>(data.size()) * 8;
+    for (std::size_t i = 0; i < 8; ++i)
+        block[63 - i] = static_cast<std::uint8_t>(bits >> (i * 8));
+
+    sha1_block(state, block);
+
+    std::array<std::uint8_t, 20> digest;
+    for (std::size_t i = 0; i < 20; ++i)
+        digest[i] = static_cast<std::uint8_t>(state[i / 4] >> (24 - (i % 4) * 8));
+
+    return digest;
+}
+
+/// \brief
+///   Encode binary data with base64.
+/// \param data
+///   Pointer to start of the data to be encoded.
+/// \param size
+///   Size in byte of the data to be encoded.
+/// \return
+///   The base64 encoded string with padding.
+[[nodiscard]]
+static auto base64_encode(const std::uint8_t *data, std::size_t size) -> std::string {
+    static constexpr char table[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string result;
+    result.reserve((size + 2) / 3 * 4);
+
+    std::size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        std::uint32_t value = (static_cast<std::uint32_t>(data[i]) << 16) |
+                              (static_cast<std::uint32_t>(data[i + 1]) << 8) | data[i + 2];
+        result.push_back(table[(value >> 18) & 0x3F]);
+        result.push_back(table[(value >> 12) & 0x3F]);
+        result.push_back(table[(value >> 6) & 0x3F]);
+        result.push_back(table[value & 0x3F]);
+    }
+
+    if (size - i == 1) {
+        std::uint32_t value = static_cast<std::uint32_t>(data[i]) << 16;
+        result.push_back(table[(value >> 18) & 0x3F]);
+        result.push_back(table[(value >> 12) & 0x3F]);
+        result.append("==");
+    } else if (size - i == 2) {
+        std::uint32_t value = (static_cast<std::uint32_t>(data[i]) << 16) |
+                              (static_cast<std::uint32_t>(data[i + 1]) << 8);
+        result.push_back(table[(value >> 18) & 0x3F]);
+        result.push_back(table[(value >> 12) & 0x3F]);
+        result.push_back(table[(value >> 6) & 0x3F]);
+        result.push_back('=');
+    }
+
+    return result;
+}
+
+/// \brief
+///   Generate the next pseudo random number with xorshift64*. Randomness is only used for masking
+///   keys and handshake nonces of client connections.
+/// \param[in, out] state
+///   The random state to be updated. The state must not be 0.
+/// \return
+///   The next pseudo random number.
+[[nodiscard]]
+static auto next_random(std::uint64_t &state) noexcept -> std::uint64_t {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+/// \brief
+///   Generate a non-zero random seed for client connections.
+/// \return
+///   A non-zero random seed.
+[[nodiscard]]
+static auto random_seed() noexcept -> std::uint64_t {
+    std::random_device device;
+    std::uint64_t      seed = (static_cast<std::uint64_t>(device()) << 32) | device();
+    return seed | 1;
+}
+
+/// \brief
+///   Compare two strings case-insensitively.
+/// \param lhs
+///   The first string.
+/// \param rhs
+///   The second string.
+/// \retval true
+///   The two strings are equal ignoring ASCII case.
+/// \retval false
+///   The two strings are not equal.
+[[nodiscard]]
+static auto equals_ignore_case(std::string_view lhs, std::string_view rhs) noexcept -> bool {
+    if (lhs.size() != rhs.size())
+        return false;
+
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        char l = lhs[i];
+        char r = rhs[i];
+
+        l = (l >= 'A' && l <= 'Z') ? static_cast<char>(l - 'A' + 'a') : l;
+        r = (r >= 'A' && r <= 'Z') ? static_cast<char>(r - 'A' + 'a') : r;
+
+        if (l != r)
+            return false;
+    }
+
+    return true;
+}
+
+/// \brief
+///   Remove leading and trailing whitespaces.
+/// \param value
+///   The string to be trimmed.
+/// \return
+///   The trimmed string.
+[[nodiscard]]
+static auto trim(std::string_view value) noexcept -> std::string_view {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        value.remove_suffix(1);
+    return value;
+}
+
+/// \brief
+///   Checks if a comma-separated header field value contains the specified token.
+/// \param list
+///   Value of the header field.
+/// \param token
+///   The token to find. Tokens are compared case-insensitively.
+/// \retval true
+///   The header field value contains the token.
+/// \retval false
+///   The header field is missing or does not contain the token.
+[[nodiscard]]
+static auto has_token(std::optional<std::string_view> list, std::string_view token) noexcept
+    -> bool {
+    if (!list.has_value())
+        return false;
+
+    std::string_view value = *list;
+    while (!value.empty()) {
+        std::size_t comma = value.find(',');
+        if (equals_ignore_case(trim(value.substr(0, comma)), token))
+            return true;
+
+        if (comma == std::string_view::npos)
+            break;
+
+        value.remove_prefix(comma + 1);
+    }
+
+    return false;
+}
+
+/// \brief
+///   Validate the opening handshake response from a WebSocket server.
+/// \param header
+///   Status line and header fields of the response, including the terminating empty line.
+/// \param accept
+///   Expected value of the \c Sec-WebSocket-Accept header field.
+/// \retval true
+///   The response accepts the WebSocket connection.
+/// \retval false
+///   The response is malformed or rejects the WebSocket connection.
+[[nodiscard]]
+static auto check_handshake_response(std::string_view header, std::string_view accept) noexcept
+    -> bool {
+    if (!header.starts_with("HTTP/1.1 101 ") && !header.starts_with("HTTP/1.1 101\r\n"))
+        return false;
+
+    bool upgrade    = false;
+    bool connection = false;
+    bool accepted   = false;
+
+    // Skip the status line.
+    header.remove_prefix(header.find("\r\n") + 2);
+    while (!header.empty()) {
+        std::size_t      end  = header.find("\r\n");
+        std::string_view line = header.substr(0, end);
+        header.remove_prefix(end == std::string_view::npos ? header.size() : end + 2);
+
+        std::size_t colon = line.find(':');
+        if (colon == std::string_view::npos)
+            continue;
+
+        std::string_view name  = line.substr(0, colon);
+        std::string_view value = trim(line.substr(colon + 1));
+
+        if (equals_ignore_case(name, "upgrade"))
+            upgrade = has_token(value, "websocket");
+        else if (equals_ignore_case(name, "connection"))
+            connection = has_token(value, "upgrade");
+        else if (equals_ignore_case(name, "sec-websocket-accept"))
+            accepted = (value == accept);
+    }
+
+    return upgrade && connection && accepted;
+}
+
+/// \brief
+///   Append a WebSocket frame header to the output buffer.
+/// \param opcode
+///   Opcode of the frame.
+/// \param fin
+///   Whether this is the final fragment of a message.
+/// \param size
+///   Size in byte of the payload.
+/// \param masked
+///   Whether the payload is masked.
+/// \param mask
+///   Masking key in the same byte order as on the wire. Ignored if \p masked is \c false.
+/// \param[out] output
+///   The output buffer.
+static auto write_frame_header(websocket_opcode opcode,
+                               bool             fin,
+                               std::uint64_t    size,
+                               bool             masked,
+                               std::uint32_t    mask,
+                               std::string     &output) -> void {
+    char        header[14];
+    std::size_t length   = 0;
+    auto        mask_bit = static_cast<std::uint8_t>(masked ? 0x80 : 0x00);
+
+    header[length++] = static_cast<char>((fin ? 0x80 : 0x00) | static_cast<std::uint8_t>(opcode));
+
+    if (size < 126) {
+        header[length++] = static_cast<char>(mask_bit | size);
+    } else if (size <= 0xFFFF) {
+        header[length++] = static_cast<char>(mask_bit | 126);
+        header[length++] = static_cast<char>(size >> 8);
+        header[length++] = static_cast<char>(size);
+    } else {
+        header[length++] = static_cast<char>(mask_bit | 127);
+        for (int shift = 56; shift >= 0; shift -= 8)
+            header[length++] = static_cast<char>(size >> shift);
+    }
+
+    if (masked) {
+        std::memcpy(header + length, &mask, sizeof(mask));
+        length += sizeof(mask);
+    }
+
+    output.append(header, length);
+}
+
+auto ossia::parse_websocket_frame(std::span<const char> data) noexcept
+    -> std::expected<websocket_frame, websocket_parse_error> {
+    if (data.size() < 2)
+        return std::unexpected(websocket_parse_error::incomplete);
+
+    auto first  = static_cast<std::uint8_t>(data[0]);
+    auto second = static_cast<std::uint8_t>(data[1]);
+
+    // Extensions are not negotiated, so RSV bits must be 0.
+    if ((first & 0x70) != 0) [[unlikely]]
+        return std::unexpected(websocket_parse_error::invalid);
+
+    auto opcode = static_cast<websocket_opcode>(first & 0x0F);
+    switch (opcode) {
+    case websocket_opcode::continuation:
+    case websocket_opcode::text:
+    case websocket_opcode::binary:
+    case websocket_opcode::close:
+    case websocket_opcode::ping:
+    case websocket_opcode::pong:         break;
+    default:                             return std::unexpected(websocket_parse_error::invalid);
+    }
+
+    bool          fin         = (first & 0x80) != 0;
+    bool          masked      = (second & 0x80) != 0;
+    std::uint64_t size        = second & 0x7F;
+    std::uint32_t header_size = 2;
+
+    // Control frames must not be fragmented and must have at most 125 bytes of payload.
+    if ((first & 0x08) != 0 && (!fin || size > 125)) [[unlikely]]
+        return std::unexpected(websocket_parse_error::invalid);
+
+    // Payload length must be encoded with the minimal number of bytes.
+    if (size == 126) {
+        if (data.size() < 4)
+            return std::unexpected(websocket_parse_error::incomplete);
+
+        size        = (static_cast<std::uint64_t>(static_cast<std::uint8_t>(data[2])) << 8) |
+                      static_cast<std::uint8_t>(data[3]);
+        header_size = 4;
+
+        if (size < 126) [[unlikely]]
+            return std::unexpected(websocket_parse_error::invalid);
+    } else if (size == 127) {
+        if (data.size() < 10)
+            return std::unexpected(websocket_parse_error::incomplete);
+
+        size = 0;
+        for (std::size_t i = 2; i < 10; ++i)
+            size = (size << 8) | static_cast<std::uint8_t>(data[i]);
+        header_size = 10;
+
+        if ((size >> 63) != 0 || size <= 0xFFFF) [[unlikely]]
+            return std::unexpected(websocket_parse_error::invalid);
+    }
+
+    std::uint32_t mask = 0;
+    if (masked) {
+        if (data.size() < header_size + 4)
+            return std::unexpected(websocket_parse_error::incomplete);
+
+        std::memcpy(&mask, data.data() + header_size, sizeof(mask));
+        header_size += 4;
+    }
+
+    return websocket_frame{
+        .fin          = fin,
+        .masked       = masked,
+        .opcode       = opcode,
+        .mask         = mask,
+        .header_size  = header_size,
+        .payload_size = size,
+    };
+}
+
+auto ossia::websocket_mask(std::span<char> data, std::uint32_t mask) noexcept -> void {
+    char *first = data.data();
+    char *last  = first + data.size();
+
+    // Each step consumes a multiple of 4 bytes, so the masking key never needs to be rotated.
+#if defined(__AVX2__)
+    __m256i key256 = _mm256_set1_epi32(static_cast<int>(mask));
+    while (last - first >= 32) {
+        auto   *p     = reinterpret_cast<__m256i *>(first);
+        __m256i value = _mm256_loadu_si256(p);
+        _mm256_storeu_si256(p, _mm256_xor_si256(value, key256));
+        first += 32;
+    }
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    __m128i key128 = _mm_set1_epi32(static_cast<int>(mask));
+    while (last - first >= 16) {
+        auto   *p     = reinterpret_cast<__m128i *>(first);
+        __m128i value = _mm_loadu_si128(p);
+        _mm_storeu_si128(p, _mm_xor_si128(value, key128));
+        first += 16;
+    }
+#endif
+
+    std::uint64_t key64 = (static_cast<std::uint64_t>(mask) << 32) | mask;
+    while (last - first >= 8) {
+        std::uint64_t value;
+        std::memcpy(&value, first, sizeof(value));
+        value ^= key64;
+        std::memcpy(first, &value, sizeof(value));
+        first += 8;
+    }
+
+    std::uint8_t key[4];
+    std::memcpy(key, &mask, sizeof(key));
+    for (std::size_t i = 0; first != last; ++i, ++first)
+        *first = static_cast<char>(static_cast<std::uint8_t>(*first) ^ key[i & 3]);
+}
+
+auto ossia::write_websocket_frame(websocket_opcode opcode,
+                                  bool             fin,
+                                  std::string_view payload,
+                                  std::string     &output) -> void {
+    write_frame_header(opcode, fin, payload.size(), false, 0, output);
+    output.append(payload);
+}
+
+auto ossia::write_websocket_frame(websocket_opcode opcode,
+                                  bool             fin,
+                                  std::string_view payload,
+                                  std::uint32_t    mask,
+                                  std::string     &output) -> void {
+    write_frame_header(opcode, fin, payload.size(), true, mask, output);
+
+    std::size_t offset = output.size();
+    output.append(payload);
+    websocket_mask(std::span<char>(output.data() + offset, payload.size()), mask);
+}
+
+auto ossia::websocket_accept_key(std::string_view key) -> std::string {
+    std::string data;
+    data.reserve(key.size() + websocket_guid.size());
+    data.append(key);
+    data.append(websocket_guid);
+
+    auto digest = sha1(data);
+    return base64_encode(digest.data(), digest.size());
+}
+
+websocket_stream::websocket_stream() noexcept
+    : m_stream(),
+      m_data(),
+      m_begin(),
+      m_cursor(),
+      m_end(),
+      m_capacity(),
+      m_limit(),
+      m_message_size(),
+      m_message_opcode(websocket_opcode::continuation),
+      m_client(),
+      m_flushing(),
+      m_close_sent(),
+      m_ping_sent(),
+      m_random(),
+      m_ping_interval(default_ping_interval),
+      m_pending(),
+      m_sending() {}
+
+websocket_stream::websocket_stream(tcp_stream stream, bool client, std::size_t limit)
+    : m_stream(std::move(stream)),
+      m_data(std::make_unique_for_overwrite<char[]>(default_buffer_size)),
+      m_begin(),
+      m_cursor(),
+      m_end(),
+      m_capacity(default_buffer_size),
+      m_limit(limit),
+      m_message_size(),
+      m_message_opcode(websocket_opcode::continuation),
+      m_client(client),
+      m_flushing(),
+      m_close_sent(),
+      m_ping_sent(),
+      m_random(client ? random_seed() : 0),
+      m_ping_interval(default_ping_interval),
+      m_pending(),
+      m_sending() {}
+
+auto websocket_stream::open(tcp_stream stream, std::size_t limit) -> void {
+    if (m_data == nullptr) {
+        m_data     = std::make_unique_for_overwrite<char[]>(default_buffer_size);
+        m_capacity = default_buffer_size;
+    }
+
+    m_stream = std::move(stream);
+    m_limit  = limit;
+}
+
+auto websocket_stream::recycle() noexcept -> bool {
+    m_stream.close();
+
+    // Release large buffers kept by large messages.
+    if (m_capacity > std::max(default_buffer_size, detail::max_retained_buffer)) {
+        try {
+            m_data = std::make_unique_for_overwrite<char[]>(default_buffer_size);
+        } catch (...) {
+            return false;
+        }
+        m_capacity = default_buffer_size;
+    }
+
+    if (m_pending.capacity() > detail::max_retained_buffer)
+        std::string().swap(m_pending);
+    if (m_sending.capacity() > detail::max_retained_buffer)
+        std::string().swap(m_sending);
+
+    m_begin          = 0;
+    m_cursor         = 0;
+    m_end            = 0;
+    m_message_size   = 0;
+    m_message_opcode = websocket_opcode::continuation;
+    m_flushing       = false;
+    m_close_sent     = false;
+    m_ping_sent      = false;
+    m_ping_interval  = default_ping_interval;
+    m_pending.clear();
+    m_sending.clear();
+    return true;
+}
+
+auto websocket_stream::accept_async(tcp_stream stream, std::size_t limit) noexcept
+    -> future<std::expected<websocket_stream, std::error_code>> {
+    websocket_stream websocket(std::move(stream), false, limit);
+
+    auto error = co_await websocket.accept_handshake_async();
+    if (error) [[unlikely]]
+        co_return std::unexpected(error);
+
+    co_return std::move(websocket);
+}
+
+auto websocket_stream::accept_handshake_async() noexcept -> future<std::error_code> {
+    http_request request;
+    std::size_t  header_size;
+
+    // Receive the handshake request.
+    while (true) {
+        std::string_view data(m_data.get(), m_end);
+
+        auto result = parse_http_request(data, request);
+        if (result.has_value()) {
+            header_size = *result;
+            break;
+        }
+
+        if (result.error() != http_parse_error::incomplete || m_end == m_capacity) [[unlikely]] {
+            m_pending.append("HTTP/1.1 400 Bad Request\r\n"
+                             "Content-Length: 0\r\n"
+                             "Connection: close\r\n\r\n");
+            static_cast<void>(co_await flush_async());
+            co_return std::make_error_code(std::errc::protocol_error);
+        }
+
+        auto received = co_await m_stream.receive_async(
+            m_data.get() + m_end, static_cast<std::uint32_t>(m_capacity - m_end));
+
+        if (!received.has_value()) [[unlikely]]
+            co_return received.error();
+
+        if (*received == 0) [[unlikely]]
+            co_return std::make_error_code(std::errc::connection_reset);
+
+        m_end += *received;
+    }
+
+    auto key = request.header("Sec-WebSocket-Key");
+
+    bool valid = request.method() == "GET" && request.minor_version() == 1 &&
+                 !request.is_chunked() && request.content_length() == 0 &&
+                 has_token(request.header("Upgrade"), "websocket") &&
+                 has_token(request.header("Connection"), "upgrade") && key.has_value() &&
+                 key->size() == 24;
+
+    if (!valid) [[unlikely]] {
+        m_pending.append("HTTP/1.1 400 Bad Request\r\n"
+                         "Content-Length: 0\r\n"
+                         "Connection: close\r\n\r\n");
+        static_cast<void>(co_await flush_async());
+        co_return std::make_error_code(std::errc::protocol_error);
+    }
+
+    if (request.header("Sec-WebSocket-Version") != "13") [[unlikely]] {
+        m_pending.append("HTTP/1.1 426 Upgrade Required\r\n"
+                         "Sec-WebSocket-Version: 13\r\n"
+                         "Content-Length: 0\r\n"
+                         "Connection: close\r\n\r\n");
+        static_cast<void>(co_await flush_async());
+        co_return std::make_error_code(std::errc::protocol_error);
+    }
+
+    m_pending.append("HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: ");
+    m_pending.append(websocket_accept_key(*key));
+    m_pending.append("\r\n\r\n");
+
+    auto error = co_await flush_async();
+    if (error) [[unlikely]]
+        co_return error;
+
+    // Frames may be pipelined right after the handshake request.
+    m_begin  = header_size;
+    m_cursor = header_size;
+
+    co_return std::error_code();
+}
+
+auto websocket_stream::connect_async(const inet_address &address,
+                                     std::string_view    host,
+                                     std::string_view    target,
+                                     std::size_t         limit) noexcept
+    -> future<std::expected<websocket_stream, std::error_code>> {
+    tcp_stream stream;
+
+    auto error = co_await stream.connect_async(address);
+    if (error) [[unlikely]]
+        co_return std::unexpected(error);
+
+    stream.set_no_delay(true);
+    websocket_stream websocket(std::move(stream), true, limit);
+
+    // Generate a random 16-byte nonce for Sec-WebSocket-Key.
+    std::uint8_t nonce[16];
+    for (std::size_t i = 0; i < sizeof(nonce); i += 8) {
+        std::uint64_t value = next_random(websocket.m_random);
+        std::memcpy(nonce + i, &value, sizeof(value));
+    }
+
+    std::string key = base64_encode(nonce, sizeof(nonce));
+
+    std::string &output = websocket.m_pending;
+    output.append("GET ");
+    output.append(target);
+    output.append(" HTTP/1.1\r\nHost: ");
+    output.append(host);
+    output.append("\r\nUpgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: ");
+    output.append(key);
+    output.append("\r\nSec-WebSocket-Version: 13\r\n\r\n");
+
+    error = co_await websocket.flush_async();
+    if (error) [[unlikely]]
+        co_return std::unexpected(error);
+
+    // Receive the handshake response.
+    std::size_t header_size;
+    while (true) {
+        std::string_view data(websocket.m_data.get(), websocket.m_end);
+
+        std::size_t position = data.find("\r\n\r\n");
+        if (position != std::string_view::npos) {
+            header_size = position + 4;
+            break;
+        }
+
+        if (websocket.m_end == websocket.m_capacity) [[unlikely]]
+            co_return std::unexpected(std::make_error_code(std::errc::protocol_error));
+
+        auto received = co_await websocket.m_stream.receive_async(
+            websocket.m_data.get() + websocket.m_end,
+            static_cast<std::uint32_t>(websocket.m_capacity - websocket.m_end));
+
+        if (!received.has_value()) [[unlikely]]
+            co_return std::unexpected(received.error());
+
+        if (*received == 0) [[unlikely]]
+            co_return std::unexpected(std::make_error_code(std::errc::connection_reset));
+
+        websocket.m_end += *received;
+    }
+
+    std::string_view header(websocket.m_data.get(), header_size);
+    if (!check_handshake_response(header, websocket_accept_key(key))) [[unlikely]]
+        co_return std::unexpected(std::make_error_code(std::errc::protocol_error));
+
+    websocket.m_begin  = header_size;
+    websocket.m_cursor = header_size;
+
+    co_return std::move(websocket);
+}
+
+auto websocket_stream::receive_async() noexcept
+    -> future<std::expected<websocket_message, std::error_code>> {
+    while (true) {
+        auto frame = parse_websocket_frame(
+            std::span<const char>(m_data.get() + m_cursor, m_end - m_cursor));
+
+        if (frame.has_value()) {
+            // Frames sent by clients must be masked and frames sent by servers must not be masked.
+            if (frame->masked == m_client) [[unlikely]]
+                co_return std::unexpected(std::make_error_code(std::errc::protocol_error));
+
+            if (frame->payload_size > m_limit - m_message_size) [[unlikely]]
+                co_return std::unexpected(std::make_error_code(std::errc::message_size));
+
+            auto size  = static_cast<std::size_t>(frame->payload_size);
+            auto total = frame->header_size + size;
+
+            if (m_end - m_cursor >= total) {
+                char *payload = m_data.get() + m_cursor + frame->header_size;
+                if (frame->masked)
+                    websocket_mask(std::span<char>(payload, size), frame->mask);
+
+                m_cursor += total;
+
+                switch (frame->opcode) {
+                case websocket_opcode::ping:
+                    if (!m_close_sent) {
+                        queue(websocket_opcode::pong, std::string_view(payload, size));
+                        auto error = co_await flush_async();
+                        if (error) [[unlikely]]
+                            co_return std::unexpected(error);
+                    }
+                    continue;
+
+                case websocket_opcode::pong:
+                    continue;
+
+                case websocket_opcode::close:
+                    if (size == 1) [[unlikely]]
+                        co_return std::unexpected(std::make_error_code(std::errc::protocol_error));
+
+                    // Echo the status code to complete the closing handshake.
+                    if (!m_close_sent) {
+                        m_close_sent = true;
+                        queue(websocket_opcode::close,
+                              std::string_view(payload, std::min<std::size_t>(size, 2)));
+
+                        auto error = co_await flush_async();
+                        if (error) [[unlikely]]
+                            co_return std::unexpected(error);
+                    }
+
+                    co_return websocket_message{
+                        .opcode  = websocket_opcode::close,
+                        .payload = std::string_view(payload, size),
+                    };
+
+                case websocket_opcode::continuation:
+                    if (m_message_opcode == websocket_opcode::continuation) [[unlikely]]
+                        co_return std::unexpected(std::make_error_code(std::errc::protocol_error));
+                    break;
+
+                default:
+                    if (m_message_opcode != websocket_opcode::continuation) [[unlikely]]
+                        co_return std::unexpected(std::make_error_code(std::errc::protocol_error));
+                    m_message_opcode = frame->opcode;
+                    break;
+                }
+
+                // Unfragmented messages are returned in place without copying.
+                if (frame->fin && m_message_size == 0) {
+                    m_begin = m_cursor;
+                    co_return websocket_message{
+                        .opcode  = std::exchange(m_message_opcode, websocket_opcode::continuation),
+                        .payload = std::string_view(payload, size),
+                    };
+                }
+
+                // Reassemble fragments right after previous fragments.
+                std::memmove(m_data.get() + m_begin + m_message_size, payload, size);
+                m_message_size += size;
+
+                if (frame->fin) {
+                    websocket_message message{
+                        .opcode  = std::exchange(m_message_opcode, websocket_opcode::continuation),
+                        .payload = std::string_view(m_data.get() + m_begin, m_message_size),
+                    };
+
+                    m_begin        = m_cursor;
+                    m_message_size = 0;
+                    co_return message;
+                }
+
+                continue;
+            }
+        } else if (frame.error() == websocket_parse_error::invalid) [[unlikely]] {
+            co_return std::unexpected(std::make_error_code(std::errc::protocol_error));
+        }
+
+        // Send queued frames before waiting for more data.
+        if (!m_pending.empty()) {
+            auto error = co_await flush_async();
+            if (error) [[unlikely]]
+                co_return std::unexpected(error);
+        }
+
+        // More data is required.
+        if (!prepare()) [[unlikely]]
+            co_return std::unexpected(std::make_error_code(std::errc::message_size));
+
+        std::size_t free   = std::min<std::size_t>(m_capacity - m_end, max_io_size);
+        auto        result = co_await m_stream.receive_async(
+            m_data.get() + m_end, static_cast<std::uint32_t>(free), m_ping_interval);
+
+        if (!result.has_value()) [[unlikely]] {
+            if (result.error() != std::errc::timed_out)
+                co_return std::unexpected(result.error());
+
+            // The peer did not respond to the previous ping.
+            if (m_ping_sent)
+                co_return std::unexpected(result.error());
+
+            m_ping_sent = true;
+            queue(websocket_opcode::ping, std::string_view());
+
+            auto error = co_await flush_async();
+            if (error) [[unlikely]]
+                co_return std::unexpected(error);
+
+            continue;
+        }
+
+        if (*result == 0) [[unlikely]]
+            co_return std::unexpected(std::make_error_code(std::errc::connection_reset));
+
+        m_ping_sent  = false;
+        m_end       += *result;
+    }
+}
+
+auto websocket_stream::send_async(websocket_opcode opcode,
+                                  std::string_view payload,
+                                  bool             fin) noexcept -> future<std::error_code> {
+    queue(opcode, payload, fin);
+    co_return co_await flush_async();
+}
+
+auto websocket_stream::close_async(std::uint16_t code) noexcept -> future<std::error_code> {
+    if (m_close_sent)
+        co_return std::error_code();
+
+    char payload[2]{
+        static_cast<char>(code >> 8),
+        static_cast<char>(code),
+    };
+
+    m_close_sent = true;
+    queue(websocket_opcode::close, std::string_view(payload, sizeof(payload)));
+    co_return co_await flush_async();
+}
+
+auto websocket_stream::queue(websocket_opcode opcode, std::string_view payload, bool fin) -> void {
+    if (m_client) {
+        auto mask = static_cast<std::uint32_t>(next_random(m_random));
+        write_websocket_frame(opcode, fin, payload, mask, m_pending);
+    } else {
+        write_websocket_frame(opcode, fin, payload, m_pending);
+    }
+}
+
+auto websocket_stream::flush_async() noexcept -> future<std::error_code> {
+    // Frames queued now will be sent by the active flush operation.
+    if (m_flushing)
+        co_return std::error_code();
+
+    m_flushing = true;
+    while (!m_pending.empty()) {
+        m_sending.swap(m_pending);
+
+        std::size_t sent = 0;
+        while (sent < m_sending.size()) {
+            std::size_t size   = std::min<std::size_t>(m_sending.size() - sent, max_io_size);
+            auto        result = co_await m_stream.send_async(m_sending.data() + sent,
+                                                              static_cast<std::uint32_t>(size));
+
+            if (!result.has_value()) [[unlikely]] {
+                m_sending.clear();
+                m_flushing = false;
+                co_return result.error();
+            }
+
+            sent += *result;
+        }
+
+        m_sending.clear();
+    }
+
+    m_flushing = false;
+    co_return std::error_code();
+}
+
+auto websocket_stream::prepare() -> bool {
+    char *data = m_data.get();
+
+    // Discard handled data and control frames between the reassembled message and unparsed
+    // frames.
+    if (m_begin != 0)
+        std::memmove(data, data + m_begin, m_message_size);
+    if (m_cursor != m_message_size)
+        std::memmove(data + m_message_size, data + m_cursor, m_end - m_cursor);
+
+    m_end    = m_message_size + (m_end - m_cursor);
+    m_cursor = m_message_size;
+    m_begin  = 0;
+
+    if (m_end < m_capacity)
+        return true;
+
+    // Grow the buffer if it is full.
+    std::size_t limit = m_limit + frame_overhead;
+    if (m_capacity >= limit) [[unlikely]]
+        return false;
+
+    std::size_t capacity = std::min(m_capacity * 2, limit);
+    auto        buffer   = std::make_unique_for_overwrite<char[]>(capacity);
+
+    std::memcpy(buffer.get(), data, m_end);
+    m_data     = std::move(buffer);
+    m_capacity = capacity;
+
+    return true;
+}
@@ -0,0 +1,203 @@
+#include "ossia/tcp_server.hpp"
+
+#include <doctest/doctest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace ossia;
+
+inline constexpr std::size_t file_size = 3 * 1048576 + 12345;
+
+static auto make_content() noexcept -> std::vector<char> {
+    std::vector<char> content(file_size);
+    for (std::size_t i = 0; i < content.size(); ++i)
+        content[i] = static_cast<char>((i * 131) ^ (i >> 7));
+    return content;
+}
+
+static auto file_operations(io_context &ctx, std::string path) noexcept -> future<> {
+    auto content = make_content();
+
+    { // Create and write the file.
+        auto created = co_await file::open_async(
+            path.c_str(), file_mode::write | file_mode::create | file_mode::truncate);
+        REQUIRE(created.has_value());
+        CHECK(created->is_open());
+
+        std::size_t written = 0;
+        while (written < content.size()) {
+            auto result = co_await created->write_async(
+                content.data() + written, static_cast<std::uint32_t>(content.size() - written),
+                written);
+            REQUIRE(result.has_value());
+            written += *result;
+        }
+    }
+
+    { // Exclusive creation fails for an existing file.
+        auto created = co_await file::open_async(
+            path.c_str(), file_mode::write | file_mode::create | file_mode::exclusive);
+        CHECK_FALSE(created.has_value());
+        CHECK(created.error() == std::errc::file_exists);
+    }
+
+    { // Query status by path.
+        auto status = co_await file::status_async(path.c_str());
+        REQUIRE(status.has_value());
+        CHECK(status->size == file_size);
+        CHECK(status->is_regular);
+        CHECK_FALSE(status->is_directory);
+        CHECK(status->last_write_time.time_since_epoch().count() > 0);
+    }
+
+    { // Query status of a directory.
+        auto directory = std::filesystem::path(path).parent_path().string();
+        auto status    = co_await file::status_async(directory.c_str());
+        REQUIRE(status.has_value());
+        CHECK(status->is_directory);
+        CHECK_FALSE(status->is_regular);
+    }
+
+    { // Missing files.
+        auto missing = path + ".missing";
+        auto status  = co_await file::status_async(missing.c_str());
+        CHECK_FALSE(status.has_value());
+        CHECK(status.error() == std::errc::no_such_file_or_directory);
+
+        auto opened = co_await file::open_async(missing.c_str());
+        CHECK_FALSE(opened.has_value());
+        CHECK(opened.error() == std::errc::no_such_file_or_directory);
+    }
+
+    { // Read the file back.
+        auto opened = co_await file::open_async(path.c_str());
+        REQUIRE(opened.has_value());
+
+        auto status = co_await opened->status_async();
+        REQUIRE(status.has_value());
+        CHECK(status->size == file_size);
+
+        auto by_path = co_await file::status_async(path.c_str());
+        REQUIRE(by_path.has_value());
+        CHECK(status->id == by_path->id);
+
+        char buffer[4096];
+        auto result = co_await opened->read_async(buffer, sizeof(buffer), 1000);
+        REQUIRE(result.has_value());
+        CHECK(*result == sizeof(buffer));
+        CHECK(std::equal(buffer, buffer + sizeof(buffer), content.data() + 1000));
+
+        // Reading at end of file returns 0.
+        result = co_await opened->read_async(buffer, sizeof(buffer), file_size);
+        REQUIRE(result.has_value());
+        CHECK(*result == 0);
+
+        file moved = std::move(*opened);
+        CHECK_FALSE(opened->is_open());
+        CHECK(moved.is_open());
+
+        moved.close();
+        CHECK_FALSE(moved.is_open());
+    }
+
+    ctx.stop();
+}
+
+TEST_CASE("File async operations") {
+    auto path = (std::filesystem::temp_directory_path() / "ossia-test-file.bin").string();
+
+    io_context ctx(1);
+    ctx.dispatch(file_operations, ctx, path);
+    ctx.run();
+
+    std::filesystem::remove(path);
+}
+
+static auto file_sender(tcp_server &server, std::string path) noexcept -> future<> {
+    auto connection = co_await server.accept_async();
+    REQUIRE(connection.has_value());
+
+    auto opened = co_await file::open_async(path.c_str());
+    REQUIRE(opened.has_value());
+
+    // Send the whole file.
+    auto result = co_await connection->send_file_async(*opened, 0, file_size);
+    REQUIRE(result.has_value());
+    CHECK(*result == file_size);
+
+    // Send a range in the middle of the file.
+    result = co_await connection->send_file_async(*opened, 4097, 100000);
+    REQUIRE(result.has_value());
+    CHECK(*result == 100000);
+
+    // Sending beyond end of file stops at end of file.
+    result = co_await connection->send_file_async(*opened, file_size - 10, 1000);
+    REQUIRE(result.has_value());
+    CHECK(*result == 10);
+}
+
+static auto file_receiver(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    auto content = make_content();
+
+    std::vector<char> expected(content);
+    expected.insert(expected.end(), content.begin() + 4097, content.begin() + 4097 + 100000);
+    expected.insert(expected.end(), content.end() - 10, content.end());
+
+    tcp_stream connection;
+    auto       error = co_await connection.connect_async(address);
+    REQUIRE(error.value() == 0);
+
+    std::vector<char> received(expected.size());
+    std::size_t       total = 0;
+    while (total < received.size()) {
+        auto result = co_await connection.receive_async(
+            received.data() + total, static_cast<std::uint32_t>(received.size() - total));
+        REQUIRE(result.has_value());
+        REQUIRE(*result != 0);
+        total += *result;
+    }
+
+    CHECK(received == expected);
+    ctx.stop();
+}
+
+static auto file_transfer(io_context         &ctx,
+                          const inet_address &address,
+                          std::string         path) noexcept -> future<> {
+    auto content = make_content();
+
+    {
+        auto created = co_await file::open_async(
+            path.c_str(), file_mode::write | file_mode::create | file_mode::truncate);
+        REQUIRE(created.has_value());
+
+        std::size_t written = 0;
+        while (written < content.size()) {
+            auto result = co_await created->write_async(
+                content.data() + written, static_cast<std::uint32_t>(content.size() - written),
+                written);
+            REQUIRE(result.has_value());
+            written += *result;
+        }
+    }
+
+    tcp_server server;
+    REQUIRE(server.bind(address).value() == 0);
+
+    schedule(file_receiver(ctx, address));
+    co_await file_sender(server, std::move(path));
+}
+
+TEST_CASE("TCP send file") {
+    auto path = (std::filesystem::temp_directory_path() / "ossia-test-send-file.bin").string();
+
+    io_context ctx(1);
+
+    inet_address address(ipv4_loopback, 23340);
+    ctx.dispatch(file_transfer, ctx, address, path);
+    ctx.run();
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,76 @@
+#include "ossia/futex.hpp"
+
+#include <doctest/doctest.h>
+
+#include <thread>
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+using namespace ossia;
+
+static auto futex_consumer(io_context &ctx, futex &word, std::uint32_t count) noexcept -> future<> {
+    // Coroutine is not suspended if the word has been changed.
+    std::error_code error = co_await word.wait(UINT32_MAX);
+    CHECK(error.value() == 0);
+
+    std::uint32_t value = word.word().load(std::memory_order_acquire);
+    while (value < count) {
+        error = co_await word.wait(value);
+        CHECK(error.value() == 0);
+        value = word.word().load(std::memory_order_acquire);
+    }
+
+    CHECK(value == count);
+    ctx.stop();
+}
+
+TEST_CASE("Futex notified by foreign thread") {
+    constexpr std::uint32_t count = 1000;
+
+    futex      word;
+    io_context ctx(1);
+    ctx.dispatch(futex_consumer, ctx, word, count);
+
+    std::thread producer([&word]() {
+        for (std::uint32_t i = 0; i < count; ++i) {
+            word.word().fetch_add(1, std::memory_order_release);
+            word.notify_one();
+        }
+    });
+
+    ctx.run();
+    producer.join();
+}
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+static auto futex_raw_consumer(io_context &ctx, futex &word) noexcept -> future<> {
+    while (word.word().load(std::memory_order_acquire) == 0) {
+        std::error_code error = co_await word.wait(0);
+        CHECK(error.value() == 0);
+    }
+
+    ctx.stop();
+}
+
+TEST_CASE("Futex woken by plain futex wake") {
+    futex word;
+    if (!word.is_native())
+        return;
+
+    io_context ctx(1);
+    ctx.dispatch(futex_raw_consumer, ctx, word);
+
+    std::thread producer([&word]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        word.word().store(1, std::memory_order_release);
+        ::syscall(SYS_futex, &word.word(), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    });
+
+    ctx.run();
+    producer.join();
+}
+#endif
@@ -0,0 +1,94 @@
+#include "ossia/health_prober.hpp"
+#include "ossia/tcp_server.hpp"
+#include "ossia/timer.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \brief
+///   Reply "PONG" to a 4-byte request, or never reply if \p silent is set.
+static auto probe_session(tcp_stream stream, bool silent) noexcept -> future<> {
+    char buffer[4];
+    auto received = co_await stream.receive_async(buffer, sizeof(buffer));
+    if (!received.has_value() || *received != sizeof(buffer))
+        co_return;
+
+    // Wait for the prober to close the connection.
+    if (silent) {
+        co_await stream.receive_async(buffer, sizeof(buffer));
+        co_return;
+    }
+
+    [[maybe_unused]] auto sent = co_await stream.send_async("PONG", 4);
+}
+
+static auto probe_target(inet_address address, bool silent) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    while (true) {
+        auto connection = co_await server.accept_async();
+        REQUIRE(connection.has_value());
+        schedule(probe_session(std::move(*connection), silent));
+    }
+}
+
+static auto check_health(io_context &ctx, health_prober &prober) noexcept -> future<> {
+    co_await sleep_for(500ms);
+    prober.stop();
+
+    probe_status alive = prober.status(0);
+    CHECK(alive.health == endpoint_health::healthy);
+    CHECK(alive.succeeded);
+    CHECK(alive.consecutive >= 2);
+    CHECK(!alive.error);
+
+    probe_status refused = prober.status(1);
+    CHECK(refused.health == endpoint_health::unhealthy);
+    CHECK_FALSE(refused.succeeded);
+    CHECK(refused.error == std::errc::connection_refused);
+
+    // Replies that never come are cut by the probe timeout.
+    probe_status silent = prober.status(2);
+    CHECK(silent.health == endpoint_health::unhealthy);
+    CHECK(silent.error == std::errc::timed_out);
+    CHECK(silent.latency >= 40ms);
+    CHECK(silent.latency < 500ms);
+
+    CHECK(prober.healthy_count() == 1);
+    CHECK(prober.probes() >= 6);
+    CHECK(prober.failures() >= 4);
+
+    // Let the probe tasks drain after stopping.
+    co_await sleep_for(250ms);
+    ctx.stop();
+}
+
+TEST_CASE("health prober") {
+    io_context   ctx(1);
+    inet_address alive(ipv4_loopback, 23355);
+    inet_address refused(ipv4_loopback, 23356);
+    inet_address silent(ipv4_loopback, 23357);
+    bool         loud  = false;
+    bool         quiet = true;
+
+    health_prober_options options;
+    options.interval            = 100ms;
+    options.timeout             = 50ms;
+    options.unhealthy_threshold = 2;
+    options.request             = "PING";
+    options.response            = "PONG";
+
+    // Two shards run in one worker.
+    health_prober prober({alive, refused, silent}, 2, options);
+    auto          run = [&prober]() noexcept -> future<> { return prober.run(); };
+
+    ctx.dispatch(probe_target, alive, loud);
+    ctx.dispatch(probe_target, silent, quiet);
+    ctx.dispatch(run);
+    ctx.dispatch(run);
+    ctx.dispatch(check_health, ctx, prober);
+    ctx.run();
+}
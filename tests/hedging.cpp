@@ -0,0 +1,169 @@
+#include "ossia/hedging.hpp"
+#include "ossia/tcp_server.hpp"
+
+#include <doctest/doctest.h>
+
+#include <thread>
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <netinet/in.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+#endif
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \brief
+///   Reply to a 4-byte request after the specified delay.
+static auto replica_session(tcp_stream stream, std::chrono::milliseconds delay) noexcept
+    -> future<> {
+    char buffer[4];
+    auto received = co_await stream.receive_async(buffer, sizeof(buffer));
+    if (!received.has_value() || *received != sizeof(buffer))
+        co_return;
+
+    co_await sleep_for(delay);
+    [[maybe_unused]] auto sent = co_await stream.send_async(buffer, sizeof(buffer));
+}
+
+static auto replica(inet_address address, std::chrono::milliseconds delay) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    while (true) {
+        auto connection = co_await server.accept_async();
+        REQUIRE(connection.has_value());
+        schedule(replica_session(std::move(*connection), delay));
+    }
+}
+
+/// \brief
+///   Send a 4-byte request and wait for the echo.
+static auto echo_request(tcp_stream &stream) noexcept
+    -> future<std::expected<std::uint32_t, std::error_code>> {
+    char request[4]{'p', 'i', 'n', 'g'};
+    auto sent = co_await stream.send_async(request, sizeof(request));
+    if (!sent.has_value())
+        co_return std::unexpected(sent.error());
+
+    char reply[4]{};
+    auto received = co_await stream.receive_async(reply, sizeof(reply));
+    if (!received.has_value())
+        co_return std::unexpected(received.error());
+    if (*received != sizeof(reply))
+        co_return std::unexpected(std::make_error_code(std::errc::connection_reset));
+
+    co_return *received;
+}
+
+static auto hedged_requests(io_context &ctx, inet_address slow, inet_address fast) noexcept
+    -> future<> {
+    hedging_options options;
+    options.initial_delay = 20ms;
+    options.budget_ratio  = 0;
+    options.budget_burst  = 1;
+
+    hedging_client client({slow, fast}, options);
+
+    // Primary attempt goes to the slow replica and is beaten by the hedged attempt.
+    auto start  = std::chrono::steady_clock::now();
+    auto result = co_await client.execute_async(echo_request);
+    CHECK(result.has_value());
+    CHECK(std::chrono::steady_clock::now() - start < 400ms);
+    CHECK(client.stats().hedges == 1);
+    CHECK(client.stats().hedge_wins == 1);
+
+    // Primary attempt goes to the fast replica.
+    result = co_await client.execute_async(echo_request);
+    CHECK(result.has_value());
+    CHECK(client.stats().hedges == 1);
+
+    // The hedge budget has run out.
+    result = co_await client.execute_async(echo_request);
+    CHECK(result.has_value());
+    CHECK(client.stats().hedges == 1);
+    CHECK(client.stats().throttled_hedges == 1);
+
+    CHECK(client.stats().requests == 3);
+    CHECK(client.stats().failures == 0);
+    CHECK(client.stats().hit_rate() == 1.0);
+
+    // Failed primary attempts are hedged at once.
+    hedging_client broken({inet_address(ipv4_loopback, 23349), fast}, options);
+    result = co_await broken.execute_async(echo_request);
+    CHECK(result.has_value());
+    CHECK(broken.stats().hedge_wins == 1);
+
+    ctx.stop();
+}
+
+TEST_CASE("Hedged requests") {
+    io_context ctx(1);
+
+    inet_address slow(ipv4_loopback, 23344);
+    inet_address fast(ipv4_loopback, 23345);
+
+    std::chrono::milliseconds slow_delay = 500ms;
+    std::chrono::milliseconds fast_delay = 0ms;
+    ctx.dispatch(replica, slow, slow_delay);
+    ctx.dispatch(replica, fast, fast_delay);
+    ctx.dispatch(hedged_requests, ctx, slow, fast);
+
+    ctx.run();
+}
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+static auto hedged_silent_request(io_context &ctx, inet_address silent, inet_address fast) noexcept
+    -> future<> {
+    hedging_options options;
+    options.initial_delay = 20ms;
+
+    // Attempts share the request function, so the token is released with the last attempt.
+    auto token   = std::make_shared<int>();
+    auto request = [token](tcp_stream &stream) { return echo_request(stream); };
+
+    hedging_client client({silent, fast}, options);
+    auto           result = co_await client.execute_async(std::move(request));
+    CHECK(result.has_value());
+    CHECK(client.stats().hedge_wins == 1);
+
+    // The primary attempt is still connecting to the silent replica and must be cancelled.
+    co_await sleep_for(50ms);
+    CHECK(token.use_count() == 1);
+
+    ctx.stop();
+}
+
+TEST_CASE("Hedged requests cancel pending connects") {
+    inet_address silent(ipv4_loopback, 23358);
+    inet_address fast(ipv4_loopback, 23359);
+
+    // A listener with a full accept queue drops new SYNs, so connects to it never complete.
+    int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    REQUIRE(listener != -1);
+    CHECK(::bind(listener, reinterpret_cast<const sockaddr *>(&silent), sizeof(sockaddr_in)) == 0);
+    CHECK(::listen(listener, 0) == 0);
+
+    int fillers[2];
+    for (int &filler : fillers) {
+        filler = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+        REQUIRE(filler != -1);
+        ::connect(filler, reinterpret_cast<const sockaddr *>(&silent), sizeof(sockaddr_in));
+    }
+
+    std::this_thread::sleep_for(50ms);
+
+    io_context ctx(1);
+
+    std::chrono::milliseconds fast_delay = 0ms;
+    ctx.dispatch(replica, fast, fast_delay);
+    ctx.dispatch(hedged_silent_request, ctx, silent, fast);
+
+    ctx.run();
+
+    for (int filler : fillers)
+        ::close(filler);
+    ::close(listener);
+}
+#endif
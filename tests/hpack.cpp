@@ -0,0 +1,182 @@
+#include "ossia/hpack.hpp"
+
+#include <doctest/doctest.h>
+
+#include <string>
+
+using namespace ossia;
+
+TEST_CASE("HPACK Huffman code") {
+    // Examples from RFC 7541 appendix C.4.
+    std::string encoded;
+    hpack_huffman_encode("www.example.com", encoded);
+    CHECK(encoded == "\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff");
+    CHECK(hpack_huffman_size("www.example.com") == encoded.size());
+
+    std::string decoded;
+    CHECK(hpack_huffman_decode(encoded, decoded));
+    CHECK(decoded == "www.example.com");
+
+    encoded.clear();
+    hpack_huffman_encode("custom-value", encoded);
+    CHECK(encoded == "\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf");
+
+    // Every symbol survives a round trip, including codes longer than 24 bits.
+    std::string all;
+    for (int i = 0; i < 256; ++i)
+        all.push_back(static_cast<char>(i));
+
+    encoded.clear();
+    hpack_huffman_encode(all, encoded);
+    CHECK(hpack_huffman_size(all) == encoded.size());
+
+    decoded.clear();
+    CHECK(hpack_huffman_decode(encoded, decoded));
+    CHECK(decoded == all);
+
+    // Padding longer than 7 bits, padding that is not all ones and the EOS code are rejected.
+    decoded.clear();
+    CHECK_FALSE(hpack_huffman_decode("\xff", decoded));
+    CHECK_FALSE(hpack_huffman_decode(std::string_view("\x00", 1), decoded));
+    CHECK_FALSE(hpack_huffman_decode("\xff\xff\xff\xff", decoded));
+
+    decoded.clear();
+    CHECK(hpack_huffman_decode("\x1f", decoded));
+    CHECK(decoded == "a");
+}
+
+TEST_CASE("HPACK decoder") {
+    hpack_decoder     decoder;
+    hpack_header_list headers;
+
+    // Requests with Huffman coding from RFC 7541 appendix C.4.
+    auto result = decoder.decode("\x82\x86\x84\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4"
+                                 "\xff",
+                                 headers);
+    REQUIRE(result.has_value());
+    REQUIRE(headers.size() == 4);
+    CHECK(headers.name(0) == ":method");
+    CHECK(headers.value(0) == "GET");
+    CHECK(headers.name(1) == ":scheme");
+    CHECK(headers.value(1) == "http");
+    CHECK(headers.name(2) == ":path");
+    CHECK(headers.value(2) == "/");
+    CHECK(headers.find(":authority") == "www.example.com");
+    CHECK_FALSE(headers.find("cache-control").has_value());
+
+    headers.clear();
+    result = decoder.decode("\x82\x86\x84\xbe\x58\x86\xa8\xeb\x10\x64\x9c\xbf", headers);
+    REQUIRE(result.has_value());
+    REQUIRE(headers.size() == 5);
+    CHECK(headers.find(":authority") == "www.example.com");
+    CHECK(headers.find("cache-control") == "no-cache");
+
+    headers.clear();
+    result = decoder.decode("\x82\x87\x85\xbf\x40\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f\x89\x25\xa8"
+                            "\x49\xe9\x5b\xb8\xe8\xb4\xbf",
+                            headers);
+    REQUIRE(result.has_value());
+    REQUIRE(headers.size() == 5);
+    CHECK(headers.find(":scheme") == "https");
+    CHECK(headers.find(":path") == "/index.html");
+    CHECK(headers.find(":authority") == "www.example.com");
+    CHECK(headers.find("custom-key") == "custom-value");
+    CHECK(headers.list_size() == 5 * 32 + 7 + 3 + 7 + 5 + 5 + 11 + 10 + 15 + 10 + 12);
+
+    // Literal without Huffman coding from RFC 7541 appendix C.3.
+    hpack_decoder plain;
+    headers.clear();
+    result = plain.decode("\x82\x86\x84\x41\x0f\x77\x77\x77\x2e\x65\x78\x61\x6d\x70\x6c\x65\x2e"
+                          "\x63\x6f\x6d",
+                          headers);
+    REQUIRE(result.has_value());
+    CHECK(headers.find(":authority") == "www.example.com");
+
+    hpack_header_list ignored;
+
+    // A literal that names a dynamic table entry which is evicted by its own insertion.
+    std::string name(40, 'n');
+    std::string block("\x3f\xa9\x01\x40\x28");
+    block += name;
+    block += '\x28';
+    block += std::string(40, 'v');
+    block += "\x7e\x3c";
+    block += std::string(60, 'w');
+
+    hpack_decoder evicting;
+    headers.clear();
+    result = evicting.decode(block, headers);
+    REQUIRE(result.has_value());
+    REQUIRE(headers.size() == 2);
+    CHECK(headers.name(1) == name);
+    CHECK(headers.value(1) == std::string(60, 'w'));
+
+    headers.clear();
+    result = evicting.decode("\xbe", headers);
+    REQUIRE(result.has_value());
+    REQUIRE(headers.size() == 1);
+    CHECK(headers.name(0) == name);
+    CHECK(headers.value(0) == std::string(60, 'w'));
+    CHECK(evicting.decode("\xbf", ignored).error() == hpack_error::invalid_index);
+
+    // Malformed header blocks.
+    CHECK(hpack_decoder().decode(std::string_view("\x80", 1), ignored).error() ==
+          hpack_error::invalid_index);
+    CHECK(hpack_decoder().decode("\xc0", ignored).error() == hpack_error::invalid_index);
+    CHECK(hpack_decoder().decode("\x41\x05" "ab", ignored).error() == hpack_error::invalid);
+    CHECK(hpack_decoder().decode("\x41\x81\xff", ignored).error() == hpack_error::invalid_huffman);
+    CHECK(hpack_decoder().decode("\x3f\xe2\x1f", ignored).error() ==
+          hpack_error::invalid_table_size);
+    CHECK(hpack_decoder().decode("\x82\x20", ignored).error() == hpack_error::invalid_table_size);
+    CHECK(hpack_decoder().decode("\x82\x86", ignored, 64).error() ==
+          hpack_error::header_list_too_large);
+}
+
+TEST_CASE("HPACK round trip") {
+    hpack_encoder     encoder;
+    hpack_decoder     decoder;
+    hpack_header_list headers;
+
+    std::string first;
+    encoder.encode(":status", "200", first);
+    encoder.encode("content-type", "application/grpc", first);
+    encoder.encode("x-request-id", "0123456789", first);
+    encoder.encode("authorization", "secret", first, true);
+
+    REQUIRE(decoder.decode(first, headers).has_value());
+    REQUIRE(headers.size() == 4);
+    CHECK(headers.value(0) == "200");
+    CHECK(headers.find("content-type") == "application/grpc");
+    CHECK(headers.find("x-request-id") == "0123456789");
+    CHECK(headers.find("authorization") == "secret");
+
+    // Repeated header fields are encoded as indices of the dynamic table.
+    std::string second;
+    encoder.encode("content-type", "application/grpc", second);
+    encoder.encode("x-request-id", "0123456789", second);
+    CHECK(second.size() == 2);
+
+    headers.clear();
+    REQUIRE(decoder.decode(second, headers).has_value());
+    CHECK(headers.find("content-type") == "application/grpc");
+    CHECK(headers.find("x-request-id") == "0123456789");
+
+    // Shrinking the table emits a size update and evicts all entries.
+    encoder.set_max_table_size(0);
+    std::string third;
+    encoder.encode("content-type", "application/grpc", third);
+    CHECK(third.front() == '\x20');
+
+    headers.clear();
+    REQUIRE(decoder.decode(third, headers).has_value());
+    CHECK(headers.find("content-type") == "application/grpc");
+
+    // Long values need multi-byte integers.
+    std::string value(1000, 'x');
+    std::string fourth;
+    encoder.encode("x-long", value, fourth);
+
+    headers.clear();
+    REQUIRE(decoder.decode(fourth, headers).has_value());
+    CHECK(headers.find("x-long") == value);
+}
@@ -0,0 +1,121 @@
+#include "ossia/http2.hpp"
+#include "ossia/timer.hpp"
+
+#include <doctest/doctest.h>
+
+#include <string>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+TEST_CASE("HTTP/2 frame header") {
+    std::string output;
+    write_http2_frame_header(
+        http2_frame_header{
+            .length    = 0x123456,
+            .type      = http2_frame_type::headers,
+            .flags     = http2_flag_end_stream | http2_flag_end_headers,
+            .stream_id = 0x80000003,
+        },
+        output);
+
+    CHECK(output == std::string_view("\x12\x34\x56\x01\x05\x00\x00\x00\x03", 9));
+
+    // The reserved bit is ignored.
+    output[5]   = '\x80';
+    auto header = parse_http2_frame_header(output);
+    REQUIRE(header.has_value());
+    CHECK(header->length == 0x123456);
+    CHECK(header->type == http2_frame_type::headers);
+    CHECK(header->flags == (http2_flag_end_stream | http2_flag_end_headers));
+    CHECK(header->stream_id == 3);
+
+    CHECK_FALSE(parse_http2_frame_header(std::span<const char>(output.data(), 8)).has_value());
+}
+
+/// \brief
+///   Echo the request body after a short delay, so that streams overlap.
+static auto echo_handler(const http2_request &request, http2_response &response) noexcept
+    -> future<> {
+    co_await sleep_for(1ms);
+
+    response.add_header("content-type", "application/octet-stream");
+    response.add_header("x-path", request.path());
+    response.set_body(request.body());
+
+    if (request.path() == "/missing")
+        response.set_status(404);
+}
+
+static auto listener(const inet_address &address) noexcept -> future<> {
+    http2_server server;
+    CHECK(server.bind(address).value() == 0);
+    co_await server.run(echo_handler);
+}
+
+static auto request(http2_client &client,
+                    std::size_t   index,
+                    std::size_t  &completed) noexcept -> future<> {
+    std::string path = "/echo/" + std::to_string(index);
+    std::string body(index * 97, static_cast<char>('a' + index % 26));
+
+    auto response = co_await client.request_async("POST", path, body);
+    REQUIRE(response.has_value());
+    CHECK(response->status() == 200);
+    CHECK(response->header("x-path") == path);
+    CHECK(response->header("content-length") == std::to_string(body.size()));
+    CHECK(response->body() == body);
+
+    completed += 1;
+}
+
+static auto multiplex(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    http2_client client;
+    REQUIRE((co_await client.connect_async(address, "localhost")).value() == 0);
+
+    // Concurrent streams share the same connection.
+    std::size_t completed = 0;
+    for (std::size_t i = 0; i < 64; ++i)
+        schedule(request(client, i, completed));
+
+    while (completed < 64)
+        co_await sleep_for(1ms);
+
+    auto response = co_await client.request_async("GET", "/missing");
+    REQUIRE(response.has_value());
+    CHECK(response->status() == 404);
+    CHECK(response->body().empty());
+
+    // Bodies larger than the flow control windows are sent as windows are updated.
+    std::string large(1 << 20, 'x');
+    response = co_await client.request_async("PUT", "/large", large);
+    REQUIRE(response.has_value());
+    CHECK(response->status() == 200);
+    CHECK(response->body() == large);
+
+    // Bodies beyond the request limit are refused.
+    std::string huge(http2_server::default_request_limit + 1, 'x');
+    response = co_await client.request_async("PUT", "/huge", huge);
+    CHECK_FALSE(response.has_value());
+
+    response = co_await client.request_async("GET", "/after");
+    REQUIRE(response.has_value());
+    CHECK(response->header("x-path") == "/after");
+
+    client.close();
+    response = co_await client.request_async("GET", "/closed");
+    CHECK_FALSE(response.has_value());
+
+    // Let both ends of the connection shut down.
+    co_await sleep_for(10ms);
+    ctx.stop();
+}
+
+TEST_CASE("HTTP/2 server") {
+    io_context   ctx(1);
+    inet_address address(ipv4_loopback, 23350);
+
+    ctx.dispatch(listener, address);
+    ctx.dispatch(multiplex, ctx, address);
+    ctx.run();
+}
@@ -0,0 +1,155 @@
+#include "ossia/http_parser.hpp"
+
+#include <doctest/doctest.h>
+
+#include <string>
+
+using namespace ossia;
+
+TEST_CASE("HTTP request line and headers") {
+    std::string_view data = "GET /index.html?query=1 HTTP/1.1\r\n"
+                            "Host: example.com\r\n"
+                            "User-Agent:   ossia-test  \r\n"
+                            "Accept: */*\r\n"
+                            "\r\n";
+
+    http_request request;
+    auto         result = parse_http_request(data, request);
+
+    REQUIRE(result.has_value());
+    CHECK(*result == data.size());
+    CHECK(request.method() == "GET");
+    CHECK(request.target() == "/index.html?query=1");
+    CHECK(request.minor_version() == 1);
+    CHECK(request.keep_alive());
+    CHECK(!request.is_chunked());
+    CHECK(request.content_length() == 0);
+
+    REQUIRE(request.headers().size() == 3);
+    CHECK(request.headers()[0].name == "Host");
+    CHECK(request.headers()[0].value == "example.com");
+    CHECK(request.headers()[1].value == "ossia-test");
+    CHECK(request.header("user-agent") == "ossia-test");
+    CHECK(request.header("ACCEPT") == "*/*");
+    CHECK(!request.header("Content-Type").has_value());
+}
+
+TEST_CASE("HTTP request with long header fields") {
+    // Long fields go through the vectorized scanning path.
+    std::string name(100, 'x');
+    std::string value(300, 'v');
+    value[150] = '\t';
+
+    std::string data = "POST /" + std::string(200, 'p') + " HTTP/1.0\r\n" + name + ": " + value +
+                       "\r\nConnection: keep-alive\r\nContent-Length: 42\r\n\r\n";
+
+    http_request request;
+    auto         result = parse_http_request(data, request);
+
+    REQUIRE(result.has_value());
+    CHECK(*result == data.size());
+    CHECK(request.method() == "POST");
+    CHECK(request.target().size() == 201);
+    CHECK(request.minor_version() == 0);
+    CHECK(request.keep_alive());
+    CHECK(request.content_length() == 42);
+    CHECK(request.header(name) == value);
+}
+
+TEST_CASE("HTTP incomplete request") {
+    std::string_view data = "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+
+    // Every proper prefix of a valid request is incomplete.
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        http_request request;
+        auto         result = parse_http_request(data.substr(0, i), request);
+        REQUIRE(!result.has_value());
+        CHECK(result.error() == http_parse_error::incomplete);
+    }
+
+    http_request request;
+    auto         result = parse_http_request(data, request);
+    REQUIRE(result.has_value());
+    CHECK(!request.keep_alive());
+}
+
+TEST_CASE("HTTP pipelined requests") {
+    std::string_view data = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\nHost: b\r\n\r\nGET /c";
+
+    http_request request;
+    auto         first = parse_http_request(data, request);
+    REQUIRE(first.has_value());
+    CHECK(request.target() == "/a");
+
+    data.remove_prefix(*first);
+    auto second = parse_http_request(data, request);
+    REQUIRE(second.has_value());
+    CHECK(request.target() == "/b");
+    CHECK(request.header("host") == "b");
+
+    data.remove_prefix(*second);
+    auto third = parse_http_request(data, request);
+    REQUIRE(!third.has_value());
+    CHECK(third.error() == http_parse_error::incomplete);
+}
+
+TEST_CASE("HTTP malformed requests") {
+    const std::string_view cases[]{
+        "GET  / HTTP/1.1\r\n\r\n",
+        "GET / HTTP/2.0\r\n\r\n",
+        "GET / HTTP/1.1\r\nHost : example.com\r\n\r\n",
+        "GET / HTTP/1.1\r\nHost: example.com\r\n folded\r\n\r\n",
+        "GET / HTTP/1.1\r\nX-Test: a\x01z\r\n\r\n",
+        "GET / HTTP/1.1\r\nContent-Length: 12a\r\n\r\n",
+        "GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n",
+        "POST / HTTP/1.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n",
+        "G(T / HTTP/1.1\r\n\r\n",
+        "GET /\x7f HTTP/1.1\r\n\r\n",
+    };
+
+    for (std::string_view data : cases) {
+        http_request request;
+        auto         result = parse_http_request(data, request);
+        REQUIRE(!result.has_value());
+        CHECK(result.error() == http_parse_error::invalid);
+    }
+
+    http_request request;
+    auto result = parse_http_request("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", request);
+    REQUIRE(!result.has_value());
+    CHECK(result.error() == http_parse_error::unsupported_transfer_coding);
+
+    std::string data = "GET / HTTP/1.1\r\n";
+    for (std::size_t i = 0; i <= http_request::max_headers; ++i)
+        data += "X-Header: value\r\n";
+    data += "\r\n";
+
+    result = parse_http_request(data, request);
+    REQUIRE(!result.has_value());
+    CHECK(result.error() == http_parse_error::too_many_headers);
+}
+
+TEST_CASE("HTTP chunked body") {
+    std::string data = "4\r\nWiki\r\n6;name=value\r\npedia \r\nE\r\nin \r\n\r\nchunks.\r\n0\r\n"
+                       "Trailer: value\r\n\r\nGET /next HTTP/1.1\r\n\r\n";
+    std::string original = data;
+
+    // Incomplete chunked bodies should not modify the buffer.
+    for (std::size_t i = 0; i < 71; ++i) {
+        auto result = decode_http_chunked(std::span<char>(data.data(), i));
+        REQUIRE(!result.has_value());
+        CHECK(result.error() == http_parse_error::incomplete);
+        CHECK(data == original);
+    }
+
+    auto result = decode_http_chunked(data);
+    REQUIRE(result.has_value());
+    CHECK(result->consumed == 71);
+    CHECK(std::string_view(data.data(), result->size) == "Wikipedia in \r\n\r\nchunks.");
+    CHECK(std::string_view(data).substr(result->consumed) == "GET /next HTTP/1.1\r\n\r\n");
+
+    std::string invalid = "4\r\nWikiXX\r\n0\r\n\r\n";
+    result              = decode_http_chunked(invalid);
+    REQUIRE(!result.has_value());
+    CHECK(result.error() == http_parse_error::invalid);
+}
@@ -0,0 +1,180 @@
+#include "ossia/http_server.hpp"
+
+#include <doctest/doctest.h>
+
+#include <string>
+
+using namespace ossia;
+
+static auto handler(const http_request &request, http_response &response) -> void {
+    response.add_header("Content-Type", "text/plain");
+    if (request.method() == "POST")
+        response.set_body(request.body());
+    else
+        response.set_body(request.target());
+}
+
+static auto async_handler(const http_request &request, http_response &response) -> future<> {
+    handler(request, response);
+    co_return;
+}
+
+static auto listener(const inet_address &address, bool async) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    auto stream = co_await server.accept_async();
+    CHECK(stream.has_value());
+
+    if (async)
+        schedule(http_server::serve(std::move(*stream), async_handler));
+    else
+        schedule(http_server::serve(std::move(*stream), handler));
+}
+
+static auto client(io_context        &ctx,
+                   const inet_address &address,
+                   std::string_view    requests,
+                   std::string_view    expected) noexcept -> future<> {
+    tcp_stream stream;
+    CHECK(co_await stream.connect_async(address) == std::error_code());
+
+    // Send all requests at once to test pipelining.
+    std::size_t sent = 0;
+    while (sent < requests.size()) {
+        auto result = co_await stream.send_async(
+            requests.data() + sent, static_cast<std::uint32_t>(requests.size() - sent));
+        REQUIRE(result.has_value());
+        sent += *result;
+    }
+
+    // Server closes the connection after the last response.
+    std::string response;
+    char        buffer[4096];
+    while (true) {
+        auto result = co_await stream.receive_async(buffer, sizeof(buffer));
+        if (!result.has_value() || *result == 0)
+            break;
+        response.append(buffer, *result);
+    }
+
+    CHECK(response == expected);
+    ctx.stop();
+}
+
+TEST_CASE("HTTP server pipelined requests") {
+    io_context ctx(1);
+
+    std::string_view requests = "GET /first HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                                "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                "5\r\nhello\r\n7\r\n, world\r\n0\r\n\r\n"
+                                "HEAD /head HTTP/1.1\r\n\r\n"
+                                "GET /last HTTP/1.1\r\nConnection: close\r\n\r\n"
+                                "GET /ignored HTTP/1.1\r\n\r\n";
+
+    std::string_view expected = "HTTP/1.1 200 OK\r\nContent-Length: 6\r\n"
+                                "Content-Type: text/plain\r\n\r\n/first"
+                                "HTTP/1.1 200 OK\r\nContent-Length: 12\r\n"
+                                "Content-Type: text/plain\r\n\r\nhello, world"
+                                "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n"
+                                "Content-Type: text/plain\r\n\r\n"
+                                "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nConnection: close\r\n"
+                                "Content-Type: text/plain\r\n\r\n/last";
+
+    inet_address address(ipv4_loopback, 23334);
+    bool         async = false;
+    ctx.dispatch(listener, address, async);
+    ctx.dispatch(client, ctx, address, requests, expected);
+
+    ctx.run();
+}
+
+TEST_CASE("HTTP server malformed request") {
+    io_context ctx(1);
+
+    std::string_view requests = "GET /ok HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"
+                                "GET /bad HTTP/1.1\r\nBad Header: value\r\n\r\n";
+
+    std::string_view expected = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\nConnection: keep-alive\r\n"
+                                "Content-Type: text/plain\r\n\r\n/ok"
+                                "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n"
+                                "Connection: close\r\n\r\n";
+
+    inet_address address(ipv4_loopback, 23335);
+    bool         async = true;
+    ctx.dispatch(listener, address, async);
+    ctx.dispatch(client, ctx, address, requests, expected);
+
+    ctx.run();
+}
+
+TEST_CASE("HTTP connection pool") {
+    detail::connection_pool<detail::http_connection> pool;
+
+    std::size_t capacity = http_server::default_buffer_size;
+    std::size_t limit    = http_server::default_request_limit;
+
+    auto first  = pool.acquire(capacity, limit);
+    auto second = pool.acquire(capacity, limit);
+    auto third  = pool.acquire(capacity, limit);
+    CHECK(pool.active() == 3);
+
+    // Released connection states are kept and reused.
+    auto *reused = second.get();
+    pool.release(std::move(first));
+    pool.release(std::move(second));
+    CHECK(pool.size() == 2);
+
+    auto again = pool.acquire(capacity, limit);
+    CHECK(again.get() == reused);
+    pool.release(std::move(again));
+
+    // The pool shrinks to the peak of the latest window.
+    pool.release(std::move(third));
+    for (std::size_t i = 0; i < 2 * pool.window_size; ++i)
+        pool.release(pool.acquire(capacity, limit));
+
+    CHECK(pool.active() == 0);
+    CHECK(pool.size() == 1);
+}
+
+static auto pooled_client(io_context &ctx, http_server &server) noexcept -> future<> {
+    std::string_view request = "GET /pooled HTTP/1.1\r\nConnection: close\r\n\r\n";
+
+    for (int i = 0; i < 3; ++i) {
+        tcp_stream stream;
+        CHECK(co_await stream.connect_async(server.local_address()) == std::error_code());
+
+        auto sent = co_await stream.send_async(request.data(),
+                                               static_cast<std::uint32_t>(request.size()));
+        CHECK(sent.has_value());
+
+        std::string response;
+        char        buffer[4096];
+        while (true) {
+            auto result = co_await stream.receive_async(buffer, sizeof(buffer));
+            if (!result.has_value() || *result == 0)
+                break;
+            response.append(buffer, *result);
+        }
+
+        CHECK(response.ends_with("\r\n\r\n/pooled"));
+
+        // Connections are closed one after another, so a single connection state is reused.
+        CHECK(server.pooled_connections() == 1);
+    }
+
+    server.close();
+    ctx.stop();
+}
+
+TEST_CASE("HTTP server connection pool") {
+    io_context  ctx(1);
+    http_server server;
+    CHECK(server.bind(inet_address(ipv4_loopback, 23347)).value() == 0);
+
+    ctx.dispatch([&server]() noexcept -> future<> { return server.run(handler); });
+    ctx.dispatch(pooled_client, ctx, server);
+
+    ctx.run();
+}
@@ -0,0 +1,106 @@
+#include "ossia/file.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+using namespace ossia;
+
+TEST_CASE("Huge page buffer") {
+    huge_page_buffer empty;
+    CHECK(empty.data() == nullptr);
+    CHECK(empty.size() == 0);
+    CHECK_FALSE(empty.is_huge_page());
+
+    huge_page_buffer buffer(3 * 1024 * 1024);
+    REQUIRE(buffer.data() != nullptr);
+    CHECK(buffer.size() == 2 * huge_page_buffer::huge_page_size);
+    CHECK(reinterpret_cast<std::uintptr_t>(buffer.data()) % huge_page_buffer::huge_page_size == 0);
+
+    // Memory is zero-initialized and writable.
+    auto *bytes = static_cast<unsigned char *>(buffer.data());
+    CHECK(bytes[0] == 0);
+    CHECK(bytes[buffer.size() - 1] == 0);
+    std::memset(bytes, 0x5A, buffer.size());
+
+    huge_page_buffer moved(std::move(buffer));
+    CHECK(buffer.data() == nullptr);
+    CHECK(moved.data() == bytes);
+    CHECK(static_cast<unsigned char *>(moved.data())[12345] == 0x5A);
+
+    empty = std::move(moved);
+    CHECK(moved.data() == nullptr);
+    CHECK(empty.data() == bytes);
+}
+
+/// \brief
+///   Sum numbers recursively so that many coroutine frames are allocated and released.
+static auto recursive_sum(std::uint32_t n) noexcept -> future<std::uint64_t> {
+    if (n == 0)
+        co_return 0;
+    co_return n + co_await recursive_sum(n - 1);
+}
+
+static auto registered_buffer_operations(io_context &ctx, std::string path) noexcept -> future<> {
+    auto *worker = detail::io_context_worker::current();
+    REQUIRE(worker != nullptr);
+
+    // Frames are taken from the frame pool.
+    for (int i = 0; i < 64; ++i)
+        CHECK(co_await recursive_sum(16) == 136);
+
+    registered_buffer buffers[4];
+    for (auto &buffer : buffers) {
+        auto acquired = worker->acquire_buffer();
+        REQUIRE(acquired.has_value());
+        CHECK(acquired->size == 8192);
+        buffer = *acquired;
+    }
+
+    // All buffers are in use.
+    auto exhausted = worker->acquire_buffer();
+    CHECK_FALSE(exhausted.has_value());
+    CHECK(exhausted.error() == std::errc::no_buffer_space);
+    CHECK(worker->stats().available_buffers == 0);
+
+    auto created = co_await file::open_async(
+        path.c_str(), file_mode::read_write | file_mode::create | file_mode::truncate);
+    REQUIRE(created.has_value());
+
+    auto *source = static_cast<char *>(buffers[0].data);
+    for (std::uint32_t i = 0; i < buffers[0].size; ++i)
+        source[i] = static_cast<char>(i * 7);
+
+    auto written = co_await created->write_async(buffers[0], buffers[0].size, 4096);
+    REQUIRE(written.has_value());
+    CHECK(*written == buffers[0].size);
+
+    auto read = co_await created->read_async(buffers[3], buffers[3].size, 4096);
+    REQUIRE(read.has_value());
+    CHECK(*read == buffers[3].size);
+    CHECK(std::memcmp(buffers[3].data, buffers[0].data, buffers[0].size) == 0);
+
+    for (const auto &buffer : buffers)
+        worker->release_buffer(buffer);
+    CHECK(worker->stats().available_buffers == 4);
+
+    ctx.stop();
+}
+
+TEST_CASE("Registered buffers in huge page memory") {
+    auto path = (std::filesystem::temp_directory_path() / "ossia-test-registered.bin").string();
+
+    io_context_options options;
+    options.huge_page_rings         = true;
+    options.registered_buffer_count = 4;
+    options.registered_buffer_size  = 8192;
+    options.coroutine_frame_pool    = true;
+
+    io_context ctx(1, options);
+    ctx.dispatch(registered_buffer_operations, ctx, path);
+    ctx.run();
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,269 @@
+#include "ossia/file.hpp"
+#include "ossia/poll.hpp"
+
+#include <doctest/doctest.h>
+
+#include <thread>
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <fcntl.h>
+#    include <poll.h>
+#    include <unistd.h>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+static auto embedded_task(int reader, int &step) noexcept -> future<> {
+    step = 1;
+
+    // Completed by another thread while the host loop is waiting for the poll handle.
+    auto events = co_await poll(static_cast<std::uintptr_t>(reader), poll_event::in);
+    CHECK(events.has_value());
+    step = 2;
+
+    // Watchers post coroutines without completing any IO request.
+    poll_watcher watcher(static_cast<std::uintptr_t>(reader), poll_event::in);
+    events = co_await watcher.next();
+    CHECK(events.has_value());
+    watcher.cancel();
+    events = co_await watcher.next();
+    CHECK(events.error() == std::errc::operation_canceled);
+
+    step = 3;
+}
+
+TEST_CASE("Drive worker from external event loop") {
+    int pipes[2];
+    REQUIRE(::pipe2(pipes, O_CLOEXEC | O_NONBLOCK) == 0);
+
+    io_context ctx(1);
+    auto      &worker = ctx.worker(0);
+
+    auto handle = worker.poll_handle();
+    REQUIRE(handle.has_value());
+    CHECK(*worker.poll_handle() == *handle);
+
+    int step = 0;
+    ctx.dispatch(embedded_task, pipes[0], step);
+
+    std::thread writer([pipe = pipes[1]]() {
+        std::this_thread::sleep_for(20ms);
+        CHECK(::write(pipe, "x", 1) == 1);
+    });
+
+    // Host loop: wait for the poll handle and handle completions without blocking.
+    for (int i = 0; i < 100 && step != 3; ++i) {
+        pollfd fd{
+            .fd      = static_cast<int>(*handle),
+            .events  = POLLIN,
+            .revents = 0,
+        };
+
+        REQUIRE(::poll(&fd, 1, 5000) == 1);
+        worker.poll_once();
+    }
+
+    writer.join();
+    CHECK(step == 3);
+
+    // Handle remaining completions one by one. The poll handle keeps readable until all
+    // completions are handled.
+    pollfd fd{
+        .fd      = static_cast<int>(*handle),
+        .events  = POLLIN,
+        .revents = 0,
+    };
+
+    int remaining = 0;
+    while (::poll(&fd, 1, 0) == 1 && remaining < 100) {
+        worker.poll_once(1);
+        ++remaining;
+    }
+
+    CHECK(remaining < 100);
+    CHECK(worker.poll_once() == 0);
+
+    ::close(pipes[0]);
+    ::close(pipes[1]);
+}
+
+static auto limited_task(io_context &ctx, std::atomic_int &finished) noexcept -> future<> {
+    auto *worker = detail::io_context_worker::current();
+
+    // Limits are read back once the worker starts.
+    worker_stats stats = worker->stats();
+    CHECK(stats.bounded_async_worker_limit == 2);
+    CHECK(stats.unbounded_async_worker_limit == 3);
+
+    // Buffered file writes may be punted to kernel async workers.
+    std::string path = "/tmp/ossia-async-workers-" + std::to_string(worker->thread_id());
+    auto        file = co_await file::open_async(path.c_str(),
+                                                 file_mode::write | file_mode::create |
+                                                     file_mode::truncate);
+    REQUIRE(file.has_value());
+
+    char buffer[4096]{};
+    for (std::uint64_t i = 0; i < 64; ++i) {
+        auto written = co_await file->write_async(buffer, sizeof(buffer), i * sizeof(buffer));
+        CHECK(written.has_value());
+    }
+
+    stats = worker->stats();
+    CHECK(stats.async_worker_threads <= 5);
+
+    file->close();
+    ::unlink(path.c_str());
+
+    if (finished.fetch_add(1) + 1 == 2)
+        ctx.stop();
+}
+
+TEST_CASE("Kernel async worker limits and affinity") {
+    io_context_options options;
+    options.max_bounded_async_workers   = 2;
+    options.max_unbounded_async_workers = 3;
+    options.async_worker_cpus           = {0};
+
+    std::atomic_int finished = 0;
+
+    io_context ctx(2, options);
+    ctx.dispatch(limited_task, ctx, finished);
+    ctx.run();
+
+    CHECK(finished == 2);
+
+    // Threads are counted only while the worker is running.
+    CHECK(ctx.worker(0).stats().async_worker_threads == 0);
+}
+
+static auto batched_poll(io_context &ctx, int reader, int &remaining) noexcept -> future<> {
+    auto events = co_await poll(static_cast<std::uintptr_t>(reader), poll_event::in);
+    CHECK(events.has_value());
+
+    if (--remaining == 0)
+        ctx.stop();
+}
+
+static auto batched_task(io_context &ctx, int reader, int &remaining) noexcept -> future<> {
+    for (int i = 0; i < remaining; ++i)
+        schedule(batched_poll(ctx, reader, remaining));
+    co_return;
+}
+
+TEST_CASE("Completions handled in bounded batches") {
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+
+    // Keep the pipe readable so that all polls complete in the same burst.
+    char byte = 1;
+    REQUIRE(::write(fds[1], &byte, 1) == 1);
+
+    io_context_options options;
+    options.max_completion_batch = 3;
+
+    int remaining = 300;
+
+    io_context ctx(1, options);
+    ctx.worker(0).schedule(batched_task(ctx, fds[0], remaining));
+    ctx.run();
+
+    CHECK(remaining == 0);
+
+    // The burst is split into iterations of at most 3 completions.
+    CHECK(ctx.worker(0).stats().largest_completion_batch == options.max_completion_batch);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+/// \brief
+///   Number of IO requests to issue in one iteration. This is more than the submission queue could
+///   hold.
+inline constexpr int overflow_request_count = 40000;
+
+static auto overflow_poll(io_context &ctx,
+                          int         reader,
+                          int        &remaining,
+                          int        &rejected) noexcept -> future<> {
+    auto events = co_await poll(static_cast<std::uintptr_t>(reader), poll_event::in);
+    if (!events.has_value()) {
+        CHECK(events.error() == std::errc::resource_unavailable_try_again);
+        ++rejected;
+    }
+
+    if (--remaining == 0)
+        ctx.stop();
+}
+
+static auto overflow_task(io_context &ctx,
+                          int         reader,
+                          int        &remaining,
+                          int        &rejected) noexcept -> future<> {
+    for (int i = 0; i < overflow_request_count; ++i)
+        schedule(overflow_poll(ctx, reader, remaining, rejected));
+    co_return;
+}
+
+/// \brief
+///   Issue more IO requests than the submission queue could hold in one iteration.
+/// \param options
+///   Options of the worker.
+/// \param[out] rejected
+///   Number of requests that failed because the submission queue was full.
+/// \return
+///   Statistics of the worker after all requests are completed.
+static auto run_overflow(io_context_options options, int &rejected) -> worker_stats {
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+
+    char byte = 1;
+    REQUIRE(::write(fds[1], &byte, 1) == 1);
+
+    int remaining = overflow_request_count;
+    rejected      = 0;
+
+    io_context ctx(1, options);
+    ctx.worker(0).schedule(overflow_task(ctx, fds[0], remaining, rejected));
+    ctx.run();
+
+    CHECK(remaining == 0);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    return ctx.worker(0).stats();
+}
+
+TEST_CASE("Submission queue overflow") {
+    int rejected = 0;
+
+    // All requests are parked and completed.
+    io_context_options options;
+    worker_stats       stats = run_overflow(options, rejected);
+    CHECK(rejected == 0);
+    CHECK(stats.overflowed_submissions > 0);
+    CHECK(stats.pending_submissions == 0);
+    CHECK(stats.rejected_submissions == 0);
+
+    // Requests fail fast once the submission queue is full.
+    options.submission_overflow = submission_overflow_policy::fail;
+    stats                       = run_overflow(options, rejected);
+    CHECK(rejected > 0);
+    CHECK(stats.rejected_submissions == static_cast<std::uint64_t>(rejected));
+    CHECK(stats.overflowed_submissions == 0);
+}
+
+TEST_CASE("Completion queue overflow") {
+    // Every chunk of requests submitted while the worker is flushing the overflow queue completes
+    // at once, which overflows such a small completion queue many times.
+    io_context_options options;
+    options.submission_queue_entries = 64;
+    options.completion_queue_factor  = 1;
+
+    int          rejected = 0;
+    worker_stats stats    = run_overflow(options, rejected);
+    CHECK(rejected == 0);
+    CHECK(stats.completion_overflows > 0);
+    CHECK(stats.dropped_completions == 0);
+}
+#endif
@@ -0,0 +1,160 @@
+#include "ossia/load_balancer.hpp"
+#include "ossia/tcp_server.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+TEST_CASE("load balancer picks") {
+    std::vector<inet_address> endpoints{
+        inet_address(ipv4_loopback, 1),
+        inet_address(ipv4_loopback, 2),
+        inet_address(ipv4_loopback, 3),
+    };
+
+    load_balancer_options options;
+    options.ejection_failures = 3;
+    load_balancer balancer(endpoints, options);
+
+    // A slow endpoint is avoided whenever it is compared with another one.
+    auto start = balancer.begin_request(0);
+    balancer.end_request(0, start - 100ms, true);
+    CHECK(balancer.stats(0).latency >= 100ms);
+
+    for (int i = 0; i < 100; ++i)
+        CHECK(balancer.pick() != 0);
+
+    // Requests in flight raise the cost of an endpoint as well.
+    for (int i = 0; i < 200; ++i)
+        [[maybe_unused]] auto ignored = balancer.begin_request(1);
+    for (int i = 0; i < 100; ++i)
+        CHECK(balancer.pick() != 1);
+
+    // Consecutive failures eject an endpoint.
+    for (std::uint32_t i = 0; i < options.ejection_failures; ++i) {
+        start = balancer.begin_request(2);
+        balancer.end_request(2, start, false);
+    }
+
+    endpoint_stats stats = balancer.stats(2);
+    CHECK(stats.ejected);
+    CHECK(stats.ejections == 1);
+    CHECK(stats.failures == options.ejection_failures);
+
+    for (int i = 0; i < 100; ++i)
+        CHECK(balancer.pick() != 2);
+
+    // No more than half of the endpoints could be ejected.
+    for (std::uint32_t i = 0; i < options.ejection_failures; ++i) {
+        start = balancer.begin_request(0);
+        balancer.end_request(0, start, false);
+    }
+    CHECK_FALSE(balancer.stats(0).ejected);
+}
+
+/// \brief
+///   Echo 4-byte requests until the connection is closed.
+static auto echo_session(tcp_stream stream, std::size_t &accepted) noexcept -> future<> {
+    accepted += 1;
+
+    char buffer[4];
+    while (true) {
+        auto received = co_await stream.receive_async(buffer, sizeof(buffer));
+        if (!received.has_value() || *received != sizeof(buffer))
+            co_return;
+
+        auto sent = co_await stream.send_async(buffer, sizeof(buffer));
+        if (!sent.has_value())
+            co_return;
+    }
+}
+
+static auto echo_server(inet_address address, std::size_t &accepted) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    while (true) {
+        auto connection = co_await server.accept_async();
+        REQUIRE(connection.has_value());
+        schedule(echo_session(std::move(*connection), accepted));
+    }
+}
+
+/// \brief
+///   Send a 4-byte request and wait for the echo.
+static auto echo_request(tcp_stream &stream) noexcept
+    -> future<std::expected<std::uint32_t, std::error_code>> {
+    char request[4]{'p', 'i', 'n', 'g'};
+    auto sent = co_await stream.send_async(request, sizeof(request));
+    if (!sent.has_value())
+        co_return std::unexpected(sent.error());
+
+    char reply[4]{};
+    auto received = co_await stream.receive_async(reply, sizeof(reply));
+    if (!received.has_value())
+        co_return std::unexpected(received.error());
+    if (*received != sizeof(reply))
+        co_return std::unexpected(std::make_error_code(std::errc::connection_reset));
+
+    co_return *received;
+}
+
+static auto balanced_requests(io_context        &ctx,
+                              inet_address       alive,
+                              inet_address       dead,
+                              const std::size_t &accepted) noexcept -> future<> {
+    co_await sleep_for(10ms);
+
+    // Refused connections count as failures and eject the endpoint.
+    load_balancer_options options;
+    options.ejection_failures  = 2;
+    options.max_ejection_ratio = 1;
+
+    load_balancer dead_balancer({dead}, options);
+    for (int i = 0; i < 2; ++i) {
+        auto result = co_await dead_balancer.execute_async(echo_request);
+        CHECK_FALSE(result.has_value());
+    }
+
+    endpoint_stats dead_stats = dead_balancer.stats(0);
+    CHECK(dead_stats.ejected);
+    CHECK(dead_stats.failures == 2);
+    CHECK(dead_stats.in_flight == 0);
+
+    // Requests to the alive endpoint are sent over the same connection, and the dead endpoint is
+    // no longer picked once ejected.
+    options.max_ejection_ratio = 0.5;
+    load_balancer balancer({alive, dead}, options);
+
+    std::size_t succeeded = 0;
+    for (int i = 0; i < 64; ++i) {
+        auto result = co_await balancer.execute_async(echo_request);
+        if (result.has_value())
+            succeeded += 1;
+    }
+
+    dead_stats = balancer.stats(1);
+    CHECK(dead_stats.requests <= 2);
+    CHECK(dead_stats.ejected == (dead_stats.requests == 2));
+    CHECK(succeeded == 64 - dead_stats.requests);
+
+    endpoint_stats alive_stats = balancer.stats(0);
+    CHECK(alive_stats.failures == 0);
+    CHECK(alive_stats.in_flight == 0);
+    CHECK(alive_stats.idle_connections == 1);
+    CHECK(accepted == 1);
+
+    ctx.stop();
+}
+
+TEST_CASE("load balancer requests") {
+    io_context   ctx(1);
+    inet_address alive(ipv4_loopback, 23353);
+    inet_address dead(ipv4_loopback, 23354);
+    std::size_t  accepted = 0;
+
+    ctx.dispatch(echo_server, alive, accepted);
+    ctx.dispatch(balanced_requests, ctx, alive, dead, accepted);
+    ctx.run();
+}
@@ -0,0 +1,80 @@
+#include "ossia/tcp_server.hpp"
+#include "ossia/timer.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \brief
+///   Keep the worker busy so that resumed tasks wait for each other.
+static auto busy_task(int rounds) noexcept -> future<> {
+    for (int i = 0; i < rounds; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < 2ms) {}
+        co_await sleep_for(1us);
+    }
+}
+
+static auto paused_accept(const inet_address &address, bool &accepted) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    auto connection = co_await server.accept_async();
+    CHECK(connection.has_value());
+    accepted = true;
+}
+
+static auto overload(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    auto &worker = ctx.worker(0);
+    CHECK(admit_request());
+
+    for (int i = 0; i < 4; ++i)
+        schedule(busy_task(40));
+
+    // The queue delay stays above the target for a whole interval.
+    auto start = std::chrono::steady_clock::now();
+    while (!worker.is_overloaded() && std::chrono::steady_clock::now() - start < 1s)
+        co_await sleep_for(1ms);
+
+    REQUIRE(worker.is_overloaded());
+    CHECK(worker.stats().overloaded);
+    CHECK(worker.stats().overload_events == 1);
+    CHECK(worker.stats().queue_delay >= 1000000);
+
+    // New requests are rejected and accepts are paused.
+    CHECK_FALSE(admit_request());
+    CHECK(worker.stats().shed_requests == 1);
+
+    bool accepted = false;
+    schedule(paused_accept(address, accepted));
+    co_await sleep_for(1ms);
+    REQUIRE(worker.is_overloaded());
+    CHECK(worker.stats().paused_accepts == 1);
+
+    tcp_stream client;
+    CHECK((co_await client.connect_async(address)).value() == 0);
+    CHECK_FALSE(accepted);
+
+    // The worker recovers once the busy tasks are done, and the paused accept is issued.
+    while (worker.is_overloaded())
+        co_await sleep_for(1ms);
+
+    co_await sleep_for(10ms);
+    CHECK(accepted);
+    CHECK(admit_request());
+    CHECK(worker.stats().shed_requests == 1);
+
+    ctx.stop();
+}
+
+TEST_CASE("Load shedding") {
+    io_context_options options;
+    options.shedding_target   = 1ms;
+    options.shedding_interval = 10ms;
+
+    io_context   ctx(1, options);
+    inet_address address(ipv4_loopback, 23346);
+    ctx.dispatch(overload, ctx, address);
+    ctx.run();
+}
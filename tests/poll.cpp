@@ -0,0 +1,105 @@
+#include "ossia/poll.hpp"
+
+#include <doctest/doctest.h>
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <fcntl.h>
+#    include <unistd.h>
+
+using namespace ossia;
+
+static auto poll_once(io_context &ctx, int reader, int writer) noexcept -> future<> {
+    // Writing end of an empty pipe is writable.
+    auto events = co_await poll(static_cast<std::uintptr_t>(writer), poll_event::out);
+    CHECK(events.has_value());
+    CHECK((*events & poll_event::out) == poll_event::out);
+
+    CHECK(::write(writer, "x", 1) == 1);
+    events = co_await poll(static_cast<std::uintptr_t>(reader), poll_event::in);
+    CHECK(events.has_value());
+    CHECK((*events & poll_event::in) == poll_event::in);
+
+    // Hang up is reported once the writing end is closed.
+    char buffer[8];
+    CHECK(::read(reader, buffer, sizeof(buffer)) == 1);
+    ::close(writer);
+
+    events = co_await poll(static_cast<std::uintptr_t>(reader), poll_event::in);
+    CHECK(events.has_value());
+    CHECK((*events & poll_event::hang_up) == poll_event::hang_up);
+
+    ctx.stop();
+}
+
+TEST_CASE("Poll once") {
+    int pipes[2];
+    REQUIRE(::pipe2(pipes, O_CLOEXEC | O_NONBLOCK) == 0);
+
+    io_context ctx(1);
+    ctx.dispatch(poll_once, ctx, pipes[0], pipes[1]);
+    ctx.run();
+
+    ::close(pipes[0]);
+}
+
+static auto poll_writer(int writer, int count) noexcept -> future<> {
+    for (int i = 0; i < count; ++i) {
+        // Suspend between writes so that the watcher is woken up multiple times.
+        auto events = co_await poll(static_cast<std::uintptr_t>(writer), poll_event::out);
+        CHECK(events.has_value());
+        CHECK(::write(writer, "x", 1) == 1);
+    }
+}
+
+static auto poll_multishot(io_context &ctx, int reader, int writer) noexcept -> future<> {
+    constexpr int count = 16;
+    schedule(poll_writer(writer, count));
+
+    poll_watcher watcher(static_cast<std::uintptr_t>(reader), poll_event::in);
+
+    // A single watcher reports events until all data is read.
+    int  received = 0;
+    char buffer[count];
+    while (received < count) {
+        auto events = co_await watcher.next();
+        REQUIRE(events.has_value());
+        CHECK((*events & poll_event::in) == poll_event::in);
+
+        ssize_t size = ::read(reader, buffer, sizeof(buffer));
+        if (size > 0)
+            received += static_cast<int>(size);
+    }
+
+    CHECK(received == count);
+
+    // Cancelled watcher resumes the waiting coroutine.
+    watcher.cancel();
+    auto events = co_await watcher.next();
+    CHECK_FALSE(events.has_value());
+    CHECK(events.error() == std::errc::operation_canceled);
+
+    // Armed watcher could be destroyed.
+    poll_watcher armed(static_cast<std::uintptr_t>(writer), poll_event::out);
+    events = co_await armed.next();
+    CHECK(events.has_value());
+    armed = poll_watcher();
+
+    // Wait for the kernel to terminate the orphaned poll request.
+    events = co_await poll(static_cast<std::uintptr_t>(writer), poll_event::out);
+    CHECK(events.has_value());
+
+    ctx.stop();
+}
+
+TEST_CASE("Multishot poll watcher") {
+    int pipes[2];
+    REQUIRE(::pipe2(pipes, O_CLOEXEC | O_NONBLOCK) == 0);
+
+    io_context ctx(1);
+    ctx.dispatch(poll_multishot, ctx, pipes[0], pipes[1]);
+    ctx.run();
+
+    ::close(pipes[0]);
+    ::close(pipes[1]);
+}
+#endif
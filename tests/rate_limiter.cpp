@@ -0,0 +1,151 @@
+#include "ossia/tcp_server.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+TEST_CASE("Rate limiter") {
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto algorithm : {rate_limit_algorithm::token_bucket, rate_limit_algorithm::gcra}) {
+        rate_limiter limiter(rate_limit{
+            .algorithm = algorithm,
+            .unit      = rate_limit_unit::bytes,
+            .rate      = 1000,
+            .burst     = 100,
+        });
+
+        // The limiter starts with a full burst.
+        CHECK(limiter.try_acquire(100, 1, now));
+        CHECK_FALSE(limiter.try_acquire(1, 1, now));
+
+        // Tokens are refilled at the rate.
+        CHECK(limiter.try_acquire(10, 1, now + 10ms));
+        CHECK_FALSE(limiter.try_acquire(10, 1, now + 10ms));
+
+        // Reservations go into debt and later requests wait for the debt.
+        CHECK(limiter.reserve(50, 1, now + 10ms) == now + 60ms);
+        CHECK(limiter.reserve(0, 1, now + 20ms) == now + 60ms);
+        CHECK(limiter.reserve(0, 1, now + 70ms) == now + 70ms);
+    }
+
+    // Requests are charged to every limiter up to the root in its own unit.
+    rate_limiter worker(rate_limit{.unit = rate_limit_unit::bytes, .rate = 1000, .burst = 100});
+    rate_limiter tenant(rate_limit{.rate = 0}, &worker);
+    rate_limiter connection(
+        rate_limit{
+            .algorithm = rate_limit_algorithm::gcra,
+            .unit      = rate_limit_unit::operations,
+            .rate      = 10,
+            .burst     = 2,
+        },
+        &tenant);
+
+    CHECK(connection.try_acquire(10, 1, now));
+    CHECK(connection.try_acquire(10, 1, now));
+    CHECK_FALSE(connection.try_acquire(10, 1, now));
+
+    // A rejected request costs nothing.
+    CHECK(worker.try_acquire(80, 0, now));
+    CHECK_FALSE(worker.try_acquire(1, 0, now));
+
+    // The request waits for the slowest limiter, and every limiter is charged.
+    CHECK(connection.reserve(20, 1, now + 100ms) == now + 100ms);
+    CHECK(connection.reserve(90, 1, now + 100ms) == now + 200ms);
+    CHECK(worker.reserve(0, 0, now + 100ms) == now + 110ms);
+}
+
+static auto sleeper(io_context &ctx) noexcept -> future<> {
+    auto start = std::chrono::steady_clock::now();
+
+    co_await sleep_for(20ms);
+    CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+
+    // Passed deadlines do not suspend.
+    co_await sleep_until(start);
+
+    rate_limiter limiter(rate_limit{.unit = rate_limit_unit::operations, .rate = 100, .burst = 1});
+    for (int i = 0; i < 4; ++i)
+        co_await limiter.acquire_async(0);
+    CHECK(std::chrono::steady_clock::now() - start >= 50ms);
+
+    ctx.stop();
+}
+
+TEST_CASE("Sleep in worker") {
+    io_context ctx(1);
+    ctx.dispatch(sleeper, ctx);
+    ctx.run();
+}
+
+inline constexpr std::uint32_t limited_chunk_size = 1024;
+inline constexpr std::uint32_t limited_total_size = 40 * 1024;
+
+static auto limited_receiver(const inet_address &address) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    auto connection = co_await server.accept_async();
+    REQUIRE(connection.has_value());
+
+    // Connection limits operations and the tenant limits bandwidth.
+    rate_limiter tenant(rate_limit{
+        .algorithm = rate_limit_algorithm::gcra,
+        .unit      = rate_limit_unit::bytes,
+        .rate      = 256 * 1024,
+        .burst     = 8 * 1024,
+    });
+    rate_limiter limiter(
+        rate_limit{.unit = rate_limit_unit::operations, .rate = 10000, .burst = 16}, &tenant);
+    connection->set_receive_limiter(&limiter);
+
+    auto        start = std::chrono::steady_clock::now();
+    char        buffer[limited_chunk_size];
+    std::size_t total = 0;
+
+    while (total < limited_total_size) {
+        auto result = co_await connection->receive_async(buffer, sizeof(buffer));
+        REQUIRE(result.has_value());
+        REQUIRE(*result != 0);
+        total += *result;
+    }
+
+    CHECK(total == limited_total_size);
+    CHECK(std::chrono::steady_clock::now() - start >= 100ms);
+}
+
+static auto limited_sender(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    tcp_stream connection;
+    REQUIRE((co_await connection.connect_async(address)).value() == 0);
+
+    rate_limiter limiter(rate_limit{.rate = 256 * 1024, .burst = 8 * 1024});
+    connection.set_send_limiter(&limiter);
+
+    auto        start = std::chrono::steady_clock::now();
+    char        buffer[limited_chunk_size]{};
+    std::size_t total = 0;
+
+    while (total < limited_total_size) {
+        auto result = co_await connection.send_async(buffer, sizeof(buffer));
+        REQUIRE(result.has_value());
+        total += *result;
+    }
+
+    // 32 KiB over the burst at 256 KiB/s.
+    CHECK(std::chrono::steady_clock::now() - start >= 120ms);
+
+    // Wait for the receiver to drain the socket.
+    co_await sleep_for(200ms);
+    ctx.stop();
+}
+
+TEST_CASE("Rate limited TCP stream") {
+    io_context ctx(1);
+
+    inet_address address(ipv4_loopback, 23343);
+    ctx.dispatch(limited_receiver, address);
+    ctx.dispatch(limited_sender, ctx, address);
+
+    ctx.run();
+}
@@ -0,0 +1,418 @@
+#include "ossia/resp_client.hpp"
+#include "ossia/tcp_server.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ossia;
+
+TEST_CASE("RESP parse simple values") {
+    resp_message message;
+
+    auto result = parse_resp("+OK\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(*result == 5);
+    CHECK(message.root().type() == resp_type::simple_string);
+    CHECK(message.root().string() == "OK");
+
+    result = parse_resp("-ERR unknown command\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().is_error());
+    CHECK(message.root().string() == "ERR unknown command");
+
+    result = parse_resp(":-42\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().type() == resp_type::integer);
+    CHECK(message.root().integer() == -42);
+
+    result = parse_resp(":+7\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().integer() == 7);
+
+    result = parse_resp("$5\r\nhe\r\no\r\n+next\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(*result == 11);
+    CHECK(message.root().type() == resp_type::bulk_string);
+    CHECK(message.root().string() == "he\r\no");
+
+    result = parse_resp("$0\r\n\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().string().empty());
+
+    // RESP2 nulls.
+    result = parse_resp("$-1\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().is_null());
+
+    result = parse_resp("*-1\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().is_null());
+
+    // RESP3 scalars.
+    result = parse_resp("_\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().is_null());
+
+    result = parse_resp("#t\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().type() == resp_type::boolean);
+    CHECK(message.root().boolean());
+
+    result = parse_resp(",1.5e3\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().type() == resp_type::double_number);
+    CHECK(message.root().number() == 1500.0);
+
+    result = parse_resp(",-inf\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(std::isinf(message.root().number()));
+
+    result = parse_resp("(3492890328409238509324850943850943825024385\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().type() == resp_type::big_number);
+    CHECK(message.root().string() == "3492890328409238509324850943850943825024385");
+
+    result = parse_resp("!21\r\nSYNTAX invalid syntax\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().type() == resp_type::bulk_error);
+    CHECK(message.root().is_error());
+
+    result = parse_resp("=15\r\ntxt:Some string\r\n", message);
+    REQUIRE(result.has_value());
+    CHECK(message.root().type() == resp_type::verbatim_string);
+    CHECK(message.root().string() == "txt:Some string");
+}
+
+TEST_CASE("RESP parse aggregates") {
+    resp_message message;
+
+    std::string_view data = "*3\r\n"
+                            ":1\r\n"
+                            "%2\r\n+first\r\n*2\r\n$1\r\na\r\n_\r\n+second\r\n#f\r\n"
+                            "|1\r\n+ttl\r\n:3600\r\n"
+                            "~2\r\n+x\r\n+y\r\n"
+                            "+trailing\r\n";
+
+    auto result = parse_resp(data, message);
+    REQUIRE(result.has_value());
+    CHECK(*result == data.size() - 11);
+
+    resp_value root = message.root();
+    CHECK(root.type() == resp_type::array);
+    REQUIRE(root.size() == 3);
+    CHECK(root[0].integer() == 1);
+
+    // Map keys and values are counted separately.
+    resp_value map = root[1];
+    CHECK(map.type() == resp_type::map);
+    REQUIRE(map.size() == 4);
+    CHECK(map[0].string() == "first");
+    CHECK(map[1].size() == 2);
+    CHECK(map[1][0].string() == "a");
+    CHECK(map[1][1].is_null());
+    CHECK(map[2].string() == "second");
+    CHECK(!map[3].boolean());
+
+    // The attribute is skipped.
+    resp_value set = root[2];
+    CHECK(set.type() == resp_type::set);
+    REQUIRE(set.size() == 2);
+
+    std::string joined;
+    for (resp_value value : set)
+        joined.append(value.string());
+    CHECK(joined == "xy");
+
+    // Every proper prefix is incomplete.
+    std::string_view message_data = data.substr(0, *result);
+    for (std::size_t i = 0; i < message_data.size(); ++i) {
+        auto prefix = parse_resp(message_data.substr(0, i), message);
+        REQUIRE(!prefix.has_value());
+        CHECK(prefix.error() == resp_parse_error::incomplete);
+    }
+}
+
+TEST_CASE("RESP parse invalid") {
+    resp_message message;
+
+    const std::string_view invalid[]{
+        "?\r\n",           // Unknown type.
+        "+OK\rX",          // CR without LF.
+        ":12a\r\n",        // Invalid integer.
+        ":\r\n",           // Empty integer.
+        "$-2\r\n",         // Negative length.
+        "$3\r\nabcd\r\n",  // Length mismatch.
+        "$?\r\n",          // Streamed string.
+        "!-1\r\n",         // Null bulk error.
+        "=3\r\ntxt\r\n",   // Verbatim string without format.
+        "#x\r\n",          // Invalid boolean.
+        "_x\r\n",          // Invalid null.
+        ",\r\n",           // Empty double.
+        "(12x\r\n",        // Invalid big number.
+        "%-1\r\n",         // Negative map size.
+        "*1\r\n:x\r\n",    // Invalid child.
+    };
+
+    for (std::string_view data : invalid) {
+        auto result = parse_resp(data, message);
+        REQUIRE(!result.has_value());
+        CHECK(result.error() == resp_parse_error::invalid);
+    }
+
+    // Nesting depth is limited.
+    std::string nested;
+    for (std::size_t i = 0; i < resp_message::max_depth; ++i)
+        nested.append("*1\r\n");
+    nested.append(":1\r\n");
+
+    auto result = parse_resp(nested, message);
+    REQUIRE(!result.has_value());
+    CHECK(result.error() == resp_parse_error::invalid);
+
+    nested.erase(0, 4);
+    CHECK(parse_resp(nested, message).has_value());
+}
+
+TEST_CASE("RESP message detach") {
+    std::string  data = "*2\r\n$5\r\nhello\r\n:1\r\n";
+    resp_message message;
+
+    REQUIRE(parse_resp(data, message).has_value());
+    CHECK(message.data().data() == data.data());
+
+    message.detach();
+    data.assign(data.size(), '\0');
+
+    resp_message moved = std::move(message);
+    CHECK(moved.data() == "*2\r\n$5\r\nhello\r\n:1\r\n");
+    CHECK(moved.root()[0].string() == "hello");
+    CHECK(moved.root()[1].integer() == 1);
+}
+
+TEST_CASE("RESP write") {
+    std::string output;
+
+    const std::string_view args[]{"SET", "key", "binary\r\nvalue"};
+    write_resp_command(args, output);
+    CHECK(output == "*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$13\r\nbinary\r\nvalue\r\n");
+
+    output.clear();
+    write_resp_simple_string("OK", output);
+    write_resp_error("ERR oops", output);
+    write_resp_integer(-9223372036854775807LL - 1, output);
+    write_resp_bulk_string("", output);
+    write_resp_null(output);
+    write_resp_aggregate(resp_type::map, 1, output);
+    CHECK(output == "+OK\r\n-ERR oops\r\n:-9223372036854775808\r\n$0\r\n\r\n$-1\r\n%1\r\n");
+
+    // Serialized values could be parsed back.
+    resp_message message;
+    output.clear();
+    write_resp_aggregate(resp_type::array, 2, output);
+    write_resp_integer(123, output);
+    write_resp_bulk_string("value", output);
+
+    auto result = parse_resp(output, message);
+    REQUIRE(result.has_value());
+    CHECK(*result == output.size());
+    CHECK(message.root()[0].integer() == 123);
+    CHECK(message.root()[1].string() == "value");
+}
+
+/// \brief
+///   Execute a single command for the test server.
+/// \param command
+///   The command to execute.
+/// \param database
+///   The key-value store.
+/// \param[out] output
+///   Output buffer for the reply.
+static auto execute(resp_value                                    command,
+                    std::unordered_map<std::string, std::string> &database,
+                    std::string                                  &output) -> void {
+    std::string_view name = command[0].string();
+
+    if (name == "PING") {
+        write_resp_simple_string("PONG", output);
+    } else if (name == "ECHO" && command.size() == 2) {
+        write_resp_bulk_string(command[1].string(), output);
+    } else if (name == "SET" && command.size() == 3) {
+        database[std::string(command[1].string())] = command[2].string();
+        write_resp_simple_string("OK", output);
+    } else if (name == "GET" && command.size() == 2) {
+        auto iter = database.find(std::string(command[1].string()));
+        if (iter == database.end())
+            write_resp_null(output);
+        else
+            write_resp_bulk_string(iter->second, output);
+    } else if (name == "INCR" && command.size() == 2) {
+        auto &value = database[std::string(command[1].string())];
+        auto  count = (value.empty() ? 0 : std::stoll(value)) + 1;
+        value       = std::to_string(count);
+        write_resp_integer(count, output);
+    } else {
+        write_resp_error("ERR unknown command", output);
+    }
+}
+
+static auto resp_server(const inet_address &address, std::vector<std::size_t> &batches) noexcept
+    -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    auto stream = co_await server.accept_async();
+    REQUIRE(stream.has_value());
+
+    std::unordered_map<std::string, std::string> database;
+
+    std::string  input;
+    std::string  output;
+    resp_message command;
+    char         buffer[65536];
+
+    while (true) {
+        auto received = co_await stream->receive_async(buffer, sizeof(buffer));
+        if (!received.has_value() || *received == 0)
+            co_return;
+
+        input.append(buffer, *received);
+
+        std::size_t count = 0;
+        std::size_t begin = 0;
+        while (true) {
+            auto parsed = parse_resp(std::string_view(input).substr(begin), command);
+            if (!parsed.has_value()) {
+                REQUIRE(parsed.error() == resp_parse_error::incomplete);
+                break;
+            }
+
+            begin += *parsed;
+            execute(command.root(), database, output);
+            ++count;
+        }
+
+        input.erase(0, begin);
+        batches.push_back(count);
+
+        std::size_t sent = 0;
+        while (sent < output.size()) {
+            auto result = co_await stream->send_async(
+                output.data() + sent, static_cast<std::uint32_t>(output.size() - sent));
+            REQUIRE(result.has_value());
+            sent += *result;
+        }
+
+        output.clear();
+    }
+}
+
+/// \struct pipeline_state
+/// \brief
+///   Shared state of the pipelined client test.
+struct pipeline_state {
+    io_context *ctx;
+    resp_client client;
+    std::size_t remaining;
+};
+
+static auto set_get(pipeline_state &state, std::size_t index) noexcept -> future<> {
+    std::string key   = "key:" + std::to_string(index);
+    std::string value = "value:" + std::to_string(index * index);
+
+    auto reply = co_await state.client.execute_async("SET", key, value);
+    REQUIRE(reply.has_value());
+    CHECK(reply->root().string() == "OK");
+
+    reply = co_await state.client.execute_async("GET", key);
+    REQUIRE(reply.has_value());
+    CHECK(reply->root().string() == value);
+
+    reply = co_await state.client.execute_async("INCR", "counter");
+    REQUIRE(reply.has_value());
+    CHECK(reply->root().type() == resp_type::integer);
+
+    if (--state.remaining == 0) {
+        reply = co_await state.client.execute_async("GET", "counter");
+        REQUIRE(reply.has_value());
+        CHECK(reply->root().string() == "50");
+
+        reply = co_await state.client.execute_async("GET", "missing");
+        REQUIRE(reply.has_value());
+        CHECK(reply->root().is_null());
+
+        reply = co_await state.client.execute_async("FLUSHALL");
+        REQUIRE(reply.has_value());
+        CHECK(reply->root().is_error());
+
+        state.ctx->stop();
+    }
+}
+
+static auto pipeline_client(pipeline_state &state, const inet_address &address) noexcept
+    -> future<> {
+    CHECK(co_await state.client.connect_async(address) == std::error_code());
+
+    auto reply = co_await state.client.execute_async("PING");
+    REQUIRE(reply.has_value());
+    CHECK(reply->root().string() == "PONG");
+
+    // Commands from all coroutines in the same iteration are sent together.
+    for (std::size_t i = 0; i < state.remaining; ++i)
+        schedule(set_get(state, i));
+}
+
+TEST_CASE("RESP client pipelining") {
+    io_context ctx(1);
+
+    inet_address             address(ipv4_loopback, 23338);
+    std::vector<std::size_t> batches;
+    pipeline_state           state{.ctx = &ctx, .client = resp_client(), .remaining = 50};
+
+    ctx.dispatch(resp_server, address, batches);
+    ctx.dispatch(pipeline_client, state, address);
+
+    ctx.run();
+
+    // PING is sent alone. The 50 SET commands are issued in the same iteration and received in
+    // a single batch.
+    REQUIRE(batches.size() >= 2);
+    CHECK(batches[0] == 1);
+    CHECK(batches[1] == 50);
+}
+
+static auto large_client(io_context         &ctx,
+                         const inet_address &address,
+                         std::size_t        &replies) noexcept -> future<> {
+    resp_client client;
+    CHECK(co_await client.connect_async(address) == std::error_code());
+
+    // Replies larger than the initial receive buffer span multiple receive operations.
+    for (std::size_t i = 0; i < 10; ++i) {
+        std::string payload(i * 10000, static_cast<char>('a' + i));
+
+        auto reply = co_await client.execute_async("ECHO", payload);
+        REQUIRE(reply.has_value());
+        CHECK(reply->root().string() == payload);
+        ++replies;
+    }
+
+    ctx.stop();
+}
+
+TEST_CASE("RESP client large replies") {
+    io_context ctx(1);
+
+    inet_address             address(ipv4_loopback, 23339);
+    std::vector<std::size_t> batches;
+    std::size_t              replies = 0;
+
+    ctx.dispatch(resp_server, address, batches);
+    ctx.dispatch(large_client, ctx, address, replies);
+
+    ctx.run();
+    CHECK(replies == 10);
+}
@@ -0,0 +1,158 @@
+#include "ossia/signal_set.hpp"
+#include "ossia/timer.hpp"
+
+#include <doctest/doctest.h>
+
+#if defined(__linux) || defined(__linux__) || defined(__gnu_linux__)
+#    include <pthread.h>
+#    include <signal.h>
+#    include <unistd.h>
+
+#    include <atomic>
+#    include <thread>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+static auto signal_wait(io_context &ctx) noexcept -> future<> {
+    {
+        signal_set signals{SIGUSR1, SIGUSR2};
+        CHECK(signals.contains(SIGUSR1));
+        CHECK(signals.contains(SIGUSR2));
+        CHECK_FALSE(signals.contains(SIGHUP));
+
+        // SIGKILL and SIGSTOP could not be caught.
+        CHECK(signals.add(SIGKILL) == std::errc::invalid_argument);
+        CHECK(signals.add(0) == std::errc::invalid_argument);
+
+        // Process-directed signals may be delivered to threads that have not blocked them.
+        CHECK(::kill(::getpid(), SIGUSR1) == 0);
+        auto signal = co_await signals.wait();
+        CHECK(signal.has_value());
+        CHECK(*signal == SIGUSR1);
+
+        // Signals could be added to an existing set.
+        CHECK(signals.add(SIGHUP).value() == 0);
+        CHECK(::kill(::getpid(), SIGHUP) == 0);
+        signal = co_await signals.wait();
+        CHECK(signal.has_value());
+        CHECK(*signal == SIGHUP);
+
+        // Moved signal set still receives signals.
+        signal_set moved(std::move(signals));
+        CHECK_FALSE(signals.contains(SIGUSR2));
+        CHECK(::kill(::getpid(), SIGUSR2) == 0);
+        signal = co_await moved.wait();
+        CHECK(signal.has_value());
+        CHECK(*signal == SIGUSR2);
+    }
+
+    // Previous signal action is restored once the last signal set is destroyed.
+    struct sigaction action{};
+    CHECK(::sigaction(SIGUSR1, nullptr, &action) == 0);
+    CHECK(action.sa_handler == SIG_DFL);
+
+    // Empty signal set could not be waited for.
+    signal_set empty;
+    auto       signal = co_await empty.wait();
+    CHECK(signal.error() == std::errc::bad_file_descriptor);
+
+    ctx.stop();
+}
+
+TEST_CASE("Signal set") {
+    io_context ctx(1);
+    ctx.dispatch(signal_wait, ctx);
+    ctx.run();
+}
+
+/// \brief
+///   Checks if a signal is blocked in the calling thread.
+static auto is_blocked(int signal) noexcept -> bool {
+    sigset_t mask;
+    sigemptyset(&mask);
+    pthread_sigmask(SIG_BLOCK, nullptr, &mask);
+    return sigismember(&mask, signal) == 1;
+}
+
+/// \struct release_state
+/// \brief
+///   State shared by the two workers of the signal release test.
+struct release_state {
+    std::atomic_size_t workers;
+    std::atomic_int    stage;
+    pthread_t          observer;
+};
+
+/// \brief
+///   Wait until the other worker reaches the specified stage.
+static auto wait_stage(release_state &state, int stage) noexcept -> future<> {
+    while (state.stage.load(std::memory_order_acquire) < stage)
+        co_await sleep_for(1ms);
+}
+
+static auto signal_release(io_context &ctx, release_state &state) noexcept -> future<> {
+    if (state.workers.fetch_add(1, std::memory_order_relaxed) != 0) {
+        state.observer = pthread_self();
+        state.stage.store(1, std::memory_order_release);
+
+        // Stay inside this task so that this worker does not block the signal on its own, and is
+        // interrupted by the forwarding handler instead.
+        while (state.stage.load(std::memory_order_acquire) < 2)
+            std::this_thread::yield();
+        CHECK(is_blocked(SIGURG));
+
+        // The forwarded signal is unblocked again once the last set releases it.
+        co_await wait_stage(state, 3);
+        co_await sleep_for(1ms);
+        CHECK_FALSE(is_blocked(SIGURG));
+
+        state.stage.store(4, std::memory_order_release);
+        co_return;
+    }
+
+    co_await wait_stage(state, 1);
+
+    struct sigaction action{};
+    {
+        signal_set first{SIGURG};
+        {
+            signal_set second{SIGURG};
+
+            // The worker that has not blocked the signal forwards it to the process.
+            CHECK(::pthread_kill(state.observer, SIGURG) == 0);
+            auto signal = co_await second.wait();
+            CHECK(signal.has_value());
+            CHECK(*signal == SIGURG);
+            state.stage.store(2, std::memory_order_release);
+        }
+
+        // The signal is still owned by the first set once the second set is released.
+        CHECK(::sigaction(SIGURG, nullptr, &action) == 0);
+        CHECK(action.sa_handler != SIG_DFL);
+        CHECK(is_blocked(SIGURG));
+    }
+
+    // The default action of SIGURG is to ignore it, so it is not left pending once unblocked.
+    CHECK(::sigaction(SIGURG, nullptr, &action) == 0);
+    CHECK(action.sa_handler == SIG_DFL);
+    CHECK_FALSE(is_blocked(SIGURG));
+
+    CHECK(::raise(SIGURG) == 0);
+    sigset_t pending;
+    sigemptyset(&pending);
+    CHECK(::sigpending(&pending) == 0);
+    CHECK(sigismember(&pending, SIGURG) == 0);
+
+    state.stage.store(3, std::memory_order_release);
+    co_await wait_stage(state, 4);
+    ctx.stop();
+}
+
+TEST_CASE("Signal set release") {
+    io_context    ctx(2);
+    release_state state{};
+    ctx.dispatch(signal_release, ctx, state);
+    ctx.run();
+}
+#endif
@@ -0,0 +1,134 @@
+#include "ossia/tcp_server.hpp"
+#include "ossia/timer.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+static auto nested(task_context *expected) noexcept -> future<task_context *> {
+    task_context *inherited = co_await current_task_context();
+    CHECK(inherited == expected);
+
+    // A narrower context is only seen by coroutines awaited from here.
+    task_context child    = expected->with_timeout(1ms);
+    auto        *previous = co_await set_task_context(&child);
+    CHECK(previous == expected);
+    CHECK(child.trace_id == expected->trace_id);
+    CHECK(child.deadline <= expected->deadline);
+
+    co_return co_await current_task_context();
+}
+
+static auto scheduled(task_context *expected, bool &done) noexcept -> future<> {
+    task_context *context = co_await current_task_context();
+    CHECK(context == expected);
+    done = true;
+}
+
+static auto inherit(io_context &ctx) noexcept -> future<> {
+    task_context *initial = co_await current_task_context();
+    CHECK(initial == nullptr);
+
+    task_context context;
+    context.trace_id[0] = 0x4b;
+    context.deadline    = std::chrono::steady_clock::now() + 1s;
+    co_await set_task_context(&context);
+
+    task_context *inner = co_await nested(&context);
+    CHECK(inner != nullptr);
+    CHECK(inner != &context);
+
+    // The context of this coroutine is not changed by the callee.
+    task_context *current = co_await current_task_context();
+    CHECK(current == &context);
+
+    // Scheduled tasks do not inherit a context by themselves.
+    bool done = false;
+    schedule(with_task_context(scheduled(&context, done), &context));
+    co_await sleep_for(1ms);
+    CHECK(done);
+
+    ctx.stop();
+}
+
+TEST_CASE("task context inheritance") {
+    io_context ctx(1);
+    ctx.dispatch(inherit, ctx);
+    ctx.run();
+}
+
+static auto silent_listener(const inet_address &address) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    // Accept and keep the connection open without sending anything.
+    auto stream = co_await server.accept_async();
+    REQUIRE(stream.has_value());
+
+    char buffer[1];
+    co_await stream->receive_async(buffer, sizeof(buffer));
+}
+
+static auto receive_once(tcp_stream &stream) noexcept
+    -> future<std::expected<std::uint32_t, std::error_code>> {
+    char buffer[16];
+    co_return co_await stream.receive_async(buffer, sizeof(buffer));
+}
+
+static auto cancelled_receive(tcp_stream &stream, bool &done) noexcept -> future<> {
+    auto result = co_await receive_once(stream);
+    REQUIRE_FALSE(result.has_value());
+    CHECK(result.error() == std::errc::operation_canceled);
+    done = true;
+}
+
+static auto deadline_client(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    tcp_stream stream;
+    REQUIRE((co_await stream.connect_async(address)).value() == 0);
+
+    // Operations under a deadline are cancelled without being reported as timed out.
+    task_context distant = task_context{}.with_timeout(10s);
+    bool         done    = false;
+    schedule(with_task_context(cancelled_receive(stream, done), &distant));
+    co_await sleep_for(10ms);
+    CHECK(stream.cancel().value() == 0);
+    co_await sleep_for(10ms);
+    CHECK(done);
+
+    task_context context = task_context{}.with_timeout(50ms);
+    co_await set_task_context(&context);
+
+    // The receive has no timeout of its own. It times out at the deadline of the task.
+    auto start  = std::chrono::steady_clock::now();
+    auto result = co_await receive_once(stream);
+    auto spent  = std::chrono::steady_clock::now() - start;
+
+    REQUIRE_FALSE(result.has_value());
+    CHECK(result.error() == std::errc::timed_out);
+    CHECK(spent >= 40ms);
+    CHECK(spent < 1s);
+
+    // Receive operations fail at once once the deadline has passed.
+    result = co_await receive_once(stream);
+    REQUIRE_FALSE(result.has_value());
+    CHECK(result.error() == std::errc::timed_out);
+
+    // So do connect operations.
+    tcp_stream      other;
+    std::error_code error = co_await other.connect_async(address);
+    CHECK(error == std::errc::timed_out);
+
+    stream.close();
+    co_await sleep_for(10ms);
+    ctx.stop();
+}
+
+TEST_CASE("task context deadline") {
+    io_context   ctx(1);
+    inet_address address(ipv4_loopback, 23352);
+
+    ctx.dispatch(silent_listener, address);
+    ctx.dispatch(deadline_client, ctx, address);
+    ctx.run();
+}
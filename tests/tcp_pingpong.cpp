@@ -2,6 +2,10 @@
 
 #include <doctest/doctest.h>
 
+#include <array>
+#include <string>
+#include <type_traits>
+
 using namespace ossia;
 using namespace std::chrono_literals;
 
@@ -84,3 +88,274 @@ TEST_CASE("TCP async ping-pong") {
 
     ctx.run();
 }
+
+/// \brief
+///   Options of connections in the policy test.
+struct fast_policy : default_tcp_policy {
+    static constexpr bool                     no_delay        = true;
+    static constexpr bool                     keep_alive      = true;
+    static constexpr std::chrono::nanoseconds receive_timeout = 50ms;
+};
+
+static auto policy_listener(const inet_address &address) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    auto stream = co_await server.accept_async<fast_policy>();
+    REQUIRE(stream.has_value());
+
+    // The receive timeout of the policy is used by default.
+    char buffer[4];
+    auto result = co_await stream->receive_async(buffer, sizeof(buffer));
+    CHECK_FALSE(result.has_value());
+    CHECK(result.error() == std::errc::timed_out);
+
+    result = co_await stream->receive_async(buffer, sizeof(buffer), 1s);
+    REQUIRE(result.has_value());
+    CHECK(*result == sizeof(buffer));
+
+    auto sent = co_await stream->send_async(buffer, *result);
+    CHECK(sent.has_value());
+}
+
+static auto policy_client(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    basic_tcp_stream<fast_policy> stream;
+    CHECK((co_await stream.connect_async(address)).value() == 0);
+
+    // Let the first receive of the server time out.
+    co_await sleep_for(100ms);
+
+    char request[4]{'p', 'i', 'n', 'g'};
+    auto sent = co_await stream.send_async(request, sizeof(request));
+    CHECK(sent.has_value());
+
+    char reply[4]{};
+    auto received = co_await stream.receive_async(reply, sizeof(reply));
+    REQUIRE(received.has_value());
+    CHECK(std::string_view(reply, *received) == "ping");
+
+    ctx.stop();
+}
+
+TEST_CASE("TCP stream policy") {
+    io_context ctx(1);
+
+    inet_address address(ipv4_loopback, 23348);
+    ctx.dispatch(policy_listener, address);
+    ctx.dispatch(policy_client, ctx, address);
+
+    ctx.run();
+}
+
+/// \brief
+///   Options of connections that exchange registered buffers without rate limiting.
+struct registered_policy : default_tcp_policy {
+    static constexpr bool no_delay     = true;
+    static constexpr bool rate_limited = false;
+};
+
+// The policy could not be dropped through an implicit conversion to tcp_stream.
+static_assert(!std::is_convertible_v<basic_tcp_stream<registered_policy> &, tcp_stream &>);
+
+/// \brief
+///   Size in byte of the payload in the registered buffer test.
+inline constexpr std::uint32_t registered_payload_size = 8192;
+
+static auto registered_listener(const inet_address &address) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    auto stream = co_await server.accept_async<registered_policy>();
+    REQUIRE(stream.has_value());
+
+    auto *worker = detail::io_context_worker::current();
+    auto  buffer = worker->acquire_buffer();
+    REQUIRE(buffer.has_value());
+
+    std::uint32_t total = 0;
+    while (total < registered_payload_size) {
+        registered_buffer rest{
+            .data  = static_cast<char *>(buffer->data) + total,
+            .size  = buffer->size - total,
+            .index = buffer->index,
+        };
+
+        auto result = co_await stream->receive_async(rest, registered_payload_size - total);
+        REQUIRE(result.has_value());
+        REQUIRE(*result != 0);
+        total += *result;
+    }
+
+    // The buffer is released by the kernel once the send operation completes.
+    auto sent = co_await stream->send_async(*buffer, registered_payload_size);
+    REQUIRE(sent.has_value());
+    CHECK(*sent == registered_payload_size);
+
+    worker->release_buffer(*buffer);
+}
+
+static auto registered_client(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    basic_tcp_stream<registered_policy> stream;
+    CHECK((co_await stream.connect_async(address)).value() == 0);
+
+    std::string payload(registered_payload_size, '\0');
+    for (std::size_t i = 0; i < payload.size(); ++i)
+        payload[i] = static_cast<char>(i * 7);
+
+    for (std::uint32_t sent = 0; sent < payload.size();) {
+        auto result = co_await stream.send_async(payload.data() + sent,
+                                                 registered_payload_size - sent);
+        REQUIRE(result.has_value());
+        sent += *result;
+    }
+
+    std::string reply(registered_payload_size, '\0');
+    for (std::uint32_t received = 0; received < reply.size();) {
+        auto result = co_await stream.receive_async(reply.data() + received,
+                                                    registered_payload_size - received);
+        REQUIRE(result.has_value());
+        REQUIRE(*result != 0);
+        received += *result;
+    }
+
+    CHECK(reply == payload);
+
+    char end;
+    auto closed = co_await stream.receive_async(&end, 1);
+    REQUIRE(closed.has_value());
+    CHECK(*closed == 0);
+
+    // The peer is gone. Sending from a registered buffer fails without raising SIGPIPE.
+    auto *worker = detail::io_context_worker::current();
+    auto  buffer = worker->acquire_buffer();
+    REQUIRE(buffer.has_value());
+
+    std::expected<std::uint32_t, std::error_code> result;
+    for (int i = 0; i < 16 && result.has_value(); ++i)
+        result = co_await stream.send_async(*buffer, buffer->size);
+    CHECK_FALSE(result.has_value());
+
+    worker->release_buffer(*buffer);
+    ctx.stop();
+}
+
+TEST_CASE("TCP stream policy with registered buffers") {
+    io_context_options options;
+    options.registered_buffer_count = 2;
+
+    io_context ctx(1, options);
+
+    inet_address address(ipv4_loopback, 23360);
+    ctx.dispatch(registered_listener, address);
+    ctx.dispatch(registered_client, ctx, address);
+
+    ctx.run();
+}
+
+/// \brief
+///   Echo the first bytes received by the accept and then everything else until end of stream.
+static auto echo_first(accepted_stream accepted, std::array<char, 64> first) noexcept -> future<> {
+    tcp_stream &stream = accepted.stream;
+    if (accepted.size != 0) {
+        auto sent = co_await stream.send_async(first.data(), accepted.size);
+        CHECK(sent.has_value());
+    }
+
+    char buffer[64];
+    while (true) {
+        auto result = co_await stream.receive_async(buffer, sizeof(buffer));
+        REQUIRE(result.has_value());
+        if (*result == 0)
+            break;
+
+        auto sent = co_await stream.send_async(buffer, *result);
+        CHECK(sent.has_value());
+    }
+}
+
+static auto first_read_listener(const inet_address &address) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    // The first receive is linked with the accept only if the worker has direct descriptor slots.
+    auto        *worker = detail::io_context_worker::current();
+    std::int32_t slot   = worker->acquire_direct_descriptor();
+    bool         linked = (slot >= 0);
+    if (linked)
+        worker->release_direct_descriptor(slot);
+
+    // Three requests, a connection closed at once and a connection that sends nothing in time.
+    // Slots are reused by later accepts.
+    for (int i = 0; i < 5; ++i) {
+        std::array<char, 64> first{};
+        auto                 accepted = co_await server.accept_async(first.data(), 64, 50ms);
+        REQUIRE(accepted.has_value());
+        CHECK(accepted->stream.peer_address().port() != 0);
+
+        std::uint32_t expected = (linked && i < 3) ? sizeof("request 0") - 1 : 0;
+        CHECK(accepted->size == expected);
+
+        schedule(echo_first(std::move(*accepted), first));
+    }
+}
+
+static auto first_read_client(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    for (int i = 0; i < 3; ++i) {
+        tcp_stream stream;
+        CHECK((co_await stream.connect_async(address)).value() == 0);
+
+        std::string request = "request " + std::to_string(i);
+        auto        sent    = co_await stream.send_async(request.data(),
+                                                  static_cast<std::uint32_t>(request.size()));
+        CHECK(sent.has_value());
+
+        char        reply[64];
+        std::size_t size = 0;
+        while (size < request.size()) {
+            auto received = co_await stream.receive_async(reply + size,
+                                                         static_cast<std::uint32_t>(64 - size));
+            REQUIRE(received.has_value());
+            REQUIRE(*received != 0);
+            size += *received;
+        }
+
+        CHECK(std::string_view(reply, size) == request);
+    }
+
+    // A connection closed without sending anything is accepted with nothing read ahead.
+    tcp_stream closed;
+    CHECK((co_await closed.connect_async(address)).value() == 0);
+    closed.close();
+
+    // A connection that sends nothing is accepted once the first receive times out, and works
+    // as usual afterwards.
+    tcp_stream silent;
+    CHECK((co_await silent.connect_async(address)).value() == 0);
+    co_await sleep_for(100ms);
+
+    auto sent = co_await silent.send_async("late", 4);
+    CHECK(sent.has_value());
+
+    char reply[4]{};
+    auto received = co_await silent.receive_async(reply, sizeof(reply), 1s);
+    REQUIRE(received.has_value());
+    CHECK(std::string_view(reply, *received) == "late");
+
+    ctx.stop();
+}
+
+TEST_CASE("TCP accept with first receive") {
+    io_context_options options;
+
+    // Workers without direct descriptors fall back to a plain accept.
+    for (std::uint32_t count : {2u, 0u}) {
+        options.direct_descriptor_count = count;
+        io_context ctx(1, options);
+
+        inet_address address(ipv4_loopback, 23351);
+        ctx.dispatch(first_read_listener, address);
+        ctx.dispatch(first_read_client, ctx, address);
+
+        ctx.run();
+    }
+}
@@ -0,0 +1,133 @@
+#include "ossia/udp_socket.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+/// \brief
+///   Linux enables software receive timestamps in the network stack asynchronously the first time
+///   any socket asks for them, so datagrams received right after enabling may not be timestamped.
+///   Exchange datagrams until the receiver gets a timestamp.
+static auto wait_for_timestamps(udp_socket &sender, udp_socket &receiver, inet_address to) noexcept
+    -> future<bool> {
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (std::chrono::steady_clock::now() < deadline) {
+        const char probe = 0;
+        auto       sent  = co_await sender.send_to_async(&probe, 1, to);
+        if (!sent.has_value())
+            co_return false;
+
+        char buffer;
+        auto datagram = co_await receiver.receive_from_async(&buffer, 1);
+        if (!datagram.has_value())
+            co_return false;
+
+        if (datagram->timestamp.time_since_epoch().count() != 0)
+            co_return true;
+    }
+
+    co_return false;
+}
+
+static auto udp_unicast(io_context &ctx) noexcept -> future<> {
+    udp_socket receiver;
+    CHECK(receiver.bind(inet_address(ipv4_loopback, 23341)).value() == 0);
+    CHECK(receiver.local_address().port() == 23341);
+    CHECK(receiver.set_receive_timestamps(true).value() == 0);
+
+    udp_socket sender;
+    CHECK(sender.bind(inet_address(ipv4_loopback, 0)).value() == 0);
+    CHECK(sender.local_address().port() != 0);
+    CHECK(co_await wait_for_timestamps(sender, receiver, receiver.local_address()));
+
+    auto before = std::chrono::system_clock::now();
+
+    const char message[] = "Hello, UDP!";
+    auto       sent = co_await sender.send_to_async(message, sizeof(message),
+                                                    receiver.local_address());
+    CHECK(sent.has_value());
+    CHECK(*sent == sizeof(message));
+
+    char buffer[64]{};
+    auto datagram = co_await receiver.receive_from_async(buffer, sizeof(buffer));
+    CHECK(datagram.has_value());
+    CHECK(datagram->size == sizeof(message));
+    CHECK_FALSE(datagram->truncated);
+    CHECK(datagram->peer == sender.local_address());
+    CHECK(std::memcmp(buffer, message, sizeof(message)) == 0);
+
+    // Kernel timestamp is taken between sending and receiving.
+    CHECK(datagram->timestamp >= before - 1s);
+    CHECK(datagram->timestamp <= std::chrono::system_clock::now());
+
+    // Datagrams larger than the buffer are truncated.
+    sent = co_await sender.send_to_async(message, sizeof(message), receiver.local_address());
+    CHECK(sent.has_value());
+
+    datagram = co_await receiver.receive_from_async(buffer, 4);
+    CHECK(datagram.has_value());
+    CHECK(datagram->size == 4);
+    CHECK(datagram->truncated);
+
+    // Timestamps could be disabled.
+    CHECK(receiver.set_receive_timestamps(false).value() == 0);
+
+    sent = co_await sender.send_to_async(message, sizeof(message), receiver.local_address());
+    CHECK(sent.has_value());
+
+    datagram = co_await receiver.receive_from_async(buffer, sizeof(buffer));
+    CHECK(datagram.has_value());
+    CHECK(datagram->timestamp.time_since_epoch().count() == 0);
+
+    ctx.stop();
+}
+
+TEST_CASE("UDP unicast with receive timestamps") {
+    io_context ctx(1);
+    ctx.dispatch(udp_unicast, ctx);
+    ctx.run();
+}
+
+static auto udp_multicast(io_context &ctx) noexcept -> future<> {
+    // Loopback interface is the first interface on Linux.
+    constexpr std::uint32_t loopback = 1;
+    const ip_address        group(239, 255, 0, 1);
+
+    udp_socket receiver;
+    CHECK(receiver.bind(inet_address(ipv4_any, 23342)).value() == 0);
+    CHECK(receiver.join_group(group, loopback).value() == 0);
+    CHECK(receiver.set_receive_timestamps(true).value() == 0);
+
+    // Unicast addresses could not be joined.
+    CHECK(receiver.join_group(ipv4_loopback, loopback) == std::errc::invalid_argument);
+
+    udp_socket sender;
+    CHECK(sender.bind(inet_address(ipv4_any, 0)).value() == 0);
+    CHECK(sender.set_multicast_interface(loopback).value() == 0);
+    CHECK(co_await wait_for_timestamps(sender, receiver, inet_address(group, 23342)));
+
+    const char message[] = "multicast";
+    auto       sent      = co_await sender.send_to_async(message, sizeof(message),
+                                                         inet_address(group, 23342));
+    CHECK(sent.has_value());
+
+    char buffer[64]{};
+    auto datagram = co_await receiver.receive_from_async(buffer, sizeof(buffer));
+    CHECK(datagram.has_value());
+    CHECK(datagram->size == sizeof(message));
+    CHECK(std::memcmp(buffer, message, sizeof(message)) == 0);
+    CHECK(datagram->timestamp.time_since_epoch().count() != 0);
+
+    CHECK(receiver.leave_group(group, loopback).value() == 0);
+
+    ctx.stop();
+}
+
+TEST_CASE("UDP multicast") {
+    io_context ctx(1);
+    ctx.dispatch(udp_multicast, ctx);
+    ctx.run();
+}
@@ -0,0 +1,296 @@
+#include "ossia/websocket.hpp"
+#include "ossia/timer.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+#include <string>
+
+using namespace ossia;
+using namespace std::chrono_literals;
+
+TEST_CASE("WebSocket accept key") {
+    CHECK(websocket_accept_key("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST_CASE("WebSocket frame header") {
+    // A single-frame masked text message from RFC 6455 section 5.7.
+    const char hello[]{
+        '\x81', '\x85', '\x37', '\xfa', '\x21', '\x3d', '\x7f', '\x9f', '\x4d', '\x51', '\x58',
+    };
+
+    auto frame = parse_websocket_frame(hello);
+    REQUIRE(frame.has_value());
+    CHECK(frame->fin);
+    CHECK(frame->masked);
+    CHECK(frame->opcode == websocket_opcode::text);
+    CHECK(frame->header_size == 6);
+    CHECK(frame->payload_size == 5);
+
+    std::string payload(hello + 6, 5);
+    websocket_mask(payload, frame->mask);
+    CHECK(payload == "Hello");
+
+    // Every proper prefix of the header is incomplete.
+    for (std::size_t i = 0; i < 6; ++i) {
+        auto result = parse_websocket_frame(std::span<const char>(hello, i));
+        REQUIRE(!result.has_value());
+        CHECK(result.error() == websocket_parse_error::incomplete);
+    }
+
+    const char medium[]{'\x02', '\x7e', '\x01', '\x00'};
+    frame = parse_websocket_frame(medium);
+    REQUIRE(frame.has_value());
+    CHECK(!frame->fin);
+    CHECK(!frame->masked);
+    CHECK(frame->opcode == websocket_opcode::binary);
+    CHECK(frame->header_size == 4);
+    CHECK(frame->payload_size == 256);
+
+    const char large[]{
+        '\x82', '\x7f', '\x00', '\x00', '\x00', '\x00', '\x00', '\x01', '\x00', '\x00',
+    };
+    frame = parse_websocket_frame(large);
+    REQUIRE(frame.has_value());
+    CHECK(frame->header_size == 10);
+    CHECK(frame->payload_size == 65536);
+
+    const std::string_view invalid[]{
+        std::string_view("\xc1\x00", 2),         // RSV1 without extension.
+        std::string_view("\x83\x00", 2),         // Reserved opcode.
+        std::string_view("\x09\x00", 2),         // Fragmented control frame.
+        std::string_view("\x89\x7e\x00\x7e", 4), // Control frame with large payload.
+        std::string_view("\x82\x7e\x00\x7d", 4), // Non-minimal 16-bit length.
+        std::string_view("\x82\x7f\x00\x00\x00\x00\x00\x00\xff\xff", 10),
+        std::string_view("\x82\x7f\x80\x00\x00\x00\x00\x01\x00\x00", 10),
+    };
+
+    for (std::string_view data : invalid) {
+        auto result = parse_websocket_frame(data);
+        REQUIRE(!result.has_value());
+        CHECK(result.error() == websocket_parse_error::invalid);
+    }
+}
+
+TEST_CASE("WebSocket mask") {
+    const std::uint8_t key[4]{0x12, 0x34, 0x56, 0x78};
+    std::uint32_t      mask;
+    std::memcpy(&mask, key, sizeof(mask));
+
+    // Cover vectorized loops, 8-byte loop and byte tail with different alignments.
+    std::string buffer(1100, '\0');
+    for (std::size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = static_cast<char>(i * 7);
+
+    for (std::size_t offset : {0, 1, 3}) {
+        for (std::size_t size : {0, 1, 7, 8, 15, 16, 31, 32, 33, 63, 100, 1000}) {
+            std::string data(buffer.data() + offset, size);
+            websocket_mask(std::span<char>(data.data(), data.size()), mask);
+
+            bool matched = true;
+            for (std::size_t i = 0; i < size; ++i) {
+                auto expected = static_cast<std::uint8_t>(buffer[offset + i]) ^ key[i % 4];
+                matched       = matched && static_cast<std::uint8_t>(data[i]) == expected;
+            }
+            CHECK(matched);
+
+            websocket_mask(std::span<char>(data.data(), data.size()), mask);
+            CHECK(data == std::string_view(buffer.data() + offset, size));
+        }
+    }
+}
+
+TEST_CASE("WebSocket write frame") {
+    std::string output;
+    write_websocket_frame(websocket_opcode::text, true, "Hello", output);
+    CHECK(output == "\x81\x05Hello");
+
+    output.clear();
+    write_websocket_frame(websocket_opcode::binary, false, std::string(256, 'x'), output);
+    CHECK(output.size() == 260);
+    CHECK(output.starts_with(std::string_view("\x02\x7e\x01\x00", 4)));
+
+    output.clear();
+    write_websocket_frame(websocket_opcode::binary, true, std::string(65536, 'x'), output);
+    CHECK(output.size() == 65546);
+    CHECK(output.starts_with(std::string_view("\x82\x7f\x00\x00\x00\x00\x00\x01\x00\x00", 10)));
+
+    // Masked frame from RFC 6455 section 5.7.
+    const std::uint8_t key[4]{0x37, 0xfa, 0x21, 0x3d};
+    std::uint32_t      mask;
+    std::memcpy(&mask, key, sizeof(mask));
+
+    output.clear();
+    write_websocket_frame(websocket_opcode::text, true, "Hello", mask, output);
+    CHECK(output == "\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58");
+}
+
+static auto echo(websocket_stream &stream) noexcept -> future<> {
+    while (true) {
+        auto message = co_await stream.receive_async();
+        if (!message.has_value() || message->opcode == websocket_opcode::close)
+            co_return;
+
+        auto error = co_await stream.send_async(message->opcode, message->payload);
+        if (error)
+            co_return;
+    }
+}
+
+static auto listener(const inet_address &address) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    auto stream = co_await server.accept_async();
+    REQUIRE(stream.has_value());
+
+    schedule(websocket_server::serve(std::move(*stream), echo));
+}
+
+static auto client(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    auto stream = co_await websocket_stream::connect_async(address, "localhost", "/echo");
+    REQUIRE(stream.has_value());
+
+    // Fragmented message with an interleaved ping.
+    CHECK(co_await stream->send_async(websocket_opcode::text, "Hel", false) == std::error_code());
+    CHECK(co_await stream->send_async(websocket_opcode::ping, "ping") == std::error_code());
+    CHECK(co_await stream->send_async(websocket_opcode::continuation, "lo") == std::error_code());
+
+    auto message = co_await stream->receive_async();
+    REQUIRE(message.has_value());
+    CHECK(message->opcode == websocket_opcode::text);
+    CHECK(message->payload == "Hello");
+
+    // Large message that requires the receive buffer to grow.
+    std::string large(100000, '\0');
+    for (std::size_t i = 0; i < large.size(); ++i)
+        large[i] = static_cast<char>(i * 31);
+
+    CHECK(co_await stream->send_async(websocket_opcode::binary, large) == std::error_code());
+
+    message = co_await stream->receive_async();
+    REQUIRE(message.has_value());
+    CHECK(message->opcode == websocket_opcode::binary);
+    CHECK(message->payload == large);
+
+    // Closing handshake.
+    CHECK(co_await stream->close_async(1000) == std::error_code());
+
+    message = co_await stream->receive_async();
+    REQUIRE(message.has_value());
+    CHECK(message->opcode == websocket_opcode::close);
+    CHECK(message->payload == std::string_view("\x03\xe8", 2));
+
+    ctx.stop();
+}
+
+TEST_CASE("WebSocket echo") {
+    io_context ctx(1);
+
+    inet_address address(ipv4_loopback, 23336);
+    ctx.dispatch(listener, address);
+    ctx.dispatch(client, ctx, address);
+
+    ctx.run();
+}
+
+static auto idle_server(const inet_address &address) noexcept -> future<> {
+    tcp_server server;
+    CHECK(server.bind(address).value() == 0);
+
+    auto stream = co_await server.accept_async();
+    REQUIRE(stream.has_value());
+
+    auto websocket = co_await websocket_stream::accept_async(std::move(*stream));
+    REQUIRE(websocket.has_value());
+
+    websocket->set_ping_interval(50ms);
+
+    auto message = co_await websocket->receive_async();
+    REQUIRE(!message.has_value());
+    CHECK(message.error() == std::errc::timed_out);
+}
+
+static auto idle_client(io_context &ctx, const inet_address &address) noexcept -> future<> {
+    tcp_stream stream;
+    CHECK(co_await stream.connect_async(address) == std::error_code());
+
+    std::string_view request = "GET /idle HTTP/1.1\r\n"
+                               "Host: localhost\r\n"
+                               "Upgrade: websocket\r\n"
+                               "Connection: Upgrade\r\n"
+                               "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                               "Sec-WebSocket-Version: 13\r\n\r\n";
+
+    auto sent =
+        co_await stream.send_async(request.data(), static_cast<std::uint32_t>(request.size()));
+    REQUIRE(sent.has_value());
+
+    // Never answer ping. The server should close the connection after the second interval.
+    std::string response;
+    char        buffer[1024];
+    while (true) {
+        auto result = co_await stream.receive_async(buffer, sizeof(buffer));
+        if (!result.has_value() || *result == 0)
+            break;
+        response.append(buffer, *result);
+    }
+
+    CHECK(response.starts_with("HTTP/1.1 101 Switching Protocols\r\n"));
+    CHECK(response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") !=
+          std::string::npos);
+    CHECK(response.ends_with(std::string_view("\r\n\r\n\x89\x00", 6)));
+
+    ctx.stop();
+}
+
+TEST_CASE("WebSocket ping timeout") {
+    io_context ctx(1);
+
+    inet_address address(ipv4_loopback, 23337);
+    ctx.dispatch(idle_server, address);
+    ctx.dispatch(idle_client, ctx, address);
+
+    ctx.run();
+}
+
+static auto pooled_client(io_context &ctx, websocket_server &server) noexcept -> future<> {
+    using pool = detail::connection_pool<websocket_stream>;
+
+    for (std::size_t size : {100000, 5, 5}) {
+        auto stream = co_await websocket_stream::connect_async(server.local_address(),
+                                                               "localhost", "/pooled");
+        REQUIRE(stream.has_value());
+
+        std::string payload(size, 'x');
+        CHECK(co_await stream->send_async(websocket_opcode::binary, payload) == std::error_code());
+
+        auto message = co_await stream->receive_async();
+        REQUIRE(message.has_value());
+        CHECK(message->payload == payload);
+
+        CHECK(co_await stream->close_async(1000) == std::error_code());
+        message = co_await stream->receive_async();
+        REQUIRE(message.has_value());
+        CHECK(message->opcode == websocket_opcode::close);
+
+        // Connections are closed one after another, so a single stream is reused.
+        co_await sleep_for(10ms);
+        CHECK(pool::local().size() == 1);
+        CHECK(pool::local().active() == 0);
+    }
+
+    server.close();
+    ctx.stop();
+}
+
+TEST_CASE("WebSocket server stream pool") {
+    io_context       ctx(1);
+    websocket_server server;
+    CHECK(server.bind(inet_address(ipv4_loopback, 23361)).value() == 0);
+
+    ctx.dispatch([&server]() noexcept -> future<> { return server.run(echo); });
+    ctx.dispatch(pooled_client, ctx, server);
+
+    ctx.run();
+}